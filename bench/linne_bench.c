@@ -0,0 +1,680 @@
+/* C90でもclock_gettimeを宣言させる */
+#if (defined(__unix__) || defined(__APPLE__)) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 199309L
+#endif
+
+#include <linne_encoder.h>
+#include <linne_decoder.h>
+#include "wav.h"
+#include "command_line_parser.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+/* a, bのうち小さい方を選択 */
+#define LINNEBENCH_MIN(a, b) (((a) < (b)) ? (a) : (b))
+/* a, bのうち大きい方を選択 */
+#define LINNEBENCH_MAX(a, b) (((a) > (b)) ? (a) : (b))
+
+/* 円周率 */
+#define LINNEBENCH_PI 3.14159265358979323846
+/* ブロックあたりサンプル数（linne_codecと同じ） */
+#define LINNEBENCH_NUM_SAMPLES_PER_BLOCK (5 * 2048)
+/* 指定できる最大入力ファイル数 */
+#define LINNEBENCH_MAX_NUM_INPUT_FILES 64
+/* 合成信号のサンプリングレート */
+#define LINNEBENCH_SYNTHETIC_SAMPLING_RATE 44100
+/* 合成信号のチャンネル数 */
+#define LINNEBENCH_SYNTHETIC_NUM_CHANNELS 2
+/* 合成信号のビット深度 */
+#define LINNEBENCH_SYNTHETIC_BITS_PER_SAMPLE 16
+/* 合成信号の種類数 */
+#define LINNEBENCH_NUM_SYNTHETIC_SIGNALS 3
+
+/* 計測対象の信号（全サンプルをメモリ上に持つ） */
+/* 補足）PCMはWAVの読み込み結果と同じく32bitのMSB詰め */
+struct LINNEBenchSignal {
+    const char *name; /* 信号名 */
+    uint8_t is_synthetic; /* 合成信号か */
+    uint32_t num_channels; /* チャンネル数 */
+    uint32_t sampling_rate; /* サンプリングレート */
+    uint32_t bits_per_sample; /* サンプルあたりビット数 */
+    uint32_t num_samples; /* 1チャンネルあたりサンプル数 */
+    int32_t *pcm[LINNE_MAX_NUM_CHANNELS]; /* チャンネル毎のPCM */
+    struct WAVFile *wav; /* 読み込んだWAVファイル（合成信号ではNULL） */
+};
+
+/* 符号化・復号の片方の計測結果 */
+struct LINNEBenchMeasure {
+    double total_time; /* 全繰り返しの合計処理時間[sec] */
+    double *block_latencies; /* ブロック毎の処理時間[sec] */
+    uint32_t num_latencies; /* 記録した処理時間の数 */
+};
+
+/* 1信号・1プリセットの計測結果 */
+struct LINNEBenchResult {
+    uint32_t num_blocks; /* ブロック数 */
+    uint64_t encoded_size; /* ヘッダを含む符号化データサイズ */
+    uint8_t is_lossless; /* 復号結果が入力と一致したか */
+    struct LINNEBenchMeasure encode; /* エンコードの計測結果 */
+    struct LINNEBenchMeasure decode; /* デコードの計測結果 */
+};
+
+/* コマンドライン仕様 */
+static struct CommandLineParserSpecification command_line_spec[] = {
+    { 'm', "mode", "Specify compress mode to measure: 0(fast), ..., 7(high compression) (default:all)",
+        COMMAND_LINE_PARSER_TRUE, NULL, COMMAND_LINE_PARSER_FALSE },
+    { 'l', "enable-learning", "Whether to learning at encoding (default:no)",
+        COMMAND_LINE_PARSER_FALSE, NULL, COMMAND_LINE_PARSER_FALSE },
+    { 's', "seconds", "Specify length of synthetic signals in seconds (default:10)",
+        COMMAND_LINE_PARSER_TRUE, "10", COMMAND_LINE_PARSER_FALSE },
+    { 'n', "no-synthetic", "Whether to NOT measure synthetic signals (default:no)",
+        COMMAND_LINE_PARSER_FALSE, NULL, COMMAND_LINE_PARSER_FALSE },
+    { 'r', "repeat", "Specify number of repetitions for each measurement (default:1)",
+        COMMAND_LINE_PARSER_TRUE, "1", COMMAND_LINE_PARSER_FALSE },
+    { 'o', "output", "Specify JSON output file name (default:standard output)",
+        COMMAND_LINE_PARSER_TRUE, NULL, COMMAND_LINE_PARSER_FALSE },
+    { 'h', "help", "Show command help message",
+        COMMAND_LINE_PARSER_FALSE, NULL, COMMAND_LINE_PARSER_FALSE },
+    { 0, NULL,  }
+};
+
+/* 経過時間計測用の時刻[sec]を取得 */
+/* 補足）ブロック毎の遅延を測るため、時刻合わせで戻らず分解能の高い単調増加の時計を使う */
+static double LINNEBench_GetTime(void)
+{
+#if defined(_WIN32)
+    LARGE_INTEGER count, frequency;
+    QueryPerformanceCounter(&count);
+    QueryPerformanceFrequency(&frequency);
+    return (double)count.QuadPart / (double)frequency.QuadPart;
+#elif defined(CLOCK_MONOTONIC)
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1.0e-9;
+#else
+    return (double)clock() / CLOCKS_PER_SEC;
+#endif
+}
+
+/* 合成信号用の乱数生成（xorshift32） 実行毎に同じ系列を返す */
+static uint32_t LINNEBench_Random(uint32_t *state)
+{
+    uint32_t x = (*state);
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    (*state) = x;
+    return x;
+}
+
+/* [-1,1)の一様乱数 */
+static double LINNEBench_UniformRandom(uint32_t *state)
+{
+    return (double)LINNEBench_Random(state) / 2147483648.0 - 1.0;
+}
+
+/* 合成信号の作成 成功時は0、失敗時は0以外を返す */
+/* signal_no 0:正弦波の和に弱い雑音を加えた信号 1:白色雑音 2:無音 */
+static int LINNEBench_CreateSyntheticSignal(struct LINNEBenchSignal *signal, uint32_t signal_no, uint32_t num_samples)
+{
+    static const char *names[LINNEBENCH_NUM_SYNTHETIC_SIGNALS] = { "synthetic-sine", "synthetic-noise", "synthetic-silence" };
+    uint32_t ch, smpl;
+    uint32_t state = 0x12345678UL;
+    const double scale = 32767.0;
+
+    signal->name = names[signal_no];
+    signal->is_synthetic = 1;
+    signal->num_channels = LINNEBENCH_SYNTHETIC_NUM_CHANNELS;
+    signal->sampling_rate = LINNEBENCH_SYNTHETIC_SAMPLING_RATE;
+    signal->bits_per_sample = LINNEBENCH_SYNTHETIC_BITS_PER_SAMPLE;
+    signal->num_samples = num_samples;
+    signal->wav = NULL;
+    for (ch = 0; ch < LINNE_MAX_NUM_CHANNELS; ch++) {
+        signal->pcm[ch] = NULL;
+    }
+
+    for (ch = 0; ch < signal->num_channels; ch++) {
+        if ((signal->pcm[ch] = (int32_t *)malloc(sizeof(int32_t) * LINNEBENCH_MAX(1, num_samples))) == NULL) {
+            return 1;
+        }
+        for (smpl = 0; smpl < num_samples; smpl++) {
+            const double t = (double)smpl / signal->sampling_rate;
+            double value = 0.0;
+            switch (signal_no) {
+            case 0:
+                /* チャンネル間で位相をずらし、相関はあるが同一ではない信号にする */
+                value = 0.3 * sin(2.0 * LINNEBENCH_PI * 440.0 * t + 0.5 * ch)
+                    + 0.2 * sin(2.0 * LINNEBENCH_PI * 1234.5 * t)
+                    + 0.1 * sin(2.0 * LINNEBENCH_PI * 5678.9 * t + 0.25 * ch)
+                    + 0.001 * LINNEBench_UniformRandom(&state);
+                break;
+            case 1:
+                value = 0.5 * LINNEBench_UniformRandom(&state);
+                break;
+            default:
+                break;
+            }
+            /* 16bitに量子化してMSB詰め */
+            signal->pcm[ch][smpl] = (int32_t)floor(value * scale + 0.5) * 65536;
+        }
+    }
+
+    return 0;
+}
+
+/* WAVファイルから信号を作成 成功時は0、失敗時は0以外を返す */
+static int LINNEBench_CreateSignalFromFile(struct LINNEBenchSignal *signal, const char *filename)
+{
+    uint32_t ch;
+    struct WAVFile *wav;
+
+    if ((wav = WAV_CreateFromFile(filename)) == NULL) {
+        fprintf(stderr, "Failed to open %s. \n", filename);
+        return 1;
+    }
+    if ((wav->format.num_channels > LINNE_MAX_NUM_CHANNELS) || (wav->format.num_samples > UINT32_MAX)) {
+        fprintf(stderr, "Unsupported wav format: %s \n", filename);
+        WAV_Destroy(wav);
+        return 1;
+    }
+
+    signal->name = filename;
+    signal->is_synthetic = 0;
+    signal->num_channels = wav->format.num_channels;
+    signal->sampling_rate = wav->format.sampling_rate;
+    signal->bits_per_sample = wav->format.bits_per_sample;
+    signal->num_samples = (uint32_t)wav->format.num_samples;
+    for (ch = 0; ch < signal->num_channels; ch++) {
+        signal->pcm[ch] = wav->data[ch];
+    }
+    signal->wav = wav;
+
+    return 0;
+}
+
+/* 信号の破棄 */
+static void LINNEBench_DestroySignal(struct LINNEBenchSignal *signal)
+{
+    uint32_t ch;
+
+    if (signal->wav != NULL) {
+        WAV_Destroy(signal->wav);
+        return;
+    }
+
+    for (ch = 0; ch < signal->num_channels; ch++) {
+        if (signal->pcm[ch] != NULL) {
+            free(signal->pcm[ch]);
+        }
+    }
+}
+
+/* 計測結果の領域確保 成功時は0、失敗時は0以外を返す */
+static int LINNEBench_AllocateMeasure(struct LINNEBenchMeasure *measure, uint32_t max_num_latencies)
+{
+    measure->total_time = 0.0;
+    measure->num_latencies = 0;
+    if ((measure->block_latencies = (double *)malloc(sizeof(double) * LINNEBENCH_MAX(1, max_num_latencies))) == NULL) {
+        return 1;
+    }
+
+    return 0;
+}
+
+/* 処理時間の昇順ソート用の比較関数 */
+static int LINNEBench_CompareLatency(const void *a, const void *b)
+{
+    const double da = *(const double *)a;
+    const double db = *(const double *)b;
+
+    if (da < db) {
+        return -1;
+    } else if (da > db) {
+        return 1;
+    }
+
+    return 0;
+}
+
+/* ソート済みの処理時間からパーセンタイル値を取得（nearest-rank法） */
+static double LINNEBench_GetPercentile(const double *sorted, uint32_t num, double percent)
+{
+    uint32_t rank;
+
+    if (num == 0) {
+        return 0.0;
+    }
+
+    rank = (uint32_t)ceil(percent * num / 100.0);
+    rank = LINNEBENCH_MAX(1, LINNEBENCH_MIN(rank, num));
+
+    return sorted[rank - 1];
+}
+
+/* 1信号・1プリセットの計測 成功時は0、失敗時は0以外を返す */
+/* 補足）ブロック単位でエンコード・デコードし、ファイル入出力を含まないコーデック処理のみの時間を測る */
+static int LINNEBench_Measure(const struct LINNEBenchSignal *signal,
+    uint32_t preset, uint8_t enable_learning, uint32_t num_repeats, struct LINNEBenchResult *result)
+{
+    struct LINNEEncoderConfig encoder_config;
+    struct LINNEDecoderConfig decoder_config;
+    struct LINNEEncodeParameter parameter;
+    struct LINNEHeader header;
+    struct LINNEEncoder *encoder = NULL;
+    struct LINNEDecoder *decoder = NULL;
+    struct LINNEEncoderPCMInput input;
+    struct LINNEDecoderPCMOutput output;
+    uint8_t header_data[LINNE_HEADER_SIZE];
+    uint8_t *data = NULL;
+    uint32_t *block_sizes = NULL;
+    int32_t *decoded[LINNE_MAX_NUM_CHANNELS];
+    uint32_t max_block_size, ch, blk, rep;
+    int ret = 1;
+
+    for (ch = 0; ch < LINNE_MAX_NUM_CHANNELS; ch++) {
+        decoded[ch] = NULL;
+    }
+
+    /* エンコードパラメータセット（linne_codecと同じ設定） */
+    parameter.num_channels = (uint16_t)signal->num_channels;
+    parameter.bits_per_sample = (uint16_t)signal->bits_per_sample;
+    parameter.sampling_rate = signal->sampling_rate;
+    parameter.num_samples_per_block = LINNEBENCH_NUM_SAMPLES_PER_BLOCK;
+    parameter.preset = (uint8_t)preset;
+    parameter.ch_process_method = (signal->num_channels >= 2) ? LINNE_CH_PROCESS_METHOD_MS : LINNE_CH_PROCESS_METHOD_NONE;
+    parameter.enable_learning = enable_learning;
+    parameter.num_afmethod_iterations = 0;
+
+    result->num_blocks = (signal->num_samples + LINNEBENCH_NUM_SAMPLES_PER_BLOCK - 1) / LINNEBENCH_NUM_SAMPLES_PER_BLOCK;
+    result->encoded_size = LINNE_HEADER_SIZE;
+    result->is_lossless = 1;
+    result->encode.block_latencies = NULL;
+    result->decode.block_latencies = NULL;
+    if ((LINNEBench_AllocateMeasure(&result->encode, result->num_blocks * num_repeats) != 0)
+            || (LINNEBench_AllocateMeasure(&result->decode, result->num_blocks * num_repeats) != 0)) {
+        fprintf(stderr, "Failed to allocate measurement buffer. \n");
+        return 1;
+    }
+
+    /* ハンドル作成 */
+    encoder_config.max_num_channels = signal->num_channels;
+    encoder_config.max_num_samples_per_block = LINNEBENCH_NUM_SAMPLES_PER_BLOCK;
+    encoder_config.max_num_layers = 5;
+    encoder_config.max_num_parameters_per_layer = 128;
+    encoder_config.max_num_threads = 1;
+    encoder_config.allocator = NULL;
+    decoder_config.max_num_channels = signal->num_channels;
+    decoder_config.max_num_layers = 5;
+    decoder_config.max_num_parameters_per_layer = 128;
+    decoder_config.max_num_threads = 1;
+    decoder_config.max_num_samples_per_block = LINNEBENCH_NUM_SAMPLES_PER_BLOCK;
+    decoder_config.check_crc = 1;
+    decoder_config.allocator = NULL;
+    if (((encoder = LINNEEncoder_Create(&encoder_config, NULL, 0)) == NULL)
+            || ((decoder = LINNEDecoder_Create(&decoder_config, NULL, 0)) == NULL)) {
+        fprintf(stderr, "Failed to create handles. \n");
+        goto EXIT;
+    }
+    if (LINNEEncoder_SetEncodeParameter(encoder, &parameter) != LINNE_APIRESULT_OK) {
+        fprintf(stderr, "Failed to set encode parameter. \n");
+        goto EXIT;
+    }
+
+    /* ヘッダはエンコードしたものをデコードして使う */
+    header.num_channels = parameter.num_channels;
+    header.num_samples = signal->num_samples;
+    header.sampling_rate = parameter.sampling_rate;
+    header.bits_per_sample = parameter.bits_per_sample;
+    header.num_samples_per_block = parameter.num_samples_per_block;
+    header.preset = parameter.preset;
+    header.ch_process_method = parameter.ch_process_method;
+    if ((LINNEEncoder_EncodeHeader(&header, header_data, sizeof(header_data)) != LINNE_APIRESULT_OK)
+            || (LINNEDecoder_DecodeHeader(header_data, sizeof(header_data), &header) != LINNE_APIRESULT_OK)
+            || (LINNEDecoder_SetHeader(decoder, &header) != LINNE_APIRESULT_OK)) {
+        fprintf(stderr, "Failed to set header. \n");
+        goto EXIT;
+    }
+
+    /* 全ブロックの符号化データを保持する領域 */
+    if (LINNEEncoder_CalculateMaxBlockSize(&parameter, &max_block_size) != LINNE_APIRESULT_OK) {
+        fprintf(stderr, "Failed to calculate max block size. \n");
+        goto EXIT;
+    }
+    if (((data = (uint8_t *)malloc((size_t)max_block_size * LINNEBENCH_MAX(1, result->num_blocks))) == NULL)
+            || ((block_sizes = (uint32_t *)malloc(sizeof(uint32_t) * LINNEBENCH_MAX(1, result->num_blocks))) == NULL)) {
+        fprintf(stderr, "Failed to allocate encode buffer. \n");
+        goto EXIT;
+    }
+    for (ch = 0; ch < signal->num_channels; ch++) {
+        if ((decoded[ch] = (int32_t *)malloc(sizeof(int32_t) * LINNEBENCH_NUM_SAMPLES_PER_BLOCK)) == NULL) {
+            fprintf(stderr, "Failed to allocate decode buffer. \n");
+            goto EXIT;
+        }
+    }
+
+    input.format = LINNE_PCM_FORMAT_INT32;
+    input.stride = sizeof(int32_t);
+    output.format = LINNE_PCM_FORMAT_INT32;
+    output.stride = sizeof(int32_t);
+    for (ch = 0; ch < signal->num_channels; ch++) {
+        output.channels[ch] = decoded[ch];
+    }
+
+    for (rep = 0; rep < num_repeats; rep++) {
+        double start, total;
+
+        /* エンコード */
+        total = 0.0;
+        for (blk = 0; blk < result->num_blocks; blk++) {
+            const uint32_t offset = blk * LINNEBENCH_NUM_SAMPLES_PER_BLOCK;
+            const uint32_t num_samples = LINNEBENCH_MIN(LINNEBENCH_NUM_SAMPLES_PER_BLOCK, signal->num_samples - offset);
+            for (ch = 0; ch < signal->num_channels; ch++) {
+                input.channels[ch] = &signal->pcm[ch][offset];
+            }
+            start = LINNEBench_GetTime();
+            if (LINNEEncoder_EncodeBlockPCM(encoder, &input, num_samples,
+                        &data[(size_t)blk * max_block_size], max_block_size, &block_sizes[blk]) != LINNE_APIRESULT_OK) {
+                fprintf(stderr, "Failed to encode. \n");
+                goto EXIT;
+            }
+            result->encode.block_latencies[result->encode.num_latencies++] = LINNEBench_GetTime() - start;
+            total += result->encode.block_latencies[result->encode.num_latencies - 1];
+        }
+        result->encode.total_time += total;
+
+        /* デコード 入力との一致確認は計測に含めない */
+        total = 0.0;
+        for (blk = 0; blk < result->num_blocks; blk++) {
+            const uint32_t offset = blk * LINNEBENCH_NUM_SAMPLES_PER_BLOCK;
+            uint32_t decode_size, num_samples;
+            start = LINNEBench_GetTime();
+            if (LINNEDecoder_DecodeBlockPCM(decoder, &data[(size_t)blk * max_block_size], block_sizes[blk],
+                        &output, LINNEBENCH_NUM_SAMPLES_PER_BLOCK, &decode_size, &num_samples) != LINNE_APIRESULT_OK) {
+                fprintf(stderr, "Failed to decode. \n");
+                goto EXIT;
+            }
+            result->decode.block_latencies[result->decode.num_latencies++] = LINNEBench_GetTime() - start;
+            total += result->decode.block_latencies[result->decode.num_latencies - 1];
+            for (ch = 0; ch < signal->num_channels; ch++) {
+                if ((num_samples != LINNEBENCH_MIN(LINNEBENCH_NUM_SAMPLES_PER_BLOCK, signal->num_samples - offset))
+                        || (memcmp(decoded[ch], &signal->pcm[ch][offset], sizeof(int32_t) * num_samples) != 0)) {
+                    result->is_lossless = 0;
+                }
+            }
+        }
+        result->decode.total_time += total;
+    }
+
+    for (blk = 0; blk < result->num_blocks; blk++) {
+        result->encoded_size += block_sizes[blk];
+    }
+    ret = 0;
+
+EXIT:
+    for (ch = 0; ch < LINNE_MAX_NUM_CHANNELS; ch++) {
+        if (decoded[ch] != NULL) {
+            free(decoded[ch]);
+        }
+    }
+    if (block_sizes != NULL) {
+        free(block_sizes);
+    }
+    if (data != NULL) {
+        free(data);
+    }
+    LINNEDecoder_Destroy(decoder);
+    LINNEEncoder_Destroy(encoder);
+
+    return ret;
+}
+
+/* JSON文字列の書き出し */
+static void LINNEBench_PrintJSONString(FILE *fp, const char *str)
+{
+    fputc('"', fp);
+    for (; *str != '\0'; str++) {
+        const unsigned char c = (unsigned char)*str;
+        if ((c == '"') || (c == '\\')) {
+            fprintf(fp, "\\%c", c);
+        } else if (c < 0x20) {
+            fprintf(fp, "\\u%04x", c);
+        } else {
+            fputc(c, fp);
+        }
+    }
+    fputc('"', fp);
+}
+
+/* 計測結果（エンコード・デコードの片方）をJSONで書き出し */
+static void LINNEBench_PrintMeasureJSON(FILE *fp, const char *name,
+    const struct LINNEBenchSignal *signal, uint32_t num_repeats, struct LINNEBenchMeasure *measure)
+{
+    const double elapsed = LINNEBENCH_MAX(measure->total_time, 1.0e-9);
+    const double num_samples = (double)signal->num_samples * num_repeats;
+    const double pcm_size = num_samples * signal->num_channels * (signal->bits_per_sample / 8);
+    const double *sorted = measure->block_latencies;
+
+    qsort(measure->block_latencies, measure->num_latencies, sizeof(double), LINNEBench_CompareLatency);
+
+    fprintf(fp, "      \"%s\": {\n", name);
+    fprintf(fp, "        \"seconds\": %.6f,\n", measure->total_time);
+    fprintf(fp, "        \"samples_per_second\": %.1f,\n", num_samples / elapsed);
+    fprintf(fp, "        \"realtime_factor\": %.3f,\n", num_samples / signal->sampling_rate / elapsed);
+    fprintf(fp, "        \"bytes_per_second\": %.1f,\n", pcm_size / elapsed);
+    fprintf(fp, "        \"block_latency_usec\": { \"p50\": %.1f, \"p90\": %.1f, \"p99\": %.1f, \"max\": %.1f }\n",
+            1.0e6 * LINNEBench_GetPercentile(sorted, measure->num_latencies, 50.0),
+            1.0e6 * LINNEBench_GetPercentile(sorted, measure->num_latencies, 90.0),
+            1.0e6 * LINNEBench_GetPercentile(sorted, measure->num_latencies, 99.0),
+            1.0e6 * LINNEBench_GetPercentile(sorted, measure->num_latencies, 100.0));
+    fprintf(fp, "      }");
+}
+
+/* 1信号・1プリセットの計測結果をJSONで書き出し */
+static void LINNEBench_PrintResultJSON(FILE *fp, const struct LINNEBenchSignal *signal,
+    uint32_t preset, uint8_t enable_learning, uint32_t num_repeats, struct LINNEBenchResult *result)
+{
+    const double pcm_size = (double)signal->num_samples * signal->num_channels * (signal->bits_per_sample / 8);
+
+    fprintf(fp, "    {\n");
+    fprintf(fp, "      \"signal\": ");
+    LINNEBench_PrintJSONString(fp, signal->name);
+    fprintf(fp, ",\n");
+    fprintf(fp, "      \"synthetic\": %s,\n", signal->is_synthetic ? "true" : "false");
+    fprintf(fp, "      \"num_channels\": %u,\n", signal->num_channels);
+    fprintf(fp, "      \"sampling_rate\": %u,\n", signal->sampling_rate);
+    fprintf(fp, "      \"bits_per_sample\": %u,\n", signal->bits_per_sample);
+    fprintf(fp, "      \"num_samples\": %u,\n", signal->num_samples);
+    fprintf(fp, "      \"preset\": %u,\n", preset);
+    fprintf(fp, "      \"enable_learning\": %s,\n", enable_learning ? "true" : "false");
+    fprintf(fp, "      \"num_blocks\": %u,\n", result->num_blocks);
+    fprintf(fp, "      \"pcm_size\": %.0f,\n", pcm_size);
+    fprintf(fp, "      \"encoded_size\": %.0f,\n", (double)result->encoded_size);
+    fprintf(fp, "      \"compression_ratio\": %.6f,\n", (pcm_size > 0.0) ? ((double)result->encoded_size / pcm_size) : 0.0);
+    fprintf(fp, "      \"lossless\": %s,\n", result->is_lossless ? "true" : "false");
+    LINNEBench_PrintMeasureJSON(fp, "encode", signal, num_repeats, &result->encode);
+    fprintf(fp, ",\n");
+    LINNEBench_PrintMeasureJSON(fp, "decode", signal, num_repeats, &result->decode);
+    fprintf(fp, "\n    }");
+}
+
+/* 使用法の表示 */
+static void print_usage(char** argv)
+{
+    printf("Usage: %s [options] [INPUT_FILE_NAME.wav ...] \n", argv[0]);
+    printf("Measure in-memory encode/decode throughput of synthetic signals and input files, and print results in JSON. \n");
+}
+
+/* メインエントリ */
+int main(int argc, char** argv)
+{
+    const char* filename_ptr[LINNEBENCH_MAX_NUM_INPUT_FILES];
+    struct LINNEBenchSignal signals[LINNEBENCH_NUM_SYNTHETIC_SIGNALS + LINNEBENCH_MAX_NUM_INPUT_FILES];
+    uint32_t num_signals, num_samples, num_repeats, preset_begin, preset_end, preset, i;
+    uint8_t enable_learning, is_first;
+    FILE *out_fp;
+    int ret = 0;
+
+    for (i = 0; i < LINNEBENCH_MAX_NUM_INPUT_FILES; i++) {
+        filename_ptr[i] = NULL;
+    }
+
+    /* コマンドライン解析 */
+    if (CommandLineParser_ParseArguments(command_line_spec,
+                argc, (const char* const*)argv, filename_ptr, sizeof(filename_ptr) / sizeof(filename_ptr[0]))
+            != COMMAND_LINE_PARSER_RESULT_OK) {
+        return 1;
+    }
+
+    /* ヘルプの表示判定 */
+    if (CommandLineParser_GetOptionAcquired(command_line_spec, "help") == COMMAND_LINE_PARSER_TRUE) {
+        print_usage(argv);
+        printf("options: \n");
+        CommandLineParser_PrintDescription(command_line_spec);
+        return 0;
+    }
+
+    /* 計測するプリセットの範囲 */
+    preset_begin = 0;
+    preset_end = LINNE_NUM_PARAMETER_PRESETS;
+    if (CommandLineParser_GetOptionAcquired(command_line_spec, "mode") == COMMAND_LINE_PARSER_TRUE) {
+        char *e;
+        const char *lstr = CommandLineParser_GetArgumentString(command_line_spec, "mode");
+        preset_begin = (uint32_t)strtol(lstr, &e, 10);
+        if (*e != '\0') {
+            fprintf(stderr, "%s: invalid encode preset number. (irregular character found in %s at %s)\n", argv[0], lstr, e);
+            return 1;
+        }
+        if (preset_begin >= LINNE_NUM_PARAMETER_PRESETS) {
+            fprintf(stderr, "%s: encode preset number is out of range. \n", argv[0]);
+            return 1;
+        }
+        preset_end = preset_begin + 1;
+    }
+
+    /* 学習フラグを取得 */
+    enable_learning = 0;
+    if (CommandLineParser_GetOptionAcquired(command_line_spec, "enable-learning") == COMMAND_LINE_PARSER_TRUE) {
+        enable_learning = 1;
+    }
+
+    /* 合成信号の長さを取得 */
+    {
+        char *e;
+        const char *lstr = CommandLineParser_GetArgumentString(command_line_spec, "seconds");
+        const double seconds = strtod(lstr, &e);
+        if ((*e != '\0') || (seconds <= 0.0) || (seconds > 3600.0)) {
+            fprintf(stderr, "%s: invalid length of synthetic signals: %s \n", argv[0], lstr);
+            return 1;
+        }
+        num_samples = (uint32_t)(seconds * LINNEBENCH_SYNTHETIC_SAMPLING_RATE);
+    }
+
+    /* 繰り返し回数を取得 */
+    {
+        char *e;
+        const char *lstr = CommandLineParser_GetArgumentString(command_line_spec, "repeat");
+        const long num = strtol(lstr, &e, 10);
+        if ((*e != '\0') || (num < 1) || (num > 1000)) {
+            fprintf(stderr, "%s: invalid number of repetitions: %s \n", argv[0], lstr);
+            return 1;
+        }
+        num_repeats = (uint32_t)num;
+    }
+
+    /* 計測対象の信号を用意 */
+    num_signals = 0;
+    if (CommandLineParser_GetOptionAcquired(command_line_spec, "no-synthetic") != COMMAND_LINE_PARSER_TRUE) {
+        for (i = 0; i < LINNEBENCH_NUM_SYNTHETIC_SIGNALS; i++) {
+            if (LINNEBench_CreateSyntheticSignal(&signals[num_signals], i, num_samples) != 0) {
+                fprintf(stderr, "%s: failed to create synthetic signal. \n", argv[0]);
+                LINNEBench_DestroySignal(&signals[num_signals]);
+                ret = 1;
+                goto EXIT;
+            }
+            num_signals++;
+        }
+    }
+    for (i = 0; (i < LINNEBENCH_MAX_NUM_INPUT_FILES) && (filename_ptr[i] != NULL); i++) {
+        if (LINNEBench_CreateSignalFromFile(&signals[num_signals], filename_ptr[i]) != 0) {
+            ret = 1;
+            goto EXIT;
+        }
+        num_signals++;
+    }
+    if (num_signals == 0) {
+        fprintf(stderr, "%s: no signal to measure. \n", argv[0]);
+        return 1;
+    }
+
+    /* 出力先 */
+    out_fp = stdout;
+    if (CommandLineParser_GetOptionAcquired(command_line_spec, "output") == COMMAND_LINE_PARSER_TRUE) {
+        const char *out_filename = CommandLineParser_GetArgumentString(command_line_spec, "output");
+        if ((out_fp = fopen(out_filename, "w")) == NULL) {
+            fprintf(stderr, "%s: failed to open %s. \n", argv[0], out_filename);
+            ret = 1;
+            goto EXIT;
+        }
+    }
+
+    fprintf(out_fp, "{\n");
+    fprintf(out_fp, "  \"format_version\": %d,\n", LINNE_FORMAT_VERSION);
+    fprintf(out_fp, "  \"codec_version\": %d,\n", LINNE_CODEC_VERSION);
+    fprintf(out_fp, "  \"num_samples_per_block\": %d,\n", LINNEBENCH_NUM_SAMPLES_PER_BLOCK);
+    fprintf(out_fp, "  \"repeat\": %u,\n", num_repeats);
+    fprintf(out_fp, "  \"results\": [\n");
+
+    /* 信号とプリセットの組み合わせ毎に計測 進捗は標準エラー出力に表示 */
+    is_first = 1;
+    for (i = 0; i < num_signals; i++) {
+        for (preset = preset_begin; preset < preset_end; preset++) {
+            struct LINNEBenchResult result;
+            fprintf(stderr, "%s (mode %u)... ", signals[i].name, preset);
+            fflush(stderr);
+            if (LINNEBench_Measure(&signals[i], preset, enable_learning, num_repeats, &result) != 0) {
+                fprintf(stderr, "failed. \n");
+                ret = 1;
+            } else {
+                fprintf(stderr, "encode %.2f x realtime, decode %.2f x realtime, %6.2f %% \n",
+                        (double)signals[i].num_samples * num_repeats / signals[i].sampling_rate / LINNEBENCH_MAX(result.encode.total_time, 1.0e-9),
+                        (double)signals[i].num_samples * num_repeats / signals[i].sampling_rate / LINNEBENCH_MAX(result.decode.total_time, 1.0e-9),
+                        100.0 * (double)result.encoded_size
+                        / LINNEBENCH_MAX(1.0, (double)signals[i].num_samples * signals[i].num_channels * (signals[i].bits_per_sample / 8)));
+                if (!result.is_lossless) {
+                    fprintf(stderr, "%s (mode %u): decoded signal does not match the input! \n", signals[i].name, preset);
+                    ret = 1;
+                }
+                fprintf(out_fp, is_first ? "" : ",\n");
+                LINNEBench_PrintResultJSON(out_fp, &signals[i], preset, enable_learning, num_repeats, &result);
+                is_first = 0;
+            }
+            if (result.encode.block_latencies != NULL) {
+                free(result.encode.block_latencies);
+            }
+            if (result.decode.block_latencies != NULL) {
+                free(result.decode.block_latencies);
+            }
+        }
+    }
+
+    fprintf(out_fp, "\n  ]\n");
+    fprintf(out_fp, "}\n");
+    if (out_fp != stdout) {
+        fclose(out_fp);
+    }
+
+EXIT:
+    for (i = 0; i < num_signals; i++) {
+        LINNEBench_DestroySignal(&signals[i]);
+    }
+
+    return ret;
+}
@@ -1,16 +1,17 @@
 #ifndef LINNE_H_INCLUDED
 #define LINNE_H_INCLUDED
 
+#include <stddef.h>
 #include "linne_stdint.h"
 
 /* フォーマットバージョン */
-#define LINNE_FORMAT_VERSION        1
+#define LINNE_FORMAT_VERSION        2
 
 /* コーデックバージョン */
 #define LINNE_CODEC_VERSION         2
 
 /* ヘッダサイズ */
-#define LINNE_HEADER_SIZE           30
+#define LINNE_HEADER_SIZE           34
 
 /* 処理可能な最大チャンネル数 */
 #define LINNE_MAX_NUM_CHANNELS      8
@@ -18,6 +19,9 @@
 /* パラメータプリセット数 */
 #define LINNE_NUM_PARAMETER_PRESETS 8
 
+/* 総サンプル数が不明であることを示すヘッダの値（ストリーム出力でヘッダを書き直せなかった場合に残る） */
+#define LINNE_NUM_SAMPLES_UNKNOWN   UINT64_MAX
+
 /* API結果型 */
 typedef enum LINNEApiResultTag {
     LINNE_APIRESULT_OK = 0,                  /* 成功                         */
@@ -37,12 +41,22 @@ typedef enum LINNEChannelProcessMethodTag {
     LINNE_CH_PROCESS_METHOD_INVALID    /* 無効値         */
 } LINNEChannelProcessMethod;
 
+/* PCMサンプル形式 */
+/* 補足）整数形式はコンテナのビット幅に対してMSB詰め（フルスケール）の値として扱う */
+typedef enum LINNEPCMFormatTag {
+    LINNE_PCM_FORMAT_INT16 = 0,  /* 16bit符号付き整数                       */
+    LINNE_PCM_FORMAT_INT24,      /* 24bit符号付き整数（3byteリトルエンディアン） */
+    LINNE_PCM_FORMAT_INT32,      /* 32bit符号付き整数                       */
+    LINNE_PCM_FORMAT_FLOAT32,    /* [-1,1)に正規化した32bit浮動小数（デコーダ出力のみ） */
+    LINNE_PCM_FORMAT_INVALID     /* 無効値                                  */
+} LINNEPCMFormat;
+
 /* ヘッダ情報 */
 struct LINNEHeader {
     uint32_t format_version;                        /* フォーマットバージョン         */
     uint32_t codec_version;                         /* エンコーダバージョン           */
     uint16_t num_channels;                          /* チャンネル数                   */
-    uint32_t num_samples;                           /* 1チャンネルあたり総サンプル数  */
+    uint64_t num_samples;                           /* 1チャンネルあたり総サンプル数  */
     uint32_t sampling_rate;                         /* サンプリングレート             */
     uint16_t bits_per_sample;                       /* サンプルあたりビット数         */
     uint32_t num_samples_per_block;                 /* ブロックあたりサンプル数   */
@@ -50,4 +64,11 @@ struct LINNEHeader {
     LINNEChannelProcessMethod ch_process_method;    /* マルチチャンネル処理法         */
 };
 
+/* メモリアロケータ ハンドルのワーク領域を自前確保する時に使用 */
+struct LINNEAllocator {
+    void *(*malloc_func)(void *context, size_t size);   /* 領域確保関数 */
+    void (*free_func)(void *context, void *ptr);         /* 領域解放関数 */
+    void *context;                                      /* 各関数に渡すコンテキスト */
+};
+
 #endif /* LINNE_H_INCLUDED */
@@ -9,7 +9,21 @@ struct LINNEDecoderConfig {
     uint32_t max_num_channels; /* 最大チャンネル数 */
     uint32_t max_num_layers; /* 最大レイヤー数 */
     uint32_t max_num_parameters_per_layer; /* レイヤーあたり最大パラメータ数 */
+    uint32_t max_num_threads; /* チャンネル並列合成の最大スレッド数（0,1で並列化しない） */
+    uint32_t max_num_samples_per_block; /* PCM出力デコードの最大ブロックあたりサンプル数（0でPCM出力デコードを使わない） */
     uint8_t check_crc; /* CRCによるデータ破損検査を行うか？ 1:ON それ意外:OFF */
+    const struct LINNEAllocator *allocator; /* ワーク領域自前確保時のアロケータ（NULLでmalloc/free） */
+};
+
+/* デコーダ出力PCMバッファ */
+/* 補足）channels[ch]はチャンネルchの先頭サンプル、strideは同一チャンネル内で隣接するサンプル間のバイト数。 */
+/* 16bitステレオのインターリーブ出力はchannels[0] = buf, channels[1] = buf + 2, stride = 4 と指定する。 */
+/* 整数形式はMSB詰めで、デコードした値を(コンテナのビット幅 - bits_per_sample)ビット左シフトして書き出す。 */
+/* INT16, INT32, FLOAT32はホストのバイトオーダーで、各サンプルが型のアラインメントに合っていること。 */
+struct LINNEDecoderPCMOutput {
+    LINNEPCMFormat format; /* サンプル形式 */
+    void *channels[LINNE_MAX_NUM_CHANNELS]; /* 各チャンネルの先頭サンプル位置 */
+    uint32_t stride; /* 同一チャンネル内の隣接サンプル間のバイト数 */
 };
 
 /* デコーダハンドル */
@@ -49,6 +63,20 @@ LINNEApiResult LINNEDecoder_DecodeWhole(
         const uint8_t *data, uint32_t data_size,
         int32_t **buffer, uint32_t buffer_num_channels, uint32_t buffer_num_samples);
 
+/* 単一データブロックデコード（PCMバッファ出力） */
+/* 補足）出力形式への変換はデコーダの最終段で行う。コンフィグのmax_num_samples_per_blockを超えるブロックはデコードできない */
+LINNEApiResult LINNEDecoder_DecodeBlockPCM(
+        struct LINNEDecoder *decoder,
+        const uint8_t *data, uint32_t data_size,
+        const struct LINNEDecoderPCMOutput *output, uint32_t output_num_samples,
+        uint32_t *decode_size, uint32_t *num_decode_samples);
+
+/* ヘッダを含めて全ブロックデコード（PCMバッファ出力） */
+LINNEApiResult LINNEDecoder_DecodeWholePCM(
+        struct LINNEDecoder *decoder,
+        const uint8_t *data, uint32_t data_size,
+        const struct LINNEDecoderPCMOutput *output, uint32_t output_num_samples);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
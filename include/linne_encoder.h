@@ -22,6 +22,20 @@ struct LINNEEncoderConfig {
     uint32_t max_num_samples_per_block; /* 最大のブロックあたりサンプル数 */
     uint32_t max_num_layers; /* LPCNetの最大レイヤー数 */
     uint32_t max_num_parameters_per_layer; /* LPCNetのレイヤーあたり最大パラメータ数 */
+    uint32_t max_num_threads; /* チャンネル並列分析の最大スレッド数（0,1で並列化しない） */
+    const struct LINNEAllocator *allocator; /* ワーク領域自前確保時のアロケータ（NULLでmalloc/free） */
+};
+
+/* エンコーダ入力PCMバッファ */
+/* 補足）channels[ch]はチャンネルchの先頭サンプル、strideは同一チャンネル内で隣接するサンプル間のバイト数。 */
+/* 例えば16bitステレオのインターリーブ入力はchannels[0] = buf, channels[1] = buf + 2, stride = 4、 */
+/* チャンネル毎に分かれた（プレーナ）入力はchannels[ch] = plane[ch], stride = 2 と指定する。 */
+/* 整数形式の値はMSB詰めとして扱い、(コンテナのビット幅 - bits_per_sample)ビット右シフトした値をエンコードする。 */
+/* INT16とINT32はホストのバイトオーダーで、各サンプルが型のアラインメントに合っていること。 */
+struct LINNEEncoderPCMInput {
+    LINNEPCMFormat format; /* サンプル形式 */
+    const void *channels[LINNE_MAX_NUM_CHANNELS]; /* 各チャンネルの先頭サンプル位置 */
+    uint32_t stride; /* 同一チャンネル内の隣接サンプル間のバイト数 */
 };
 
 /* エンコーダハンドル */
@@ -35,6 +49,16 @@ extern "C" {
 LINNEApiResult LINNEEncoder_EncodeHeader(
     const struct LINNEHeader *header, uint8_t *data, uint32_t data_size);
 
+/* 単一データブロックエンコードの最大出力サイズ計算 */
+/* 補足）LINNEEncoder_EncodeBlockの出力はこのサイズを超えない */
+LINNEApiResult LINNEEncoder_CalculateMaxBlockSize(
+    const struct LINNEEncodeParameter *parameter, uint32_t *max_block_size);
+
+/* ヘッダ含めファイル全体をエンコードした時の最大出力サイズ計算 */
+/* 補足）LINNEEncoder_EncodeWholeの出力はこのサイズを超えない */
+LINNEApiResult LINNEEncoder_CalculateMaxOutputSize(
+    const struct LINNEEncodeParameter *parameter, uint32_t num_samples, uint32_t *max_output_size);
+
 /* エンコーダハンドル作成に必要なワークサイズ計算 */
 int32_t LINNEEncoder_CalculateWorkSize(const struct LINNEEncoderConfig *config);
 
@@ -60,6 +84,19 @@ LINNEApiResult LINNEEncoder_EncodeWhole(
     const int32_t *const *input, uint32_t num_samples,
     uint8_t *data, uint32_t data_size, uint32_t *output_size);
 
+/* 単一データブロックエンコード（PCMバッファ入力） */
+/* 補足）入力はエンコーダ内部バッファへの最初のコピーでチャンネル分離・32bit化する */
+LINNEApiResult LINNEEncoder_EncodeBlockPCM(
+        struct LINNEEncoder *encoder,
+        const struct LINNEEncoderPCMInput *input, uint32_t num_samples,
+        uint8_t *data, uint32_t data_size, uint32_t *output_size);
+
+/* ヘッダ含めファイル全体をエンコード（PCMバッファ入力） */
+LINNEApiResult LINNEEncoder_EncodeWholePCM(
+    struct LINNEEncoder *encoder,
+    const struct LINNEEncoderPCMInput *input, uint32_t num_samples,
+    uint8_t *data, uint32_t data_size, uint32_t *output_size);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -31,6 +31,13 @@
             (((uint32_t)((p_array)[3])) <<  0)\
             )
 
+/* 8バイト読み出し（ビッグエンディアン） */
+#define ByteArray_ReadUint64BE(p_array)\
+    (uint64_t)(\
+            (((uint64_t)ByteArray_ReadUint32BE(p_array)) << 32) |\
+            (((uint64_t)ByteArray_ReadUint32BE((p_array) + 4)) << 0)\
+            )
+
 /* 2バイト読み出し（リトルエンディアン） */
 #define ByteArray_ReadUint16LE(p_array)\
     (uint16_t)(\
@@ -83,6 +90,13 @@
         (p_array) += 4;\
     } while (0);
 
+/* 8バイト取得（ビッグエンディアン） */
+#define ByteArray_GetUint64BE(p_array, p_u64val)\
+    do {\
+        (*(p_u64val)) = ByteArray_ReadUint64BE(p_array);\
+        (p_array) += 8;\
+    } while (0);
+
 /* 2バイト取得（リトルエンディアン） */
 #define ByteArray_GetUint16LE(p_array, p_u16val)\
     do {\
@@ -134,6 +148,19 @@
         ((p_array)[3]) = (uint8_t)(((u32val) >>  0) & 0xFF);\
     } while (0);
 
+/* 8バイト書き出し（ビッグエンディアン） */
+#define ByteArray_WriteUint64BE(p_array, u64val)\
+    do {\
+        ((p_array)[0]) = (uint8_t)(((uint64_t)(u64val) >> 56) & 0xFF);\
+        ((p_array)[1]) = (uint8_t)(((uint64_t)(u64val) >> 48) & 0xFF);\
+        ((p_array)[2]) = (uint8_t)(((uint64_t)(u64val) >> 40) & 0xFF);\
+        ((p_array)[3]) = (uint8_t)(((uint64_t)(u64val) >> 32) & 0xFF);\
+        ((p_array)[4]) = (uint8_t)(((uint64_t)(u64val) >> 24) & 0xFF);\
+        ((p_array)[5]) = (uint8_t)(((uint64_t)(u64val) >> 16) & 0xFF);\
+        ((p_array)[6]) = (uint8_t)(((uint64_t)(u64val) >>  8) & 0xFF);\
+        ((p_array)[7]) = (uint8_t)(((uint64_t)(u64val) >>  0) & 0xFF);\
+    } while (0);
+
 /* 2バイト書き出し（リトルエンディアン） */
 #define ByteArray_WriteUint16LE(p_array, u16val)\
     do {\
@@ -186,6 +213,13 @@
         (p_array) += 4;\
     } while (0);
 
+/* 8バイト出力（ビッグエンディアン） */
+#define ByteArray_PutUint64BE(p_array, u64val)\
+    do {\
+        ByteArray_WriteUint64BE(p_array, u64val);\
+        (p_array) += 8;\
+    } while (0);
+
 /* 2バイト出力（リトルエンディアン） */
 #define ByteArray_PutUint16LE(p_array, u16val)\
     do {\
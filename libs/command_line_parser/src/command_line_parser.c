@@ -265,8 +265,9 @@ CommandLineParserResult CommandLineParser_ParseArguments(
                 fprintf(stderr, "%s: Unknown long option - \"%s\" \n", argv[0], &arg_str[2]);
                 return COMMAND_LINE_PARSER_RESULT_UNKNOWN_OPTION;
             }
-        } else if (arg_str[0] == '-') {
+        } else if ((arg_str[0] == '-') && (arg_str[1] != '\0')) {
             /* ショートオプション（の連なり） */
+            /* 補足）単独の'-'は標準入出力を表す文字列として扱うためここに来ない */
             uint32_t str_index;
             for (str_index = 1; arg_str[str_index] != '\0'; str_index++) {
                 for (spec_no = 0; spec_no < num_specs; spec_no++) {
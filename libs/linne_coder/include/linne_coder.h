@@ -2,11 +2,21 @@
 #define LINNECODER_H_INCLUDED
 
 #include <stdint.h>
+#include "linne.h"
 #include "bit_stream.h"
 
 /* 符号化ハンドル */
 struct LINNECoder;
 
+/* 逐次復号の状態 */
+struct LINNECoderDecodeState {
+    uint32_t nsmpls_per_part; /* 分割あたりサンプル数 */
+    uint32_t num_parts; /* 分割数 */
+    uint32_t part; /* 次に読む分割のインデックス */
+    uint32_t remain; /* 現在の分割の残りサンプル数 */
+    uint32_t k2; /* 現在の分割の符号パラメータ */
+};
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -14,8 +24,8 @@ extern "C" {
 /* 符号化ハンドルの作成に必要なワークサイズの計算 */
 int32_t LINNECoder_CalculateWorkSize(void);
 
-/* 符号化ハンドルの作成 */
-struct LINNECoder* LINNECoder_Create(void *work, int32_t work_size);
+/* 符号化ハンドルの作成 allocatorはワーク領域自前確保時に使用（NULLでmalloc/free） */
+struct LINNECoder* LINNECoder_Create(const struct LINNEAllocator *allocator, void *work, int32_t work_size);
 
 /* 符号化ハンドルの破棄 */
 void LINNECoder_Destroy(struct LINNECoder *coder);
@@ -23,9 +33,25 @@ void LINNECoder_Destroy(struct LINNECoder *coder);
 /* 符号付き整数配列の符号化 */
 void LINNECoder_Encode(struct LINNECoder *coder, struct BitStream *stream, const int32_t *data, uint32_t num_samples);
 
+/* 分割次数を指定した符号付き整数配列の符号化 */
+/* 補足）partition_orderにLINNECoder_CalculateCodeLengthで得た値を渡すと、分割の探索を省いて同じ符号を出力する */
+void LINNECoder_EncodeWithPartitionOrder(
+        struct LINNECoder *coder, struct BitStream *stream, const int32_t *data, uint32_t num_samples, uint32_t partition_order);
+
+/* 符号付き整数配列を符号化した時の符号長[bit]の計算 partition_orderに最適な分割次数を取得（NULLで取得しない） */
+uint32_t LINNECoder_CalculateCodeLength(
+        struct LINNECoder *coder, const int32_t *data, uint32_t num_samples, uint32_t *partition_order);
+
 /* 符号付き整数配列の復号 */
 void LINNECoder_Decode(struct BitStream *stream, int32_t *data, uint32_t num_samples);
 
+/* 逐次復号の開始 num_samplesは復号する総サンプル数 */
+void LINNECoder_BeginDecode(struct BitStream *stream, struct LINNECoderDecodeState *state, uint32_t num_samples);
+
+/* 逐次復号 続きのnum_samples分を復号 */
+void LINNECoder_DecodeSamples(
+        struct BitStream *stream, struct LINNECoderDecodeState *state, int32_t *data, uint32_t num_samples);
+
 #ifdef __cplusplus
 }
 #endif
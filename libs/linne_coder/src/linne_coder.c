@@ -2,6 +2,7 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <math.h>
 #include <float.h>
 
@@ -19,6 +20,7 @@
 struct LINNECoder {
     uint8_t alloced_by_own;
     double part_mean[LINNECODER_LOG2_MAX_NUM_PARTITIONS + 1][LINNECODER_MAX_NUM_PARTITIONS];
+    struct LINNEAllocator allocator;
     void *work;
 };
 
@@ -34,7 +36,7 @@ int32_t LINNECoder_CalculateWorkSize(void)
 }
 
 /* 符号化ハンドルの作成 */
-struct LINNECoder* LINNECoder_Create(void *work, int32_t work_size)
+struct LINNECoder* LINNECoder_Create(const struct LINNEAllocator *allocator, void *work, int32_t work_size)
 {
     struct LINNECoder *coder;
     uint8_t tmp_alloc_by_own = 0;
@@ -46,7 +48,10 @@ struct LINNECoder* LINNECoder_Create(void *work, int32_t work_size)
         if ((work_size = LINNECoder_CalculateWorkSize()) < 0) {
             return NULL;
         }
-        work = malloc((uint32_t)work_size);
+        if (!LINNEUtility_CheckAllocator(allocator)) {
+            return NULL;
+        }
+        work = LINNEUtility_Allocate(allocator, (uint32_t)work_size);
         tmp_alloc_by_own = 1;
     }
 
@@ -66,6 +71,11 @@ struct LINNECoder* LINNECoder_Create(void *work, int32_t work_size)
     /* ハンドルメンバ設定 */
     coder->alloced_by_own = tmp_alloc_by_own;
     coder->work = work;
+    if (allocator != NULL) {
+        coder->allocator = (*allocator);
+    } else {
+        memset(&coder->allocator, 0, sizeof(struct LINNEAllocator));
+    }
 
     return coder;
 }
@@ -76,7 +86,7 @@ void LINNECoder_Destroy(struct LINNECoder *coder)
     if (coder != NULL) {
         /* 自前確保していたら領域開放 */
         if (coder->alloced_by_own == 1) {
-            free(coder->work);
+            LINNEUtility_Free(&coder->allocator, coder->work);
         }
     }
 }
@@ -213,46 +223,61 @@ static uint32_t RecursiveRice_GetCodeLength(uint32_t k1, uint32_t k2, uint32_t u
     }
 }
 
-/* 符号付き整数配列の符号化 */
-static void LINNECoder_EncodePartitionedRecursiveRice(struct LINNECoder *coder, struct BitStream *stream, const int32_t *data, uint32_t num_samples)
+/* 最大の分割次数の計算 */
+static uint32_t LINNECoder_CalculateMaxPartitionOrder(uint32_t num_samples)
 {
-    uint32_t max_porder, max_num_partitions;
-    uint32_t porder, part, best_porder, smpl;
+    uint32_t max_porder;
 
-    /* 最大分割数の決定 */
     max_porder = 1;
     while ((num_samples % (1 << max_porder)) == 0) {
         max_porder++;
     }
-    max_porder = LINNEUTILITY_MIN(max_porder - 1, LINNECODER_LOG2_MAX_NUM_PARTITIONS);
-    max_num_partitions = (1 << max_porder);
 
-    /* 各分割での平均を計算 */
-    {
-        int32_t i;
+    return LINNEUTILITY_MIN(max_porder - 1, LINNECODER_LOG2_MAX_NUM_PARTITIONS);
+}
 
-        /* 最も細かい分割時の平均値 */
-        for (part = 0; part < max_num_partitions; part++) {
-            const uint32_t nsmpl = num_samples / max_num_partitions;
-            double part_sum = 0.0;
-            for (smpl = 0; smpl < nsmpl; smpl++) {
-                part_sum += LINNEUTILITY_SINT32_TO_UINT32(data[part * nsmpl + smpl]);
-            }
-            coder->part_mean[max_porder][part] = part_sum / nsmpl;
+/* 各分割での平均の計算 */
+/* 補足）符号化パラメータは平均から決まるため、探索時と符号化時で同じ手順で計算すること */
+static void LINNECoder_CalculatePartitionMean(
+        struct LINNECoder *coder, const int32_t *data, uint32_t num_samples, uint32_t max_porder)
+{
+    int32_t i;
+    uint32_t part, smpl;
+    const uint32_t max_num_partitions = (1 << max_porder);
+
+    /* 最も細かい分割時の平均値 */
+    for (part = 0; part < max_num_partitions; part++) {
+        const uint32_t nsmpl = num_samples / max_num_partitions;
+        double part_sum = 0.0;
+        for (smpl = 0; smpl < nsmpl; smpl++) {
+            part_sum += LINNEUTILITY_SINT32_TO_UINT32(data[part * nsmpl + smpl]);
         }
+        coder->part_mean[max_porder][part] = part_sum / nsmpl;
+    }
 
-        /* より大きい分割の平均は、小さい分割の平均をマージして計算 */
-        for (i = (int32_t)(max_porder - 1); i >= 0; i--) {
-            for (part = 0; part < (1 << i); part++) {
-                coder->part_mean[i][part] = (coder->part_mean[i + 1][2 * part] + coder->part_mean[i + 1][2 * part + 1]) / 2.0;
-            }
+    /* より大きい分割の平均は、小さい分割の平均をマージして計算 */
+    for (i = (int32_t)(max_porder - 1); i >= 0; i--) {
+        for (part = 0; part < (1 << i); part++) {
+            coder->part_mean[i][part] = (coder->part_mean[i + 1][2 * part] + coder->part_mean[i + 1][2 * part + 1]) / 2.0;
         }
     }
+}
+
+/* 最適な分割数の探索 最適な分割での符号長[bit]を返す */
+static uint32_t LINNECoder_SearchOptimalPartitionOrder(
+        struct LINNECoder *coder, const int32_t *data, uint32_t num_samples, uint32_t *best_porder)
+{
+    uint32_t max_porder;
+    uint32_t porder, part, smpl;
+    uint32_t min_bits = UINT32_MAX;
+
+    /* 各分割での平均を計算 */
+    max_porder = LINNECoder_CalculateMaxPartitionOrder(num_samples);
+    LINNECoder_CalculatePartitionMean(coder, data, num_samples, max_porder);
 
     /* 各分割での符号長を計算し、最適な分割を探索 */
     {
-        uint32_t min_bits = UINT32_MAX;
-        best_porder = 0;
+        (*best_porder) = 0;
         for (porder = 0; porder <= max_porder; porder++) {
             const uint32_t nsmpl = (num_samples >> porder);
             uint32_t k1, k2, prevk2;
@@ -273,12 +298,22 @@ static void LINNECoder_EncodePartitionedRecursiveRice(struct LINNECoder *coder,
             }
             if (min_bits > bits) {
                 min_bits = bits;
-                best_porder = porder;
+                (*best_porder) = porder;
             }
         }
     }
 
-    /* 最適な分割を用いて符号化 */
+    /* 分割数の符号長を加える */
+    return min_bits + LINNECODER_LOG2_MAX_NUM_PARTITIONS;
+}
+
+/* 符号付き整数配列の符号化 各分割での平均は計算済みであること */
+static void LINNECoder_EncodePartitionedRecursiveRice(
+        struct LINNECoder *coder, struct BitStream *stream, const int32_t *data, uint32_t num_samples, uint32_t best_porder)
+{
+    uint32_t part;
+
+    /* 指定された分割を用いて符号化 */
     {
         uint32_t smpl, k1, k2, prevk2;
         const uint32_t nsmpl = num_samples >> best_porder;
@@ -302,44 +337,130 @@ static void LINNECoder_EncodePartitionedRecursiveRice(struct LINNECoder *coder,
     }
 }
 
-/* 符号付き整数配列の復号 */
-static void LINNECoder_DecodePartitionedRecursiveRice(struct BitStream *stream, int32_t *data, uint32_t num_samples)
+/* 逐次復号の開始 */
+static void LINNECoder_BeginDecodePartitionedRecursiveRice(
+        struct BitStream *stream, struct LINNECoderDecodeState *state, uint32_t num_samples)
 {
-    uint32_t smpl, part, nsmpl, best_porder;
-    uint32_t k1, k2;
+    uint32_t best_porder;
 
     BitReader_GetBits(stream, &best_porder, LINNECODER_LOG2_MAX_NUM_PARTITIONS);
 
-    nsmpl = num_samples >> best_porder;
-    for (part = 0; part < (1 << best_porder); part++) {
-        if (part == 0) {
-            BitReader_GetBits(stream, &k2, LINNECODER_RICE_PARAMETER_BITS);
-        } else {
-            const uint32_t udiff = Gamma_GetCode(stream);
-            k2 = (uint32_t)((int32_t)k2 + LINNEUTILITY_UINT32_TO_SINT32(udiff));
+    state->nsmpls_per_part = num_samples >> best_porder;
+    state->num_parts = 1U << best_porder;
+    state->part = 0;
+    state->remain = 0;
+    state->k2 = 0;
+}
+
+/* 符号付き整数配列の逐次復号 */
+static void LINNECoder_DecodeSamplesPartitionedRecursiveRice(
+        struct BitStream *stream, struct LINNECoderDecodeState *state, int32_t *data, uint32_t num_samples)
+{
+    uint32_t smpl, k1, k2;
+
+    k2 = state->k2;
+    while (num_samples > 0) {
+        uint32_t nsmpl;
+        /* 分割の先頭で符号パラメータを読む */
+        if (state->remain == 0) {
+            /* 全分割を読み終えた（不正なデータ） */
+            if (state->part >= state->num_parts) {
+                break;
+            }
+            if (state->part == 0) {
+                BitReader_GetBits(stream, &k2, LINNECODER_RICE_PARAMETER_BITS);
+            } else {
+                const uint32_t udiff = Gamma_GetCode(stream);
+                k2 = (uint32_t)((int32_t)k2 + LINNEUTILITY_UINT32_TO_SINT32(udiff));
+            }
+            state->part++;
+            state->remain = state->nsmpls_per_part;
         }
         k1 = k2 + 1;
+        nsmpl = LINNEUTILITY_MIN(state->remain, num_samples);
         for (smpl = 0; smpl < nsmpl; smpl++) {
             const uint32_t uval = RecursiveRice_GetCode(stream, k1, k2);
-            data[part * nsmpl + smpl] = LINNEUTILITY_UINT32_TO_SINT32(uval);
+            data[smpl] = LINNEUTILITY_UINT32_TO_SINT32(uval);
         }
+        data += nsmpl;
+        num_samples -= nsmpl;
+        state->remain -= nsmpl;
     }
+    state->k2 = k2;
 }
 
 /* 符号付き整数配列の符号化 */
 void LINNECoder_Encode(struct LINNECoder *coder, struct BitStream *stream, const int32_t *data, uint32_t num_samples)
 {
+    uint32_t best_porder;
+
     LINNE_ASSERT((stream != NULL) && (data != NULL) && (coder != NULL));
     LINNE_ASSERT(num_samples != 0);
 
-    LINNECoder_EncodePartitionedRecursiveRice(coder, stream, data, num_samples);
+    /* 最適な分割を探索して符号化 */
+    (void)LINNECoder_SearchOptimalPartitionOrder(coder, data, num_samples, &best_porder);
+    LINNECoder_EncodePartitionedRecursiveRice(coder, stream, data, num_samples, best_porder);
+}
+
+/* 分割次数を指定した符号付き整数配列の符号化 */
+void LINNECoder_EncodeWithPartitionOrder(
+        struct LINNECoder *coder, struct BitStream *stream, const int32_t *data, uint32_t num_samples, uint32_t partition_order)
+{
+    const uint32_t max_porder = LINNECoder_CalculateMaxPartitionOrder(num_samples);
+
+    LINNE_ASSERT((stream != NULL) && (data != NULL) && (coder != NULL));
+    LINNE_ASSERT(num_samples != 0);
+    LINNE_ASSERT(partition_order <= max_porder);
+
+    /* 探索は省き、平均だけ求め直して符号化 */
+    LINNECoder_CalculatePartitionMean(coder, data, num_samples, max_porder);
+    LINNECoder_EncodePartitionedRecursiveRice(coder, stream, data, num_samples, partition_order);
+}
+
+/* 符号付き整数配列を符号化した時の符号長[bit]の計算 */
+uint32_t LINNECoder_CalculateCodeLength(
+        struct LINNECoder *coder, const int32_t *data, uint32_t num_samples, uint32_t *partition_order)
+{
+    uint32_t best_porder, bits;
+
+    LINNE_ASSERT((data != NULL) && (coder != NULL));
+    LINNE_ASSERT(num_samples != 0);
+
+    bits = LINNECoder_SearchOptimalPartitionOrder(coder, data, num_samples, &best_porder);
+
+    if (partition_order != NULL) {
+        (*partition_order) = best_porder;
+    }
+
+    return bits;
 }
 
 /* 符号付き整数配列の復号 */
 void LINNECoder_Decode(struct BitStream *stream, int32_t *data, uint32_t num_samples)
 {
+    struct LINNECoderDecodeState state;
+
     LINNE_ASSERT((stream != NULL) && (data != NULL));
     LINNE_ASSERT(num_samples != 0);
 
-    LINNECoder_DecodePartitionedRecursiveRice(stream, data, num_samples);
+    LINNECoder_BeginDecodePartitionedRecursiveRice(stream, &state, num_samples);
+    LINNECoder_DecodeSamplesPartitionedRecursiveRice(stream, &state, data, num_samples);
+}
+
+/* 逐次復号の開始 */
+void LINNECoder_BeginDecode(struct BitStream *stream, struct LINNECoderDecodeState *state, uint32_t num_samples)
+{
+    LINNE_ASSERT((stream != NULL) && (state != NULL));
+    LINNE_ASSERT(num_samples != 0);
+
+    LINNECoder_BeginDecodePartitionedRecursiveRice(stream, state, num_samples);
+}
+
+/* 逐次復号 */
+void LINNECoder_DecodeSamples(
+        struct BitStream *stream, struct LINNECoderDecodeState *state, int32_t *data, uint32_t num_samples)
+{
+    LINNE_ASSERT((stream != NULL) && (state != NULL) && (data != NULL));
+
+    LINNECoder_DecodeSamplesPartitionedRecursiveRice(stream, state, data, num_samples);
 }
@@ -10,6 +10,7 @@
 #include "bit_stream.h"
 #include "lpc.h"
 #include "static_huffman.h"
+#include "thread_pool.h"
 
 /* 内部状態フラグ */
 #define LINNEDECODER_STATUS_FLAG_ALLOCED_BY_OWN  (1 << 0)  /* 領域を自己割当した */
@@ -21,19 +22,34 @@
 #define LINNEDECODER_CLEAR_STATUS_FLAG(decoder, flag)  ((decoder->status_flags) &= ~(flag))
 #define LINNEDECODER_GET_STATUS_FLAG(decoder, flag)    ((decoder->status_flags) & (flag))
 
+/* 1チャンネル分の合成タスク */
+struct LINNEDecoderSynthesizeTask {
+    struct LINNEDecoder *decoder; /* デコーダハンドル */
+    uint32_t ch; /* 合成するチャンネル */
+    int32_t **buffer; /* 出力先バッファ */
+    uint32_t num_decode_samples; /* デコードサンプル数 */
+};
+
 /* デコーダハンドル */
 struct LINNEDecoder {
     struct LINNEHeader header; /* ヘッダ */
     uint32_t max_num_channels; /* デコード可能な最大チャンネル数 */
     uint32_t max_num_layers; /* 最大レイヤー数 */
     uint32_t max_num_parameters_per_layer; /* 最大レイヤーあたりパラメータ数 */
+    uint32_t max_num_samples_per_block; /* PCM出力デコードの最大ブロックあたりサンプル数 */
+    uint32_t num_workers; /* チャンネル合成のワーカ数 */
     struct LINNEPreemphasisFilter **de_emphasis; /* デエンファシスフィルタ */
     int32_t ***params_int; /* LPC係数(int) */
     uint32_t **num_units; /* 各層のユニット数 */
     uint32_t **rshifts; /* 各層のLPC係数右シフト量 */
+    int32_t ***cascade_buffers; /* 多段合成の層毎のタイルバッファ（ワーカ毎） */
+    struct ThreadPool *thread_pool; /* チャンネル合成のスレッドプール */
+    struct LINNEDecoderSynthesizeTask *tasks; /* チャンネル毎の合成タスク */
+    int32_t **pcm_buffer; /* PCM出力デコードの信号バッファ */
     const struct LINNEParameterPreset *parameter_preset; /* パラメータプリセット */
     struct StaticHuffmanTree coef_tree; /* 係数ハフマン木 */
     uint8_t status_flags; /* 内部状態フラグ */
+    struct LINNEAllocator allocator; /* 自前確保に使ったアロケータ */
     void *work; /* ワーク領域先頭ポインタ */
 };
 
@@ -48,19 +64,22 @@ static LINNEApiResult LINNEDecoder_DecodeCompressData(
         struct LINNEDecoder *decoder,
         const uint8_t *data, uint32_t data_size,
         int32_t **buffer, uint32_t num_channels, uint32_t num_decode_samples,
-        uint32_t *decode_size);
+        const struct LINNEDecoderPCMOutput *output, uint32_t *decode_size);
 /* 無音データブロックデコード */
 static LINNEApiResult LINNEDecoder_DecodeSilentData(
         struct LINNEDecoder *decoder,
         const uint8_t *data, uint32_t data_size,
         int32_t **buffer, uint32_t num_channels, uint32_t num_decode_samples,
         uint32_t *decode_size);
+/* ワーカ数の計算 */
+static uint32_t LINNEDecoder_CalculateNumWorkers(const struct LINNEDecoderConfig *config);
 
 /* ヘッダデコード */
 LINNEApiResult LINNEDecoder_DecodeHeader(
         const uint8_t *data, uint32_t data_size, struct LINNEHeader *header)
 {
     const uint8_t *data_pos;
+    uint64_t u64buf;
     uint32_t u32buf;
     uint16_t u16buf;
     uint8_t  u8buf;
@@ -104,8 +123,8 @@ LINNEApiResult LINNEDecoder_DecodeHeader(
     ByteArray_GetUint16BE(data_pos, &u16buf);
     tmp_header.num_channels = u16buf;
     /* サンプル数 */
-    ByteArray_GetUint32BE(data_pos, &u32buf);
-    tmp_header.num_samples = u32buf;
+    ByteArray_GetUint64BE(data_pos, &u64buf);
+    tmp_header.num_samples = u64buf;
     /* サンプリングレート */
     ByteArray_GetUint32BE(data_pos, &u32buf);
     tmp_header.sampling_rate = u32buf;
@@ -187,6 +206,7 @@ static LINNEError LINNEDecoder_CheckHeaderFormat(const struct LINNEHeader *heade
 int32_t LINNEDecoder_CalculateWorkSize(const struct LINNEDecoderConfig *config)
 {
     int32_t work_size;
+    uint32_t num_workers;
 
     /* 引数チェック */
     if (config == NULL) {
@@ -200,17 +220,39 @@ int32_t LINNEDecoder_CalculateWorkSize(const struct LINNEDecoderConfig *config)
         return -1;
     }
 
+    /* ワーカ数 */
+    num_workers = LINNEDecoder_CalculateNumWorkers(config);
+
     /* 構造体サイズ（+メモリアラインメント） */
     work_size = sizeof(struct LINNEDecoder) + LINNE_MEMORY_ALIGNMENT;
     /* デエンファシスフィルタのサイズ */
-    work_size += LINNE_CALCULATE_2DIMARRAY_WORKSIZE(struct LINNEPreemphasisFilter, config->max_num_channels, LINNE_NUM_PREEMPHASIS_FILTERS);
+    work_size += (int32_t)LINNE_CALCULATE_2DIMARRAY_WORKSIZE(struct LINNEPreemphasisFilter, (size_t)config->max_num_channels, LINNE_NUM_PREEMPHASIS_FILTERS);
     /* パラメータ領域 */
     /* LPC係数(int) */
-    work_size += LINNE_CALCULATE_3DIMARRAY_WORKSIZE(int32_t, config->max_num_channels, config->max_num_layers, config->max_num_parameters_per_layer);
+    work_size += (int32_t)LINNE_CALCULATE_3DIMARRAY_WORKSIZE(int32_t, (size_t)config->max_num_channels, (size_t)config->max_num_layers, (size_t)config->max_num_parameters_per_layer);
     /* 各層のユニット数 */
-    work_size += LINNE_CALCULATE_2DIMARRAY_WORKSIZE(uint32_t, config->max_num_channels, config->max_num_layers);
+    work_size += (int32_t)LINNE_CALCULATE_2DIMARRAY_WORKSIZE(uint32_t, (size_t)config->max_num_channels, (size_t)config->max_num_layers);
     /* 各層のLPC係数右シフト量 */
-    work_size += LINNE_CALCULATE_2DIMARRAY_WORKSIZE(uint32_t, config->max_num_channels, config->max_num_layers);
+    work_size += (int32_t)LINNE_CALCULATE_2DIMARRAY_WORKSIZE(uint32_t, (size_t)config->max_num_channels, (size_t)config->max_num_layers);
+    /* 多段合成のタイルバッファ */
+    work_size += (int32_t)LINNE_CALCULATE_3DIMARRAY_WORKSIZE(int32_t, (size_t)num_workers, (size_t)config->max_num_layers, (size_t)config->max_num_parameters_per_layer + LINNELPC_CASCADE_TILE_SIZE);
+    /* スレッドプールと合成タスク */
+    {
+        int32_t pool_size;
+        struct ThreadPoolConfig pool_config;
+        pool_config.max_num_threads = num_workers;
+        pool_config.max_num_tasks = config->max_num_channels;
+        pool_config.allocator = NULL;
+        if ((pool_size = ThreadPool_CalculateWorkSize(&pool_config)) < 0) {
+            return -1;
+        }
+        work_size += pool_size;
+    }
+    work_size += (int32_t)(config->max_num_channels * sizeof(struct LINNEDecoderSynthesizeTask)) + LINNE_MEMORY_ALIGNMENT;
+    /* PCM出力デコードの信号バッファ */
+    if (config->max_num_samples_per_block > 0) {
+        work_size += (int32_t)LINNE_CALCULATE_2DIMARRAY_WORKSIZE(int32_t, (size_t)config->max_num_channels, (size_t)config->max_num_samples_per_block);
+    }
 
     return work_size;
 }
@@ -228,13 +270,19 @@ struct LINNEDecoder *LINNEDecoder_Create(const struct LINNEDecoderConfig *config
         if ((work_size = LINNEDecoder_CalculateWorkSize(config)) < 0) {
             return NULL;
         }
-        work = malloc((uint32_t)work_size);
+        if (!LINNEUtility_CheckAllocator(config->allocator)) {
+            return NULL;
+        }
+        work = LINNEUtility_Allocate(config->allocator, (uint32_t)work_size);
         tmp_alloc_by_own = 1;
     }
 
     /* 引数チェック */
     if ((config == NULL) || (work == NULL)
             || (work_size < LINNEDecoder_CalculateWorkSize(config))) {
+        if ((tmp_alloc_by_own == 1) && (work != NULL)) {
+            LINNEUtility_Free(config->allocator, work);
+        }
         return NULL;
     }
 
@@ -242,7 +290,7 @@ struct LINNEDecoder *LINNEDecoder_Create(const struct LINNEDecoderConfig *config
     if ((config->max_num_channels == 0)
             || (config->max_num_layers == 0)
             || (config->max_num_parameters_per_layer == 0)) {
-        return NULL;
+        goto EXIT_FAILURE_WITH_WORK_RELEASE;
     }
 
     /* ワーク領域先頭ポインタ取得 */
@@ -255,9 +303,16 @@ struct LINNEDecoder *LINNEDecoder_Create(const struct LINNEDecoderConfig *config
 
     /* 構造体メンバセット */
     decoder->work = work;
+    if (config->allocator != NULL) {
+        decoder->allocator = (*config->allocator);
+    } else {
+        memset(&decoder->allocator, 0, sizeof(struct LINNEAllocator));
+    }
     decoder->max_num_channels = config->max_num_channels;
     decoder->max_num_layers = config->max_num_layers;
     decoder->max_num_parameters_per_layer = config->max_num_parameters_per_layer;
+    decoder->max_num_samples_per_block = config->max_num_samples_per_block;
+    decoder->num_workers = LINNEDecoder_CalculateNumWorkers(config);
     decoder->status_flags = 0;  /* 状態クリア */
     if (tmp_alloc_by_own == 1) {
         LINNEDECODER_SET_STATUS_FLAG(decoder, LINNEDECODER_STATUS_FLAG_ALLOCED_BY_OWN);
@@ -280,6 +335,34 @@ struct LINNEDecoder *LINNEDecoder_Create(const struct LINNEDecoderConfig *config
     /* 各層のLPC係数右シフト量 */
     LINNE_ALLOCATE_2DIMARRAY(decoder->rshifts,
             work_ptr, uint32_t, config->max_num_channels, config->max_num_layers);
+    /* 多段合成のタイルバッファ */
+    LINNE_ALLOCATE_3DIMARRAY(decoder->cascade_buffers,
+            work_ptr, int32_t, decoder->num_workers, config->max_num_layers, config->max_num_parameters_per_layer + LINNELPC_CASCADE_TILE_SIZE);
+    /* 合成タスク */
+    work_ptr = (uint8_t *)LINNEUTILITY_ROUNDUP((uintptr_t)work_ptr, LINNE_MEMORY_ALIGNMENT);
+    decoder->tasks = (struct LINNEDecoderSynthesizeTask *)work_ptr;
+    work_ptr += config->max_num_channels * sizeof(struct LINNEDecoderSynthesizeTask);
+    /* PCM出力デコードの信号バッファ */
+    decoder->pcm_buffer = NULL;
+    if (config->max_num_samples_per_block > 0) {
+        LINNE_ALLOCATE_2DIMARRAY(decoder->pcm_buffer,
+                work_ptr, int32_t, config->max_num_channels, config->max_num_samples_per_block);
+    }
+
+    /* スレッドプールの作成 */
+    /* 補足）作成に失敗した時にスレッドが残らないよう最後に作る */
+    {
+        int32_t pool_size;
+        struct ThreadPoolConfig pool_config;
+        pool_config.max_num_threads = decoder->num_workers;
+        pool_config.max_num_tasks = config->max_num_channels;
+        pool_config.allocator = NULL;
+        pool_size = ThreadPool_CalculateWorkSize(&pool_config);
+        if ((decoder->thread_pool = ThreadPool_Create(&pool_config, work_ptr, pool_size)) == NULL) {
+            goto EXIT_FAILURE_WITH_WORK_RELEASE;
+        }
+        work_ptr += pool_size;
+    }
 
     /* バッファオーバーランチェック */
     /* 補足）既にメモリを破壊している可能性があるので、チェックに失敗したら落とす */
@@ -293,14 +376,22 @@ struct LINNEDecoder *LINNEDecoder_Create(const struct LINNEDecoderConfig *config
     }
 
     return decoder;
+
+EXIT_FAILURE_WITH_WORK_RELEASE:
+    /* 自前確保した領域を解放 */
+    if (tmp_alloc_by_own == 1) {
+        LINNEUtility_Free(config->allocator, work);
+    }
+    return NULL;
 }
 
 /* デコーダハンドルの破棄 */
 void LINNEDecoder_Destroy(struct LINNEDecoder *decoder)
 {
     if (decoder != NULL) {
+        ThreadPool_Destroy(decoder->thread_pool);
         if (LINNEDECODER_GET_STATUS_FLAG(decoder, LINNEDECODER_STATUS_FLAG_ALLOCED_BY_OWN)) {
-            free(decoder->work);
+            LINNEUtility_Free(&decoder->allocator, decoder->work);
         }
     }
 }
@@ -426,12 +517,175 @@ static LINNEApiResult LINNEDecoder_DecodeRawData(
     return LINNE_APIRESULT_OK;
 }
 
+/* 1チャンネル分の信号の区間をPCM出力バッファに書き出し */
+/* 補足）ストライドが奇数のこともあるため、整数・浮動小数の書き込みはmemcpyでアラインメントに依らず行う */
+static void LINNEDecoder_StoreChannel(
+        const struct LINNEDecoder *decoder, const struct LINNEDecoderPCMOutput *output,
+        uint32_t ch, const int32_t *buffer, uint32_t head, uint32_t num_samples)
+{
+    uint32_t smpl, lshift;
+    uint8_t *dst;
+    const int32_t *src;
+    const struct LINNEHeader *header;
+
+    /* 内部関数なので不正な引数はアサートで落とす */
+    LINNE_ASSERT(decoder != NULL);
+    LINNE_ASSERT(output != NULL);
+    LINNE_ASSERT(buffer != NULL);
+
+    header = &(decoder->header);
+    dst = (uint8_t *)output->channels[ch] + (size_t)head * output->stride;
+    src = &buffer[head];
+    lshift = 8 * LINNEUtility_GetPCMFormatByteSize(output->format) - header->bits_per_sample;
+
+    switch (output->format) {
+    case LINNE_PCM_FORMAT_INT16:
+        for (smpl = 0; smpl < num_samples; smpl++) {
+            const int16_t sval = (int16_t)((uint32_t)src[smpl] << lshift);
+            memcpy(dst, &sval, sizeof(int16_t));
+            dst += output->stride;
+        }
+        break;
+    case LINNE_PCM_FORMAT_INT24:
+        for (smpl = 0; smpl < num_samples; smpl++) {
+            const uint32_t u = (uint32_t)src[smpl] << lshift;
+            dst[0] = (uint8_t)((u >>  0) & 0xFF);
+            dst[1] = (uint8_t)((u >>  8) & 0xFF);
+            dst[2] = (uint8_t)((u >> 16) & 0xFF);
+            dst += output->stride;
+        }
+        break;
+    case LINNE_PCM_FORMAT_INT32:
+        for (smpl = 0; smpl < num_samples; smpl++) {
+            const int32_t sval = (int32_t)((uint32_t)src[smpl] << lshift);
+            memcpy(dst, &sval, sizeof(int32_t));
+            dst += output->stride;
+        }
+        break;
+    case LINNE_PCM_FORMAT_FLOAT32:
+        {
+            /* [-1,1)の範囲に正規化 */
+            const double scale = 1.0 / (double)((uint32_t)1 << (header->bits_per_sample - 1));
+            for (smpl = 0; smpl < num_samples; smpl++) {
+                const float fval = (float)(src[smpl] * scale);
+                memcpy(dst, &fval, sizeof(float));
+                dst += output->stride;
+            }
+        }
+        break;
+    default:
+        LINNE_ASSERT(0);
+    }
+}
+
+/* 確定した区間をPCM出力バッファに書き出し 出力指定がなければ何もしない */
+/* 補足）MS処理時は先頭2チャンネルが最終チャンネルのLR変換まで確定しないため、その時にまとめて書き出す */
+static void LINNEDecoder_StoreFinalizedRange(
+        const struct LINNEDecoder *decoder, int32_t **buffer, const struct LINNEDecoderPCMOutput *output,
+        uint32_t ch, uint32_t head, uint32_t num_samples)
+{
+    const struct LINNEHeader *header;
+
+    LINNE_ASSERT(decoder != NULL);
+    LINNE_ASSERT(buffer != NULL);
+
+    if (output == NULL) {
+        return;
+    }
+
+    header = &(decoder->header);
+
+    if (header->ch_process_method == LINNE_CH_PROCESS_METHOD_MS) {
+        if ((ch + 1) == header->num_channels) {
+            LINNEDecoder_StoreChannel(decoder, output, 0, buffer[0], head, num_samples);
+            LINNEDecoder_StoreChannel(decoder, output, 1, buffer[1], head, num_samples);
+        }
+        if (ch >= 2) {
+            LINNEDecoder_StoreChannel(decoder, output, ch, buffer[ch], head, num_samples);
+        }
+    } else {
+        LINNEDecoder_StoreChannel(decoder, output, ch, buffer[ch], head, num_samples);
+    }
+}
+
+/* ワーカ数の計算 */
+static uint32_t LINNEDecoder_CalculateNumWorkers(const struct LINNEDecoderConfig *config)
+{
+    LINNE_ASSERT(config != NULL);
+
+    /* チャンネル数より多いワーカは不要 */
+    return LINNEUTILITY_MAX(1, LINNEUTILITY_MIN(config->max_num_threads, config->max_num_channels));
+}
+
+/* スレッドプールで実行する合成タスク */
+static void LINNEDecoder_SynthesizeChannelTask(void *arg, uint32_t thread_index)
+{
+    const struct LINNEDecoderSynthesizeTask *task = (const struct LINNEDecoderSynthesizeTask *)arg;
+    struct LINNEDecoder *decoder = task->decoder;
+    const uint32_t ch = task->ch;
+
+    /* タイルバッファは実行スレッドのものを使う */
+    LINNE_ASSERT(thread_index < decoder->num_workers);
+    LINNELPC_SynthesizeCascade(task->buffer[ch], task->num_decode_samples,
+        decoder->params_int[ch], decoder->parameter_preset->layer_num_params_list,
+        decoder->rshifts[ch], decoder->num_units[ch], decoder->parameter_preset->num_layers,
+        decoder->de_emphasis[ch], decoder->cascade_buffers[thread_index]);
+}
+
+/* 残差を全チャンネル復号した後にチャンネル並列で合成 */
+static LINNEApiResult LINNEDecoder_DecodeCompressDataParallel(
+        struct LINNEDecoder *decoder, struct BitStream *reader,
+        int32_t **buffer, uint32_t num_decode_samples,
+        const struct LINNEDecoderPCMOutput *output, uint32_t *decode_size)
+{
+    uint32_t ch;
+    struct ThreadPoolTaskGroup group;
+    const struct LINNEHeader *header = &(decoder->header);
+
+    /* 残差復号 ビットストリームの読み出しは逐次的に行うしかない */
+    for (ch = 0; ch < header->num_channels; ch++) {
+        LINNECoder_Decode(reader, buffer[ch], num_decode_samples);
+    }
+
+    /* バイト境界に揃える */
+    BitStream_Flush(reader);
+
+    /* 読み出しサイズの取得 */
+    BitStream_Tell(reader, (int32_t *)decode_size);
+
+    /* ビットリーダ破棄 */
+    BitStream_Close(reader);
+
+    /* チャンネル毎の合成処理をスレッドプールで並列に行う */
+    ThreadPool_InitializeTaskGroup(&group);
+    for (ch = 0; ch < header->num_channels; ch++) {
+        decoder->tasks[ch].decoder = decoder;
+        decoder->tasks[ch].ch = ch;
+        decoder->tasks[ch].buffer = buffer;
+        decoder->tasks[ch].num_decode_samples = num_decode_samples;
+        ThreadPool_Submit(decoder->thread_pool, &group, LINNEDecoder_SynthesizeChannelTask, &decoder->tasks[ch]);
+    }
+    ThreadPool_Wait(decoder->thread_pool, &group);
+
+    /* MS -> LR */
+    if (header->ch_process_method == LINNE_CH_PROCESS_METHOD_MS) {
+        LINNEUtility_LRConversion(buffer, num_decode_samples);
+    }
+
+    /* 出力指定があれば書き出し */
+    for (ch = 0; ch < header->num_channels; ch++) {
+        LINNEDecoder_StoreFinalizedRange(decoder, buffer, output, ch, 0, num_decode_samples);
+    }
+
+    return LINNE_APIRESULT_OK;
+}
+
 /* 圧縮データブロックデコード */
 static LINNEApiResult LINNEDecoder_DecodeCompressData(
         struct LINNEDecoder *decoder,
         const uint8_t *data, uint32_t data_size,
         int32_t **buffer, uint32_t num_channels, uint32_t num_decode_samples,
-        uint32_t *decode_size)
+        const struct LINNEDecoderPCMOutput *output, uint32_t *decode_size)
 {
     uint32_t ch;
     int32_t l;
@@ -485,9 +739,59 @@ static LINNEApiResult LINNEDecoder_DecodeCompressData(
         }
     }
 
-    /* 残差復号 */
+    /* MS処理のチャンネル数チェック */
+    if ((header->ch_process_method == LINNE_CH_PROCESS_METHOD_MS) && (header->num_channels < 2)) {
+        return LINNE_APIRESULT_INVALID_FORMAT;
+    }
+
+    /* スレッドが複数あればチャンネル並列で合成 */
+    if ((ThreadPool_GetNumThreads(decoder->thread_pool) > 1) && (header->num_channels > 1)) {
+        return LINNEDecoder_DecodeCompressDataParallel(decoder, &reader, buffer, num_decode_samples, output, decode_size);
+    }
+
+    /* チャンネル毎に残差復号と合成処理 */
+    /* 補足）残差はチャンネル順に並んでいるためチャンネルを跨いだタイル化はできない */
     for (ch = 0; ch < header->num_channels; ch++) {
-        LINNECoder_Decode(&reader, buffer[ch], num_decode_samples);
+        const uint32_t num_tiled_layers = LINNELPC_GetNumCascadeTiledLayers(
+                decoder->parameter_preset->layer_num_params_list, decoder->num_units[ch], decoder->parameter_preset->num_layers);
+
+        if (num_tiled_layers < decoder->parameter_preset->num_layers) {
+            /* ユニット並列で合成する層はブロック全体の残差を必要とする */
+            LINNECoder_Decode(&reader, buffer[ch], num_decode_samples);
+            /* LPC合成とデエンファシスを1回の走査で行う */
+            LINNELPC_SynthesizeCascade(buffer[ch], num_decode_samples,
+                decoder->params_int[ch], decoder->parameter_preset->layer_num_params_list,
+                decoder->rshifts[ch], decoder->num_units[ch], decoder->parameter_preset->num_layers,
+                decoder->de_emphasis[ch], decoder->cascade_buffers[0]);
+            /* 最終チャンネルならばMS -> LR */
+            if ((header->ch_process_method == LINNE_CH_PROCESS_METHOD_MS) && ((ch + 1) == header->num_channels)) {
+                LINNEUtility_LRConversion(buffer, num_decode_samples);
+            }
+            /* 確定したチャンネルを出力に書き出し */
+            LINNEDecoder_StoreFinalizedRange(decoder, buffer, output, ch, 0, num_decode_samples);
+        } else {
+            uint32_t tile_head;
+            struct LINNECoderDecodeState state;
+            /* タイル毎に残差復号・合成・デエンファシスを行いキャッシュ上で完結させる */
+            LINNECoder_BeginDecode(&reader, &state, num_decode_samples);
+            for (tile_head = 0; tile_head < num_decode_samples; tile_head += LINNELPC_CASCADE_TILE_SIZE) {
+                const uint32_t tile_size = LINNEUTILITY_MIN(LINNELPC_CASCADE_TILE_SIZE, num_decode_samples - tile_head);
+                LINNECoder_DecodeSamples(&reader, &state, &buffer[ch][tile_head], tile_size);
+                LINNELPC_SynthesizeCascadeTile(buffer[ch], tile_head, tile_size, num_decode_samples,
+                    decoder->params_int[ch], decoder->parameter_preset->layer_num_params_list,
+                    decoder->rshifts[ch], decoder->num_units[ch], num_tiled_layers,
+                    decoder->de_emphasis[ch], decoder->cascade_buffers[0]);
+                /* 最終チャンネルならば合成済みのタイルをMS -> LR */
+                if ((header->ch_process_method == LINNE_CH_PROCESS_METHOD_MS) && ((ch + 1) == header->num_channels)) {
+                    int32_t *tile[2];
+                    tile[0] = &buffer[0][tile_head];
+                    tile[1] = &buffer[1][tile_head];
+                    LINNEUtility_LRConversion(tile, tile_size);
+                }
+                /* キャッシュ上にあるうちに確定したタイルを出力に書き出し */
+                LINNEDecoder_StoreFinalizedRange(decoder, buffer, output, ch, tile_head, tile_size);
+            }
+        }
     }
 
     /* バイト境界に揃える */
@@ -499,28 +803,6 @@ static LINNEApiResult LINNEDecoder_DecodeCompressData(
     /* ビットライタ破棄 */
     BitStream_Close(&reader);
 
-    /* チャンネル毎に合成処理 */
-    for (ch = 0; ch < header->num_channels; ch++) {
-        /* LPC合成 */
-        for (l = (int32_t)decoder->parameter_preset->num_layers - 1; l >= 0; l--) {
-            LINNELPC_Synthesize(buffer[ch],
-                num_decode_samples, decoder->params_int[ch][l], decoder->parameter_preset->layer_num_params_list[l],
-                decoder->rshifts[ch][l], decoder->num_units[ch][l]);
-        }
-        /* デエンファシス */
-        LINNEPreemphasisFilter_MultiStageDeemphasis(
-            decoder->de_emphasis[ch], LINNE_NUM_PREEMPHASIS_FILTERS, buffer[ch], num_decode_samples);
-    }
-
-    /* MS -> LR */
-    if (header->ch_process_method == LINNE_CH_PROCESS_METHOD_MS) {
-        /* チャンネル数チェック */
-        if (header->num_channels < 2) {
-            return LINNE_APIRESULT_INVALID_FORMAT;
-        }
-        LINNEUtility_LRConversion(buffer, num_decode_samples);
-    }
-
     /* 成功終了 */
     return LINNE_APIRESULT_OK;
 }
@@ -560,11 +842,11 @@ static LINNEApiResult LINNEDecoder_DecodeSilentData(
     return LINNE_APIRESULT_OK;
 }
 
-/* 単一データブロックデコード */
-LINNEApiResult LINNEDecoder_DecodeBlock(
+/* 単一データブロックデコード 出力指定があればデコード結果を出力形式に変換して書き出す */
+static LINNEApiResult LINNEDecoder_DecodeBlockCore(
         struct LINNEDecoder *decoder,
         const uint8_t *data, uint32_t data_size,
-        int32_t **buffer, uint32_t buffer_num_channels, uint32_t buffer_num_samples,
+        int32_t **buffer, uint32_t buffer_num_samples, const struct LINNEDecoderPCMOutput *output,
         uint32_t *decode_size, uint32_t *num_decode_samples)
 {
     uint8_t buf8;
@@ -572,31 +854,23 @@ LINNEApiResult LINNEDecoder_DecodeBlock(
     uint32_t buf32;
     uint16_t num_block_samples;
     uint32_t block_header_size, block_data_size;
+    uint8_t store_whole_block = 0;
     LINNEApiResult ret;
     LINNEBlockDataType block_type;
     const struct LINNEHeader *header;
     const uint8_t *read_ptr;
 
-    /* 引数チェック */
-    if ((decoder == NULL) || (data == NULL)
-            || (buffer == NULL) || (decode_size == NULL)
-            || (num_decode_samples == NULL)) {
-        return LINNE_APIRESULT_INVALID_ARGUMENT;
-    }
-
-    /* ヘッダがまだセットされていない */
-    if (!LINNEDECODER_GET_STATUS_FLAG(decoder, LINNEDECODER_STATUS_FLAG_SET_HEADER)) {
-        return LINNE_APIRESULT_PARAMETER_NOT_SET;
-    }
+    /* 内部関数なので不正な引数はアサートで落とす */
+    LINNE_ASSERT(decoder != NULL);
+    LINNE_ASSERT(data != NULL);
+    LINNE_ASSERT(buffer != NULL);
+    LINNE_ASSERT(decode_size != NULL);
+    LINNE_ASSERT(num_decode_samples != NULL);
+    LINNE_ASSERT(LINNEDECODER_GET_STATUS_FLAG(decoder, LINNEDECODER_STATUS_FLAG_SET_HEADER));
 
     /* ヘッダ取得 */
     header = &(decoder->header);
 
-    /* バッファチャンネル数チェック */
-    if (buffer_num_channels < header->num_channels) {
-        return LINNE_APIRESULT_INSUFFICIENT_BUFFER;
-    }
-
     /* ブロックヘッダデコード */
     read_ptr = data;
 
@@ -639,14 +913,17 @@ LINNEApiResult LINNEDecoder_DecodeBlock(
     case LINNE_BLOCK_DATA_TYPE_RAWDATA:
         ret = LINNEDecoder_DecodeRawData(decoder,
                 read_ptr, data_size - block_header_size, buffer, header->num_channels, num_block_samples, &block_data_size);
+        store_whole_block = 1;
         break;
     case LINNE_BLOCK_DATA_TYPE_COMPRESSDATA:
+        /* 圧縮データは合成の最終段で出力に書き出す */
         ret = LINNEDecoder_DecodeCompressData(decoder,
-                read_ptr, data_size - block_header_size, buffer, header->num_channels, num_block_samples, &block_data_size);
+                read_ptr, data_size - block_header_size, buffer, header->num_channels, num_block_samples, output, &block_data_size);
         break;
     case LINNE_BLOCK_DATA_TYPE_SILENT:
         ret = LINNEDecoder_DecodeSilentData(decoder,
                 read_ptr, data_size - block_header_size, buffer, header->num_channels, num_block_samples, &block_data_size);
+        store_whole_block = 1;
         break;
     default:
         return LINNE_APIRESULT_INVALID_FORMAT;
@@ -657,6 +934,14 @@ LINNEApiResult LINNEDecoder_DecodeBlock(
         return ret;
     }
 
+    /* 生データ・無音データはブロック全体を出力に書き出す */
+    if ((output != NULL) && (store_whole_block == 1)) {
+        uint32_t ch;
+        for (ch = 0; ch < header->num_channels; ch++) {
+            LINNEDecoder_StoreChannel(decoder, output, ch, buffer[ch], 0, num_block_samples);
+        }
+    }
+
     /* デコードサイズ */
     (*decode_size) = block_header_size + block_data_size;
 
@@ -667,23 +952,124 @@ LINNEApiResult LINNEDecoder_DecodeBlock(
     return LINNE_APIRESULT_OK;
 }
 
-/* ヘッダを含めて全ブロックデコード */
-LINNEApiResult LINNEDecoder_DecodeWhole(
+/* PCM出力バッファのチェック */
+static LINNEApiResult LINNEDecoder_CheckPCMOutput(
+        const struct LINNEDecoder *decoder, const struct LINNEDecoderPCMOutput *output)
+{
+    uint32_t ch, byte_size;
+    const struct LINNEHeader *header;
+
+    LINNE_ASSERT(decoder != NULL);
+    LINNE_ASSERT(output != NULL);
+    LINNE_ASSERT(LINNEDECODER_GET_STATUS_FLAG(decoder, LINNEDECODER_STATUS_FLAG_SET_HEADER));
+
+    header = &(decoder->header);
+
+    /* 形式とストライドのチェック */
+    byte_size = LINNEUtility_GetPCMFormatByteSize(output->format);
+    if ((byte_size == 0) || (output->stride < byte_size)) {
+        return LINNE_APIRESULT_INVALID_ARGUMENT;
+    }
+
+    /* 整数形式はコンテナに収まらないビット深度を扱えない */
+    if ((output->format != LINNE_PCM_FORMAT_FLOAT32) && ((8 * byte_size) < header->bits_per_sample)) {
+        return LINNE_APIRESULT_INVALID_ARGUMENT;
+    }
+
+    for (ch = 0; ch < header->num_channels; ch++) {
+        if (output->channels[ch] == NULL) {
+            return LINNE_APIRESULT_INVALID_ARGUMENT;
+        }
+    }
+
+    /* 信号バッファに収まらないブロックはデコードできない */
+    if (header->num_samples_per_block > decoder->max_num_samples_per_block) {
+        return LINNE_APIRESULT_INSUFFICIENT_BUFFER;
+    }
+
+    return LINNE_APIRESULT_OK;
+}
+
+/* 単一データブロックデコード */
+LINNEApiResult LINNEDecoder_DecodeBlock(
         struct LINNEDecoder *decoder,
         const uint8_t *data, uint32_t data_size,
-        int32_t **buffer, uint32_t buffer_num_channels, uint32_t buffer_num_samples)
+        int32_t **buffer, uint32_t buffer_num_channels, uint32_t buffer_num_samples,
+        uint32_t *decode_size, uint32_t *num_decode_samples)
+{
+    /* 引数チェック */
+    if ((decoder == NULL) || (data == NULL)
+            || (buffer == NULL) || (decode_size == NULL)
+            || (num_decode_samples == NULL)) {
+        return LINNE_APIRESULT_INVALID_ARGUMENT;
+    }
+
+    /* ヘッダがまだセットされていない */
+    if (!LINNEDECODER_GET_STATUS_FLAG(decoder, LINNEDECODER_STATUS_FLAG_SET_HEADER)) {
+        return LINNE_APIRESULT_PARAMETER_NOT_SET;
+    }
+
+    /* バッファチャンネル数チェック */
+    if (buffer_num_channels < decoder->header.num_channels) {
+        return LINNE_APIRESULT_INSUFFICIENT_BUFFER;
+    }
+
+    return LINNEDecoder_DecodeBlockCore(decoder,
+            data, data_size, buffer, buffer_num_samples, NULL, decode_size, num_decode_samples);
+}
+
+/* 単一データブロックデコード（PCMバッファ出力） */
+LINNEApiResult LINNEDecoder_DecodeBlockPCM(
+        struct LINNEDecoder *decoder,
+        const uint8_t *data, uint32_t data_size,
+        const struct LINNEDecoderPCMOutput *output, uint32_t output_num_samples,
+        uint32_t *decode_size, uint32_t *num_decode_samples)
+{
+    LINNEApiResult ret;
+
+    /* 引数チェック */
+    if ((decoder == NULL) || (data == NULL)
+            || (output == NULL) || (decode_size == NULL)
+            || (num_decode_samples == NULL)) {
+        return LINNE_APIRESULT_INVALID_ARGUMENT;
+    }
+
+    /* ヘッダがまだセットされていない */
+    if (!LINNEDECODER_GET_STATUS_FLAG(decoder, LINNEDECODER_STATUS_FLAG_SET_HEADER)) {
+        return LINNE_APIRESULT_PARAMETER_NOT_SET;
+    }
+
+    /* 出力バッファのチェック */
+    if ((ret = LINNEDecoder_CheckPCMOutput(decoder, output)) != LINNE_APIRESULT_OK) {
+        return ret;
+    }
+
+    /* 内部の信号バッファでデコードして出力に書き出す */
+    return LINNEDecoder_DecodeBlockCore(decoder,
+            data, data_size, decoder->pcm_buffer,
+            LINNEUTILITY_MIN(output_num_samples, decoder->max_num_samples_per_block), output,
+            decode_size, num_decode_samples);
+}
+
+/* ヘッダを含めて全ブロックデコード 出力指定があればPCMバッファに書き出す */
+static LINNEApiResult LINNEDecoder_DecodeWholeCore(
+        struct LINNEDecoder *decoder,
+        const uint8_t *data, uint32_t data_size,
+        int32_t **buffer, uint32_t buffer_num_channels,
+        const struct LINNEDecoderPCMOutput *output, uint32_t buffer_num_samples)
 {
     LINNEApiResult ret;
     uint32_t progress, ch, read_offset, read_block_size, num_decode_samples;
     const uint8_t *read_pos;
     int32_t *buffer_ptr[LINNE_MAX_NUM_CHANNELS];
+    struct LINNEDecoderPCMOutput block_output;
     struct LINNEHeader tmp_header;
     const struct LINNEHeader *header;
 
-    /* 引数チェック */
-    if ((decoder == NULL) || (data == NULL) || (buffer == NULL)) {
-        return LINNE_APIRESULT_INVALID_ARGUMENT;
-    }
+    /* 内部関数なので不正な引数はアサートで落とす */
+    LINNE_ASSERT(decoder != NULL);
+    LINNE_ASSERT(data != NULL);
+    LINNE_ASSERT((buffer != NULL) || (output != NULL));
 
     /* ヘッダデコードとデコーダへのセット */
     if ((ret = LINNEDecoder_DecodeHeader(data, data_size, &tmp_header))
@@ -697,8 +1083,15 @@ LINNEApiResult LINNEDecoder_DecodeWhole(
     header = &(decoder->header);
 
     /* バッファサイズチェック */
-    if ((buffer_num_channels < header->num_channels)
-            || (buffer_num_samples < header->num_samples)) {
+    if (output != NULL) {
+        if ((ret = LINNEDecoder_CheckPCMOutput(decoder, output)) != LINNE_APIRESULT_OK) {
+            return ret;
+        }
+        block_output = (*output);
+    } else if (buffer_num_channels < header->num_channels) {
+        return LINNE_APIRESULT_INSUFFICIENT_BUFFER;
+    }
+    if (buffer_num_samples < header->num_samples) {
         return LINNE_APIRESULT_INSUFFICIENT_BUFFER;
     }
 
@@ -706,15 +1099,28 @@ LINNEApiResult LINNEDecoder_DecodeWhole(
     read_offset = LINNE_HEADER_SIZE;
     read_pos = data + LINNE_HEADER_SIZE;
     while ((progress < header->num_samples) && (read_offset < data_size)) {
-        /* サンプル書き出し位置のセット */
-        for (ch = 0; ch < header->num_channels; ch++) {
-            buffer_ptr[ch] = &buffer[ch][progress];
-        }
         /* ブロックデコード */
-        if ((ret = LINNEDecoder_DecodeBlock(decoder,
-                        read_pos, data_size - read_offset,
-                        buffer_ptr, buffer_num_channels, buffer_num_samples - progress,
-                        &read_block_size, &num_decode_samples)) != LINNE_APIRESULT_OK) {
+        if (output != NULL) {
+            /* サンプル書き出し位置のセット */
+            for (ch = 0; ch < header->num_channels; ch++) {
+                block_output.channels[ch] = (uint8_t *)output->channels[ch] + (size_t)progress * output->stride;
+            }
+            ret = LINNEDecoder_DecodeBlockCore(decoder,
+                    read_pos, data_size - read_offset,
+                    decoder->pcm_buffer,
+                    LINNEUTILITY_MIN(buffer_num_samples - progress, decoder->max_num_samples_per_block), &block_output,
+                    &read_block_size, &num_decode_samples);
+        } else {
+            /* サンプル書き出し位置のセット */
+            for (ch = 0; ch < header->num_channels; ch++) {
+                buffer_ptr[ch] = &buffer[ch][progress];
+            }
+            ret = LINNEDecoder_DecodeBlockCore(decoder,
+                    read_pos, data_size - read_offset,
+                    buffer_ptr, buffer_num_samples - progress, NULL,
+                    &read_block_size, &num_decode_samples);
+        }
+        if (ret != LINNE_APIRESULT_OK) {
             return ret;
         }
         /* 進捗更新 */
@@ -728,3 +1134,33 @@ LINNEApiResult LINNEDecoder_DecodeWhole(
     /* 成功終了 */
     return LINNE_APIRESULT_OK;
 }
+
+/* ヘッダを含めて全ブロックデコード */
+LINNEApiResult LINNEDecoder_DecodeWhole(
+        struct LINNEDecoder *decoder,
+        const uint8_t *data, uint32_t data_size,
+        int32_t **buffer, uint32_t buffer_num_channels, uint32_t buffer_num_samples)
+{
+    /* 引数チェック */
+    if ((decoder == NULL) || (data == NULL) || (buffer == NULL)) {
+        return LINNE_APIRESULT_INVALID_ARGUMENT;
+    }
+
+    return LINNEDecoder_DecodeWholeCore(decoder,
+            data, data_size, buffer, buffer_num_channels, NULL, buffer_num_samples);
+}
+
+/* ヘッダを含めて全ブロックデコード（PCMバッファ出力） */
+LINNEApiResult LINNEDecoder_DecodeWholePCM(
+        struct LINNEDecoder *decoder,
+        const uint8_t *data, uint32_t data_size,
+        const struct LINNEDecoderPCMOutput *output, uint32_t output_num_samples)
+{
+    /* 引数チェック */
+    if ((decoder == NULL) || (data == NULL) || (output == NULL)) {
+        return LINNE_APIRESULT_INVALID_ARGUMENT;
+    }
+
+    return LINNEDecoder_DecodeWholeCore(decoder,
+            data, data_size, NULL, 0, output, output_num_samples);
+}
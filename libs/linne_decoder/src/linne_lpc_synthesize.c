@@ -4,8 +4,48 @@
 #include "linne_internal.h"
 #include "linne_utility.h"
 
-/* LPC係数により合成(in-place) */
-void LINNELPC_Synthesize(
+#if defined(LINNE_USE_X86_SIMD)
+#include <immintrin.h>
+#endif
+
+/* ユニット並列合成で一度に転置するサンプル数 */
+#define LINNELPC_LANE_TILE_SIZE 64
+/* ユニット並列合成で扱える係数の総数（レーン数 x 次数） */
+#define LINNELPC_LANE_MAX_NUM_COEFS 512
+/* 単一ユニットの合成で内積をSIMD化する最小次数 */
+#define LINNELPC_SINGLE_UNIT_SIMD_MIN_ORDER 8
+/* 次数固定の関数を用意する次数の数（1,2,4,...,128） */
+#define LINNELPC_NUM_SPECIALIZED_ORDERS 8
+/* 関数テーブルのサイズ 最後の要素は次数可変の関数 */
+#define LINNELPC_FUNCTION_TABLE_SIZE (LINNELPC_NUM_SPECIALIZED_ORDERS + 1)
+
+/* 次数分の積和（次数可変: ループ） */
+#define LINNELPC_MAC_LOOP(STEP, order)\
+    {\
+        uint32_t ord;\
+        for (ord = 0; ord < (order); ord++) {\
+            STEP(ord)\
+        }\
+    }
+/* 次数分の積和（次数固定: 完全展開） */
+#define LINNELPC_MAC_UNROLL(STEP, order) LINNEUTILITY_UNROLL_##order(STEP, 0)
+
+/* 合成関数型 関数毎に決まった数のユニットをまとめて合成する */
+typedef void (*LINNELPCSynthesizeFunction)(
+    int32_t *data, uint32_t nsmpls_per_unit, const int32_t *coef, uint32_t order, int32_t half, uint32_t rshift);
+
+/* 関数テーブルの参照位置を取得 */
+static uint32_t LINNELPC_GetFunctionTableIndex(uint32_t order)
+{
+    if ((order > 0) && LINNEUTILITY_IS_POWERED_OF_2(order)
+            && (order <= (1U << (LINNELPC_NUM_SPECIALIZED_ORDERS - 1)))) {
+        return LINNEUTILITY_LOG2FLOOR(order);
+    }
+    return LINNELPC_NUM_SPECIALIZED_ORDERS;
+}
+
+/* LPC係数により合成(in-place, スカラー実装) */
+static void LINNELPC_SynthesizeScalar(
     int32_t *data, uint32_t num_samples,
     const int32_t *coef, uint32_t coef_order, uint32_t coef_rshift, uint32_t num_units)
 {
@@ -14,14 +54,6 @@ void LINNELPC_Synthesize(
     const uint32_t nparams_per_unit = coef_order / num_units;
     const uint32_t nsmpls_per_unit = num_samples / num_units;
 
-    /* 引数チェック */
-    LINNE_ASSERT(data != NULL);
-    LINNE_ASSERT(coef != NULL);
-
-    /* ユニット数は2の冪であることを要求 */
-    LINNE_ASSERT(num_units > 0);
-    LINNE_ASSERT(LINNEUTILITY_IS_POWERED_OF_2(num_units));
-
     if (num_units == 1) {
         int32_t predict;
         for (smpl = 0; smpl < nsmpls_per_unit - nparams_per_unit; smpl++) {
@@ -81,3 +113,518 @@ void LINNELPC_Synthesize(
         }
     }
 }
+
+/* 単一ユニットの合成（スカラー実装）の定義 */
+#define LINNELPC_SYNTHESIZE_STEP_SCALAR(k) predict += (coef[k] * pdata[k]);
+#define LINNELPC_DEFINE_SYNTHESIZE_UNIT_SCALAR(function_name, MAC, ORDER)\
+static void function_name(\
+    int32_t *data, uint32_t nsmpls_per_unit, const int32_t *coef, uint32_t order, int32_t half, uint32_t rshift)\
+{\
+    uint32_t smpl;\
+\
+    LINNEUTILITY_UNUSED_ARGUMENT(order);\
+\
+    for (smpl = 0; smpl < nsmpls_per_unit - (ORDER); smpl++) {\
+        int32_t *pdata = &data[smpl];\
+        int32_t predict = half;\
+        MAC(LINNELPC_SYNTHESIZE_STEP_SCALAR, ORDER)\
+        pdata[(ORDER)] -= (predict >> rshift);\
+    }\
+}
+
+LINNELPC_DEFINE_SYNTHESIZE_UNIT_SCALAR(LINNELPC_SynthesizeUnitScalar, LINNELPC_MAC_LOOP, order)
+LINNELPC_DEFINE_SYNTHESIZE_UNIT_SCALAR(LINNELPC_SynthesizeUnitScalarOrder1, LINNELPC_MAC_UNROLL, 1)
+LINNELPC_DEFINE_SYNTHESIZE_UNIT_SCALAR(LINNELPC_SynthesizeUnitScalarOrder2, LINNELPC_MAC_UNROLL, 2)
+LINNELPC_DEFINE_SYNTHESIZE_UNIT_SCALAR(LINNELPC_SynthesizeUnitScalarOrder4, LINNELPC_MAC_UNROLL, 4)
+LINNELPC_DEFINE_SYNTHESIZE_UNIT_SCALAR(LINNELPC_SynthesizeUnitScalarOrder8, LINNELPC_MAC_UNROLL, 8)
+LINNELPC_DEFINE_SYNTHESIZE_UNIT_SCALAR(LINNELPC_SynthesizeUnitScalarOrder16, LINNELPC_MAC_UNROLL, 16)
+LINNELPC_DEFINE_SYNTHESIZE_UNIT_SCALAR(LINNELPC_SynthesizeUnitScalarOrder32, LINNELPC_MAC_UNROLL, 32)
+LINNELPC_DEFINE_SYNTHESIZE_UNIT_SCALAR(LINNELPC_SynthesizeUnitScalarOrder64, LINNELPC_MAC_UNROLL, 64)
+LINNELPC_DEFINE_SYNTHESIZE_UNIT_SCALAR(LINNELPC_SynthesizeUnitScalarOrder128, LINNELPC_MAC_UNROLL, 128)
+
+/* 次数別の単一ユニット合成（スカラー実装） */
+static const LINNELPCSynthesizeFunction st_synthesize_unit_scalar_functions[LINNELPC_FUNCTION_TABLE_SIZE] = {
+    LINNELPC_SynthesizeUnitScalarOrder1, LINNELPC_SynthesizeUnitScalarOrder2,
+    LINNELPC_SynthesizeUnitScalarOrder4, LINNELPC_SynthesizeUnitScalarOrder8,
+    LINNELPC_SynthesizeUnitScalarOrder16, LINNELPC_SynthesizeUnitScalarOrder32,
+    LINNELPC_SynthesizeUnitScalarOrder64, LINNELPC_SynthesizeUnitScalarOrder128,
+    LINNELPC_SynthesizeUnitScalar
+};
+
+#if defined(LINNE_USE_X86_SIMD)
+
+/* ユニット毎に連続したデータをレーン毎に交互に並べ替え */
+static void LINNELPC_TransposeToLanes(
+    const int32_t *data, uint32_t stride, uint32_t num_lanes, uint32_t num_rows, int32_t *lanes)
+{
+    uint32_t i, j;
+
+    for (j = 0; j < num_lanes; j++) {
+        const int32_t *pdata = &data[j * stride];
+        for (i = 0; i < num_rows; i++) {
+            lanes[i * num_lanes + j] = pdata[i];
+        }
+    }
+}
+
+/* レーン毎に交互に並んだデータをユニット毎に連続した並びに戻す */
+static void LINNELPC_TransposeFromLanes(
+    const int32_t *lanes, uint32_t num_lanes, uint32_t num_rows, int32_t *data, uint32_t stride)
+{
+    uint32_t i, j;
+
+    for (j = 0; j < num_lanes; j++) {
+        int32_t *pdata = &data[j * stride];
+        for (i = 0; i < num_rows; i++) {
+            pdata[i] = lanes[i * num_lanes + j];
+        }
+    }
+}
+
+/* レーン並列合成の定義 各ユニットを1レーンに割り当てて合成する */
+/* 補足）転置したタイルを用いるためgatherは不要 */
+#define LINNELPC_SYNTHESIZE_STEP_LANES_SSE41(k)\
+    vpred = _mm_add_epi32(vpred, _mm_mullo_epi32(\
+                _mm_loadu_si128((const __m128i *)&lane_coef[(k) * 4]), _mm_loadu_si128((const __m128i *)&prow[(k) * 4])));
+#define LINNELPC_SYNTHESIZE_STEP_LANES_AVX2(k)\
+    vpred = _mm256_add_epi32(vpred, _mm256_mullo_epi32(\
+                _mm256_loadu_si256((const __m256i *)&lane_coef[(k) * 8]), _mm256_loadu_si256((const __m256i *)&prow[(k) * 8])));
+#define LINNELPC_SYNTHESIZE_STEP_LANES_AVX512(k)\
+    vpred = _mm512_add_epi32(vpred, _mm512_mullo_epi32(\
+                _mm512_loadu_si512((const __m512i *)&lane_coef[(k) * 16]), _mm512_loadu_si512((const __m512i *)&prow[(k) * 16])));
+#define LINNELPC_DEFINE_SYNTHESIZE_LANES(function_name, MAC, ORDER,\
+        isa, num_lanes, vtype, STEP, set1, loadu, storeu, sub, sra)\
+LINNE_TARGET_ATTRIBUTE(isa)\
+static void function_name(\
+    int32_t *data, uint32_t nsmpls_per_unit, const int32_t *coef, uint32_t order, int32_t half, uint32_t rshift)\
+{\
+    uint32_t tile_head, smpl;\
+    int32_t lanes[(LINNELPC_LANE_TILE_SIZE * (num_lanes)) + LINNELPC_LANE_MAX_NUM_COEFS];\
+    int32_t lane_coef[LINNELPC_LANE_MAX_NUM_COEFS];\
+    const uint32_t num_predict_samples = nsmpls_per_unit - order;\
+    const vtype vhalf = set1(half);\
+    const __m128i vshift = _mm_cvtsi32_si128((int)rshift);\
+\
+    LINNE_ASSERT((order * (num_lanes)) <= LINNELPC_LANE_MAX_NUM_COEFS);\
+\
+    /* 係数をレーン毎に並べる */\
+    LINNELPC_TransposeToLanes(coef, order, (num_lanes), order, lane_coef);\
+    /* 先頭の次数分のサンプルは予測しない */\
+    LINNELPC_TransposeToLanes(data, nsmpls_per_unit, (num_lanes), order, lanes);\
+\
+    for (tile_head = 0; tile_head < num_predict_samples; tile_head += LINNELPC_LANE_TILE_SIZE) {\
+        const uint32_t tile_size = LINNEUTILITY_MIN(LINNELPC_LANE_TILE_SIZE, num_predict_samples - tile_head);\
+        LINNELPC_TransposeToLanes(&data[tile_head + order], nsmpls_per_unit, (num_lanes),\
+                tile_size, &lanes[order * (num_lanes)]);\
+        for (smpl = 0; smpl < tile_size; smpl++) {\
+            int32_t *prow = &lanes[smpl * (num_lanes)];\
+            vtype vpred = vhalf;\
+            MAC(STEP, ORDER)\
+            storeu((vtype *)&prow[(ORDER) * (num_lanes)],\
+                    sub(loadu((const vtype *)&prow[(ORDER) * (num_lanes)]), sra(vpred, vshift)));\
+        }\
+        LINNELPC_TransposeFromLanes(&lanes[order * (num_lanes)], (num_lanes),\
+                tile_size, &data[tile_head + order], nsmpls_per_unit);\
+        /* 次のタイルのために末尾の次数分のサンプルを先頭に移動 */\
+        memmove(lanes, &lanes[tile_size * (num_lanes)], sizeof(int32_t) * order * (num_lanes));\
+    }\
+}
+
+/* SSE4.1: 4ユニット並列合成 */
+#define LINNELPC_DEFINE_SYNTHESIZE_LANES_SSE41(function_name, MAC, ORDER)\
+    LINNELPC_DEFINE_SYNTHESIZE_LANES(function_name, MAC, ORDER, "sse4.1", 4, __m128i, LINNELPC_SYNTHESIZE_STEP_LANES_SSE41,\
+        _mm_set1_epi32, _mm_loadu_si128, _mm_storeu_si128, _mm_sub_epi32, _mm_sra_epi32)
+/* AVX2: 8ユニット並列合成 */
+#define LINNELPC_DEFINE_SYNTHESIZE_LANES_AVX2(function_name, MAC, ORDER)\
+    LINNELPC_DEFINE_SYNTHESIZE_LANES(function_name, MAC, ORDER, "avx2", 8, __m256i, LINNELPC_SYNTHESIZE_STEP_LANES_AVX2,\
+        _mm256_set1_epi32, _mm256_loadu_si256, _mm256_storeu_si256, _mm256_sub_epi32, _mm256_sra_epi32)
+/* AVX-512: 16ユニット並列合成 */
+#define LINNELPC_DEFINE_SYNTHESIZE_LANES_AVX512(function_name, MAC, ORDER)\
+    LINNELPC_DEFINE_SYNTHESIZE_LANES(function_name, MAC, ORDER, "avx512f", 16, __m512i, LINNELPC_SYNTHESIZE_STEP_LANES_AVX512,\
+        _mm512_set1_epi32, _mm512_loadu_si512, _mm512_storeu_si512, _mm512_sub_epi32, _mm512_sra_epi32)
+
+/* 補足）プリセットではユニット数が多いほど1ユニットあたりの次数が小さい */
+/* 4ユニット以上では次数32以下、8ユニット以上では16以下、16ユニット以上では8以下のみが現れる */
+LINNELPC_DEFINE_SYNTHESIZE_LANES_SSE41(LINNELPC_SynthesizeLanesSSE41, LINNELPC_MAC_LOOP, order)
+LINNELPC_DEFINE_SYNTHESIZE_LANES_SSE41(LINNELPC_SynthesizeLanesSSE41Order1, LINNELPC_MAC_UNROLL, 1)
+LINNELPC_DEFINE_SYNTHESIZE_LANES_SSE41(LINNELPC_SynthesizeLanesSSE41Order2, LINNELPC_MAC_UNROLL, 2)
+LINNELPC_DEFINE_SYNTHESIZE_LANES_SSE41(LINNELPC_SynthesizeLanesSSE41Order4, LINNELPC_MAC_UNROLL, 4)
+LINNELPC_DEFINE_SYNTHESIZE_LANES_SSE41(LINNELPC_SynthesizeLanesSSE41Order8, LINNELPC_MAC_UNROLL, 8)
+LINNELPC_DEFINE_SYNTHESIZE_LANES_SSE41(LINNELPC_SynthesizeLanesSSE41Order16, LINNELPC_MAC_UNROLL, 16)
+LINNELPC_DEFINE_SYNTHESIZE_LANES_SSE41(LINNELPC_SynthesizeLanesSSE41Order32, LINNELPC_MAC_UNROLL, 32)
+LINNELPC_DEFINE_SYNTHESIZE_LANES_AVX2(LINNELPC_SynthesizeLanesAVX2, LINNELPC_MAC_LOOP, order)
+LINNELPC_DEFINE_SYNTHESIZE_LANES_AVX2(LINNELPC_SynthesizeLanesAVX2Order1, LINNELPC_MAC_UNROLL, 1)
+LINNELPC_DEFINE_SYNTHESIZE_LANES_AVX2(LINNELPC_SynthesizeLanesAVX2Order2, LINNELPC_MAC_UNROLL, 2)
+LINNELPC_DEFINE_SYNTHESIZE_LANES_AVX2(LINNELPC_SynthesizeLanesAVX2Order4, LINNELPC_MAC_UNROLL, 4)
+LINNELPC_DEFINE_SYNTHESIZE_LANES_AVX2(LINNELPC_SynthesizeLanesAVX2Order8, LINNELPC_MAC_UNROLL, 8)
+LINNELPC_DEFINE_SYNTHESIZE_LANES_AVX2(LINNELPC_SynthesizeLanesAVX2Order16, LINNELPC_MAC_UNROLL, 16)
+LINNELPC_DEFINE_SYNTHESIZE_LANES_AVX512(LINNELPC_SynthesizeLanesAVX512, LINNELPC_MAC_LOOP, order)
+LINNELPC_DEFINE_SYNTHESIZE_LANES_AVX512(LINNELPC_SynthesizeLanesAVX512Order1, LINNELPC_MAC_UNROLL, 1)
+LINNELPC_DEFINE_SYNTHESIZE_LANES_AVX512(LINNELPC_SynthesizeLanesAVX512Order2, LINNELPC_MAC_UNROLL, 2)
+LINNELPC_DEFINE_SYNTHESIZE_LANES_AVX512(LINNELPC_SynthesizeLanesAVX512Order4, LINNELPC_MAC_UNROLL, 4)
+LINNELPC_DEFINE_SYNTHESIZE_LANES_AVX512(LINNELPC_SynthesizeLanesAVX512Order8, LINNELPC_MAC_UNROLL, 8)
+
+/* 次数別のSSE4.1 4ユニット並列合成 */
+static const LINNELPCSynthesizeFunction st_synthesize_lanes_sse41_functions[LINNELPC_FUNCTION_TABLE_SIZE] = {
+    LINNELPC_SynthesizeLanesSSE41Order1, LINNELPC_SynthesizeLanesSSE41Order2,
+    LINNELPC_SynthesizeLanesSSE41Order4, LINNELPC_SynthesizeLanesSSE41Order8,
+    LINNELPC_SynthesizeLanesSSE41Order16, LINNELPC_SynthesizeLanesSSE41Order32,
+    LINNELPC_SynthesizeLanesSSE41, LINNELPC_SynthesizeLanesSSE41,
+    LINNELPC_SynthesizeLanesSSE41
+};
+
+/* 次数別のAVX2 8ユニット並列合成 */
+static const LINNELPCSynthesizeFunction st_synthesize_lanes_avx2_functions[LINNELPC_FUNCTION_TABLE_SIZE] = {
+    LINNELPC_SynthesizeLanesAVX2Order1, LINNELPC_SynthesizeLanesAVX2Order2,
+    LINNELPC_SynthesizeLanesAVX2Order4, LINNELPC_SynthesizeLanesAVX2Order8,
+    LINNELPC_SynthesizeLanesAVX2Order16, LINNELPC_SynthesizeLanesAVX2,
+    LINNELPC_SynthesizeLanesAVX2, LINNELPC_SynthesizeLanesAVX2,
+    LINNELPC_SynthesizeLanesAVX2
+};
+
+/* 次数別のAVX-512 16ユニット並列合成 */
+static const LINNELPCSynthesizeFunction st_synthesize_lanes_avx512_functions[LINNELPC_FUNCTION_TABLE_SIZE] = {
+    LINNELPC_SynthesizeLanesAVX512Order1, LINNELPC_SynthesizeLanesAVX512Order2,
+    LINNELPC_SynthesizeLanesAVX512Order4, LINNELPC_SynthesizeLanesAVX512Order8,
+    LINNELPC_SynthesizeLanesAVX512, LINNELPC_SynthesizeLanesAVX512,
+    LINNELPC_SynthesizeLanesAVX512, LINNELPC_SynthesizeLanesAVX512,
+    LINNELPC_SynthesizeLanesAVX512
+};
+
+/* 単一ユニットの合成（SIMDで内積を計算）の定義 */
+#define LINNELPC_SYNTHESIZE_STEP_UNIT_SSE41(k)\
+    vsum = _mm_add_epi32(vsum, _mm_mullo_epi32(\
+                _mm_loadu_si128((const __m128i *)&coef[(k) * 4]), _mm_loadu_si128((const __m128i *)&pdata[(k) * 4])));
+#define LINNELPC_SYNTHESIZE_STEP_UNIT_AVX2(k)\
+    vsum256 = _mm256_add_epi32(vsum256, _mm256_mullo_epi32(\
+                _mm256_loadu_si256((const __m256i *)&coef[(k) * 8]), _mm256_loadu_si256((const __m256i *)&pdata[(k) * 8])));
+#define LINNELPC_DEFINE_SYNTHESIZE_UNIT_SSE41(function_name, MAC, ORDER, NSTEPS)\
+LINNE_TARGET_ATTRIBUTE("sse4.1")\
+static void function_name(\
+    int32_t *data, uint32_t nsmpls_per_unit, const int32_t *coef, uint32_t order, int32_t half, uint32_t rshift)\
+{\
+    uint32_t smpl, rest;\
+\
+    LINNEUTILITY_UNUSED_ARGUMENT(order);\
+\
+    for (smpl = 0; smpl < nsmpls_per_unit - (ORDER); smpl++) {\
+        int32_t *pdata = &data[smpl];\
+        int32_t predict;\
+        __m128i vsum = _mm_setzero_si128();\
+        MAC(LINNELPC_SYNTHESIZE_STEP_UNIT_SSE41, NSTEPS)\
+        vsum = _mm_add_epi32(vsum, _mm_shuffle_epi32(vsum, 0x4E));\
+        vsum = _mm_add_epi32(vsum, _mm_shuffle_epi32(vsum, 0xB1));\
+        predict = half + _mm_cvtsi128_si32(vsum);\
+        for (rest = 4 * (NSTEPS); rest < (ORDER); rest++) {\
+            predict += (coef[rest] * pdata[rest]);\
+        }\
+        pdata[(ORDER)] -= (predict >> rshift);\
+    }\
+}
+#define LINNELPC_DEFINE_SYNTHESIZE_UNIT_AVX2(function_name, MAC, ORDER, NSTEPS)\
+LINNE_TARGET_ATTRIBUTE("avx2")\
+static void function_name(\
+    int32_t *data, uint32_t nsmpls_per_unit, const int32_t *coef, uint32_t order, int32_t half, uint32_t rshift)\
+{\
+    uint32_t smpl, rest;\
+\
+    LINNEUTILITY_UNUSED_ARGUMENT(order);\
+\
+    for (smpl = 0; smpl < nsmpls_per_unit - (ORDER); smpl++) {\
+        int32_t *pdata = &data[smpl];\
+        int32_t predict;\
+        __m128i vsum;\
+        __m256i vsum256 = _mm256_setzero_si256();\
+        MAC(LINNELPC_SYNTHESIZE_STEP_UNIT_AVX2, NSTEPS)\
+        vsum = _mm_add_epi32(_mm256_castsi256_si128(vsum256), _mm256_extracti128_si256(vsum256, 1));\
+        vsum = _mm_add_epi32(vsum, _mm_shuffle_epi32(vsum, 0x4E));\
+        vsum = _mm_add_epi32(vsum, _mm_shuffle_epi32(vsum, 0xB1));\
+        predict = half + _mm_cvtsi128_si32(vsum);\
+        for (rest = 8 * (NSTEPS); rest < (ORDER); rest++) {\
+            predict += (coef[rest] * pdata[rest]);\
+        }\
+        pdata[(ORDER)] -= (predict >> rshift);\
+    }\
+}
+
+LINNELPC_DEFINE_SYNTHESIZE_UNIT_SSE41(LINNELPC_SynthesizeUnitSSE41, LINNELPC_MAC_LOOP, order, order / 4)
+LINNELPC_DEFINE_SYNTHESIZE_UNIT_SSE41(LINNELPC_SynthesizeUnitSSE41Order8, LINNELPC_MAC_UNROLL, 8, 2)
+LINNELPC_DEFINE_SYNTHESIZE_UNIT_SSE41(LINNELPC_SynthesizeUnitSSE41Order16, LINNELPC_MAC_UNROLL, 16, 4)
+LINNELPC_DEFINE_SYNTHESIZE_UNIT_SSE41(LINNELPC_SynthesizeUnitSSE41Order32, LINNELPC_MAC_UNROLL, 32, 8)
+LINNELPC_DEFINE_SYNTHESIZE_UNIT_SSE41(LINNELPC_SynthesizeUnitSSE41Order64, LINNELPC_MAC_UNROLL, 64, 16)
+LINNELPC_DEFINE_SYNTHESIZE_UNIT_SSE41(LINNELPC_SynthesizeUnitSSE41Order128, LINNELPC_MAC_UNROLL, 128, 32)
+LINNELPC_DEFINE_SYNTHESIZE_UNIT_AVX2(LINNELPC_SynthesizeUnitAVX2, LINNELPC_MAC_LOOP, order, order / 8)
+LINNELPC_DEFINE_SYNTHESIZE_UNIT_AVX2(LINNELPC_SynthesizeUnitAVX2Order8, LINNELPC_MAC_UNROLL, 8, 1)
+LINNELPC_DEFINE_SYNTHESIZE_UNIT_AVX2(LINNELPC_SynthesizeUnitAVX2Order16, LINNELPC_MAC_UNROLL, 16, 2)
+LINNELPC_DEFINE_SYNTHESIZE_UNIT_AVX2(LINNELPC_SynthesizeUnitAVX2Order32, LINNELPC_MAC_UNROLL, 32, 4)
+LINNELPC_DEFINE_SYNTHESIZE_UNIT_AVX2(LINNELPC_SynthesizeUnitAVX2Order64, LINNELPC_MAC_UNROLL, 64, 8)
+LINNELPC_DEFINE_SYNTHESIZE_UNIT_AVX2(LINNELPC_SynthesizeUnitAVX2Order128, LINNELPC_MAC_UNROLL, 128, 16)
+
+/* 次数別のSSE4.1 単一ユニット合成 小さい次数ではスカラー実装を使う */
+static const LINNELPCSynthesizeFunction st_synthesize_unit_sse41_functions[LINNELPC_FUNCTION_TABLE_SIZE] = {
+    LINNELPC_SynthesizeUnitScalarOrder1, LINNELPC_SynthesizeUnitScalarOrder2,
+    LINNELPC_SynthesizeUnitScalarOrder4, LINNELPC_SynthesizeUnitSSE41Order8,
+    LINNELPC_SynthesizeUnitSSE41Order16, LINNELPC_SynthesizeUnitSSE41Order32,
+    LINNELPC_SynthesizeUnitSSE41Order64, LINNELPC_SynthesizeUnitSSE41Order128,
+    LINNELPC_SynthesizeUnitSSE41
+};
+
+/* 次数別のAVX2 単一ユニット合成 小さい次数ではスカラー実装を使う */
+static const LINNELPCSynthesizeFunction st_synthesize_unit_avx2_functions[LINNELPC_FUNCTION_TABLE_SIZE] = {
+    LINNELPC_SynthesizeUnitScalarOrder1, LINNELPC_SynthesizeUnitScalarOrder2,
+    LINNELPC_SynthesizeUnitScalarOrder4, LINNELPC_SynthesizeUnitAVX2Order8,
+    LINNELPC_SynthesizeUnitAVX2Order16, LINNELPC_SynthesizeUnitAVX2Order32,
+    LINNELPC_SynthesizeUnitAVX2Order64, LINNELPC_SynthesizeUnitAVX2Order128,
+    LINNELPC_SynthesizeUnitAVX2
+};
+
+#endif /* LINNE_USE_X86_SIMD */
+
+/* 単一ユニット合成の関数テーブルを選択 */
+static const LINNELPCSynthesizeFunction *LINNELPC_SelectUnitFunctionTable(uint32_t features, uint32_t nparams_per_unit)
+{
+#if defined(LINNE_USE_X86_SIMD)
+    /* 可変次数かつ小さい次数はスカラー実装の方が速い */
+    if ((LINNELPC_GetFunctionTableIndex(nparams_per_unit) < LINNELPC_NUM_SPECIALIZED_ORDERS)
+            || (nparams_per_unit >= LINNELPC_SINGLE_UNIT_SIMD_MIN_ORDER)) {
+        /* 内積をSIMD化 */
+        if (features & LINNEUTILITY_CPU_FEATURE_AVX2) {
+            return st_synthesize_unit_avx2_functions;
+        } else if (features & LINNEUTILITY_CPU_FEATURE_SSE41) {
+            return st_synthesize_unit_sse41_functions;
+        }
+    }
+#else
+    LINNEUTILITY_UNUSED_ARGUMENT(features);
+    LINNEUTILITY_UNUSED_ARGUMENT(nparams_per_unit);
+#endif
+
+    return st_synthesize_unit_scalar_functions;
+}
+
+/* ユニット並列合成の関数テーブルを選択 ユニット並列合成が使えない場合はNULLを返す */
+static const LINNELPCSynthesizeFunction *LINNELPC_SelectLanesFunctionTable(
+    uint32_t features, uint32_t num_units, uint32_t nparams_per_unit, uint32_t *num_lanes)
+{
+    LINNE_ASSERT(num_lanes != NULL);
+
+#if defined(LINNE_USE_X86_SIMD)
+    /* 使える最大幅のレーンにユニットを割り当てる */
+    /* 補足）ユニット数は2の冪なのでレーン数で割り切れる */
+    if ((num_units >= 16) && (nparams_per_unit * 16 <= LINNELPC_LANE_MAX_NUM_COEFS)
+            && (features & LINNEUTILITY_CPU_FEATURE_AVX512F)) {
+        (*num_lanes) = 16;
+        return st_synthesize_lanes_avx512_functions;
+    } else if ((num_units >= 8) && (nparams_per_unit * 8 <= LINNELPC_LANE_MAX_NUM_COEFS)
+            && (features & LINNEUTILITY_CPU_FEATURE_AVX2)) {
+        (*num_lanes) = 8;
+        return st_synthesize_lanes_avx2_functions;
+    } else if ((num_units >= 4) && (nparams_per_unit * 4 <= LINNELPC_LANE_MAX_NUM_COEFS)
+            && (features & LINNEUTILITY_CPU_FEATURE_SSE41)) {
+        (*num_lanes) = 4;
+        return st_synthesize_lanes_sse41_functions;
+    }
+#else
+    LINNEUTILITY_UNUSED_ARGUMENT(features);
+    LINNEUTILITY_UNUSED_ARGUMENT(num_units);
+    LINNEUTILITY_UNUSED_ARGUMENT(nparams_per_unit);
+#endif
+
+    (*num_lanes) = 1;
+    return NULL;
+}
+
+/* LPC係数により合成(in-place) */
+void LINNELPC_Synthesize(
+    int32_t *data, uint32_t num_samples,
+    const int32_t *coef, uint32_t coef_order, uint32_t coef_rshift, uint32_t num_units)
+{
+    uint32_t u, num_lanes, table_index;
+    const LINNELPCSynthesizeFunction *function_table;
+    const int32_t half = 1 << (coef_rshift - 1); /* 固定小数の0.5 */
+    const uint32_t nparams_per_unit = coef_order / num_units;
+    const uint32_t nsmpls_per_unit = num_samples / num_units;
+    const uint32_t features = LINNEUtility_GetCPUFeatures();
+
+    /* 引数チェック */
+    LINNE_ASSERT(data != NULL);
+    LINNE_ASSERT(coef != NULL);
+
+    /* ユニット数は2の冪であることを要求 */
+    LINNE_ASSERT(num_units > 0);
+    LINNE_ASSERT(LINNEUTILITY_IS_POWERED_OF_2(num_units));
+
+    table_index = LINNELPC_GetFunctionTableIndex(nparams_per_unit);
+
+    if (num_units == 1) {
+        function_table = LINNELPC_SelectUnitFunctionTable(features, nparams_per_unit);
+        num_lanes = 1;
+    } else if ((function_table = LINNELPC_SelectLanesFunctionTable(
+                    features, num_units, nparams_per_unit, &num_lanes)) == NULL) {
+        /* 次数固定の単一ユニット合成を全ユニットに適用 */
+        /* 次数可変の場合は複数ユニットを交互に処理するスカラー実装を使う */
+        if (table_index == LINNELPC_NUM_SPECIALIZED_ORDERS) {
+            LINNELPC_SynthesizeScalar(data, num_samples, coef, coef_order, coef_rshift, num_units);
+            return;
+        }
+        function_table = st_synthesize_unit_scalar_functions;
+    }
+
+    for (u = 0; u < num_units; u += num_lanes) {
+        function_table[table_index](&data[u * nsmpls_per_unit], nsmpls_per_unit,
+                &coef[u * nparams_per_unit], nparams_per_unit, half, coef_rshift);
+    }
+}
+
+/* 1層分のタイルを合成 */
+/* buffer: 先頭に次数分の履歴、続けてタイルを置く領域 */
+static void LINNELPC_SynthesizeLayerTile(
+    int32_t *buffer, const int32_t *input, uint32_t tile_head, uint32_t tile_size, uint32_t num_samples,
+    const int32_t *coef, uint32_t coef_order, uint32_t coef_rshift, uint32_t num_units, uint32_t features)
+{
+    uint32_t i;
+    const int32_t half = 1 << (coef_rshift - 1); /* 固定小数の0.5 */
+    const uint32_t nparams_per_unit = coef_order / num_units;
+    const uint32_t nsmpls_per_unit = num_samples / num_units;
+    const LINNELPCSynthesizeFunction synthesize_unit
+        = LINNELPC_SelectUnitFunctionTable(features, nparams_per_unit)[LINNELPC_GetFunctionTableIndex(nparams_per_unit)];
+    int32_t *ptile = &buffer[nparams_per_unit];
+
+    /* 前のタイル末尾の次数分のサンプルを履歴に移動 */
+    if (tile_head > 0) {
+        memmove(buffer, &buffer[LINNELPC_CASCADE_TILE_SIZE], sizeof(int32_t) * nparams_per_unit);
+    }
+    memcpy(ptile, input, sizeof(int32_t) * tile_size);
+
+    /* ユニット内のサンプル数が0の時は合成しない */
+    if (nsmpls_per_unit == 0) {
+        return;
+    }
+
+    /* ユニット境界で区切って合成 */
+    i = 0;
+    while (i < tile_size) {
+        const uint32_t unit = (tile_head + i) / nsmpls_per_unit;
+        const uint32_t pos = (tile_head + i) % nsmpls_per_unit;
+        uint32_t segment_end;
+        /* 剰余分の末尾サンプルは合成しない */
+        if (unit >= num_units) {
+            break;
+        }
+        segment_end = LINNEUTILITY_MIN(tile_size, i + nsmpls_per_unit - pos);
+        if (pos < nparams_per_unit) {
+            /* ユニット先頭の次数分のサンプルはそのまま */
+            i = LINNEUTILITY_MIN(segment_end, i + nparams_per_unit - pos);
+        } else {
+            /* 直前の次数分のサンプルを履歴として合成を継続 */
+            synthesize_unit(&buffer[i], nparams_per_unit + (segment_end - i),
+                    &coef[unit * nparams_per_unit], nparams_per_unit, half, coef_rshift);
+            i = segment_end;
+        }
+    }
+}
+
+/* タイル毎に合成する層数の取得 */
+uint32_t LINNELPC_GetNumCascadeTiledLayers(
+    const uint32_t *coef_orders, const uint32_t *num_units, uint32_t num_layers)
+{
+    int32_t l;
+    uint32_t num_lanes;
+    const uint32_t features = LINNEUtility_GetCPUFeatures();
+
+    LINNE_ASSERT(coef_orders != NULL);
+    LINNE_ASSERT(num_units != NULL);
+
+    /* 後段から見てユニット並列合成が使える層はブロック全体で合成する */
+    for (l = (int32_t)num_layers - 1; l >= 0; l--) {
+        if (LINNELPC_SelectLanesFunctionTable(features,
+                    num_units[l], coef_orders[l] / num_units[l], &num_lanes) == NULL) {
+            break;
+        }
+    }
+
+    return (uint32_t)(l + 1);
+}
+
+/* 1タイル分の多段LPC合成とデエンファシス(in-place) */
+void LINNELPC_SynthesizeCascadeTile(
+    int32_t *data, uint32_t tile_head, uint32_t tile_size, uint32_t num_samples,
+    int32_t * const *coefs, const uint32_t *coef_orders, const uint32_t *coef_rshifts, const uint32_t *num_units,
+    uint32_t num_tiled_layers, struct LINNEPreemphasisFilter *de_emphasis, int32_t **layer_buffers)
+{
+    int32_t l;
+    uint32_t i;
+    int32_t deemph_prev0, deemph_prev1;
+    const int32_t *input = &data[tile_head];
+    int32_t *output = &data[tile_head];
+    const uint32_t features = LINNEUtility_GetCPUFeatures();
+
+    /* 注意）現段階では2回を前提 */
+    LINNE_STATIC_ASSERT(LINNE_NUM_PREEMPHASIS_FILTERS == 2);
+
+    /* 引数チェック */
+    LINNE_ASSERT(data != NULL);
+    LINNE_ASSERT(coefs != NULL);
+    LINNE_ASSERT(coef_orders != NULL);
+    LINNE_ASSERT(coef_rshifts != NULL);
+    LINNE_ASSERT(num_units != NULL);
+    LINNE_ASSERT(de_emphasis != NULL);
+    LINNE_ASSERT(layer_buffers != NULL);
+    LINNE_ASSERT(tile_size <= LINNELPC_CASCADE_TILE_SIZE);
+    LINNE_ASSERT((tile_head + tile_size) <= num_samples);
+
+    /* LPC合成 */
+    for (l = (int32_t)num_tiled_layers - 1; l >= 0; l--) {
+        LINNELPC_SynthesizeLayerTile(layer_buffers[l], input, tile_head, tile_size, num_samples,
+                coefs[l], coef_orders[l], coef_rshifts[l], num_units[l], features);
+        input = &layer_buffers[l][coef_orders[l] / num_units[l]];
+    }
+
+    /* デエンファシス 後段のフィルタから逆順に適用 */
+    deemph_prev0 = de_emphasis[0].prev;
+    deemph_prev1 = de_emphasis[1].prev;
+    for (i = 0; i < tile_size; i++) {
+        deemph_prev1 = input[i] + ((deemph_prev1 * de_emphasis[1].coef) >> LINNE_PREEMPHASIS_COEF_SHIFT);
+        deemph_prev0 = deemph_prev1 + ((deemph_prev0 * de_emphasis[0].coef) >> LINNE_PREEMPHASIS_COEF_SHIFT);
+        output[i] = deemph_prev0;
+    }
+    de_emphasis[0].prev = deemph_prev0;
+    de_emphasis[1].prev = deemph_prev1;
+}
+
+/* 多段LPC合成とデエンファシスをまとめて適用(in-place) */
+void LINNELPC_SynthesizeCascade(
+    int32_t *data, uint32_t num_samples,
+    int32_t * const *coefs, const uint32_t *coef_orders, const uint32_t *coef_rshifts, const uint32_t *num_units,
+    uint32_t num_layers, struct LINNEPreemphasisFilter *de_emphasis, int32_t **layer_buffers)
+{
+    uint32_t l, tile_head, num_tiled_layers;
+    int32_t tmp;
+
+    /* 引数チェック */
+    LINNE_ASSERT(data != NULL);
+    LINNE_ASSERT(coefs != NULL);
+    LINNE_ASSERT(coef_orders != NULL);
+    LINNE_ASSERT(coef_rshifts != NULL);
+    LINNE_ASSERT(num_units != NULL);
+    LINNE_ASSERT(de_emphasis != NULL);
+    LINNE_ASSERT(layer_buffers != NULL);
+
+    /* ユニット並列合成が使える層は先にブロック全体を合成 */
+    num_tiled_layers = LINNELPC_GetNumCascadeTiledLayers(coef_orders, num_units, num_layers);
+    for (l = num_layers; l > num_tiled_layers; l--) {
+        LINNELPC_Synthesize(data, num_samples, coefs[l - 1], coef_orders[l - 1], coef_rshifts[l - 1], num_units[l - 1]);
+    }
+
+    /* 残りの層とデエンファシスはタイル毎にまとめて処理 */
+    for (tile_head = 0; tile_head < num_samples; tile_head += LINNELPC_CASCADE_TILE_SIZE) {
+        const uint32_t tile_size = LINNEUTILITY_MIN(LINNELPC_CASCADE_TILE_SIZE, num_samples - tile_head);
+        LINNELPC_SynthesizeCascadeTile(data, tile_head, tile_size, num_samples,
+                coefs, coef_orders, coef_rshifts, num_units, num_tiled_layers, de_emphasis, layer_buffers);
+    }
+
+    /* LINNEPreemphasisFilter_MultiStageDeemphasisと同じ状態で終える */
+    tmp = de_emphasis[0].prev;
+    de_emphasis[0].prev = de_emphasis[1].prev;
+    de_emphasis[1].prev = tmp;
+}
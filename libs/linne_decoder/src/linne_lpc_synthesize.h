@@ -3,6 +3,11 @@
 
 #include <stdint.h>
 
+/* 多段合成で一度に処理するサンプル数 */
+#define LINNELPC_CASCADE_TILE_SIZE 256
+
+struct LINNEPreemphasisFilter;
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -11,6 +16,25 @@ extern "C" {
 void LINNELPC_Synthesize(
     int32_t *data, uint32_t num_samples,  const int32_t *coef, uint32_t coef_order, uint32_t coef_rshift, uint32_t num_units);
 
+/* 多段LPC合成とデエンファシスをまとめて適用(in-place) */
+/* 層は後段から順に合成する layer_buffersには層毎に(次数 + LINNELPC_CASCADE_TILE_SIZE)の領域が必要 */
+void LINNELPC_SynthesizeCascade(
+    int32_t *data, uint32_t num_samples,
+    int32_t * const *coefs, const uint32_t *coef_orders, const uint32_t *coef_rshifts, const uint32_t *num_units,
+    uint32_t num_layers, struct LINNEPreemphasisFilter *de_emphasis, int32_t **layer_buffers);
+
+/* タイル毎に合成する層数の取得 これより後段の層はユニット並列でブロック全体を合成する */
+uint32_t LINNELPC_GetNumCascadeTiledLayers(
+    const uint32_t *coef_orders, const uint32_t *num_units, uint32_t num_layers);
+
+/* 1タイル分の多段LPC合成とデエンファシス(in-place) */
+/* タイルは先頭から順にLINNELPC_CASCADE_TILE_SIZE毎に与える 後段の層は合成済みであること */
+/* de_emphasisの直前値はタイル間で引き継ぐ処理途中の値となる */
+void LINNELPC_SynthesizeCascadeTile(
+    int32_t *data, uint32_t tile_head, uint32_t tile_size, uint32_t num_samples,
+    int32_t * const *coefs, const uint32_t *coef_orders, const uint32_t *coef_rshifts, const uint32_t *num_units,
+    uint32_t num_tiled_layers, struct LINNEPreemphasisFilter *de_emphasis, int32_t **layer_buffers);
+
 #ifdef __cplusplus
 }
 #endif
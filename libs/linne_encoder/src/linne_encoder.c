@@ -12,42 +12,71 @@
 #include "linne_network.h"
 #include "linne_coder.h"
 #include "static_huffman.h"
+#include "thread_pool.h"
+
+/* 1チャンネル分の分析タスク */
+struct LINNEEncoderAnalyzeTask {
+    struct LINNEEncoder *encoder; /* エンコーダハンドル */
+    uint32_t ch; /* 分析するチャンネル */
+    uint32_t num_analyze_samples; /* 分析サンプル数 */
+};
 
 /* エンコーダハンドル */
 struct LINNEEncoder {
     struct LINNEHeader header; /* ヘッダ */
     struct LINNECoder *coder; /* 符号化ハンドル */
-    uint32_t max_num_channels; /* バッファチャンネル数 */
-    uint32_t max_num_samples_per_block; /* バッファサンプル数 */
+    uint32_t max_num_channels; /* 最大チャンネル数 */
+    uint32_t max_num_samples_per_block; /* 最大ブロックあたりサンプル数 */
     uint32_t max_num_layers; /* 最大レイヤー数 */
     uint32_t max_num_parameters_per_layer; /* 最大レイヤーあたりパラメータ数 */
+    uint32_t buffer_num_channels; /* バッファチャンネル数 */
+    uint32_t buffer_num_samples_per_block; /* バッファサンプル数 */
+    uint32_t buffer_num_layers; /* バッファレイヤー数 */
+    uint32_t buffer_num_parameters_per_layer; /* バッファレイヤーあたりパラメータ数 */
+    uint32_t num_workers; /* チャンネル分析のワーカ数 */
     uint8_t set_parameter; /* パラメータセット済み？ */
     uint8_t enable_learning; /* ネットワークの学習を行う？ */
     uint8_t num_afmethod_iterations; /* 補助関数法の繰り返し回数(0で実行しない) */
     struct LINNEPreemphasisFilter **pre_emphasis; /* プリエンファシスフィルタ */
     int32_t **pre_emphasis_prev; /* プリエンファシスフィルタの直前のサンプル */
-    struct LINNENetwork *network; /* ネットワーク */
-    struct LINNENetworkTrainer *trainer; /* LPCネットワークトレーナー */
+    struct LINNENetwork **network; /* ネットワーク（ワーカ毎） */
+    struct LINNENetworkTrainer **trainer; /* LPCネットワークトレーナー（ワーカ毎） */
+    struct ThreadPool *thread_pool; /* チャンネル分析のスレッドプール */
+    struct LINNEEncoderAnalyzeTask *tasks; /* チャンネル毎の分析タスク */
     double ***params_double; /* LPC係数(double) */
     int32_t ***params_int; /* LPC係数(int) */
     uint32_t **num_units; /* 各層のユニット数 */
     uint32_t **rshifts; /* 各層のLPC係数右シフト量 */
     int32_t **buffer_int; /* 信号バッファ(int) */
     int32_t **residual; /* 残差信号 */
-    double *buffer_double; /* 信号バッファ(double) */
+    uint32_t *residual_porders; /* 残差符号化の分割次数（サイズ計算時に探索したもの） */
+    uint32_t compress_data_size; /* サイズ計算時に求めた圧縮データサイズ */
+    int32_t **cascade_buffers; /* 多段予測の層毎のタイルバッファ */
+    double **buffer_double; /* 信号バッファ(double)（ワーカ毎） */
     const struct LINNEParameterPreset *parameter_preset; /* パラメータプリセット */
     struct StaticHuffmanCodes coef_code; /* 係数ハフマン符号 */
     uint8_t alloced_by_own; /* 領域を自前確保しているか？ */
+    struct LINNEAllocator allocator; /* 自前確保に使ったアロケータ */
     void *work; /* ワーク領域先頭ポインタ */
+    void *buffer_work; /* 自前確保したバッファ領域先頭ポインタ */
 };
 
 /* エンコードパラメータをヘッダに変換 */
 static LINNEError LINNEEncoder_ConvertParameterToHeader(
         const struct LINNEEncodeParameter *parameter, uint32_t num_samples,
         struct LINNEHeader *header);
+/* ワーカ数の計算 */
+static uint32_t LINNEEncoder_CalculateNumWorkers(const struct LINNEEncoderConfig *config);
 /* ブロックデータタイプの判定 */
 static LINNEBlockDataType LINNEEncoder_DecideBlockDataType(
-        struct LINNEEncoder *encoder, const int32_t *const *input, uint32_t num_samples);
+        struct LINNEEncoder *encoder, uint32_t num_samples);
+
+/* 生データブロックのデータサイズ計算 */
+static uint32_t LINNEEncoder_CalculateRawDataSize(
+        uint32_t num_channels, uint32_t bits_per_sample, uint32_t num_samples)
+{
+    return (bits_per_sample * num_samples * num_channels + 7) / 8;
+}
 
 /* ヘッダエンコード */
 LINNEApiResult LINNEEncoder_EncodeHeader(
@@ -118,7 +147,7 @@ LINNEApiResult LINNEEncoder_EncodeHeader(
     /* チャンネル数 */
     ByteArray_PutUint16BE(data_pos, header->num_channels);
     /* サンプル数 */
-    ByteArray_PutUint32BE(data_pos, header->num_samples);
+    ByteArray_PutUint64BE(data_pos, header->num_samples);
     /* サンプリングレート */
     ByteArray_PutUint32BE(data_pos, header->sampling_rate);
     /* サンプルあたりビット数 */
@@ -197,6 +226,158 @@ static LINNEError LINNEEncoder_ConvertParameterToHeader(
     return LINNE_ERROR_OK;
 }
 
+/* ハンドル本体・符号化ハンドル・スレッドプールなど、バッファ以外の領域のワークサイズ計算 */
+static int32_t LINNEEncoder_CalculateHandleWorkSize(const struct LINNEEncoderConfig *config)
+{
+    int32_t work_size, tmp_work_size;
+    uint32_t num_workers;
+
+    LINNE_ASSERT(config != NULL);
+
+    /* ハンドル本体のサイズ */
+    work_size = sizeof(struct LINNEEncoder) + LINNE_MEMORY_ALIGNMENT;
+
+    /* 符号化ハンドルのサイズ */
+    if ((tmp_work_size = LINNECoder_CalculateWorkSize()) < 0) {
+        return -1;
+    }
+    work_size += tmp_work_size;
+
+    /* ワーカ数 */
+    num_workers = LINNEEncoder_CalculateNumWorkers(config);
+
+    /* スレッドプールと分析タスクのサイズ */
+    {
+        struct ThreadPoolConfig pool_config;
+        pool_config.max_num_threads = num_workers;
+        pool_config.max_num_tasks = config->max_num_channels;
+        pool_config.allocator = NULL;
+        if ((tmp_work_size = ThreadPool_CalculateWorkSize(&pool_config)) < 0) {
+            return -1;
+        }
+        work_size += tmp_work_size;
+    }
+    work_size += (int32_t)(config->max_num_channels * sizeof(struct LINNEEncoderAnalyzeTask)) + LINNE_MEMORY_ALIGNMENT;
+
+    /* 残差符号化の分割次数 */
+    work_size += (int32_t)(config->max_num_channels * sizeof(uint32_t)) + LINNE_MEMORY_ALIGNMENT;
+
+    /* ネットワークとトレーナーのポインタ配列 */
+    work_size += (int32_t)(num_workers * sizeof(struct LINNENetwork *)) + LINNE_MEMORY_ALIGNMENT;
+    work_size += (int32_t)(num_workers * sizeof(struct LINNENetworkTrainer *)) + LINNE_MEMORY_ALIGNMENT;
+
+    return work_size;
+}
+
+/* ネットワーク・信号処理バッファ領域のワークサイズ計算 */
+static int32_t LINNEEncoder_CalculateBufferWorkSize(
+        uint32_t num_channels, uint32_t num_samples_per_block,
+        uint32_t num_layers, uint32_t num_parameters_per_layer, uint32_t num_workers)
+{
+    int32_t work_size, tmp_work_size;
+
+    /* 先頭ポインタのアラインメント分 */
+    work_size = LINNE_MEMORY_ALIGNMENT;
+
+    /* LPCネットのサイズ */
+    if ((tmp_work_size = LINNENetwork_CalculateWorkSize(
+                    num_samples_per_block, num_layers, num_parameters_per_layer)) < 0) {
+        return -1;
+    }
+    work_size += (int32_t)num_workers * tmp_work_size;
+
+    /* トレーナーのサイズ */
+    if ((tmp_work_size = LINNENetworkTrainer_CalculateWorkSize(num_layers, num_parameters_per_layer)) < 0) {
+        return -1;
+    }
+    work_size += (int32_t)num_workers * tmp_work_size;
+
+    /* プリエンファシスフィルタのサイズ */
+    work_size += (int32_t)LINNE_CALCULATE_2DIMARRAY_WORKSIZE(struct LINNEPreemphasisFilter, num_channels, LINNE_NUM_PREEMPHASIS_FILTERS);
+    work_size += (int32_t)LINNE_CALCULATE_2DIMARRAY_WORKSIZE(int32_t, num_channels, LINNE_NUM_PREEMPHASIS_FILTERS);
+    /* パラメータバッファ領域 */
+    /* LPC係数(int) */
+    work_size += (int32_t)LINNE_CALCULATE_3DIMARRAY_WORKSIZE(int32_t, num_channels, num_layers, num_parameters_per_layer);
+    /* LPC係数(double) */
+    work_size += (int32_t)LINNE_CALCULATE_3DIMARRAY_WORKSIZE(double, num_channels, num_layers, num_parameters_per_layer);
+    /* 各層のユニット数 */
+    work_size += (int32_t)LINNE_CALCULATE_2DIMARRAY_WORKSIZE(uint32_t, num_channels, num_layers);
+    /* 各層のLPC係数右シフト量 */
+    work_size += (int32_t)LINNE_CALCULATE_2DIMARRAY_WORKSIZE(uint32_t, num_channels, num_layers);
+    /* 信号処理バッファのサイズ */
+    work_size += (int32_t)LINNE_CALCULATE_2DIMARRAY_WORKSIZE(int32_t, num_channels, num_samples_per_block);
+    work_size += (int32_t)LINNE_CALCULATE_2DIMARRAY_WORKSIZE(double, num_workers, num_samples_per_block);
+    /* 残差信号のサイズ */
+    work_size += (int32_t)LINNE_CALCULATE_2DIMARRAY_WORKSIZE(int32_t, num_channels, num_samples_per_block);
+    /* 多段予測のタイルバッファのサイズ */
+    work_size += (int32_t)LINNE_CALCULATE_2DIMARRAY_WORKSIZE(int32_t, num_layers, num_parameters_per_layer + LINNELPC_CASCADE_TILE_SIZE);
+
+    return work_size;
+}
+
+/* 単一データブロックエンコードの最大出力サイズ計算 */
+LINNEApiResult LINNEEncoder_CalculateMaxBlockSize(
+        const struct LINNEEncodeParameter *parameter, uint32_t *max_block_size)
+{
+    struct LINNEHeader tmp_header;
+
+    /* 引数チェック */
+    if ((parameter == NULL) || (max_block_size == NULL)) {
+        return LINNE_APIRESULT_INVALID_ARGUMENT;
+    }
+
+    /* パラメータ設定がおかしくないか、ヘッダへの変換を通じて確認 */
+    if (LINNEEncoder_ConvertParameterToHeader(parameter, 0, &tmp_header) != LINNE_ERROR_OK) {
+        return LINNE_APIRESULT_INVALID_FORMAT;
+    }
+
+    /* 圧縮データが生データを超える場合は生データで出力するため、
+    * ブロックヘッダ + 生データのサイズが最大 */
+    (*max_block_size) = LINNE_BLOCK_HEADER_SIZE + LINNEEncoder_CalculateRawDataSize(
+            parameter->num_channels, parameter->bits_per_sample, parameter->num_samples_per_block);
+
+    return LINNE_APIRESULT_OK;
+}
+
+/* ヘッダ含めファイル全体をエンコードした時の最大出力サイズ計算 */
+LINNEApiResult LINNEEncoder_CalculateMaxOutputSize(
+        const struct LINNEEncodeParameter *parameter, uint32_t num_samples, uint32_t *max_output_size)
+{
+    uint64_t output_size;
+    uint32_t num_blocks, num_remain_samples;
+    LINNEApiResult ret;
+
+    /* 引数チェック */
+    if ((parameter == NULL) || (max_output_size == NULL)) {
+        return LINNE_APIRESULT_INVALID_ARGUMENT;
+    }
+
+    /* パラメータ設定のチェックも兼ねて最大ブロックサイズを計算 */
+    {
+        uint32_t max_block_size;
+        if ((ret = LINNEEncoder_CalculateMaxBlockSize(parameter, &max_block_size)) != LINNE_APIRESULT_OK) {
+            return ret;
+        }
+        num_blocks = num_samples / parameter->num_samples_per_block;
+        output_size = LINNE_HEADER_SIZE + (uint64_t)num_blocks * max_block_size;
+    }
+
+    /* 端数のブロック */
+    num_remain_samples = num_samples % parameter->num_samples_per_block;
+    if (num_remain_samples > 0) {
+        output_size += LINNE_BLOCK_HEADER_SIZE + LINNEEncoder_CalculateRawDataSize(
+                parameter->num_channels, parameter->bits_per_sample, num_remain_samples);
+    }
+
+    /* 32bitで表せないサイズ */
+    if (output_size > UINT32_MAX) {
+        return LINNE_APIRESULT_NG;
+    }
+
+    (*max_output_size) = (uint32_t)output_size;
+    return LINNE_APIRESULT_OK;
+}
+
 /* エンコーダハンドル作成に必要なワークサイズ計算 */
 int32_t LINNEEncoder_CalculateWorkSize(const struct LINNEEncoderConfig *config)
 {
@@ -220,70 +401,226 @@ int32_t LINNEEncoder_CalculateWorkSize(const struct LINNEEncoderConfig *config)
         return -1;
     }
 
-    /* ハンドル本体のサイズ */
-    work_size = sizeof(struct LINNEEncoder) + LINNE_MEMORY_ALIGNMENT;
-
-    /* 符号化ハンドルのサイズ */
-    if ((tmp_work_size = LINNECoder_CalculateWorkSize()) < 0) {
+    /* ハンドル本体などのサイズ */
+    if ((work_size = LINNEEncoder_CalculateHandleWorkSize(config)) < 0) {
         return -1;
     }
-    work_size += tmp_work_size;
 
-    /* LPCネットのサイズ */
-    if ((tmp_work_size = LINNENetwork_CalculateWorkSize(
-                    config->max_num_samples_per_block, config->max_num_layers, config->max_num_parameters_per_layer)) < 0) {
+    /* バッファ領域のサイズ */
+    /* 補足）ワーク領域を外部から与えられた場合は最大構成のバッファを確保する */
+    if ((tmp_work_size = LINNEEncoder_CalculateBufferWorkSize(
+                    config->max_num_channels, config->max_num_samples_per_block,
+                    config->max_num_layers, config->max_num_parameters_per_layer,
+                    LINNEEncoder_CalculateNumWorkers(config))) < 0) {
         return -1;
     }
     work_size += tmp_work_size;
 
-    /* トレーナーのサイズ */
-    if ((tmp_work_size = LINNENetworkTrainer_CalculateWorkSize(
-                    config->max_num_layers, config->max_num_parameters_per_layer)) < 0) {
-        return -1;
+    return work_size;
+}
+
+/* ネットワーク・信号処理バッファ領域の割り当て */
+static LINNEError LINNEEncoder_AllocateBuffers(
+        struct LINNEEncoder *encoder,
+        uint32_t num_channels, uint32_t num_samples_per_block,
+        uint32_t num_layers, uint32_t num_parameters_per_layer,
+        void *work, int32_t work_size)
+{
+    uint32_t ch, l, w;
+    uint8_t *work_ptr;
+
+    LINNE_ASSERT(encoder != NULL);
+    LINNE_ASSERT(work != NULL);
+    LINNE_ASSERT(work_size >= LINNEEncoder_CalculateBufferWorkSize(
+                num_channels, num_samples_per_block, num_layers, num_parameters_per_layer, encoder->num_workers));
+
+    /* ワーク領域先頭ポインタ取得 */
+    work_ptr = (uint8_t *)LINNEUTILITY_ROUNDUP((uintptr_t)work, LINNE_MEMORY_ALIGNMENT);
+
+    /* ネットワークとトレーナーをワーカ毎に作成 */
+    for (w = 0; w < encoder->num_workers; w++) {
+        const int32_t network_size = LINNENetwork_CalculateWorkSize(
+                num_samples_per_block, num_layers, num_parameters_per_layer);
+        const int32_t trainer_size = LINNENetworkTrainer_CalculateWorkSize(
+                num_layers, num_parameters_per_layer);
+        if ((encoder->network[w] = LINNENetwork_Create(
+                num_samples_per_block, num_layers, num_parameters_per_layer, work_ptr, network_size)) == NULL) {
+            return LINNE_ERROR_NG;
+        }
+        work_ptr += network_size;
+        if ((encoder->trainer[w] = LINNENetworkTrainer_Create(
+                num_layers, num_parameters_per_layer, work_ptr, trainer_size)) == NULL) {
+            return LINNE_ERROR_NG;
+        }
+        work_ptr += trainer_size;
     }
-    work_size += tmp_work_size;
 
-    /* プリエンファシスフィルタのサイズ */
-    work_size += LINNE_CALCULATE_2DIMARRAY_WORKSIZE(struct LINNEPreemphasisFilter, config->max_num_channels, LINNE_NUM_PREEMPHASIS_FILTERS);
-    work_size += LINNE_CALCULATE_2DIMARRAY_WORKSIZE(int32_t, config->max_num_channels, LINNE_NUM_PREEMPHASIS_FILTERS);
-    /* パラメータバッファ領域 */
+    /* プリエンファシスフィルタの作成 */
+    LINNE_ALLOCATE_2DIMARRAY(encoder->pre_emphasis,
+            work_ptr, struct LINNEPreemphasisFilter, num_channels, LINNE_NUM_PREEMPHASIS_FILTERS);
+    /* プリエンファシスフィルタのバッファ領域 */
+    LINNE_ALLOCATE_2DIMARRAY(encoder->pre_emphasis_prev,
+            work_ptr, int32_t, num_channels, LINNE_NUM_PREEMPHASIS_FILTERS);
+
+    /* バッファ領域の確保 全てのポインタをアラインメント */
     /* LPC係数(int) */
-    work_size += LINNE_CALCULATE_3DIMARRAY_WORKSIZE(int32_t, config->max_num_channels, config->max_num_layers, config->max_num_parameters_per_layer);
+    LINNE_ALLOCATE_3DIMARRAY(encoder->params_int,
+            work_ptr, int32_t, num_channels, num_layers, num_parameters_per_layer);
     /* LPC係数(double) */
-    work_size += LINNE_CALCULATE_3DIMARRAY_WORKSIZE(double, config->max_num_channels, config->max_num_layers, config->max_num_parameters_per_layer);
+    LINNE_ALLOCATE_3DIMARRAY(encoder->params_double,
+            work_ptr, double, num_channels, num_layers, num_parameters_per_layer);
     /* 各層のユニット数 */
-    work_size += LINNE_CALCULATE_2DIMARRAY_WORKSIZE(uint32_t, config->max_num_channels, config->max_num_layers);
+    LINNE_ALLOCATE_2DIMARRAY(encoder->num_units,
+            work_ptr, uint32_t, num_channels, num_layers);
     /* 各層のLPC係数右シフト量 */
-    work_size += LINNE_CALCULATE_2DIMARRAY_WORKSIZE(uint32_t, config->max_num_channels, config->max_num_layers);
-    /* 信号処理バッファのサイズ */
-    work_size += LINNE_CALCULATE_2DIMARRAY_WORKSIZE(int32_t, config->max_num_channels, config->max_num_samples_per_block);
-    work_size += config->max_num_samples_per_block * sizeof(double) + LINNE_MEMORY_ALIGNMENT;
-    /* 残差信号のサイズ */
-    work_size += LINNE_CALCULATE_2DIMARRAY_WORKSIZE(int32_t, config->max_num_channels, config->max_num_samples_per_block);
+    LINNE_ALLOCATE_2DIMARRAY(encoder->rshifts,
+            work_ptr, uint32_t, num_channels, num_layers);
 
-    return work_size;
+    /* 信号処理用バッファ領域 */
+    LINNE_ALLOCATE_2DIMARRAY(encoder->buffer_int,
+            work_ptr, int32_t, num_channels, num_samples_per_block);
+    LINNE_ALLOCATE_2DIMARRAY(encoder->residual,
+            work_ptr, int32_t, num_channels, num_samples_per_block);
+    /* 多段予測のタイルバッファ */
+    LINNE_ALLOCATE_2DIMARRAY(encoder->cascade_buffers,
+            work_ptr, int32_t, num_layers, num_parameters_per_layer + LINNELPC_CASCADE_TILE_SIZE);
+
+    /* doubleバッファ */
+    LINNE_ALLOCATE_2DIMARRAY(encoder->buffer_double,
+            work_ptr, double, encoder->num_workers, num_samples_per_block);
+
+    /* バッファオーバーランチェック */
+    /* 補足）既にメモリを破壊している可能性があるので、チェックに失敗したら落とす */
+    LINNE_ASSERT((work_ptr - (uint8_t *)work) <= work_size);
+
+    /* プリエンファシスフィルタ初期化 */
+    for (ch = 0; ch < num_channels; ch++) {
+        for (l = 0; l < LINNE_NUM_PREEMPHASIS_FILTERS; l++) {
+            LINNEPreemphasisFilter_Initialize(&encoder->pre_emphasis[ch][l]);
+        }
+    }
+
+    /* バッファの大きさを記録 */
+    encoder->buffer_num_channels = num_channels;
+    encoder->buffer_num_samples_per_block = num_samples_per_block;
+    encoder->buffer_num_layers = num_layers;
+    encoder->buffer_num_parameters_per_layer = num_parameters_per_layer;
+
+    return LINNE_ERROR_OK;
+}
+
+/* ネットワーク・信号処理バッファ領域の破棄 */
+static void LINNEEncoder_DestroyBuffers(struct LINNEEncoder *encoder)
+{
+    uint32_t w;
+
+    LINNE_ASSERT(encoder != NULL);
+
+    /* バッファ確保済みならネットワークとトレーナーを破棄 */
+    if (encoder->buffer_num_channels > 0) {
+        for (w = 0; w < encoder->num_workers; w++) {
+            LINNENetworkTrainer_Destroy(encoder->trainer[w]);
+            LINNENetwork_Destroy(encoder->network[w]);
+        }
+    }
+    encoder->buffer_num_channels = 0;
+    encoder->buffer_num_samples_per_block = 0;
+    encoder->buffer_num_layers = 0;
+    encoder->buffer_num_parameters_per_layer = 0;
+
+    /* 自前確保した領域の解放 */
+    if (encoder->buffer_work != NULL) {
+        LINNEUtility_Free(&encoder->allocator, encoder->buffer_work);
+        encoder->buffer_work = NULL;
+    }
+}
+
+/* エンコードパラメータに必要な大きさのバッファを用意 */
+/* 補足）自前確保の場合はパラメータ設定時に必要な分だけ確保し、足りなくなった時のみ確保し直す */
+static LINNEError LINNEEncoder_PrepareBuffers(
+        struct LINNEEncoder *encoder, const struct LINNEEncodeParameter *parameter)
+{
+    uint32_t l, num_channels, num_samples_per_block, num_layers, num_parameters_per_layer;
+    int32_t work_size;
+    void *work;
+    const struct LINNEParameterPreset *preset;
+
+    LINNE_ASSERT(encoder != NULL);
+    LINNE_ASSERT(parameter != NULL);
+    LINNE_ASSERT(parameter->preset < LINNE_NUM_PARAMETER_PRESETS);
+
+    preset = &g_linne_parameter_preset[parameter->preset];
+
+    /* パラメータとプリセットから必要な大きさを計算 */
+    num_channels = parameter->num_channels;
+    num_samples_per_block = parameter->num_samples_per_block;
+    num_layers = preset->num_layers;
+    num_parameters_per_layer = 0;
+    for (l = 0; l < preset->num_layers; l++) {
+        num_parameters_per_layer = LINNEUTILITY_MAX(num_parameters_per_layer, preset->layer_num_params_list[l]);
+    }
+
+    /* 現在のバッファで足りている */
+    if ((num_channels <= encoder->buffer_num_channels)
+            && (num_samples_per_block <= encoder->buffer_num_samples_per_block)
+            && (num_layers <= encoder->buffer_num_layers)
+            && (num_parameters_per_layer <= encoder->buffer_num_parameters_per_layer)) {
+        return LINNE_ERROR_OK;
+    }
+
+    /* 外部から与えられた領域には最大構成のバッファを確保済みのため、ここには来ない */
+    LINNE_ASSERT(encoder->alloced_by_own == 1);
+
+    /* 確保し直しを繰り返さないよう、これまでの大きさとの大きい方を取る */
+    num_channels = LINNEUTILITY_MAX(num_channels, encoder->buffer_num_channels);
+    num_samples_per_block = LINNEUTILITY_MAX(num_samples_per_block, encoder->buffer_num_samples_per_block);
+    num_layers = LINNEUTILITY_MAX(num_layers, encoder->buffer_num_layers);
+    num_parameters_per_layer = LINNEUTILITY_MAX(num_parameters_per_layer, encoder->buffer_num_parameters_per_layer);
+
+    /* 古いバッファを破棄 */
+    LINNEEncoder_DestroyBuffers(encoder);
+
+    /* 新しいバッファを確保 */
+    if ((work_size = LINNEEncoder_CalculateBufferWorkSize(
+                    num_channels, num_samples_per_block, num_layers, num_parameters_per_layer, encoder->num_workers)) < 0) {
+        return LINNE_ERROR_NG;
+    }
+    if ((work = LINNEUtility_Allocate(&encoder->allocator, (uint32_t)work_size)) == NULL) {
+        return LINNE_ERROR_NG;
+    }
+    encoder->buffer_work = work;
+
+    return LINNEEncoder_AllocateBuffers(encoder,
+            num_channels, num_samples_per_block, num_layers, num_parameters_per_layer, work, work_size);
 }
 
 /* エンコーダハンドル作成 */
 struct LINNEEncoder *LINNEEncoder_Create(const struct LINNEEncoderConfig *config, void *work, int32_t work_size)
 {
-    uint32_t ch, l;
     struct LINNEEncoder *encoder;
     uint8_t tmp_alloc_by_own = 0;
     uint8_t *work_ptr;
 
     /* ワーク領域時前確保の場合 */
+    /* 補足）バッファ領域はパラメータ設定時に必要な分だけ確保するため、ここではハンドル本体などのみ確保 */
     if ((work == NULL) && (work_size == 0)) {
-        if ((work_size = LINNEEncoder_CalculateWorkSize(config)) < 0) {
+        if (LINNEEncoder_CalculateWorkSize(config) < 0) {
+            return NULL;
+        }
+        if (!LINNEUtility_CheckAllocator(config->allocator)) {
             return NULL;
         }
-        work = malloc((uint32_t)work_size);
+        work_size = LINNEEncoder_CalculateHandleWorkSize(config);
+        work = LINNEUtility_Allocate(config->allocator, (uint32_t)work_size);
         tmp_alloc_by_own = 1;
     }
 
     /* 引数チェック */
     if ((config == NULL) || (work == NULL)
-            || (work_size < LINNEEncoder_CalculateWorkSize(config))) {
+            || ((tmp_alloc_by_own == 0) && (work_size < LINNEEncoder_CalculateWorkSize(config)))) {
+        if ((tmp_alloc_by_own == 1) && (work != NULL)) {
+            LINNEUtility_Free(config->allocator, work);
+        }
         return NULL;
     }
 
@@ -292,12 +629,12 @@ struct LINNEEncoder *LINNEEncoder_Create(const struct LINNEEncoderConfig *config
             || (config->max_num_samples_per_block == 0)
             || (config->max_num_layers == 0)
             || (config->max_num_parameters_per_layer == 0)) {
-        return NULL;
+        goto EXIT_FAILURE_WITH_WORK_RELEASE;
     }
 
     /* ブロックサイズはパラメータ数より大きくなるべき */
     if (config->max_num_parameters_per_layer > config->max_num_samples_per_block) {
-        return NULL;
+        goto EXIT_FAILURE_WITH_WORK_RELEASE;
     }
 
     /* ワーク領域先頭ポインタ取得 */
@@ -312,96 +649,101 @@ struct LINNEEncoder *LINNEEncoder_Create(const struct LINNEEncoderConfig *config
     encoder->set_parameter = 0;
     encoder->alloced_by_own = tmp_alloc_by_own;
     encoder->work = work;
+    encoder->buffer_work = NULL;
+    if (config->allocator != NULL) {
+        encoder->allocator = (*config->allocator);
+    } else {
+        memset(&encoder->allocator, 0, sizeof(struct LINNEAllocator));
+    }
     encoder->max_num_channels = config->max_num_channels;
     encoder->max_num_samples_per_block = config->max_num_samples_per_block;
     encoder->max_num_layers = config->max_num_layers;
     encoder->max_num_parameters_per_layer = config->max_num_parameters_per_layer;
+    encoder->buffer_num_channels = 0;
+    encoder->buffer_num_samples_per_block = 0;
+    encoder->buffer_num_layers = 0;
+    encoder->buffer_num_parameters_per_layer = 0;
 
     /* 符号化ハンドルの作成 */
     {
         const int32_t coder_size = LINNECoder_CalculateWorkSize();
-        if ((encoder->coder = LINNECoder_Create(work_ptr, coder_size)) == NULL) {
-            return NULL;
+        if ((encoder->coder = LINNECoder_Create(NULL, work_ptr, coder_size)) == NULL) {
+            goto EXIT_FAILURE_WITH_WORK_RELEASE;
         }
         work_ptr += coder_size;
     }
 
-    /* ネットワークと領域確保 */
-    {
-        const int32_t network_size = LINNENetwork_CalculateWorkSize(
-                config->max_num_samples_per_block, config->max_num_layers, config->max_num_parameters_per_layer);
-        if ((encoder->network = LINNENetwork_Create(
-                config->max_num_samples_per_block, config->max_num_layers,
-                config->max_num_parameters_per_layer, work_ptr, network_size)) == NULL) {
-            return NULL;
+    /* ネットワークとトレーナーのポインタ配列をワーカ毎に領域確保 */
+    encoder->num_workers = LINNEEncoder_CalculateNumWorkers(config);
+    work_ptr = (uint8_t *)LINNEUTILITY_ROUNDUP((uintptr_t)work_ptr, LINNE_MEMORY_ALIGNMENT);
+    encoder->network = (struct LINNENetwork **)work_ptr;
+    work_ptr += encoder->num_workers * sizeof(struct LINNENetwork *);
+    work_ptr = (uint8_t *)LINNEUTILITY_ROUNDUP((uintptr_t)work_ptr, LINNE_MEMORY_ALIGNMENT);
+    encoder->trainer = (struct LINNENetworkTrainer **)work_ptr;
+    work_ptr += encoder->num_workers * sizeof(struct LINNENetworkTrainer *);
+
+    /* 分析タスクの領域確保 */
+    work_ptr = (uint8_t *)LINNEUTILITY_ROUNDUP((uintptr_t)work_ptr, LINNE_MEMORY_ALIGNMENT);
+    encoder->tasks = (struct LINNEEncoderAnalyzeTask *)work_ptr;
+    work_ptr += config->max_num_channels * sizeof(struct LINNEEncoderAnalyzeTask);
+
+    /* 残差符号化の分割次数の領域確保 */
+    work_ptr = (uint8_t *)LINNEUTILITY_ROUNDUP((uintptr_t)work_ptr, LINNE_MEMORY_ALIGNMENT);
+    encoder->residual_porders = (uint32_t *)work_ptr;
+    work_ptr += config->max_num_channels * sizeof(uint32_t);
+
+    /* 外部から与えられた領域には最大構成のバッファを割り当てる */
+    if (encoder->alloced_by_own == 0) {
+        const int32_t buffer_size = LINNEEncoder_CalculateBufferWorkSize(
+                config->max_num_channels, config->max_num_samples_per_block,
+                config->max_num_layers, config->max_num_parameters_per_layer, encoder->num_workers);
+        if (LINNEEncoder_AllocateBuffers(encoder,
+                    config->max_num_channels, config->max_num_samples_per_block,
+                    config->max_num_layers, config->max_num_parameters_per_layer,
+                    work_ptr, buffer_size) != LINNE_ERROR_OK) {
+            goto EXIT_FAILURE_WITH_WORK_RELEASE;
         }
-        work_ptr += network_size;
+        work_ptr += buffer_size;
     }
 
-    /* トレーナーの領域確保 */
+    /* スレッドプールの作成 */
+    /* 補足）作成に失敗した時にスレッドが残らないよう最後に作る */
     {
-        const int32_t trainer_size = LINNENetworkTrainer_CalculateWorkSize(
-                config->max_num_layers, config->max_num_parameters_per_layer);
-        if ((encoder->trainer = LINNENetworkTrainer_Create(
-                config->max_num_layers, config->max_num_parameters_per_layer, work_ptr, trainer_size)) == NULL) {
-            return NULL;
+        struct ThreadPoolConfig pool_config;
+        int32_t pool_size;
+        pool_config.max_num_threads = encoder->num_workers;
+        pool_config.max_num_tasks = config->max_num_channels;
+        pool_config.allocator = NULL;
+        pool_size = ThreadPool_CalculateWorkSize(&pool_config);
+        if ((encoder->thread_pool = ThreadPool_Create(&pool_config, work_ptr, pool_size)) == NULL) {
+            goto EXIT_FAILURE_WITH_WORK_RELEASE;
         }
-        work_ptr += trainer_size;
+        work_ptr += pool_size;
     }
 
-    /* プリエンファシスフィルタの作成 */
-    LINNE_ALLOCATE_2DIMARRAY(encoder->pre_emphasis,
-            work_ptr, struct LINNEPreemphasisFilter, config->max_num_channels, LINNE_NUM_PREEMPHASIS_FILTERS);
-    /* プリエンファシスフィルタのバッファ領域 */
-    LINNE_ALLOCATE_2DIMARRAY(encoder->pre_emphasis_prev,
-            work_ptr, int32_t, config->max_num_channels, LINNE_NUM_PREEMPHASIS_FILTERS);
-
-    /* バッファ領域の確保 全てのポインタをアラインメント */
-    /* LPC係数(int) */
-    LINNE_ALLOCATE_3DIMARRAY(encoder->params_int,
-            work_ptr, int32_t, config->max_num_channels, config->max_num_layers, config->max_num_parameters_per_layer);
-    /* LPC係数(double) */
-    LINNE_ALLOCATE_3DIMARRAY(encoder->params_double,
-            work_ptr, double, config->max_num_channels, config->max_num_layers, config->max_num_parameters_per_layer);
-    /* 各層のユニット数 */
-    LINNE_ALLOCATE_2DIMARRAY(encoder->num_units,
-            work_ptr, uint32_t, config->max_num_channels, config->max_num_layers);
-    /* 各層のLPC係数右シフト量 */
-    LINNE_ALLOCATE_2DIMARRAY(encoder->rshifts,
-            work_ptr, uint32_t, config->max_num_channels, config->max_num_layers);
-
-    /* 信号処理用バッファ領域 */
-    LINNE_ALLOCATE_2DIMARRAY(encoder->buffer_int,
-            work_ptr, int32_t, config->max_num_channels, config->max_num_samples_per_block);
-    LINNE_ALLOCATE_2DIMARRAY(encoder->residual,
-            work_ptr, int32_t, config->max_num_channels, config->max_num_samples_per_block);
-
-    /* doubleバッファ */
-    work_ptr = (uint8_t *)LINNEUTILITY_ROUNDUP((uintptr_t)work_ptr, LINNE_MEMORY_ALIGNMENT);
-    encoder->buffer_double = (double *)work_ptr;
-    work_ptr += config->max_num_samples_per_block * sizeof(double);
-
     /* バッファオーバーランチェック */
     /* 補足）既にメモリを破壊している可能性があるので、チェックに失敗したら落とす */
     LINNE_ASSERT((work_ptr - (uint8_t *)work) <= work_size);
 
-    /* プリエンファシスフィルタ初期化 */
-    for (ch = 0; ch < config->max_num_channels; ch++) {
-        for (l = 0; l < LINNE_NUM_PREEMPHASIS_FILTERS; l++) {
-            LINNEPreemphasisFilter_Initialize(&encoder->pre_emphasis[ch][l]);
-        }
-    }
-
     return encoder;
+
+EXIT_FAILURE_WITH_WORK_RELEASE:
+    /* 自前確保した領域を解放 */
+    if (tmp_alloc_by_own == 1) {
+        LINNEUtility_Free(config->allocator, work);
+    }
+    return NULL;
 }
 
 /* エンコーダハンドルの破棄 */
 void LINNEEncoder_Destroy(struct LINNEEncoder *encoder)
 {
     if (encoder != NULL) {
+        ThreadPool_Destroy(encoder->thread_pool);
+        LINNEEncoder_DestroyBuffers(encoder);
         LINNECoder_Destroy(encoder->coder);
         if (encoder->alloced_by_own == 1) {
-            free(encoder->work);
+            LINNEUtility_Free(&encoder->allocator, encoder->work);
         }
     }
 }
@@ -443,6 +785,12 @@ LINNEApiResult LINNEEncoder_SetEncodeParameter(
         }
     }
 
+    /* パラメータに合わせてバッファを用意 */
+    if (LINNEEncoder_PrepareBuffers(encoder, parameter) != LINNE_ERROR_OK) {
+        encoder->set_parameter = 0;
+        return LINNE_APIRESULT_NG;
+    }
+
     /* ヘッダ設定 */
     encoder->header = tmp_header;
 
@@ -451,9 +799,14 @@ LINNEApiResult LINNEEncoder_SetEncodeParameter(
     encoder->parameter_preset = &g_linne_parameter_preset[parameter->preset];
 
     /* LPCネットのパラメータ設定 */
-    LINNENetwork_SetLayerStructure(encoder->network,
-            parameter->num_samples_per_block,
-            encoder->parameter_preset->num_layers, encoder->parameter_preset->layer_num_params_list);
+    {
+        uint32_t w;
+        for (w = 0; w < encoder->num_workers; w++) {
+            LINNENetwork_SetLayerStructure(encoder->network[w],
+                    parameter->num_samples_per_block,
+                    encoder->parameter_preset->num_layers, encoder->parameter_preset->layer_num_params_list);
+        }
+    }
 
     /* 学習を行うかのフラグを立てる */
     encoder->enable_learning = parameter->enable_learning;
@@ -478,28 +831,31 @@ LINNEApiResult LINNEEncoder_SetEncodeParameter(
 
 /* ブロックデータタイプの判定 */
 static LINNEBlockDataType LINNEEncoder_DecideBlockDataType(
-        struct LINNEEncoder *encoder, const int32_t *const *input, uint32_t num_samples)
+        struct LINNEEncoder *encoder, uint32_t num_samples)
 {
     uint32_t ch, smpl;
     double mean_length;
     const struct LINNEHeader *header;
+    int32_t **input;
 
     LINNE_ASSERT(encoder != NULL);
-    LINNE_ASSERT(input != NULL);
     LINNE_ASSERT(encoder->set_parameter == 1);
 
     header = &encoder->header;
+    /* 入力は信号バッファにロード済み */
+    input = encoder->buffer_int;
+
 
     /* 平均符号長の計算 */
     mean_length = 0.0;
     for (ch = 0; ch < header->num_channels; ch++) {
         /* 入力をdouble化 */
         for (smpl = 0; smpl < num_samples; smpl++) {
-            encoder->buffer_double[smpl] = input[ch][smpl] * pow(2.0, -(int32_t)(header->bits_per_sample - 1));
+            encoder->buffer_double[0][smpl] = input[ch][smpl] * pow(2.0, -(int32_t)(header->bits_per_sample - 1));
         }
         /* 推定符号長計算 */
-        mean_length += LINNENetwork_EstimateCodeLength(encoder->network,
-                encoder->buffer_double, num_samples, header->bits_per_sample);
+        mean_length += LINNENetwork_EstimateCodeLength(encoder->network[0],
+                encoder->buffer_double[0], num_samples, header->bits_per_sample);
     }
     mean_length /= header->num_channels;
 
@@ -530,26 +886,27 @@ NOT_SILENCE:
 
 /* 生データブロックエンコード */
 static LINNEApiResult LINNEEncoder_EncodeRawData(
-        struct LINNEEncoder *encoder,
-        const int32_t *const *input, uint32_t num_samples,
+        struct LINNEEncoder *encoder, uint32_t num_samples,
         uint8_t *data, uint32_t data_size, uint32_t *output_size)
 {
     uint32_t ch, smpl;
     const struct LINNEHeader *header;
     uint8_t *data_ptr;
+    int32_t **input;
 
     /* 内部関数なので不正な引数はアサートで落とす */
     LINNE_ASSERT(encoder != NULL);
-    LINNE_ASSERT(input != NULL);
     LINNE_ASSERT(num_samples > 0);
     LINNE_ASSERT(data != NULL);
     LINNE_ASSERT(data_size > 0);
     LINNE_ASSERT(output_size != NULL);
 
     header = &(encoder->header);
+    /* 入力は信号バッファにロード済み */
+    input = encoder->buffer_int;
 
     /* 書き込み先のバッファサイズチェック */
-    if (data_size < (header->bits_per_sample * num_samples * header->num_channels) / 8) {
+    if (data_size < LINNEEncoder_CalculateRawDataSize(header->num_channels, header->bits_per_sample, num_samples)) {
         return LINNE_APIRESULT_INSUFFICIENT_BUFFER;
     }
 
@@ -560,7 +917,7 @@ static LINNEApiResult LINNEEncoder_EncodeRawData(
                 for (smpl = 0; smpl < num_samples; smpl++) {
                     for (ch = 0; ch < header->num_channels; ch++) {
                         ByteArray_PutUint8(data_ptr, LINNEUTILITY_SINT32_TO_UINT32(input[ch][smpl]));
-                        LINNE_ASSERT((uint32_t)(data_ptr - data) < data_size);
+                        LINNE_ASSERT((uint32_t)(data_ptr - data) <= data_size);
                     }
                 }
                 break;
@@ -568,7 +925,7 @@ static LINNEApiResult LINNEEncoder_EncodeRawData(
                 for (smpl = 0; smpl < num_samples; smpl++) {
                     for (ch = 0; ch < header->num_channels; ch++) {
                         ByteArray_PutUint16BE(data_ptr, LINNEUTILITY_SINT32_TO_UINT32(input[ch][smpl]));
-                        LINNE_ASSERT((uint32_t)(data_ptr - data) < data_size);
+                        LINNE_ASSERT((uint32_t)(data_ptr - data) <= data_size);
                     }
                 }
                 break;
@@ -576,7 +933,7 @@ static LINNEApiResult LINNEEncoder_EncodeRawData(
                 for (smpl = 0; smpl < num_samples; smpl++) {
                     for (ch = 0; ch < header->num_channels; ch++) {
                         ByteArray_PutUint24BE(data_ptr, LINNEUTILITY_SINT32_TO_UINT32(input[ch][smpl]));
-                        LINNE_ASSERT((uint32_t)(data_ptr - data) < data_size);
+                        LINNE_ASSERT((uint32_t)(data_ptr - data) <= data_size);
                     }
                 }
                 break;
@@ -590,36 +947,74 @@ static LINNEApiResult LINNEEncoder_EncodeRawData(
     return LINNE_APIRESULT_OK;
 }
 
-/* 圧縮データブロックエンコード */
-static LINNEApiResult LINNEEncoder_EncodeCompressData(
-        struct LINNEEncoder *encoder,
-        const int32_t *const *input, uint32_t num_samples,
-        uint8_t *data, uint32_t data_size, uint32_t *output_size)
+/* ワーカ数の計算 */
+static uint32_t LINNEEncoder_CalculateNumWorkers(const struct LINNEEncoderConfig *config)
+{
+    LINNE_ASSERT(config != NULL);
+
+    /* チャンネル数より多いワーカは不要 */
+    return LINNEUTILITY_MAX(1, LINNEUTILITY_MIN(config->max_num_threads, config->max_num_channels));
+}
+
+/* 1チャンネル分のLINNENetworkのパラメータ計算 */
+static void LINNEEncoder_AnalyzeChannel(
+        struct LINNEEncoder *encoder, uint32_t worker, uint32_t ch, uint32_t num_analyze_samples)
+{
+    uint32_t smpl, l;
+    const struct LINNEHeader *header = &(encoder->header);
+    struct LINNENetwork *network = encoder->network[worker];
+    double *buffer_double = encoder->buffer_double[worker];
+
+    /* double精度の信号に変換（[-1,1]の範囲に正規化） */
+    for (smpl = 0; smpl < num_analyze_samples; smpl++) {
+        buffer_double[smpl] = encoder->buffer_int[ch][smpl] * pow(2.0, -(int32_t)(header->bits_per_sample - 1));
+    }
+    /* ユニット数とパラメータ設定 */
+    LINNENetwork_SetUnitsAndParameters(network,
+        buffer_double, num_analyze_samples,
+        encoder->num_afmethod_iterations, encoder->parameter_preset->regular_terms_list, encoder->parameter_preset->num_regular_terms);
+    /* ネットワーク学習 */
+    if (encoder->enable_learning != 0) {
+        LINNENetworkTrainer_Train(encoder->trainer[worker],
+                network, buffer_double, num_analyze_samples,
+                LINNE_TRAINING_PARAMETER_MAX_NUM_ITRATION,
+                LINNE_TRAINING_PARAMETER_LEARNING_RATE,
+                LINNE_TRAINING_PARAMETER_LOSS_EPSILON);
+    }
+    /* ユニット数とパラメータ取得・量子化 */
+    LINNENetwork_GetLayerNumUnits(network, encoder->num_units[ch], encoder->buffer_num_layers);
+    LINNENetwork_GetParameters(network, encoder->params_double[ch], encoder->buffer_num_layers, encoder->buffer_num_parameters_per_layer);
+    for (l = 0; l < encoder->parameter_preset->num_layers; l++) {
+        LPC_QuantizeCoefficients(encoder->params_double[ch][l],
+                encoder->parameter_preset->layer_num_params_list[l], LINNE_LPC_COEFFICIENT_BITWIDTH,
+                encoder->params_int[ch][l], &encoder->rshifts[ch][l]);
+    }
+}
+
+/* スレッドプールで実行する分析タスク */
+static void LINNEEncoder_AnalyzeChannelTask(void *arg, uint32_t thread_index)
+{
+    const struct LINNEEncoderAnalyzeTask *task = (const struct LINNEEncoderAnalyzeTask *)arg;
+
+    /* 実行スレッドのネットワークを使う 結果はチャンネル毎の領域に書くため実行順によらない */
+    LINNE_ASSERT(thread_index < task->encoder->num_workers);
+    LINNEEncoder_AnalyzeChannel(task->encoder, thread_index, task->ch, task->num_analyze_samples);
+}
+
+/* 圧縮データブロックの分析と予測 残差とパラメータをエンコーダ内部に保持する */
+/* 補足）信号バッファにロード済みの入力をその場で書き換える */
+static LINNEApiResult LINNEEncoder_PredictCompressData(
+        struct LINNEEncoder *encoder, uint32_t num_samples)
 {
     uint32_t ch, l, num_analyze_samples;
-    struct BitStream writer;
     const struct LINNEHeader *header;
 
     /* 内部関数なので不正な引数はアサートで落とす */
     LINNE_ASSERT(encoder != NULL);
-    LINNE_ASSERT(input != NULL);
     LINNE_ASSERT(num_samples > 0);
-    LINNE_ASSERT(data != NULL);
-    LINNE_ASSERT(data_size > 0);
-    LINNE_ASSERT(output_size != NULL);
 
     header = &(encoder->header);
 
-    /* 入力をバッファにコピー */
-    for (ch = 0; ch < header->num_channels; ch++) {
-        memcpy(encoder->buffer_int[ch], input[ch], sizeof(int32_t) * num_samples);
-        /* バッファサイズより小さい入力のときは、末尾を0埋め */
-        if (num_samples < encoder->max_num_samples_per_block) {
-            const uint32_t remain = encoder->max_num_samples_per_block - num_samples;
-            memset(&encoder->buffer_int[ch][num_samples], 0, sizeof(int32_t) * remain);
-        }
-    }
-
     /* マルチチャンネル処理 */
     if (header->ch_process_method == LINNE_CH_PROCESS_METHOD_MS) {
         /* チャンネル数チェック */
@@ -655,46 +1050,88 @@ static LINNEApiResult LINNEEncoder_EncodeCompressData(
     }
 
     /* チャンネル毎にLINNENetworkのパラメータ計算 */
-    for (ch = 0; ch < header->num_channels; ch++) {
-        uint32_t smpl;
-        /* double精度の信号に変換（[-1,1]の範囲に正規化） */
-        for (smpl = 0; smpl < num_analyze_samples; smpl++) {
-            encoder->buffer_double[smpl] = encoder->buffer_int[ch][smpl] * pow(2.0, -(int32_t)(header->bits_per_sample - 1));
-        }
-        /* ユニット数とパラメータ設定 */
-        LINNENetwork_SetUnitsAndParameters(encoder->network,
-            encoder->buffer_double, num_analyze_samples,
-            encoder->num_afmethod_iterations, encoder->parameter_preset->regular_terms_list, encoder->parameter_preset->num_regular_terms);
-        /* ネットワーク学習 */
-        if (encoder->enable_learning != 0) {
-            LINNENetworkTrainer_Train(encoder->trainer,
-                    encoder->network, encoder->buffer_double, num_analyze_samples,
-                    LINNE_TRAINING_PARAMETER_MAX_NUM_ITRATION,
-                    LINNE_TRAINING_PARAMETER_LEARNING_RATE,
-                    LINNE_TRAINING_PARAMETER_LOSS_EPSILON);
-        }
-        /* ユニット数とパラメータ取得・量子化 */
-        LINNENetwork_GetLayerNumUnits(encoder->network, encoder->num_units[ch], encoder->max_num_layers);
-        LINNENetwork_GetParameters(encoder->network, encoder->params_double[ch], encoder->max_num_layers, encoder->max_num_parameters_per_layer);
-        for (l = 0; l < encoder->parameter_preset->num_layers; l++) {
-            LPC_QuantizeCoefficients(encoder->params_double[ch][l],
-                    encoder->parameter_preset->layer_num_params_list[l], LINNE_LPC_COEFFICIENT_BITWIDTH,
-                    encoder->params_int[ch][l], &encoder->rshifts[ch][l]);
+    /* 補足）チャンネル毎の分析は独立しているためスレッドプールで並列に行う */
+    {
+        struct ThreadPoolTaskGroup group;
+        ThreadPool_InitializeTaskGroup(&group);
+        for (ch = 0; ch < header->num_channels; ch++) {
+            encoder->tasks[ch].encoder = encoder;
+            encoder->tasks[ch].ch = ch;
+            encoder->tasks[ch].num_analyze_samples = num_analyze_samples;
+            ThreadPool_Submit(encoder->thread_pool, &group, LINNEEncoder_AnalyzeChannelTask, &encoder->tasks[ch]);
         }
+        ThreadPool_Wait(encoder->thread_pool, &group);
     }
 
     /* チャンネル毎にLPC予測 */
     for (ch = 0; ch < header->num_channels; ch++) {
-        /* LPC予測 */
+        /* 全レイヤーの予測を1パスで行い最終レイヤーの残差を得る */
+        LINNELPC_PredictCascade(encoder->buffer_int[ch], num_samples,
+            encoder->params_int[ch], encoder->parameter_preset->layer_num_params_list,
+            encoder->rshifts[ch], encoder->num_units[ch], encoder->parameter_preset->num_layers,
+            encoder->residual[ch], encoder->cascade_buffers);
+    }
+
+    return LINNE_APIRESULT_OK;
+}
+
+/* 圧縮データブロックのデータサイズ計算 予測済みのパラメータと残差から求める */
+static uint32_t LINNEEncoder_CalculateCompressDataSize(struct LINNEEncoder *encoder, uint32_t num_samples)
+{
+    uint32_t ch, l, i, bits;
+    const struct LINNEHeader *header;
+
+    LINNE_ASSERT(encoder != NULL);
+    LINNE_ASSERT(num_samples > 0);
+
+    header = &(encoder->header);
+
+    /* プリエンファシスフィルタのバッファと係数 */
+    bits = (uint32_t)header->num_channels * LINNE_NUM_PREEMPHASIS_FILTERS
+        * (((uint32_t)header->bits_per_sample + 1) + (LINNE_PREEMPHASIS_COEF_SHIFT - 1));
+
+    /* ユニット数/LPC係数右シフト量/LPC係数 */
+    for (ch = 0; ch < header->num_channels; ch++) {
         for (l = 0; l < encoder->parameter_preset->num_layers; l++) {
-            LINNELPC_Predict(encoder->buffer_int[ch],
-                num_samples, encoder->params_int[ch][l], encoder->parameter_preset->layer_num_params_list[l],
-                encoder->residual[ch], encoder->rshifts[ch][l], encoder->num_units[ch][l]);
-            /* 残差を次のレイヤーの入力へ */
-            memcpy(encoder->buffer_int[ch], encoder->residual[ch], sizeof(int32_t) * num_samples);
+            bits += LINNE_LOG2_NUM_UNITS_BITWIDTH + LINNE_RSHIFT_LPC_COEFFICIENT_BITWIDTH;
+            for (i = 0; i < encoder->parameter_preset->layer_num_params_list[l]; i++) {
+                const uint32_t uval = LINNEUTILITY_SINT32_TO_UINT32(encoder->params_int[ch][l][i]);
+                bits += encoder->coef_code.codes[uval].bit_count;
+            }
         }
     }
 
+    /* 残差 */
+    for (ch = 0; ch < header->num_channels; ch++) {
+        bits += LINNECoder_CalculateCodeLength(encoder->coder,
+                encoder->residual[ch], num_samples, &encoder->residual_porders[ch]);
+    }
+
+    /* バイト境界に切り上げ 符号化時の確認のため記録しておく */
+    encoder->compress_data_size = (bits + 7) / 8;
+    return encoder->compress_data_size;
+}
+
+/* 圧縮データブロックエンコード 予測済みのパラメータと残差を書き出す */
+static LINNEApiResult LINNEEncoder_EncodeCompressData(
+        struct LINNEEncoder *encoder, uint32_t num_samples,
+        uint8_t *data, uint32_t data_size, uint32_t *output_size)
+{
+    uint32_t ch, l;
+    struct BitStream writer;
+    const struct LINNEHeader *header;
+
+    /* 内部関数なので不正な引数はアサートで落とす */
+    LINNE_ASSERT(encoder != NULL);
+    LINNE_ASSERT(num_samples > 0);
+    LINNE_ASSERT(data != NULL);
+    LINNE_ASSERT(data_size > 0);
+    LINNE_ASSERT(output_size != NULL);
+
+    header = &(encoder->header);
+
+    /* 補足）書き込み先のバッファサイズは呼び出し元でチェック済み */
+
     /* ビットライタ作成 */
     BitWriter_Open(&writer, data, data_size);
 
@@ -734,9 +1171,10 @@ static LINNEApiResult LINNEEncoder_EncodeCompressData(
         }
     }
 
-    /* 残差符号化 */
+    /* 残差符号化 分割次数はサイズ計算時に探索したものを使う */
     for (ch = 0; ch < header->num_channels; ch++) {
-        LINNECoder_Encode(encoder->coder, &writer, encoder->residual[ch], num_samples);
+        LINNECoder_EncodeWithPartitionOrder(encoder->coder,
+                &writer, encoder->residual[ch], num_samples, encoder->residual_porders[ch]);
     }
 
     /* バイト境界に揃える */
@@ -744,6 +1182,7 @@ static LINNEApiResult LINNEEncoder_EncodeCompressData(
 
     /* 書き込みサイズの取得 */
     BitStream_Tell(&writer, (int32_t *)output_size);
+    LINNE_ASSERT((*output_size) == encoder->compress_data_size);
 
     /* ビットライタ破棄 */
     BitStream_Close(&writer);
@@ -753,13 +1192,11 @@ static LINNEApiResult LINNEEncoder_EncodeCompressData(
 
 /* 無音データブロックエンコード */
 static LINNEApiResult LINNEEncoder_EncodeSilentData(
-        struct LINNEEncoder *encoder,
-        const int32_t *const *input, uint32_t num_samples,
+        struct LINNEEncoder *encoder, uint32_t num_samples,
         uint8_t *data, uint32_t data_size, uint32_t *output_size)
 {
     /* 内部関数なので不正な引数はアサートで落とす */
     LINNE_ASSERT(encoder != NULL);
-    LINNE_ASSERT(input != NULL);
     LINNE_ASSERT(num_samples > 0);
     LINNE_ASSERT(data != NULL);
     LINNE_ASSERT(data_size > 0);
@@ -770,10 +1207,122 @@ static LINNEApiResult LINNEEncoder_EncodeSilentData(
     return LINNE_APIRESULT_OK;
 }
 
-/* 単一データブロックエンコード */
-LINNEApiResult LINNEEncoder_EncodeBlock(
+/* 入力PCMバッファのチェック 成功時はサンプルに掛ける右シフト量を返す */
+static LINNEApiResult LINNEEncoder_CheckPCMInput(
+        const struct LINNEEncoder *encoder, const struct LINNEEncoderPCMInput *input, uint32_t *rshift)
+{
+    uint32_t ch, byte_size;
+    const struct LINNEHeader *header;
+
+    LINNE_ASSERT(encoder != NULL);
+    LINNE_ASSERT(input != NULL);
+    LINNE_ASSERT(rshift != NULL);
+    LINNE_ASSERT(encoder->set_parameter == 1);
+
+    header = &(encoder->header);
+
+    /* 形式とストライドのチェック 浮動小数入力は可逆にならないため受け付けない */
+    byte_size = LINNEUtility_GetPCMFormatByteSize(input->format);
+    if ((byte_size == 0) || (input->format == LINNE_PCM_FORMAT_FLOAT32) || (input->stride < byte_size)) {
+        return LINNE_APIRESULT_INVALID_ARGUMENT;
+    }
+
+    /* コンテナに収まらないビット深度は扱えない */
+    if ((8 * byte_size) < header->bits_per_sample) {
+        return LINNE_APIRESULT_INVALID_ARGUMENT;
+    }
+
+    for (ch = 0; ch < header->num_channels; ch++) {
+        if (input->channels[ch] == NULL) {
+            return LINNE_APIRESULT_INVALID_ARGUMENT;
+        }
+    }
+
+    (*rshift) = 8 * byte_size - header->bits_per_sample;
+    return LINNE_APIRESULT_OK;
+}
+
+/* 入力PCMをチャンネル分離・32bit化して信号バッファにロード */
+/* 補足）ストライドが奇数のこともあるため、整数の読み込みはmemcpyでアラインメントに依らず行う */
+static void LINNEEncoder_LoadInput(
+        struct LINNEEncoder *encoder, const struct LINNEEncoderPCMInput *input, uint32_t rshift, uint32_t num_samples)
+{
+    uint32_t ch, smpl;
+    const struct LINNEHeader *header;
+
+    /* 内部関数なので不正な引数はアサートで落とす */
+    LINNE_ASSERT(encoder != NULL);
+    LINNE_ASSERT(input != NULL);
+    LINNE_ASSERT(num_samples <= encoder->buffer_num_samples_per_block);
+
+    header = &(encoder->header);
+
+    for (ch = 0; ch < header->num_channels; ch++) {
+        const uint8_t *src = (const uint8_t *)input->channels[ch];
+        int32_t *dst = encoder->buffer_int[ch];
+        switch (input->format) {
+        case LINNE_PCM_FORMAT_INT16:
+            for (smpl = 0; smpl < num_samples; smpl++) {
+                int16_t sval;
+                memcpy(&sval, src, sizeof(int16_t));
+                dst[smpl] = (int32_t)LINNEUTILITY_SHIFT_RIGHT_ARITHMETIC((int32_t)sval, rshift);
+                src += input->stride;
+            }
+            break;
+        case LINNE_PCM_FORMAT_INT24:
+            for (smpl = 0; smpl < num_samples; smpl++) {
+                const uint32_t u = (uint32_t)src[0] | ((uint32_t)src[1] << 8) | ((uint32_t)src[2] << 16);
+                /* 24bit目を符号として拡張 */
+                const int32_t sval = (int32_t)(u ^ 0x800000U) - (int32_t)0x800000;
+                dst[smpl] = (int32_t)LINNEUTILITY_SHIFT_RIGHT_ARITHMETIC(sval, rshift);
+                src += input->stride;
+            }
+            break;
+        case LINNE_PCM_FORMAT_INT32:
+            /* 詰まったプレーナ入力はそのままコピー */
+            if ((input->stride == sizeof(int32_t)) && (rshift == 0)) {
+                memcpy(dst, src, sizeof(int32_t) * num_samples);
+                break;
+            }
+            for (smpl = 0; smpl < num_samples; smpl++) {
+                int32_t sval;
+                memcpy(&sval, src, sizeof(int32_t));
+                dst[smpl] = (int32_t)LINNEUTILITY_SHIFT_RIGHT_ARITHMETIC(sval, rshift);
+                src += input->stride;
+            }
+            break;
+        default:
+            LINNE_ASSERT(0);
+        }
+        /* バッファサイズより小さい入力のときは、末尾を0埋め */
+        if (num_samples < encoder->buffer_num_samples_per_block) {
+            const uint32_t remain = encoder->buffer_num_samples_per_block - num_samples;
+            memset(&dst[num_samples], 0, sizeof(int32_t) * remain);
+        }
+    }
+}
+
+/* 32bitプレーナ入力を入力PCMバッファ記述に変換 値はそのまま使うため右シフトしない */
+static void LINNEEncoder_SetPlanarInt32Input(
+        const struct LINNEEncoder *encoder, const int32_t *const *input, struct LINNEEncoderPCMInput *pcm_input)
+{
+    uint32_t ch;
+
+    LINNE_ASSERT(encoder != NULL);
+    LINNE_ASSERT(input != NULL);
+    LINNE_ASSERT(pcm_input != NULL);
+
+    pcm_input->format = LINNE_PCM_FORMAT_INT32;
+    pcm_input->stride = sizeof(int32_t);
+    for (ch = 0; ch < encoder->header.num_channels; ch++) {
+        pcm_input->channels[ch] = input[ch];
+    }
+}
+
+/* 入力PCMバッファから単一データブロックエンコード */
+static LINNEApiResult LINNEEncoder_EncodeBlockCore(
         struct LINNEEncoder *encoder,
-        const int32_t *const *input, uint32_t num_samples,
+        const struct LINNEEncoderPCMInput *input, uint32_t rshift, uint32_t num_samples,
         uint8_t *data, uint32_t data_size, uint32_t *output_size)
 {
     uint8_t *data_ptr;
@@ -782,27 +1331,51 @@ LINNEApiResult LINNEEncoder_EncodeBlock(
     LINNEApiResult ret;
     uint32_t block_header_size, block_data_size;
 
-    /* 引数チェック */
-    if ((encoder == NULL) || (input == NULL) || (num_samples == 0)
-            || (data == NULL) || (data_size == 0) || (output_size == NULL)) {
-        return LINNE_APIRESULT_INVALID_ARGUMENT;
-    }
-    header = &(encoder->header);
+    /* 内部関数なので不正な引数はアサートで落とす */
+    LINNE_ASSERT(encoder != NULL);
+    LINNE_ASSERT(input != NULL);
+    LINNE_ASSERT(num_samples > 0);
+    LINNE_ASSERT(data != NULL);
+    LINNE_ASSERT(data_size > 0);
+    LINNE_ASSERT(output_size != NULL);
+    LINNE_ASSERT(encoder->set_parameter == 1);
 
-    /* パラメータがセットされてない */
-    if (encoder->set_parameter != 1) {
-        return LINNE_APIRESULT_PARAMETER_NOT_SET;
-    }
+    header = &(encoder->header);
 
     /* エンコードサンプル数チェック */
     if (num_samples > header->num_samples_per_block) {
         return LINNE_APIRESULT_INSUFFICIENT_BUFFER;
     }
 
+    /* 入力を信号バッファにロード 以降の処理は全てこのバッファを参照する */
+    LINNEEncoder_LoadInput(encoder, input, rshift, num_samples);
+
     /* 圧縮手法の判定 */
-    block_type = LINNEEncoder_DecideBlockDataType(encoder, input, num_samples);
+    block_type = LINNEEncoder_DecideBlockDataType(encoder, num_samples);
     LINNE_ASSERT(block_type != LINNE_BLOCK_DATA_TYPE_INVALID);
 
+    /* 圧縮データの場合は先に予測まで行い、圧縮後のサイズを確定させる */
+    if (block_type == LINNE_BLOCK_DATA_TYPE_COMPRESSDATA) {
+        uint32_t compress_data_size;
+        if ((ret = LINNEEncoder_PredictCompressData(encoder, num_samples)) != LINNE_APIRESULT_OK) {
+            return ret;
+        }
+        compress_data_size = LINNEEncoder_CalculateCompressDataSize(encoder, num_samples);
+        /* 生データより大きくなる場合は生データで出力 */
+        /* 補足）これによりブロックサイズはLINNEEncoder_CalculateMaxBlockSizeを超えない */
+        if (compress_data_size > LINNEEncoder_CalculateRawDataSize(header->num_channels, header->bits_per_sample, num_samples)) {
+            block_type = LINNE_BLOCK_DATA_TYPE_RAWDATA;
+            /* 予測で信号バッファを書き換えているため入力をロードし直す */
+            LINNEEncoder_LoadInput(encoder, input, rshift, num_samples);
+        } else if (data_size < (LINNE_BLOCK_HEADER_SIZE + compress_data_size)) {
+            return LINNE_APIRESULT_INSUFFICIENT_BUFFER;
+        }
+    }
+    /* ブロックヘッダ分の領域があるか */
+    if (data_size < LINNE_BLOCK_HEADER_SIZE) {
+        return LINNE_APIRESULT_INSUFFICIENT_BUFFER;
+    }
+
     /* ブロックヘッダをエンコード */
     data_ptr = data;
     /* ブロック先頭の同期コード */
@@ -817,20 +1390,21 @@ LINNEApiResult LINNEEncoder_EncodeBlock(
     ByteArray_PutUint16BE(data_ptr, num_samples);
     /* ブロックヘッダサイズ */
     block_header_size = (uint32_t)(data_ptr - data);
+    LINNE_ASSERT(block_header_size == LINNE_BLOCK_HEADER_SIZE);
 
     /* データ部のエンコード */
     /* 手法によりエンコードする関数を呼び分け */
     switch (block_type) {
     case LINNE_BLOCK_DATA_TYPE_RAWDATA:
-        ret = LINNEEncoder_EncodeRawData(encoder, input, num_samples,
+        ret = LINNEEncoder_EncodeRawData(encoder, num_samples,
                 data_ptr, data_size - block_header_size, &block_data_size);
         break;
     case LINNE_BLOCK_DATA_TYPE_COMPRESSDATA:
-        ret = LINNEEncoder_EncodeCompressData(encoder, input, num_samples,
+        ret = LINNEEncoder_EncodeCompressData(encoder, num_samples,
                 data_ptr, data_size - block_header_size, &block_data_size);
         break;
     case LINNE_BLOCK_DATA_TYPE_SILENT:
-        ret = LINNEEncoder_EncodeSilentData(encoder, input, num_samples,
+        ret = LINNEEncoder_EncodeSilentData(encoder, num_samples,
                 data_ptr, data_size - block_header_size, &block_data_size);
         break;
     default:
@@ -861,21 +1435,43 @@ LINNEApiResult LINNEEncoder_EncodeBlock(
     return LINNE_APIRESULT_OK;
 }
 
-/* ヘッダ含めファイル全体をエンコード */
-LINNEApiResult LINNEEncoder_EncodeWhole(
+/* 単一データブロックエンコード */
+LINNEApiResult LINNEEncoder_EncodeBlock(
         struct LINNEEncoder *encoder,
         const int32_t *const *input, uint32_t num_samples,
         uint8_t *data, uint32_t data_size, uint32_t *output_size)
+{
+    struct LINNEEncoderPCMInput pcm_input;
+
+    /* 引数チェック */
+    if ((encoder == NULL) || (input == NULL) || (num_samples == 0)
+            || (data == NULL) || (data_size == 0) || (output_size == NULL)) {
+        return LINNE_APIRESULT_INVALID_ARGUMENT;
+    }
+
+    /* パラメータがセットされてない */
+    if (encoder->set_parameter != 1) {
+        return LINNE_APIRESULT_PARAMETER_NOT_SET;
+    }
+
+    LINNEEncoder_SetPlanarInt32Input(encoder, input, &pcm_input);
+
+    return LINNEEncoder_EncodeBlockCore(encoder,
+            &pcm_input, 0, num_samples, data, data_size, output_size);
+}
+
+/* 単一データブロックエンコード（PCMバッファ入力） */
+LINNEApiResult LINNEEncoder_EncodeBlockPCM(
+        struct LINNEEncoder *encoder,
+        const struct LINNEEncoderPCMInput *input, uint32_t num_samples,
+        uint8_t *data, uint32_t data_size, uint32_t *output_size)
 {
     LINNEApiResult ret;
-    uint32_t progress, ch, write_size, write_offset, num_encode_samples;
-    uint8_t *data_pos;
-    const int32_t *input_ptr[LINNE_MAX_NUM_CHANNELS];
-    const struct LINNEHeader *header;
+    uint32_t rshift;
 
     /* 引数チェック */
-    if ((encoder == NULL) || (input == NULL)
-            || (data == NULL) || (output_size == NULL)) {
+    if ((encoder == NULL) || (input == NULL) || (num_samples == 0)
+            || (data == NULL) || (data_size == 0) || (output_size == NULL)) {
         return LINNE_APIRESULT_INVALID_ARGUMENT;
     }
 
@@ -884,6 +1480,34 @@ LINNEApiResult LINNEEncoder_EncodeWhole(
         return LINNE_APIRESULT_PARAMETER_NOT_SET;
     }
 
+    /* 入力PCMバッファのチェック */
+    if ((ret = LINNEEncoder_CheckPCMInput(encoder, input, &rshift)) != LINNE_APIRESULT_OK) {
+        return ret;
+    }
+
+    return LINNEEncoder_EncodeBlockCore(encoder,
+            input, rshift, num_samples, data, data_size, output_size);
+}
+
+/* 入力PCMバッファからヘッダ含めファイル全体をエンコード */
+static LINNEApiResult LINNEEncoder_EncodeWholeCore(
+        struct LINNEEncoder *encoder,
+        const struct LINNEEncoderPCMInput *input, uint32_t rshift, uint32_t num_samples,
+        uint8_t *data, uint32_t data_size, uint32_t *output_size)
+{
+    LINNEApiResult ret;
+    uint32_t progress, ch, write_size, write_offset, num_encode_samples;
+    uint8_t *data_pos;
+    struct LINNEEncoderPCMInput block_input;
+    const struct LINNEHeader *header;
+
+    /* 内部関数なので不正な引数はアサートで落とす */
+    LINNE_ASSERT(encoder != NULL);
+    LINNE_ASSERT(input != NULL);
+    LINNE_ASSERT(data != NULL);
+    LINNE_ASSERT(output_size != NULL);
+    LINNE_ASSERT(encoder->set_parameter == 1);
+
     /* 書き出し位置を取得 */
     data_pos = data;
 
@@ -899,6 +1523,7 @@ LINNEApiResult LINNEEncoder_EncodeWhole(
     progress = 0;
     write_offset = LINNE_HEADER_SIZE;
     data_pos = data + LINNE_HEADER_SIZE;
+    block_input = (*input);
 
     /* ブロックを時系列順にエンコード */
     while (progress < num_samples) {
@@ -909,12 +1534,12 @@ LINNEApiResult LINNEEncoder_EncodeWhole(
 
         /* サンプル参照位置のセット */
         for (ch = 0; ch < header->num_channels; ch++) {
-            input_ptr[ch] = &input[ch][progress];
+            block_input.channels[ch] = (const uint8_t *)input->channels[ch] + (size_t)progress * input->stride;
         }
 
         /* ブロックエンコード */
-        if ((ret = LINNEEncoder_EncodeBlock(encoder,
-                        input_ptr, num_encode_samples,
+        if ((ret = LINNEEncoder_EncodeBlockCore(encoder,
+                        &block_input, rshift, num_encode_samples,
                         data_pos, data_size - write_offset, &write_size)) != LINNE_APIRESULT_OK) {
             return ret;
         }
@@ -930,3 +1555,57 @@ LINNEApiResult LINNEEncoder_EncodeWhole(
     (*output_size) = write_offset;
     return LINNE_APIRESULT_OK;
 }
+
+/* ヘッダ含めファイル全体をエンコード */
+LINNEApiResult LINNEEncoder_EncodeWhole(
+        struct LINNEEncoder *encoder,
+        const int32_t *const *input, uint32_t num_samples,
+        uint8_t *data, uint32_t data_size, uint32_t *output_size)
+{
+    struct LINNEEncoderPCMInput pcm_input;
+
+    /* 引数チェック */
+    if ((encoder == NULL) || (input == NULL)
+            || (data == NULL) || (output_size == NULL)) {
+        return LINNE_APIRESULT_INVALID_ARGUMENT;
+    }
+
+    /* パラメータがセットされてない */
+    if (encoder->set_parameter != 1) {
+        return LINNE_APIRESULT_PARAMETER_NOT_SET;
+    }
+
+    LINNEEncoder_SetPlanarInt32Input(encoder, input, &pcm_input);
+
+    return LINNEEncoder_EncodeWholeCore(encoder,
+            &pcm_input, 0, num_samples, data, data_size, output_size);
+}
+
+/* ヘッダ含めファイル全体をエンコード（PCMバッファ入力） */
+LINNEApiResult LINNEEncoder_EncodeWholePCM(
+        struct LINNEEncoder *encoder,
+        const struct LINNEEncoderPCMInput *input, uint32_t num_samples,
+        uint8_t *data, uint32_t data_size, uint32_t *output_size)
+{
+    LINNEApiResult ret;
+    uint32_t rshift;
+
+    /* 引数チェック */
+    if ((encoder == NULL) || (input == NULL)
+            || (data == NULL) || (output_size == NULL)) {
+        return LINNE_APIRESULT_INVALID_ARGUMENT;
+    }
+
+    /* パラメータがセットされてない */
+    if (encoder->set_parameter != 1) {
+        return LINNE_APIRESULT_PARAMETER_NOT_SET;
+    }
+
+    /* 入力PCMバッファのチェック */
+    if ((ret = LINNEEncoder_CheckPCMInput(encoder, input, &rshift)) != LINNE_APIRESULT_OK) {
+        return ret;
+    }
+
+    return LINNEEncoder_EncodeWholeCore(encoder,
+            input, rshift, num_samples, data, data_size, output_size);
+}
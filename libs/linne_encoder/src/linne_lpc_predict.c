@@ -2,14 +2,362 @@
 
 #include <string.h>
 #include "linne_internal.h"
+#include "linne_utility.h"
+
+#if defined(LINNE_USE_X86_SIMD)
+#include <immintrin.h>
+#endif
+
+/* 16bit積和演算で一度に処理するサンプル数 */
+#define LINNELPC_INT16_TILE_SIZE 256
+/* 16bit積和演算で扱える最大次数 */
+#define LINNELPC_INT16_MAX_ORDER 128
+/* 16bit積和演算のタイル末尾の読み出し余白 */
+#define LINNELPC_INT16_TILE_MARGIN 16
+/* 次数固定の関数を用意する次数の数（1,2,4,...,128） */
+#define LINNELPC_NUM_SPECIALIZED_ORDERS 8
+/* 関数テーブルのサイズ 最後の要素は次数可変の関数 */
+#define LINNELPC_FUNCTION_TABLE_SIZE (LINNELPC_NUM_SPECIALIZED_ORDERS + 1)
+
+/* 次数分の積和（次数可変: ループ） */
+#define LINNELPC_MAC_LOOP(STEP, order)\
+    {\
+        uint32_t ord;\
+        for (ord = 0; ord < (order); ord++) {\
+            STEP(ord)\
+        }\
+    }
+/* 次数分の積和（次数固定: 完全展開） */
+#define LINNELPC_MAC_UNROLL(STEP, order) LINNEUTILITY_UNROLL_##order(STEP, 0)
+
+/* 次数固定の関数を用意する次数と、16bit積和演算での係数ペア数の組 */
+#define LINNELPC_FOR_EACH_SPECIALIZED_ORDER(M)\
+    M(1, 1) M(2, 1) M(4, 2) M(8, 4) M(16, 8) M(32, 16) M(64, 32) M(128, 64)
+
+/* ユニット単位の予測関数型 */
+/* output[smpl + order] += (half + Σ coef[ord] * input[smpl + ord]) >> rshift を0 <= smpl < num_predict_samplesについて計算 */
+typedef void (*LINNELPCPredictUnitFunction)(
+    const int32_t *input, int32_t *output, uint32_t num_predict_samples,
+    const int32_t *coef, uint32_t order, int32_t half, uint32_t rshift);
+
+/* 関数テーブルの参照位置を取得 */
+static uint32_t LINNELPC_GetFunctionTableIndex(uint32_t order)
+{
+    if ((order > 0) && LINNEUTILITY_IS_POWERED_OF_2(order)
+            && (order <= (1U << (LINNELPC_NUM_SPECIALIZED_ORDERS - 1)))) {
+        return LINNEUTILITY_LOG2FLOOR(order);
+    }
+    return LINNELPC_NUM_SPECIALIZED_ORDERS;
+}
+
+/* ユニット単位の予測（スカラー実装）の定義 */
+#define LINNELPC_PREDICT_STEP_SCALAR(k) predict += (coef[k] * pinput[k]);
+#define LINNELPC_DEFINE_PREDICT_UNIT_SCALAR(function_name, MAC, ORDER)\
+static void function_name(\
+    const int32_t *input, int32_t *output, uint32_t num_predict_samples,\
+    const int32_t *coef, uint32_t order, int32_t half, uint32_t rshift)\
+{\
+    uint32_t smpl;\
+\
+    LINNEUTILITY_UNUSED_ARGUMENT(order);\
+\
+    for (smpl = 0; smpl < num_predict_samples; smpl++) {\
+        const int32_t *pinput = &input[smpl];\
+        int32_t predict = half;\
+        MAC(LINNELPC_PREDICT_STEP_SCALAR, ORDER)\
+        output[smpl + (ORDER)] += (predict >> rshift);\
+    }\
+}
+
+LINNELPC_DEFINE_PREDICT_UNIT_SCALAR(LINNELPC_PredictUnitScalar, LINNELPC_MAC_LOOP, order)
+#define LINNELPC_DEFINE_PREDICT_UNIT_SCALAR_ORDER(ORDER, NPAIRS)\
+    LINNELPC_DEFINE_PREDICT_UNIT_SCALAR(LINNELPC_PredictUnitScalarOrder##ORDER, LINNELPC_MAC_UNROLL, ORDER)
+LINNELPC_FOR_EACH_SPECIALIZED_ORDER(LINNELPC_DEFINE_PREDICT_UNIT_SCALAR_ORDER)
+
+/* 次数別のスカラー実装 */
+static const LINNELPCPredictUnitFunction st_predict_unit_scalar_functions[LINNELPC_FUNCTION_TABLE_SIZE] = {
+    LINNELPC_PredictUnitScalarOrder1, LINNELPC_PredictUnitScalarOrder2,
+    LINNELPC_PredictUnitScalarOrder4, LINNELPC_PredictUnitScalarOrder8,
+    LINNELPC_PredictUnitScalarOrder16, LINNELPC_PredictUnitScalarOrder32,
+    LINNELPC_PredictUnitScalarOrder64, LINNELPC_PredictUnitScalarOrder128,
+    LINNELPC_PredictUnitScalar
+};
+
+#if defined(LINNE_USE_X86_SIMD)
+
+/* データと係数が16bit積和演算で扱える範囲に収まっているか？ */
+static int32_t LINNELPC_IsInt16Range(
+    const int32_t *data, uint32_t num_samples, const int32_t *coef, uint32_t coef_order)
+{
+    uint32_t i;
+    int32_t min = 0, max = 0;
+
+    for (i = 0; i < num_samples; i++) {
+        min = LINNEUTILITY_MIN(min, data[i]);
+        max = LINNEUTILITY_MAX(max, data[i]);
+    }
+    if ((min < INT16_MIN) || (max > INT16_MAX)) {
+        return 0;
+    }
+
+    /* 補足）係数から-32768を除けば2積の和は32bitで溢れない */
+    for (i = 0; i < coef_order; i++) {
+        if ((coef[i] <= INT16_MIN) || (coef[i] > INT16_MAX)) {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+/* 隣接2次の係数を32bitにパック（pmaddwd用） */
+static void LINNELPC_PackInt16CoefficientPairs(
+    const int32_t *coef, uint32_t order, int32_t *coef_pairs)
+{
+    uint32_t k;
+
+    for (k = 0; k < (order + 1) / 2; k++) {
+        const uint32_t c0 = (uint32_t)coef[2 * k] & 0xFFFFU;
+        const uint32_t c1 = ((2 * k + 1) < order) ? ((uint32_t)coef[2 * k + 1] & 0xFFFFU) : 0;
+        coef_pairs[k] = (int32_t)((c1 << 16) | c0);
+    }
+}
+
+/* タイル分の入力を16bitに変換 末尾の余白は0埋め */
+static void LINNELPC_ConvertTileToInt16(const int32_t *input, uint32_t num_samples, int16_t *tile)
+{
+    uint32_t i;
+
+    for (i = 0; i < num_samples; i++) {
+        tile[i] = (int16_t)input[i];
+    }
+    memset(&tile[num_samples], 0, sizeof(int16_t) * LINNELPC_INT16_TILE_MARGIN);
+}
+
+/* ユニット単位の予測（32bit積和）の定義 */
+#define LINNELPC_PREDICT_STEP_SSE41(k)\
+    vpred = _mm_add_epi32(vpred,\
+            _mm_mullo_epi32(_mm_set1_epi32(coef[k]), _mm_loadu_si128((const __m128i *)&pinput[k])));
+#define LINNELPC_PREDICT_STEP_AVX2(k)\
+    vpred = _mm256_add_epi32(vpred,\
+            _mm256_mullo_epi32(_mm256_set1_epi32(coef[k]), _mm256_loadu_si256((const __m256i *)&pinput[k])));
+#define LINNELPC_DEFINE_PREDICT_UNIT_INT32(function_name, tail_function, MAC, ORDER,\
+        isa, num_lanes, vtype, STEP, set1, loadu, storeu, add, sra)\
+LINNE_TARGET_ATTRIBUTE(isa)\
+static void function_name(\
+    const int32_t *input, int32_t *output, uint32_t num_predict_samples,\
+    const int32_t *coef, uint32_t order, int32_t half, uint32_t rshift)\
+{\
+    uint32_t smpl;\
+    const vtype vhalf = set1(half);\
+    const __m128i vshift = _mm_cvtsi32_si128((int)rshift);\
+\
+    for (smpl = 0; smpl + (num_lanes) <= num_predict_samples; smpl += (num_lanes)) {\
+        const int32_t *pinput = &input[smpl];\
+        vtype vpred = vhalf;\
+        MAC(STEP, ORDER)\
+        vpred = sra(vpred, vshift);\
+        storeu((vtype *)&output[smpl + (ORDER)],\
+                add(loadu((const vtype *)&output[smpl + (ORDER)]), vpred));\
+    }\
+\
+    tail_function(&input[smpl], &output[smpl], num_predict_samples - smpl, coef, order, half, rshift);\
+}
+
+/* ユニット単位の予測（16bit積和）の定義 */
+/* 隣接するサンプルを交互に並べ、2次分をまとめて積和 */
+#define LINNELPC_PREDICT_STEP_INT16_SSE2(k)\
+    {\
+        const __m128i vin0 = _mm_loadu_si128((const __m128i *)&ptile[2 * (k)]);\
+        const __m128i vin1 = _mm_loadu_si128((const __m128i *)&ptile[2 * (k) + 1]);\
+        const __m128i vcoef = _mm_set1_epi32(coef_pairs[k]);\
+        vpredlo = _mm_add_epi32(vpredlo, _mm_madd_epi16(_mm_unpacklo_epi16(vin0, vin1), vcoef));\
+        vpredhi = _mm_add_epi32(vpredhi, _mm_madd_epi16(_mm_unpackhi_epi16(vin0, vin1), vcoef));\
+    }
+#define LINNELPC_PREDICT_STEP_INT16_AVX2(k)\
+    {\
+        const __m256i vin0 = _mm256_loadu_si256((const __m256i *)&ptile[2 * (k)]);\
+        const __m256i vin1 = _mm256_loadu_si256((const __m256i *)&ptile[2 * (k) + 1]);\
+        const __m256i vcoef = _mm256_set1_epi32(coef_pairs[k]);\
+        vpredlo = _mm256_add_epi32(vpredlo, _mm256_madd_epi16(_mm256_unpacklo_epi16(vin0, vin1), vcoef));\
+        vpredhi = _mm256_add_epi32(vpredhi, _mm256_madd_epi16(_mm256_unpackhi_epi16(vin0, vin1), vcoef));\
+    }
+/* 8サンプル分の予測値を出力に加算 */
+#define LINNELPC_PREDICT_STORE_INT16_SSE2(poutput, vpredlo, vpredhi)\
+    do {\
+        _mm_storeu_si128((__m128i *)&(poutput)[0],\
+                _mm_add_epi32(_mm_loadu_si128((const __m128i *)&(poutput)[0]), vpredlo));\
+        _mm_storeu_si128((__m128i *)&(poutput)[4],\
+                _mm_add_epi32(_mm_loadu_si128((const __m128i *)&(poutput)[4]), vpredhi));\
+    } while (0)
+/* 16サンプル分の予測値を出力に加算 unpackは128bitレーン単位なので、サンプル順に並べ直す */
+#define LINNELPC_PREDICT_STORE_INT16_AVX2(poutput, vpredlo, vpredhi)\
+    do {\
+        _mm256_storeu_si256((__m256i *)&(poutput)[0], _mm256_add_epi32(\
+                    _mm256_loadu_si256((const __m256i *)&(poutput)[0]), _mm256_permute2x128_si256(vpredlo, vpredhi, 0x20)));\
+        _mm256_storeu_si256((__m256i *)&(poutput)[8], _mm256_add_epi32(\
+                    _mm256_loadu_si256((const __m256i *)&(poutput)[8]), _mm256_permute2x128_si256(vpredlo, vpredhi, 0x31)));\
+    } while (0)
+#define LINNELPC_DEFINE_PREDICT_UNIT_INT16(function_name, tail_function, MAC, ORDER, NPAIRS,\
+        isa, num_lanes, vtype, STEP, STORE, set1, sra)\
+LINNE_TARGET_ATTRIBUTE(isa)\
+static void function_name(\
+    const int32_t *input, int32_t *output, uint32_t num_predict_samples,\
+    const int32_t *coef, uint32_t order, int32_t half, uint32_t rshift)\
+{\
+    uint32_t tile_head, smpl;\
+    int16_t tile[LINNELPC_INT16_TILE_SIZE + LINNELPC_INT16_MAX_ORDER + LINNELPC_INT16_TILE_MARGIN];\
+    int32_t coef_pairs[(LINNELPC_INT16_MAX_ORDER + 1) / 2];\
+    const uint32_t num_pairs = (order + 1) / 2;\
+    const vtype vhalf = set1(half);\
+    const __m128i vshift = _mm_cvtsi32_si128((int)rshift);\
+\
+    LINNE_ASSERT(order <= LINNELPC_INT16_MAX_ORDER);\
+    LINNEUTILITY_UNUSED_ARGUMENT(num_pairs);\
+\
+    LINNELPC_PackInt16CoefficientPairs(coef, order, coef_pairs);\
+\
+    for (tile_head = 0; tile_head < num_predict_samples; tile_head += LINNELPC_INT16_TILE_SIZE) {\
+        const uint32_t tile_size = LINNEUTILITY_MIN(LINNELPC_INT16_TILE_SIZE, num_predict_samples - tile_head);\
+        int32_t *poutput = &output[tile_head + (ORDER)];\
+\
+        LINNELPC_ConvertTileToInt16(&input[tile_head], tile_size + (ORDER), tile);\
+\
+        for (smpl = 0; smpl + (num_lanes) <= tile_size; smpl += (num_lanes)) {\
+            const int16_t *ptile = &tile[smpl];\
+            vtype vpredlo = vhalf, vpredhi = vhalf;\
+            MAC(STEP, NPAIRS)\
+            vpredlo = sra(vpredlo, vshift);\
+            vpredhi = sra(vpredhi, vshift);\
+            STORE(&poutput[smpl], vpredlo, vpredhi);\
+        }\
+\
+        /* タイル末尾の端数 */\
+        tail_function(&input[tile_head + smpl], &output[tile_head + smpl],\
+                tile_size - smpl, coef, order, half, rshift);\
+    }\
+}
+
+/* SSE4.1 32bit積和 */
+#define LINNELPC_DEFINE_PREDICT_UNIT_SSE41(function_name, tail_function, MAC, ORDER)\
+    LINNELPC_DEFINE_PREDICT_UNIT_INT32(function_name, tail_function, MAC, ORDER,\
+        "sse4.1", 4, __m128i, LINNELPC_PREDICT_STEP_SSE41,\
+        _mm_set1_epi32, _mm_loadu_si128, _mm_storeu_si128, _mm_add_epi32, _mm_sra_epi32)
+/* AVX2 32bit積和 */
+#define LINNELPC_DEFINE_PREDICT_UNIT_AVX2(function_name, tail_function, MAC, ORDER)\
+    LINNELPC_DEFINE_PREDICT_UNIT_INT32(function_name, tail_function, MAC, ORDER,\
+        "avx2", 8, __m256i, LINNELPC_PREDICT_STEP_AVX2,\
+        _mm256_set1_epi32, _mm256_loadu_si256, _mm256_storeu_si256, _mm256_add_epi32, _mm256_sra_epi32)
+/* SSE2 16bit積和 */
+#define LINNELPC_DEFINE_PREDICT_UNIT_INT16_SSE2(function_name, tail_function, MAC, ORDER, NPAIRS)\
+    LINNELPC_DEFINE_PREDICT_UNIT_INT16(function_name, tail_function, MAC, ORDER, NPAIRS,\
+        "sse2", 8, __m128i, LINNELPC_PREDICT_STEP_INT16_SSE2, LINNELPC_PREDICT_STORE_INT16_SSE2,\
+        _mm_set1_epi32, _mm_sra_epi32)
+/* AVX2 16bit積和 */
+#define LINNELPC_DEFINE_PREDICT_UNIT_INT16_AVX2(function_name, tail_function, MAC, ORDER, NPAIRS)\
+    LINNELPC_DEFINE_PREDICT_UNIT_INT16(function_name, tail_function, MAC, ORDER, NPAIRS,\
+        "avx2", 16, __m256i, LINNELPC_PREDICT_STEP_INT16_AVX2, LINNELPC_PREDICT_STORE_INT16_AVX2,\
+        _mm256_set1_epi32, _mm256_sra_epi32)
+
+/* 次数可変版 */
+LINNELPC_DEFINE_PREDICT_UNIT_SSE41(LINNELPC_PredictUnitSSE41,
+        LINNELPC_PredictUnitScalar, LINNELPC_MAC_LOOP, order)
+LINNELPC_DEFINE_PREDICT_UNIT_AVX2(LINNELPC_PredictUnitAVX2,
+        LINNELPC_PredictUnitScalar, LINNELPC_MAC_LOOP, order)
+LINNELPC_DEFINE_PREDICT_UNIT_INT16_SSE2(LINNELPC_PredictUnitInt16SSE2,
+        LINNELPC_PredictUnitScalar, LINNELPC_MAC_LOOP, order, num_pairs)
+LINNELPC_DEFINE_PREDICT_UNIT_INT16_AVX2(LINNELPC_PredictUnitInt16AVX2,
+        LINNELPC_PredictUnitScalar, LINNELPC_MAC_LOOP, order, num_pairs)
+
+/* 次数固定版 */
+#define LINNELPC_DEFINE_PREDICT_UNIT_SIMD_ORDER(ORDER, NPAIRS)\
+    LINNELPC_DEFINE_PREDICT_UNIT_SSE41(LINNELPC_PredictUnitSSE41Order##ORDER,\
+            LINNELPC_PredictUnitScalarOrder##ORDER, LINNELPC_MAC_UNROLL, ORDER)\
+    LINNELPC_DEFINE_PREDICT_UNIT_AVX2(LINNELPC_PredictUnitAVX2Order##ORDER,\
+            LINNELPC_PredictUnitScalarOrder##ORDER, LINNELPC_MAC_UNROLL, ORDER)\
+    LINNELPC_DEFINE_PREDICT_UNIT_INT16_SSE2(LINNELPC_PredictUnitInt16SSE2Order##ORDER,\
+            LINNELPC_PredictUnitScalarOrder##ORDER, LINNELPC_MAC_UNROLL, ORDER, NPAIRS)\
+    LINNELPC_DEFINE_PREDICT_UNIT_INT16_AVX2(LINNELPC_PredictUnitInt16AVX2Order##ORDER,\
+            LINNELPC_PredictUnitScalarOrder##ORDER, LINNELPC_MAC_UNROLL, ORDER, NPAIRS)
+LINNELPC_FOR_EACH_SPECIALIZED_ORDER(LINNELPC_DEFINE_PREDICT_UNIT_SIMD_ORDER)
+
+/* 次数別のSSE4.1 32bit積和 */
+static const LINNELPCPredictUnitFunction st_predict_unit_sse41_functions[LINNELPC_FUNCTION_TABLE_SIZE] = {
+    LINNELPC_PredictUnitSSE41Order1, LINNELPC_PredictUnitSSE41Order2,
+    LINNELPC_PredictUnitSSE41Order4, LINNELPC_PredictUnitSSE41Order8,
+    LINNELPC_PredictUnitSSE41Order16, LINNELPC_PredictUnitSSE41Order32,
+    LINNELPC_PredictUnitSSE41Order64, LINNELPC_PredictUnitSSE41Order128,
+    LINNELPC_PredictUnitSSE41
+};
+
+/* 次数別のAVX2 32bit積和 */
+static const LINNELPCPredictUnitFunction st_predict_unit_avx2_functions[LINNELPC_FUNCTION_TABLE_SIZE] = {
+    LINNELPC_PredictUnitAVX2Order1, LINNELPC_PredictUnitAVX2Order2,
+    LINNELPC_PredictUnitAVX2Order4, LINNELPC_PredictUnitAVX2Order8,
+    LINNELPC_PredictUnitAVX2Order16, LINNELPC_PredictUnitAVX2Order32,
+    LINNELPC_PredictUnitAVX2Order64, LINNELPC_PredictUnitAVX2Order128,
+    LINNELPC_PredictUnitAVX2
+};
+
+/* 次数別のSSE2 16bit積和 */
+static const LINNELPCPredictUnitFunction st_predict_unit_int16_sse2_functions[LINNELPC_FUNCTION_TABLE_SIZE] = {
+    LINNELPC_PredictUnitInt16SSE2Order1, LINNELPC_PredictUnitInt16SSE2Order2,
+    LINNELPC_PredictUnitInt16SSE2Order4, LINNELPC_PredictUnitInt16SSE2Order8,
+    LINNELPC_PredictUnitInt16SSE2Order16, LINNELPC_PredictUnitInt16SSE2Order32,
+    LINNELPC_PredictUnitInt16SSE2Order64, LINNELPC_PredictUnitInt16SSE2Order128,
+    LINNELPC_PredictUnitInt16SSE2
+};
+
+/* 次数別のAVX2 16bit積和 */
+static const LINNELPCPredictUnitFunction st_predict_unit_int16_avx2_functions[LINNELPC_FUNCTION_TABLE_SIZE] = {
+    LINNELPC_PredictUnitInt16AVX2Order1, LINNELPC_PredictUnitInt16AVX2Order2,
+    LINNELPC_PredictUnitInt16AVX2Order4, LINNELPC_PredictUnitInt16AVX2Order8,
+    LINNELPC_PredictUnitInt16AVX2Order16, LINNELPC_PredictUnitInt16AVX2Order32,
+    LINNELPC_PredictUnitInt16AVX2Order64, LINNELPC_PredictUnitInt16AVX2Order128,
+    LINNELPC_PredictUnitInt16AVX2
+};
+
+#endif /* LINNE_USE_X86_SIMD */
+
+/* 実行環境と入力に応じた関数テーブルを選択 */
+static const LINNELPCPredictUnitFunction *LINNELPC_SelectPredictUnitFunctionTable(
+    const int32_t *data, uint32_t num_samples, const int32_t *coef, uint32_t coef_order, uint32_t nparams_per_unit)
+{
+#if defined(LINNE_USE_X86_SIMD)
+    const uint32_t features = LINNEUtility_GetCPUFeatures();
+
+    if ((nparams_per_unit <= LINNELPC_INT16_MAX_ORDER)
+            && LINNELPC_IsInt16Range(data, num_samples, coef, coef_order)) {
+        if (features & LINNEUTILITY_CPU_FEATURE_AVX2) {
+            return st_predict_unit_int16_avx2_functions;
+        } else if (features & LINNEUTILITY_CPU_FEATURE_SSE2) {
+            return st_predict_unit_int16_sse2_functions;
+        }
+    }
+
+    if (features & LINNEUTILITY_CPU_FEATURE_AVX2) {
+        return st_predict_unit_avx2_functions;
+    } else if (features & LINNEUTILITY_CPU_FEATURE_SSE41) {
+        return st_predict_unit_sse41_functions;
+    }
+#else
+    LINNEUTILITY_UNUSED_ARGUMENT(data);
+    LINNEUTILITY_UNUSED_ARGUMENT(num_samples);
+    LINNEUTILITY_UNUSED_ARGUMENT(coef);
+    LINNEUTILITY_UNUSED_ARGUMENT(coef_order);
+    LINNEUTILITY_UNUSED_ARGUMENT(nparams_per_unit);
+#endif
+
+    return st_predict_unit_scalar_functions;
+}
 
 /* LPC係数により予測/誤差出力 */
 void LINNELPC_Predict(
     const int32_t *data, uint32_t num_samples,
     const int32_t *coef, uint32_t coef_order, int32_t *residual, uint32_t coef_rshift, uint32_t num_units)
 {
-    uint32_t u, smpl, ord;
-    int32_t predict;
+    uint32_t u;
+    LINNELPCPredictUnitFunction predict_unit;
     const int32_t half = 1 << (coef_rshift - 1); /* 固定小数の0.5 */
     const uint32_t nparams_per_unit = coef_order / num_units;
     /* 補足: num_samplesはnunitsで割り切れなくてもよい 剰余分の末尾サンプルは予測しない */
@@ -22,17 +370,105 @@ void LINNELPC_Predict(
 
     memcpy(residual, data, sizeof(int32_t) * num_samples);
 
+    /* 次数固定の関数があればそれを使用 */
+    predict_unit = LINNELPC_SelectPredictUnitFunctionTable(data, num_samples, coef, coef_order, nparams_per_unit)
+        [LINNELPC_GetFunctionTableIndex(nparams_per_unit)];
+
     /* 予測 */
     for (u = 0; u < num_units; u++) {
-        const int32_t *pinput = &data[u * nsmpls_per_unit];
-        int32_t *poutput = &residual[u * nsmpls_per_unit];
-        const int32_t *pcoef = &coef[u * nparams_per_unit];
-        for (smpl = 0; smpl < nsmpls_per_unit - nparams_per_unit; smpl++) {
-            predict = half;
-            for (ord = 0; ord < nparams_per_unit; ord++) {
-                predict += (pcoef[ord] * pinput[smpl + ord]);
+        predict_unit(&data[u * nsmpls_per_unit], &residual[u * nsmpls_per_unit],
+                nsmpls_per_unit - nparams_per_unit, &coef[u * nparams_per_unit], nparams_per_unit, half, coef_rshift);
+    }
+}
+
+/* 1タイル分の予測 inputとoutputの負の添字には直前タイルの履歴が入っている */
+static void LINNELPC_PredictCascadeTile(
+    const int32_t *input, int32_t *output, uint32_t tile_start, uint32_t tile_end,
+    uint32_t nsmpls_per_unit, const int32_t *coef, uint32_t coef_order, uint32_t coef_rshift, uint32_t num_units)
+{
+    uint32_t smpl, end;
+    const uint32_t nparams_per_unit = coef_order / num_units;
+    const int32_t half = 1 << (coef_rshift - 1); /* 固定小数の0.5 */
+    const uint32_t history = LINNEUTILITY_MIN(nparams_per_unit, tile_start);
+    LINNELPCPredictUnitFunction predict_unit;
+
+    /* 予測しないサンプルは入力をそのまま出力 */
+    memcpy(output, input, sizeof(int32_t) * (tile_end - tile_start));
+
+    /* 1ユニットにも満たないときは予測しない */
+    if (nsmpls_per_unit == 0) {
+        return;
+    }
+
+    /* 次数固定の関数があればそれを使用 */
+    predict_unit = LINNELPC_SelectPredictUnitFunctionTable(
+            input - history, history + tile_end - tile_start, coef, coef_order, nparams_per_unit)
+        [LINNELPC_GetFunctionTableIndex(nparams_per_unit)];
+
+    /* タイルをユニット境界で区切って予測 */
+    for (smpl = tile_start; smpl < tile_end; smpl = end) {
+        const uint32_t unit = smpl / nsmpls_per_unit;
+        uint32_t start;
+        /* 補足: ユニット数で割り切れない末尾サンプルは予測しない */
+        if (unit >= num_units) {
+            break;
+        }
+        end = LINNEUTILITY_MIN(tile_end, (unit + 1) * nsmpls_per_unit);
+        /* ユニット先頭の次数分のサンプルは予測しない */
+        start = LINNEUTILITY_MAX(smpl, unit * nsmpls_per_unit + nparams_per_unit);
+        if (start < end) {
+            const int32_t offset = (int32_t)(start - tile_start) - (int32_t)nparams_per_unit;
+            predict_unit(input + offset, output + offset, end - start,
+                    &coef[unit * nparams_per_unit], nparams_per_unit, half, coef_rshift);
+        }
+    }
+}
+
+/* 多段LPC予測をまとめて適用し最終層の残差を出力 */
+void LINNELPC_PredictCascade(
+    const int32_t *data, uint32_t num_samples,
+    int32_t * const *coefs, const uint32_t *coef_orders, const uint32_t *coef_rshifts, const uint32_t *num_units,
+    uint32_t num_layers, int32_t *residual, int32_t **layer_buffers)
+{
+    uint32_t l, tile_start, max_nparams_per_unit = 0;
+
+    /* 引数チェック */
+    LINNE_ASSERT(data != NULL);
+    LINNE_ASSERT(coefs != NULL);
+    LINNE_ASSERT(coef_orders != NULL);
+    LINNE_ASSERT(coef_rshifts != NULL);
+    LINNE_ASSERT(num_units != NULL);
+    LINNE_ASSERT(residual != NULL);
+    LINNE_ASSERT((num_layers <= 1) || (layer_buffers != NULL));
+
+    if (num_layers == 0) {
+        memcpy(residual, data, sizeof(int32_t) * num_samples);
+        return;
+    }
+
+    /* 各層のバッファは先頭に最大次数分の履歴を持つ */
+    for (l = 0; l < num_layers; l++) {
+        max_nparams_per_unit = LINNEUTILITY_MAX(max_nparams_per_unit, coef_orders[l] / num_units[l]);
+    }
+    LINNE_ASSERT(max_nparams_per_unit <= LINNELPC_CASCADE_TILE_SIZE);
+
+    /* タイル毎に全層を予測 中間層の残差はバッファに置き次の層の入力とする */
+    for (tile_start = 0; tile_start < num_samples; tile_start += LINNELPC_CASCADE_TILE_SIZE) {
+        const uint32_t tile_end = LINNEUTILITY_MIN(num_samples, tile_start + LINNELPC_CASCADE_TILE_SIZE);
+
+        for (l = 0; l < num_layers; l++) {
+            const int32_t *input = (l == 0) ? &data[tile_start] : &layer_buffers[l][max_nparams_per_unit];
+            int32_t *output = (l == (num_layers - 1)) ? &residual[tile_start] : &layer_buffers[l + 1][max_nparams_per_unit];
+            LINNELPC_PredictCascadeTile(input, output, tile_start, tile_end,
+                    num_samples / num_units[l], coefs[l], coef_orders[l], coef_rshifts[l], num_units[l]);
+        }
+
+        /* 次のタイルのために中間層の末尾を履歴へ移動 */
+        if (tile_end < num_samples) {
+            for (l = 1; l < num_layers; l++) {
+                memcpy(&layer_buffers[l][0],
+                        &layer_buffers[l][LINNELPC_CASCADE_TILE_SIZE], sizeof(int32_t) * max_nparams_per_unit);
             }
-            poutput[smpl + ord] += (predict >> coef_rshift);
         }
     }
 }
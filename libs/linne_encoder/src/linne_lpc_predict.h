@@ -3,6 +3,9 @@
 
 #include <stdint.h>
 
+/* 多段予測で一度に処理するサンプル数 */
+#define LINNELPC_CASCADE_TILE_SIZE 256
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -12,6 +15,13 @@ void LINNELPC_Predict(
     const int32_t *data, uint32_t num_samples,
     const int32_t *coef, uint32_t coef_order, int32_t *residual, uint32_t coef_rshift, uint32_t num_units);
 
+/* 多段LPC予測をまとめて適用し最終層の残差を出力 */
+/* 層は前段から順に予測する layer_buffersには層毎に(最大次数 + LINNELPC_CASCADE_TILE_SIZE)の領域が必要 */
+void LINNELPC_PredictCascade(
+    const int32_t *data, uint32_t num_samples,
+    int32_t * const *coefs, const uint32_t *coef_orders, const uint32_t *coef_rshifts, const uint32_t *num_units,
+    uint32_t num_layers, int32_t *residual, int32_t **layer_buffers);
+
 #ifdef __cplusplus
 }
 #endif
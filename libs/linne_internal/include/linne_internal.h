@@ -8,6 +8,9 @@
 #define LINNE_MEMORY_ALIGNMENT 16
 /* ブロック先頭の同期コード */
 #define LINNE_BLOCK_SYNC_CODE 0xFFFF
+/* ブロックヘッダサイズ: 同期コード(2byte) + ブロックサイズ(4byte) + CRC16(2byte)
+* + ブロックデータタイプ(1byte) + ブロックチャンネルあたりサンプル数(2byte) */
+#define LINNE_BLOCK_HEADER_SIZE 11
 
 /* 内部エンコードパラメータ */
 /* プリエンファシスの係数シフト量 */
@@ -46,6 +49,19 @@
 /* 静的アサートマクロ */
 #define LINNE_STATIC_ASSERT(expr) extern void assertion_failed(char dummy[(expr) ? 1 : -1])
 
+/* x86系SIMD命令の利用可否 LINNE_NO_SIMDの定義で無効化 */
+#if !defined(LINNE_NO_SIMD) && (defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86))
+#define LINNE_USE_X86_SIMD 1
+#endif
+
+/* 関数単位で使用する命令セットを指定 */
+#if defined(__GNUC__)
+#define LINNE_TARGET_ATTRIBUTE(isa) __attribute__((target(isa)))
+#else
+/* MSVCは指定なしで全ての組み込み関数を使用できる */
+#define LINNE_TARGET_ATTRIBUTE(isa)
+#endif
+
 /* ブロックデータタイプ */
 typedef enum LINNEBlockDataTypeTag {
     LINNE_BLOCK_DATA_TYPE_COMPRESSDATA  = 0, /* 圧縮済みデータ */
@@ -1,6 +1,8 @@
 #ifndef LINNEUTILITY_H_INCLUDED
 #define LINNEUTILITY_H_INCLUDED
 
+#include <stddef.h>
+#include "linne.h"
 #include "linne_stdint.h"
 
 /* 未使用引数警告回避 */
@@ -63,6 +65,16 @@ __inline uint32_t LINNEUTILITY_NLZ(uint32_t x)
 #define LINNEUTILITY_ROUNDUP2POWERED(x) LINNEUtility_RoundUp2PoweredSoft(x)
 #endif
 
+/* 文STEP(k)をk = base, base + 1, ..., base + N - 1について展開 */
+#define LINNEUTILITY_UNROLL_1(STEP, base)   STEP(base)
+#define LINNEUTILITY_UNROLL_2(STEP, base)   LINNEUTILITY_UNROLL_1(STEP, base) LINNEUTILITY_UNROLL_1(STEP, (base) + 1)
+#define LINNEUTILITY_UNROLL_4(STEP, base)   LINNEUTILITY_UNROLL_2(STEP, base) LINNEUTILITY_UNROLL_2(STEP, (base) + 2)
+#define LINNEUTILITY_UNROLL_8(STEP, base)   LINNEUTILITY_UNROLL_4(STEP, base) LINNEUTILITY_UNROLL_4(STEP, (base) + 4)
+#define LINNEUTILITY_UNROLL_16(STEP, base)  LINNEUTILITY_UNROLL_8(STEP, base) LINNEUTILITY_UNROLL_8(STEP, (base) + 8)
+#define LINNEUTILITY_UNROLL_32(STEP, base)  LINNEUTILITY_UNROLL_16(STEP, base) LINNEUTILITY_UNROLL_16(STEP, (base) + 16)
+#define LINNEUTILITY_UNROLL_64(STEP, base)  LINNEUTILITY_UNROLL_32(STEP, base) LINNEUTILITY_UNROLL_32(STEP, (base) + 32)
+#define LINNEUTILITY_UNROLL_128(STEP, base) LINNEUTILITY_UNROLL_64(STEP, base) LINNEUTILITY_UNROLL_64(STEP, (base) + 64)
+
 /* 2次元配列の領域ワークサイズ計算 */
 #define LINNE_CALCULATE_2DIMARRAY_WORKSIZE(type, size1, size2)\
     ((size1) * ((int32_t)sizeof(type *) + LINNE_MEMORY_ALIGNMENT\
@@ -107,6 +119,12 @@ __inline uint32_t LINNEUTILITY_NLZ(uint32_t x)
         }\
     } while (0)
 
+/* CPUの拡張命令フラグ */
+#define LINNEUTILITY_CPU_FEATURE_SSE2       (1U << 0)
+#define LINNEUTILITY_CPU_FEATURE_SSE41      (1U << 1)
+#define LINNEUTILITY_CPU_FEATURE_AVX2       (1U << 2)
+#define LINNEUTILITY_CPU_FEATURE_AVX512F    (1U << 3)
+
 /* プリエンファシス/デエンファシスフィルタ */
 struct LINNEPreemphasisFilter {
     int32_t prev;
@@ -132,6 +150,21 @@ uint32_t LINNEUtility_NLZSoft(uint32_t val);
 /* 2の冪乗に切り上げる */
 uint32_t LINNEUtility_RoundUp2PoweredSoft(uint32_t val);
 
+/* 実行中CPUの拡張命令フラグを取得 */
+uint32_t LINNEUtility_GetCPUFeatures(void);
+
+/* アロケータのチェック 確保・解放関数は両方指定するか両方NULLにする */
+int32_t LINNEUtility_CheckAllocator(const struct LINNEAllocator *allocator);
+
+/* アロケータによる領域確保 アロケータがNULLまたは関数未指定の場合はmallocを使う */
+void *LINNEUtility_Allocate(const struct LINNEAllocator *allocator, size_t size);
+
+/* アロケータによる領域解放 アロケータがNULLまたは関数未指定の場合はfreeを使う */
+void LINNEUtility_Free(const struct LINNEAllocator *allocator, void *ptr);
+
+/* PCMサンプル形式のサンプルあたりバイト数 無効な形式の場合は0を返す */
+uint32_t LINNEUtility_GetPCMFormatByteSize(LINNEPCMFormat format);
+
 /* LR -> MS (in-place) */
 void LINNEUtility_MSConversion(int32_t **buffer, uint32_t num_samples);
 
@@ -4,6 +4,10 @@
 #include <stdlib.h>
 #include "linne_internal.h"
 
+#if defined(LINNE_USE_X86_SIMD) && defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
 /* CRC16(IBM:多項式0x8005を反転した0xa001によるもの) の計算用テーブル */
 static const uint16_t st_crc16_ibm_byte_table[0x100] = {
     0x0000, 0xc0c1, 0xc181, 0x0140, 0xc301, 0x03c0, 0x0280, 0xc241,
@@ -116,6 +120,58 @@ uint32_t LINNEUtility_RoundUp2PoweredSoft(uint32_t val)
     return val + 1;
 }
 
+/* 実行中CPUの拡張命令フラグを取得 */
+uint32_t LINNEUtility_GetCPUFeatures(void)
+{
+    uint32_t features = 0;
+
+#if defined(LINNE_USE_X86_SIMD)
+#if defined(__GNUC__)
+    /* ビルトイン関数を使用（OSによるレジスタ退避の対応も確認される） */
+    if (__builtin_cpu_supports("sse2")) {
+        features |= LINNEUTILITY_CPU_FEATURE_SSE2;
+    }
+    if (__builtin_cpu_supports("sse4.1")) {
+        features |= LINNEUTILITY_CPU_FEATURE_SSE41;
+    }
+    if (__builtin_cpu_supports("avx2")) {
+        features |= LINNEUTILITY_CPU_FEATURE_AVX2;
+    }
+    if (__builtin_cpu_supports("avx512f")) {
+        features |= LINNEUTILITY_CPU_FEATURE_AVX512F;
+    }
+#elif defined(_MSC_VER)
+    {
+        int info[4];
+        int max_leaf;
+
+        __cpuid(info, 0);
+        max_leaf = info[0];
+        __cpuid(info, 1);
+        if (info[3] & (1 << 26)) {
+            features |= LINNEUTILITY_CPU_FEATURE_SSE2;
+        }
+        if (info[2] & (1 << 19)) {
+            features |= LINNEUTILITY_CPU_FEATURE_SSE41;
+        }
+        /* OSXSAVEとAVXが有効な場合のみ拡張レジスタの退避状態を確認 */
+        if ((info[2] & (1 << 27)) && (info[2] & (1 << 28)) && (max_leaf >= 7)) {
+            const unsigned __int64 xcr0 = _xgetbv(0);
+            __cpuidex(info, 7, 0);
+            if (((xcr0 & 0x06) == 0x06) && (info[1] & (1 << 5))) {
+                features |= LINNEUTILITY_CPU_FEATURE_AVX2;
+            }
+            if (((xcr0 & 0xE6) == 0xE6) && (info[1] & (1 << 16))) {
+                features |= LINNEUTILITY_CPU_FEATURE_AVX512F;
+            }
+        }
+    }
+#endif
+#endif
+
+    return features;
+}
+
 /* LR -> MS (in-place) */
 void LINNEUtility_MSConversion(int32_t **buffer, uint32_t num_samples)
 {
@@ -146,6 +202,49 @@ void LINNEUtility_LRConversion(int32_t **buffer, uint32_t num_samples)
     }
 }
 
+/* PCMサンプル形式のサンプルあたりバイト数 */
+uint32_t LINNEUtility_GetPCMFormatByteSize(LINNEPCMFormat format)
+{
+    switch (format) {
+    case LINNE_PCM_FORMAT_INT16: return 2;
+    case LINNE_PCM_FORMAT_INT24: return 3;
+    case LINNE_PCM_FORMAT_INT32: return 4;
+    case LINNE_PCM_FORMAT_FLOAT32: return 4;
+    default: break;
+    }
+    return 0;
+}
+
+/* アロケータのチェック */
+int32_t LINNEUtility_CheckAllocator(const struct LINNEAllocator *allocator)
+{
+    if (allocator == NULL) {
+        return 1;
+    }
+
+    /* 片方だけの指定は確保と解放の対応が崩れるため認めない */
+    return ((allocator->malloc_func == NULL) == (allocator->free_func == NULL)) ? 1 : 0;
+}
+
+/* アロケータによる領域確保 */
+void *LINNEUtility_Allocate(const struct LINNEAllocator *allocator, size_t size)
+{
+    if ((allocator == NULL) || (allocator->malloc_func == NULL)) {
+        return malloc(size);
+    }
+    return allocator->malloc_func(allocator->context, size);
+}
+
+/* アロケータによる領域解放 */
+void LINNEUtility_Free(const struct LINNEAllocator *allocator, void *ptr)
+{
+    if ((allocator == NULL) || (allocator->free_func == NULL)) {
+        free(ptr);
+        return;
+    }
+    allocator->free_func(allocator->context, ptr);
+}
+
 /* プリエンファシスフィルタ初期化 */
 void LINNEPreemphasisFilter_Initialize(struct LINNEPreemphasisFilter *preem)
 {
@@ -10,8 +10,7 @@
 
 /* LINNEネットを構成するレイヤー */
 struct LINNENetworkLayer {
-    double *din; /* 入力信号バッファ */
-    double *dout; /* 逆伝播信号バッファ */
+    double *din; /* 入力信号バッファ（ネットワークの領域を指す） */
     double *params; /* パラメータ（LPC係数） */
     double *dparams; /* パラメータ勾配 */
     uint32_t num_samples; /* 入力サンプル数 */
@@ -27,7 +26,9 @@ struct LINNENetwork {
     int32_t max_num_layers; /* 最大レイヤー（層）数 */
     uint32_t max_num_params; /* 最大レイヤーあたりパラメータ数 */
     struct LPCCalculator *lpcc; /* LPC係数計算ハンドル */
-    double *data_buffer; /* 入力データバッファ */
+    double **din_buffers; /* 各層の入力信号バッファ（逆伝播で使うため層毎に保持） */
+    double *data_buffer; /* 出力（残差）信号バッファ */
+    double *backward_buffer; /* 逆伝播信号の作業バッファ（data_bufferと交互に使う） */
     uint32_t num_samples; /* 入力サンプル数 */
     int32_t num_layers; /* レイヤー数 */
 };
@@ -84,8 +85,8 @@ static int32_t LINNENetworkLayer_CalculateWorkSize(uint32_t num_samples, uint32_
         return -1;
     }
 
+    /* 補足）信号バッファは層の間で共有するためネットワーク側で確保する */
     work_size = sizeof(struct LINNENetworkLayer) + LINNE_MEMORY_ALIGNMENT;
-    work_size += 2 * (sizeof(double) * num_samples + LINNE_MEMORY_ALIGNMENT);
     work_size += 2 * (sizeof(double) * num_params + LINNE_MEMORY_ALIGNMENT);
 
     return work_size;
@@ -118,14 +119,7 @@ static struct LINNENetworkLayer *LINNENetworkLayer_Create(
     work_ptr += sizeof(struct LINNENetworkLayer);
     layer->num_samples = num_samples;
     layer->num_params = num_params;
-
-    /* 入出力バッファ領域確保 */
-    work_ptr = (uint8_t *)LINNEUTILITY_ROUNDUP((uintptr_t)work_ptr, LINNE_MEMORY_ALIGNMENT);
-    layer->din = (double *)work_ptr;
-    work_ptr += sizeof(double) * num_samples;
-    work_ptr = (uint8_t *)LINNEUTILITY_ROUNDUP((uintptr_t)work_ptr, LINNE_MEMORY_ALIGNMENT);
-    layer->dout = (double *)work_ptr;
-    work_ptr += sizeof(double) * num_samples;
+    layer->din = NULL;
 
     /* パラメータ領域確保 */
     work_ptr = (uint8_t *)LINNEUTILITY_ROUNDUP((uintptr_t)work_ptr, LINNE_MEMORY_ALIGNMENT);
@@ -139,10 +133,6 @@ static struct LINNENetworkLayer *LINNENetworkLayer_Create(
     LINNE_ASSERT((work_ptr - (uint8_t *)work) <= work_size);
 
     /* 確保した領域を0埋め */
-    for (i = 0; i < layer->num_samples; i++) {
-        layer->din[i] = 0.0f;
-        layer->dout[i] = 0.0f;
-    }
     for (i = 0; i < layer->num_params; i++) {
         layer->params[i] = 0.0f;
         layer->dparams[i] = 0.0f;
@@ -161,21 +151,20 @@ static void LINNENetworkLayer_Destroy(struct LINNENetworkLayer *layer)
     LINNE_ASSERT(layer != NULL);
 }
 
-/* LINNEネットレイヤーの順行伝播 */
+/* LINNEネットレイヤーの順行伝播 dinに入っている入力から残差をoutputに書き込む */
 static void LINNENetworkLayer_Forward(
-        struct LINNENetworkLayer *layer, double *data, uint32_t num_samples)
+        struct LINNENetworkLayer *layer, double *output, uint32_t num_samples)
 {
     uint32_t unit, i, j;
     uint32_t nsmpls_per_unit, nparams_per_unit;
 
     LINNE_ASSERT(layer != NULL);
-    LINNE_ASSERT(data != NULL);
+    LINNE_ASSERT(layer->din != NULL);
+    LINNE_ASSERT(output != NULL);
+    LINNE_ASSERT(output != layer->din);
     LINNE_ASSERT(num_samples <= layer->num_samples);
     LINNE_ASSERT(layer->num_units >= 1);
 
-    /* 入力をコピー */
-    memcpy(layer->din, data, sizeof(double) * num_samples);
-
     nsmpls_per_unit = num_samples / layer->num_units;
     nparams_per_unit = layer->num_params / layer->num_units;
 
@@ -183,20 +172,22 @@ static void LINNENetworkLayer_Forward(
     for (unit = 0; unit < layer->num_units; unit++) {
         const double *pparams = &layer->params[unit * nparams_per_unit];
         const double *pdin = &layer->din[unit * nsmpls_per_unit];
-        double *presidual = &data[unit * nsmpls_per_unit];
+        double *presidual = &output[unit * nsmpls_per_unit];
         double predict;
         /* 行列積として取り扱うため,
         * h[0]は最も古い入力, h[nparams-1]は直前のサンプルに対応させる
         * 一般的なFIRフィルタと係数順序が逆になるの注意 */
         i = 0;
         if (unit == 0) {
+            /* 先頭サンプルは予測しない */
+            presidual[0] = pdin[0];
             /* 開始直後は入力ベクトルは0埋めされていると考える */
             for (i = 1; i < nparams_per_unit; i++) {
                 predict = 0.0f;
                 for (j = 0; j < i; j++) {
                     predict += pparams[nparams_per_unit - i + j] * pdin[j];
                 }
-                presidual[i] += predict;
+                presidual[i] = pdin[i] + predict;
             }
         }
         for (; i < nsmpls_per_unit; i++) {
@@ -204,35 +195,41 @@ static void LINNENetworkLayer_Forward(
             for (j = 0; j < nparams_per_unit; j++) {
                 predict += pparams[j] * pdin[(int32_t)(i - nparams_per_unit + j)];
             }
-            presidual[i] += predict;
+            presidual[i] = pdin[i] + predict;
         }
     }
+
+    /* ユニット数で割り切れない末尾は入力をそのまま出力 */
+    for (i = layer->num_units * nsmpls_per_unit; i < num_samples; i++) {
+        output[i] = layer->din[i];
+    }
 }
 
 /* LINNEネットレイヤーの誤差逆伝播 */
+/* doutの逆伝播信号からパラメータ勾配を計算し、前段への逆伝播信号をdbackに書き込む */
+/* 補足）dbackがNULLのときは前段への逆伝播信号を計算しない（先頭層で使う） */
 static void LINNENetworkLayer_Backward(
-        struct LINNENetworkLayer *layer, double *data, uint32_t num_samples)
+        struct LINNENetworkLayer *layer, const double *dout, double *dback, uint32_t num_samples)
 {
     uint32_t unit, i, j;
     uint32_t nsmpls_per_unit, nparams_per_unit;
 
     LINNE_ASSERT(layer != NULL);
-    LINNE_ASSERT(data != NULL);
+    LINNE_ASSERT(layer->din != NULL);
+    LINNE_ASSERT(dout != NULL);
+    LINNE_ASSERT(dout != dback);
     LINNE_ASSERT(num_samples <= layer->num_samples);
     LINNE_ASSERT(layer->num_units >= 1);
 
-    /* 逆伝播信号をコピー */
-    memcpy(layer->dout, data, sizeof(double) * num_samples);
-
     nsmpls_per_unit = num_samples / layer->num_units;
     nparams_per_unit = layer->num_params / layer->num_units;
 
     for (unit = 0; unit < layer->num_units; unit++) {
         const double *pin = &layer->din[unit * nsmpls_per_unit];
-        const double *pout = &layer->dout[unit * nsmpls_per_unit];
+        const double *pout = &dout[unit * nsmpls_per_unit];
         const double *pparams = &layer->params[unit * nparams_per_unit];
-        double *pback = &data[unit * nsmpls_per_unit];
         double *pdparams = &layer->dparams[unit * nparams_per_unit];
+        double *pback;
 
         /* パラメータ勾配計算 */
         for (i = 0; i < nparams_per_unit; i++) {
@@ -242,14 +239,19 @@ static void LINNENetworkLayer_Backward(
             }
         }
 
+        if (dback == NULL) {
+            continue;
+        }
+
         /* 逆伝播信号計算 */
+        pback = &dback[unit * nsmpls_per_unit];
         for (i = 0; i < (nsmpls_per_unit - nparams_per_unit); i++) {
             double back = 0.0f;
             for (j = 0; j < nparams_per_unit; j++) {
                 back += pparams[j] * pout[nparams_per_unit + i - j];
             }
             /* 入力はパラメータ数だけ複製されているのでパラメータ数で割る */
-            pback[i] += back / nparams_per_unit;
+            pback[i] = pout[i] + back / nparams_per_unit;
         }
         /* 端点 */
         for (; i < nsmpls_per_unit; i++) {
@@ -259,7 +261,14 @@ static void LINNENetworkLayer_Backward(
                     back += pparams[j] * pout[nparams_per_unit + i - j];
                 }
             }
-            pback[i] += back / nparams_per_unit;
+            pback[i] = pout[i] + back / nparams_per_unit;
+        }
+    }
+
+    /* ユニット数で割り切れない末尾は逆伝播信号をそのまま出力 */
+    if (dback != NULL) {
+        for (i = layer->num_units * nsmpls_per_unit; i < num_samples; i++) {
+            dback[i] = dout[i];
         }
     }
 }
@@ -396,12 +405,16 @@ int32_t LINNENetwork_CalculateWorkSize(
 
     lpcconfig.max_order = max_num_parameters_per_layer;
     lpcconfig.max_num_samples = max_num_samples;
+    lpcconfig.allocator = NULL;
 
     work_size = sizeof(struct LINNENetwork) + LINNE_MEMORY_ALIGNMENT;
     work_size += sizeof(struct LINNENetworkLayer *) * max_num_layers;
     work_size += max_num_layers * (size_t)LINNENetworkLayer_CalculateWorkSize(max_num_samples, max_num_parameters_per_layer);
     work_size += LPCCalculator_CalculateWorkSize(&lpcconfig);
-    work_size += (sizeof(double) * max_num_samples + LINNE_MEMORY_ALIGNMENT);
+    /* 各層の入力信号バッファ */
+    work_size += LINNE_CALCULATE_2DIMARRAY_WORKSIZE(double, (int32_t)max_num_layers, (int32_t)max_num_samples);
+    /* 出力信号バッファと逆伝播の作業バッファ */
+    work_size += 2 * (sizeof(double) * max_num_samples + LINNE_MEMORY_ALIGNMENT);
 
     return work_size;
 }
@@ -466,18 +479,28 @@ struct LINNENetwork *LINNENetwork_Create(
 
         lpcconfig.max_order = max_num_parameters_per_layer;
         lpcconfig.max_num_samples = max_num_samples;
+        lpcconfig.allocator = NULL;
         lpcc_work_size  = LPCCalculator_CalculateWorkSize(&lpcconfig);
         net->lpcc = LPCCalculator_Create(&lpcconfig, work_ptr, lpcc_work_size);
         work_ptr += lpcc_work_size;
     }
 
+    /* 各層の入力信号バッファ領域確保 */
+    LINNE_ALLOCATE_2DIMARRAY(net->din_buffers, work_ptr, double, max_num_layers, max_num_samples);
+    for (l = 0; l < max_num_layers; l++) {
+        net->layers[l]->din = net->din_buffers[l];
+    }
+
     /* データバッファ領域確保 */
     work_ptr = (uint8_t *)LINNEUTILITY_ROUNDUP((uintptr_t)work_ptr, LINNE_MEMORY_ALIGNMENT);
     net->data_buffer = (double *)work_ptr;
     work_ptr += sizeof(double) * max_num_samples;
+    work_ptr = (uint8_t *)LINNEUTILITY_ROUNDUP((uintptr_t)work_ptr, LINNE_MEMORY_ALIGNMENT);
+    net->backward_buffer = (double *)work_ptr;
+    work_ptr += sizeof(double) * max_num_samples;
 
     /* バッファオーバーランチェック */
-    LINNE_ASSERT(((uint8_t *)work - work_ptr) <= work_size);
+    LINNE_ASSERT((work_ptr - (uint8_t *)work) <= work_size);
 
     return net;
 }
@@ -529,6 +552,7 @@ void LINNENetwork_SetLayerStructure(struct LINNENetwork *net, uint32_t num_sampl
         const int32_t work_size = LINNENetworkLayer_CalculateWorkSize(num_samples, num_params_list[l]);
         net->layers[l] = LINNENetworkLayer_Create(num_samples, num_params_list[l], work_ptr, work_size);
         LINNE_ASSERT(net->layers[l] != NULL);
+        net->layers[l]->din = net->din_buffers[l];
         work_ptr += work_size;
     }
 
@@ -537,18 +561,31 @@ void LINNENetwork_SetLayerStructure(struct LINNENetwork *net, uint32_t num_sampl
     net->num_samples = num_samples;
 }
 
-/* ロス計算 同時に残差を計算にdataに書き込む */
-double LINNENetwork_CalculateLoss(struct LINNENetwork *net, double *data, uint32_t num_samples)
+/* 順行伝播 先頭層の入力バッファに入っている信号から最終層の残差をoutputに書き込む */
+/* 補足）各層の出力は次の層の入力バッファに直接書き込む */
+static void LINNENetwork_Forward(struct LINNENetwork *net, double *output, uint32_t num_samples)
 {
     int32_t l;
 
     LINNE_ASSERT(net != NULL);
-    LINNE_ASSERT(data != NULL);
+    LINNE_ASSERT(output != NULL);
 
-    /* 順行伝播 */
     for (l = 0; l < net->num_layers; l++) {
-        LINNENetworkLayer_Forward(net->layers[l], data, num_samples);
+        double *layer_output = (l < (net->num_layers - 1)) ? net->layers[l + 1]->din : output;
+        LINNENetworkLayer_Forward(net->layers[l], layer_output, num_samples);
     }
+}
+
+/* ロス計算 同時に残差を計算にdataに書き込む */
+double LINNENetwork_CalculateLoss(struct LINNENetwork *net, double *data, uint32_t num_samples)
+{
+    LINNE_ASSERT(net != NULL);
+    LINNE_ASSERT(data != NULL);
+    LINNE_ASSERT(num_samples <= net->num_samples);
+
+    /* 順行伝播 */
+    memcpy(net->layers[0]->din, data, sizeof(double) * num_samples);
+    LINNENetwork_Forward(net, data, num_samples);
 
     /* ロス計算 */
     return LINNEL1Norm_Loss(data, num_samples);
@@ -556,23 +593,32 @@ double LINNENetwork_CalculateLoss(struct LINNENetwork *net, double *data, uint32
 
 /* 入力から勾配を計算（結果は内部変数にセット） */
 static double LINNENetwork_CalculateGradient(
-        struct LINNENetwork *net, double *data, uint32_t num_samples)
+        struct LINNENetwork *net, const double *input, uint32_t num_samples)
 {
     int32_t l;
     double loss;
+    double *dout, *dback;
 
     LINNE_ASSERT(net != NULL);
-    LINNE_ASSERT(data != NULL);
+    LINNE_ASSERT(input != NULL);
+    LINNE_ASSERT(num_samples <= net->num_samples);
 
     /* 順行伝播 */
-    loss = LINNENetwork_CalculateLoss(net, data, num_samples);
+    memcpy(net->layers[0]->din, input, sizeof(double) * num_samples);
+    LINNENetwork_Forward(net, net->data_buffer, num_samples);
+    loss = LINNEL1Norm_Loss(net->data_buffer, num_samples);
 
     /* 誤差勾配計算 */
-    LINNEL1Norm_Backward(data, num_samples);
+    LINNEL1Norm_Backward(net->data_buffer, num_samples);
 
-    /* 誤差逆伝播 */
+    /* 誤差逆伝播 2つのバッファを交互に入出力に使う */
+    dout = net->data_buffer;
+    dback = net->backward_buffer;
     for (l = net->num_layers - 1; l >= 0; l--) {
-        LINNENetworkLayer_Backward(net->layers[l], data, num_samples);
+        double *tmp;
+        /* 先頭層より前への逆伝播信号は使わないので計算しない */
+        LINNENetworkLayer_Backward(net->layers[l], dout, (l > 0) ? dback : NULL, num_samples);
+        tmp = dout; dout = dback; dback = tmp;
     }
 
     return loss;
@@ -585,17 +631,18 @@ static double LINNENetwork_SearchSetUnitsAndParameters(
     int32_t l;
     const uint32_t max_num_units = 1UL << ((1UL << LINNE_LOG2_NUM_UNITS_BITWIDTH) - 1);
 
-    memcpy(net->data_buffer, input, sizeof(double) * num_samples);
+    memcpy(net->layers[0]->din, input, sizeof(double) * num_samples);
     for (l = 0; l < net->num_layers; l++) {
         uint32_t best_num_units;
         struct LINNENetworkLayer* layer = net->layers[l];
+        double *layer_output = (l < (net->num_layers - 1)) ? net->layers[l + 1]->din : net->data_buffer;
         LINNENetworkLayer_SearchOptimalNumUnits(
-            layer, net->lpcc, net->data_buffer, num_samples,
+            layer, net->lpcc, layer->din, num_samples,
             LINNEUTILITY_MIN(max_num_units, layer->num_params), regular_term, &best_num_units);
         layer->num_units = best_num_units;
-        LINNENetworkLayer_SetParameter(layer, net->lpcc, net->data_buffer, num_samples,
+        LINNENetworkLayer_SetParameter(layer, net->lpcc, layer->din, num_samples,
             num_af_iterations, regular_term);
-        LINNENetworkLayer_Forward(layer, net->data_buffer, num_samples);
+        LINNENetworkLayer_Forward(layer, layer_output, num_samples);
     }
 
     return LINNEL1Norm_Loss(net->data_buffer, num_samples);
@@ -838,8 +885,7 @@ void LINNENetworkTrainer_Train(struct LINNENetworkTrainer *trainer,
 
     /* 学習繰り返し */
     for (itr = 0; itr < max_num_iteration; itr++) {
-        memcpy(net->data_buffer, input, sizeof(double) * num_samples);
-        loss = LINNENetwork_CalculateGradient(net, net->data_buffer, num_samples);
+        loss = LINNENetwork_CalculateGradient(net, input, num_samples);
         for (l = 0; l < net->num_layers; l++) {
             struct LINNENetworkLayer *layer = net->layers[l];
             for (i = 0; i < layer->num_params; i++) {
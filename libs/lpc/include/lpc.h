@@ -1,6 +1,7 @@
 #ifndef LPC_H_INCLUDED
 #define LPC_H_INCLUDED
 
+#include <stddef.h>
 #include <stdint.h>
 
 /* API結果型 */
@@ -23,10 +24,18 @@ typedef enum LPCWindowTypeTag {
 /* LPC係数計算ハンドル */
 struct LPCCalculator;
 
+/* メモリアロケータ */
+struct LPCAllocator {
+    void *(*malloc_func)(void *context, size_t size);   /* 領域確保関数 */
+    void (*free_func)(void *context, void *ptr);         /* 領域解放関数 */
+    void *context;                                      /* 各関数に渡すコンテキスト */
+};
+
 /* 初期化コンフィグ */
 struct LPCCalculatorConfig {
     uint32_t max_order;        /* 最大次数 */
     uint32_t max_num_samples;  /* 最大入力サンプル数 */
+    const struct LPCAllocator *allocator; /* ワーク領域自前確保時のアロケータ（NULLでmalloc/free） */
 };
 
 #ifdef __cplusplus
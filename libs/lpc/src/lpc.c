@@ -42,6 +42,7 @@ struct LPCCalculator {
     double *parcor_coef; /* PARCOR係数ベクトル */
     double *buffer; /* 入力信号のバッファ領域 */
     uint8_t alloced_by_own; /* 自分で領域確保したか？ */
+    struct LPCAllocator allocator; /* 自前確保に使ったアロケータ */
     void *work; /* ワーク領域先頭ポインタ */
 };
 
@@ -59,6 +60,25 @@ static double LPC_Log2(double d)
 #undef INV_LOGE2
 }
 
+/* アロケータによる領域確保 */
+static void *LPC_Malloc(const struct LPCAllocator *allocator, size_t size)
+{
+    if ((allocator == NULL) || (allocator->malloc_func == NULL)) {
+        return malloc(size);
+    }
+    return allocator->malloc_func(allocator->context, size);
+}
+
+/* アロケータによる領域解放 */
+static void LPC_Free(const struct LPCAllocator *allocator, void *ptr)
+{
+    if ((allocator == NULL) || (allocator->free_func == NULL)) {
+        free(ptr);
+        return;
+    }
+    allocator->free_func(allocator->context, ptr);
+}
+
 /* LPC係数計算ハンドルのワークサイズ計算 */
 int32_t LPCCalculator_CalculateWorkSize(const struct LPCCalculatorConfig *config)
 {
@@ -94,7 +114,12 @@ struct LPCCalculator* LPCCalculator_Create(const struct LPCCalculatorConfig *con
         if ((work_size = LPCCalculator_CalculateWorkSize(config)) < 0) {
             return NULL;
         }
-        work = malloc((uint32_t)work_size);
+        /* 確保・解放関数は両方指定するか両方NULLにする */
+        if ((config->allocator != NULL)
+                && ((config->allocator->malloc_func == NULL) != (config->allocator->free_func == NULL))) {
+            return NULL;
+        }
+        work = LPC_Malloc(config->allocator, (uint32_t)work_size);
         tmp_alloc_by_own = 1;
     }
 
@@ -102,8 +127,8 @@ struct LPCCalculator* LPCCalculator_Create(const struct LPCCalculatorConfig *con
     if ((config == NULL) || (work == NULL)
             || (work_size < LPCCalculator_CalculateWorkSize(config))
             || (config->max_order == 0) || (config->max_num_samples == 0)) {
-        if (tmp_alloc_by_own == 1) {
-            free(work);
+        if ((tmp_alloc_by_own == 1) && (work != NULL)) {
+            LPC_Free(config->allocator, work);
         }
         return NULL;
     }
@@ -121,6 +146,11 @@ struct LPCCalculator* LPCCalculator_Create(const struct LPCCalculatorConfig *con
     lpcc->max_num_buffer_samples = config->max_num_samples;
     lpcc->work = work;
     lpcc->alloced_by_own = tmp_alloc_by_own;
+    if (config->allocator != NULL) {
+        lpcc->allocator = (*config->allocator);
+    } else {
+        memset(&lpcc->allocator, 0, sizeof(struct LPCAllocator));
+    }
 
     /* 計算用ベクトルの領域割当 */
     lpcc->a_vec = (double *)work_ptr;
@@ -167,7 +197,7 @@ void LPCCalculator_Destroy(struct LPCCalculator *lpcc)
     if (lpcc != NULL) {
         /* ワーク領域を時前確保していたときは開放 */
         if (lpcc->alloced_by_own == 1) {
-            free(lpcc->work);
+            LPC_Free(&lpcc->allocator, lpcc->work);
         }
     }
 }
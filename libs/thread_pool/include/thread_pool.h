@@ -0,0 +1,72 @@
+#ifndef THREADPOOL_H_INCLUDED
+#define THREADPOOL_H_INCLUDED
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* API結果型 */
+typedef enum ThreadPoolApiResultTag {
+    THREADPOOL_APIRESULT_OK = 0,            /* OK */
+    THREADPOOL_APIRESULT_NG,                /* 分類不能なエラー */
+    THREADPOOL_APIRESULT_INVALID_ARGUMENT   /* 不正な引数 */
+} ThreadPoolApiResult;
+
+/* タスク関数 thread_indexは実行スレッドの番号（呼び出し元スレッドは0） */
+/* 補足）タスクの実行順序は不定。タスク毎に固有の領域へ結果を書き出し、 */
+/* スレッド毎の作業領域はthread_indexで選ぶことで、結果はスレッド数や実行順序に依らず決定的になる */
+typedef void (*ThreadPoolTaskFunction)(void *arg, uint32_t thread_index);
+
+/* スレッドプールハンドル */
+struct ThreadPool;
+
+/* タスクグループ 投入したタスクの完了をまとめて待つ単位 */
+struct ThreadPoolTaskGroup {
+    uint32_t num_pending; /* 未完了のタスク数 */
+};
+
+/* メモリアロケータ */
+struct ThreadPoolAllocator {
+    void *(*malloc_func)(void *context, size_t size);   /* 領域確保関数 */
+    void (*free_func)(void *context, void *ptr);         /* 領域解放関数 */
+    void *context;                                      /* 各関数に渡すコンテキスト */
+};
+
+/* 初期化コンフィグ */
+struct ThreadPoolConfig {
+    uint32_t max_num_threads; /* 呼び出し元スレッドを含めた最大スレッド数（0,1でスレッドを作らない） */
+    uint32_t max_num_tasks;   /* スレッド毎のキューに積める最大タスク数 */
+    const struct ThreadPoolAllocator *allocator; /* ワーク領域自前確保時のアロケータ（NULLでmalloc/free） */
+};
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* スレッドプールのワークサイズ計算 */
+int32_t ThreadPool_CalculateWorkSize(const struct ThreadPoolConfig *config);
+
+/* スレッドプールの作成 */
+struct ThreadPool *ThreadPool_Create(const struct ThreadPoolConfig *config, void *work, int32_t work_size);
+
+/* スレッドプールの破棄 キューに残ったタスクは全て実行してから破棄する */
+void ThreadPool_Destroy(struct ThreadPool *pool);
+
+/* 呼び出し元スレッドを含めたスレッド数の取得 */
+uint32_t ThreadPool_GetNumThreads(const struct ThreadPool *pool);
+
+/* タスクグループの初期化 */
+void ThreadPool_InitializeTaskGroup(struct ThreadPoolTaskGroup *group);
+
+/* タスクの投入 キューが満杯の場合は呼び出し元スレッドでその場で実行する */
+/* 補足）投入と完了待ちはプールを作成したスレッドからのみ行うこと */
+ThreadPoolApiResult ThreadPool_Submit(
+    struct ThreadPool *pool, struct ThreadPoolTaskGroup *group, ThreadPoolTaskFunction function, void *arg);
+
+/* タスクグループの完了待ち 待っている間は呼び出し元スレッドもタスクを実行する */
+ThreadPoolApiResult ThreadPool_Wait(struct ThreadPool *pool, struct ThreadPoolTaskGroup *group);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* THREADPOOL_H_INCLUDED */
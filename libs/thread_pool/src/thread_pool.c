@@ -0,0 +1,524 @@
+#include "thread_pool.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+/* スレッドの利用可否 THREADPOOL_NO_THREADSの定義で無効化 */
+#if !defined(THREADPOOL_NO_THREADS) && (defined(_WIN32) || defined(__unix__) || defined(__APPLE__))
+#define THREADPOOL_USE_THREADS 1
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+#endif
+
+/* メモリアラインメント */
+#define THREADPOOL_ALIGNMENT 16
+
+/* nの倍数切り上げ */
+#define THREADPOOL_ROUNDUP(val, n) ((((val) + ((n) - 1)) / (n)) * (n))
+
+/* タスク */
+struct ThreadPoolTask {
+    ThreadPoolTaskFunction function; /* 実行する関数 */
+    void *arg; /* 関数の引数 */
+    struct ThreadPoolTaskGroup *group; /* 所属するタスクグループ */
+};
+
+/* スレッド毎のタスクキュー（リングバッファによる両端キュー） */
+/* 所有スレッドは末尾から取り出し、他スレッドは先頭から盗む */
+struct ThreadPoolQueue {
+    struct ThreadPoolTask *tasks; /* タスク配列 */
+    uint32_t head; /* 先頭位置 */
+    uint32_t num_tasks; /* 積まれているタスク数 */
+};
+
+/* ワーカスレッド */
+struct ThreadPoolWorker {
+    struct ThreadPool *pool; /* 所属するプール */
+    uint32_t index; /* スレッド番号 */
+#if defined(THREADPOOL_USE_THREADS)
+#if defined(_WIN32)
+    HANDLE handle; /* スレッドハンドル */
+#else
+    pthread_t handle; /* スレッドハンドル */
+#endif
+#endif
+};
+
+/* スレッドプール */
+struct ThreadPool {
+    uint32_t max_num_threads; /* 最大スレッド数 */
+    uint32_t num_threads; /* 呼び出し元を含めた実際のスレッド数 */
+    uint32_t max_num_tasks; /* キュー毎の最大タスク数 */
+    struct ThreadPoolQueue *queues; /* スレッド毎のタスクキュー */
+    struct ThreadPoolWorker *workers; /* ワーカスレッド（0番は呼び出し元のため未使用） */
+    uint32_t num_queued; /* 全キューに積まれたタスク数 */
+    uint32_t next_queue; /* 次にタスクを積むキュー */
+    uint8_t shutdown; /* 終了要求 */
+#if defined(THREADPOOL_USE_THREADS)
+    /* 補足）タスクは粒度が粗いため、キューとタスクグループは単一のロックで保護する */
+#if defined(_WIN32)
+    CRITICAL_SECTION lock; /* ロック */
+    CONDITION_VARIABLE work_cond; /* タスク投入通知 */
+    CONDITION_VARIABLE done_cond; /* タスク完了通知 */
+#else
+    pthread_mutex_t lock; /* ロック */
+    pthread_cond_t work_cond; /* タスク投入通知 */
+    pthread_cond_t done_cond; /* タスク完了通知 */
+#endif
+#endif
+    uint8_t alloced_by_own; /* 自分で領域確保したか？ */
+    struct ThreadPoolAllocator allocator; /* 自前確保に使ったアロケータ */
+    void *work; /* ワーク領域先頭ポインタ */
+};
+
+#if defined(THREADPOOL_USE_THREADS)
+/* ロック獲得 */
+static void ThreadPool_Lock(struct ThreadPool *pool)
+{
+#if defined(_WIN32)
+    EnterCriticalSection(&pool->lock);
+#else
+    pthread_mutex_lock(&pool->lock);
+#endif
+}
+
+/* ロック解放 */
+static void ThreadPool_Unlock(struct ThreadPool *pool)
+{
+#if defined(_WIN32)
+    LeaveCriticalSection(&pool->lock);
+#else
+    pthread_mutex_unlock(&pool->lock);
+#endif
+}
+
+/* ロックを解放して通知を待つ */
+#if defined(_WIN32)
+static void ThreadPool_WaitCondition(struct ThreadPool *pool, CONDITION_VARIABLE *cond)
+{
+    SleepConditionVariableCS(cond, &pool->lock, INFINITE);
+}
+#else
+static void ThreadPool_WaitCondition(struct ThreadPool *pool, pthread_cond_t *cond)
+{
+    pthread_cond_wait(cond, &pool->lock);
+}
+#endif
+
+/* 待っている全スレッドに通知 */
+#if defined(_WIN32)
+static void ThreadPool_BroadcastCondition(CONDITION_VARIABLE *cond)
+{
+    WakeAllConditionVariable(cond);
+}
+#else
+static void ThreadPool_BroadcastCondition(pthread_cond_t *cond)
+{
+    pthread_cond_broadcast(cond);
+}
+#endif
+
+/* キューからタスクを取得 ロックを獲得した状態で呼ぶこと */
+static uint8_t ThreadPool_PopTask(struct ThreadPool *pool, uint32_t index, struct ThreadPoolTask *task)
+{
+    uint32_t i;
+    struct ThreadPoolQueue *queue;
+
+    assert(pool != NULL);
+    assert(task != NULL);
+    assert(index < pool->num_threads);
+
+    if (pool->num_queued == 0) {
+        return 0;
+    }
+
+    /* 自分のキューの末尾から取り出す（直近に積んだタスクを優先） */
+    queue = &pool->queues[index];
+    if (queue->num_tasks > 0) {
+        queue->num_tasks--;
+        (*task) = queue->tasks[(queue->head + queue->num_tasks) % pool->max_num_tasks];
+        pool->num_queued--;
+        return 1;
+    }
+
+    /* 他スレッドのキューの先頭から盗む */
+    for (i = 1; i < pool->num_threads; i++) {
+        queue = &pool->queues[(index + i) % pool->num_threads];
+        if (queue->num_tasks > 0) {
+            (*task) = queue->tasks[queue->head];
+            queue->head = (queue->head + 1) % pool->max_num_tasks;
+            queue->num_tasks--;
+            pool->num_queued--;
+            return 1;
+        }
+    }
+
+    /* num_queued > 0 なのでここには来ないはず */
+    assert(0);
+    return 0;
+}
+
+/* タスクを実行して完了を記録 ロックを獲得した状態で呼ぶこと */
+static void ThreadPool_RunTask(struct ThreadPool *pool, uint32_t index, const struct ThreadPoolTask *task)
+{
+    struct ThreadPoolTaskGroup *group = task->group;
+
+    ThreadPool_Unlock(pool);
+    task->function(task->arg, index);
+    ThreadPool_Lock(pool);
+
+    assert(group->num_pending > 0);
+    group->num_pending--;
+    if (group->num_pending == 0) {
+        ThreadPool_BroadcastCondition(&pool->done_cond);
+    }
+}
+
+/* ワーカスレッドの処理 */
+static void ThreadPool_WorkerMain(struct ThreadPoolWorker *worker)
+{
+    struct ThreadPool *pool = worker->pool;
+    struct ThreadPoolTask task;
+
+    ThreadPool_Lock(pool);
+    while (1) {
+        /* タスクが積まれるか終了要求が来るまで待つ */
+        while ((pool->num_queued == 0) && (pool->shutdown == 0)) {
+            ThreadPool_WaitCondition(pool, &pool->work_cond);
+        }
+        /* 残ったタスクを全て実行してから終了 */
+        if (ThreadPool_PopTask(pool, worker->index, &task) == 0) {
+            break;
+        }
+        ThreadPool_RunTask(pool, worker->index, &task);
+    }
+    ThreadPool_Unlock(pool);
+}
+
+/* スレッドのエントリ関数 */
+#if defined(_WIN32)
+static DWORD WINAPI ThreadPool_WorkerEntry(LPVOID arg)
+{
+    ThreadPool_WorkerMain((struct ThreadPoolWorker *)arg);
+    return 0;
+}
+#else
+static void *ThreadPool_WorkerEntry(void *arg)
+{
+    ThreadPool_WorkerMain((struct ThreadPoolWorker *)arg);
+    return NULL;
+}
+#endif
+#endif /* THREADPOOL_USE_THREADS */
+
+/* アロケータによる領域確保 */
+static void *ThreadPool_Malloc(const struct ThreadPoolAllocator *allocator, size_t size)
+{
+    if ((allocator == NULL) || (allocator->malloc_func == NULL)) {
+        return malloc(size);
+    }
+    return allocator->malloc_func(allocator->context, size);
+}
+
+/* アロケータによる領域解放 */
+static void ThreadPool_Free(const struct ThreadPoolAllocator *allocator, void *ptr)
+{
+    if ((allocator == NULL) || (allocator->free_func == NULL)) {
+        free(ptr);
+        return;
+    }
+    allocator->free_func(allocator->context, ptr);
+}
+
+/* スレッドプールのワークサイズ計算 */
+int32_t ThreadPool_CalculateWorkSize(const struct ThreadPoolConfig *config)
+{
+    int32_t work_size;
+    uint32_t max_num_threads;
+
+    /* 引数チェック */
+    if (config == NULL) {
+        return -1;
+    }
+    if (config->max_num_tasks == 0) {
+        return -1;
+    }
+
+    max_num_threads = (config->max_num_threads > 1) ? config->max_num_threads : 1;
+
+    work_size = sizeof(struct ThreadPool) + THREADPOOL_ALIGNMENT;
+    /* スレッド毎のタスクキュー */
+    work_size += (int32_t)(sizeof(struct ThreadPoolQueue) * max_num_threads) + THREADPOOL_ALIGNMENT;
+    work_size += (int32_t)(sizeof(struct ThreadPoolTask) * config->max_num_tasks * max_num_threads) + THREADPOOL_ALIGNMENT;
+    /* ワーカスレッド */
+    work_size += (int32_t)(sizeof(struct ThreadPoolWorker) * max_num_threads) + THREADPOOL_ALIGNMENT;
+
+    return work_size;
+}
+
+/* スレッドプールの作成 */
+struct ThreadPool *ThreadPool_Create(const struct ThreadPoolConfig *config, void *work, int32_t work_size)
+{
+    uint32_t i;
+    struct ThreadPool *pool;
+    uint8_t *work_ptr;
+    uint8_t tmp_alloc_by_own = 0;
+
+    /* 自前でワーク領域確保 */
+    if ((work == NULL) && (work_size == 0)) {
+        if ((work_size = ThreadPool_CalculateWorkSize(config)) < 0) {
+            return NULL;
+        }
+        /* 確保・解放関数は両方指定するか両方NULLにする */
+        if ((config->allocator != NULL)
+                && ((config->allocator->malloc_func == NULL) != (config->allocator->free_func == NULL))) {
+            return NULL;
+        }
+        work = ThreadPool_Malloc(config->allocator, (uint32_t)work_size);
+        tmp_alloc_by_own = 1;
+    }
+
+    /* 引数チェック */
+    if ((config == NULL) || (work == NULL)
+            || (work_size < ThreadPool_CalculateWorkSize(config))
+            || (config->max_num_tasks == 0)) {
+        if ((tmp_alloc_by_own == 1) && (work != NULL)) {
+            ThreadPool_Free(config->allocator, work);
+        }
+        return NULL;
+    }
+
+    /* ワーク領域取得 */
+    work_ptr = (uint8_t *)work;
+
+    /* ハンドル領域確保 */
+    work_ptr = (uint8_t *)THREADPOOL_ROUNDUP((uintptr_t)work_ptr, THREADPOOL_ALIGNMENT);
+    pool = (struct ThreadPool *)work_ptr;
+    work_ptr += sizeof(struct ThreadPool);
+
+    /* ハンドルメンバの設定 */
+    pool->max_num_threads = (config->max_num_threads > 1) ? config->max_num_threads : 1;
+    pool->max_num_tasks = config->max_num_tasks;
+    pool->num_threads = 1;
+    pool->num_queued = 0;
+    pool->next_queue = 0;
+    pool->shutdown = 0;
+    pool->work = work;
+    pool->alloced_by_own = tmp_alloc_by_own;
+    if (config->allocator != NULL) {
+        pool->allocator = (*config->allocator);
+    } else {
+        memset(&pool->allocator, 0, sizeof(struct ThreadPoolAllocator));
+    }
+
+    /* タスクキューの領域割当 */
+    work_ptr = (uint8_t *)THREADPOOL_ROUNDUP((uintptr_t)work_ptr, THREADPOOL_ALIGNMENT);
+    pool->queues = (struct ThreadPoolQueue *)work_ptr;
+    work_ptr += sizeof(struct ThreadPoolQueue) * pool->max_num_threads;
+    work_ptr = (uint8_t *)THREADPOOL_ROUNDUP((uintptr_t)work_ptr, THREADPOOL_ALIGNMENT);
+    for (i = 0; i < pool->max_num_threads; i++) {
+        pool->queues[i].tasks = (struct ThreadPoolTask *)work_ptr;
+        pool->queues[i].head = 0;
+        pool->queues[i].num_tasks = 0;
+        work_ptr += sizeof(struct ThreadPoolTask) * pool->max_num_tasks;
+    }
+
+    /* ワーカの領域割当 */
+    work_ptr = (uint8_t *)THREADPOOL_ROUNDUP((uintptr_t)work_ptr, THREADPOOL_ALIGNMENT);
+    pool->workers = (struct ThreadPoolWorker *)work_ptr;
+    work_ptr += sizeof(struct ThreadPoolWorker) * pool->max_num_threads;
+    for (i = 0; i < pool->max_num_threads; i++) {
+        pool->workers[i].pool = pool;
+        pool->workers[i].index = i;
+    }
+
+    /* バッファオーバーランチェック */
+    assert((work_ptr - (uint8_t *)work) <= work_size);
+
+#if defined(THREADPOOL_USE_THREADS)
+    /* 同期オブジェクトの作成 */
+#if defined(_WIN32)
+    InitializeCriticalSection(&pool->lock);
+    InitializeConditionVariable(&pool->work_cond);
+    InitializeConditionVariable(&pool->done_cond);
+#else
+    if (pthread_mutex_init(&pool->lock, NULL) != 0) {
+        if (tmp_alloc_by_own == 1) {
+            ThreadPool_Free(config->allocator, work);
+        }
+        return NULL;
+    }
+    if (pthread_cond_init(&pool->work_cond, NULL) != 0) {
+        pthread_mutex_destroy(&pool->lock);
+        if (tmp_alloc_by_own == 1) {
+            ThreadPool_Free(config->allocator, work);
+        }
+        return NULL;
+    }
+    if (pthread_cond_init(&pool->done_cond, NULL) != 0) {
+        pthread_cond_destroy(&pool->work_cond);
+        pthread_mutex_destroy(&pool->lock);
+        if (tmp_alloc_by_own == 1) {
+            ThreadPool_Free(config->allocator, work);
+        }
+        return NULL;
+    }
+#endif
+
+    /* ワーカスレッドの起動 */
+    /* 補足）スレッドを作れなかった場合はそれまでに作れたスレッドだけで動作する */
+    ThreadPool_Lock(pool);
+    for (i = 1; i < pool->max_num_threads; i++) {
+        struct ThreadPoolWorker *worker = &pool->workers[i];
+#if defined(_WIN32)
+        if ((worker->handle = CreateThread(NULL, 0, ThreadPool_WorkerEntry, worker, 0, NULL)) == NULL) {
+            break;
+        }
+#else
+        if (pthread_create(&worker->handle, NULL, ThreadPool_WorkerEntry, worker) != 0) {
+            break;
+        }
+#endif
+        pool->num_threads++;
+    }
+    ThreadPool_Unlock(pool);
+#endif
+
+    return pool;
+}
+
+/* スレッドプールの破棄 */
+void ThreadPool_Destroy(struct ThreadPool *pool)
+{
+    if (pool == NULL) {
+        return;
+    }
+
+#if defined(THREADPOOL_USE_THREADS)
+    {
+        uint32_t i;
+
+        /* 終了要求を出してワーカスレッドの終了を待つ */
+        ThreadPool_Lock(pool);
+        pool->shutdown = 1;
+        ThreadPool_BroadcastCondition(&pool->work_cond);
+        ThreadPool_Unlock(pool);
+        for (i = 1; i < pool->num_threads; i++) {
+#if defined(_WIN32)
+            WaitForSingleObject(pool->workers[i].handle, INFINITE);
+            CloseHandle(pool->workers[i].handle);
+#else
+            pthread_join(pool->workers[i].handle, NULL);
+#endif
+        }
+
+        /* 同期オブジェクトの破棄 */
+#if defined(_WIN32)
+        DeleteCriticalSection(&pool->lock);
+#else
+        pthread_cond_destroy(&pool->done_cond);
+        pthread_cond_destroy(&pool->work_cond);
+        pthread_mutex_destroy(&pool->lock);
+#endif
+    }
+#endif
+
+    if (pool->alloced_by_own == 1) {
+        ThreadPool_Free(&pool->allocator, pool->work);
+    }
+}
+
+/* 呼び出し元スレッドを含めたスレッド数の取得 */
+uint32_t ThreadPool_GetNumThreads(const struct ThreadPool *pool)
+{
+    if (pool == NULL) {
+        return 0;
+    }
+    return pool->num_threads;
+}
+
+/* タスクグループの初期化 */
+void ThreadPool_InitializeTaskGroup(struct ThreadPoolTaskGroup *group)
+{
+    if (group == NULL) {
+        return;
+    }
+    group->num_pending = 0;
+}
+
+/* タスクの投入 */
+ThreadPoolApiResult ThreadPool_Submit(
+    struct ThreadPool *pool, struct ThreadPoolTaskGroup *group, ThreadPoolTaskFunction function, void *arg)
+{
+    /* 引数チェック */
+    if ((pool == NULL) || (group == NULL) || (function == NULL)) {
+        return THREADPOOL_APIRESULT_INVALID_ARGUMENT;
+    }
+
+#if defined(THREADPOOL_USE_THREADS)
+    if (pool->num_threads > 1) {
+        uint32_t i;
+
+        ThreadPool_Lock(pool);
+        /* 空きのあるキューに順番に積む */
+        for (i = 0; i < pool->num_threads; i++) {
+            struct ThreadPoolQueue *queue = &pool->queues[pool->next_queue];
+            pool->next_queue = (pool->next_queue + 1) % pool->num_threads;
+            if (queue->num_tasks < pool->max_num_tasks) {
+                struct ThreadPoolTask *task
+                    = &queue->tasks[(queue->head + queue->num_tasks) % pool->max_num_tasks];
+                task->function = function;
+                task->arg = arg;
+                task->group = group;
+                queue->num_tasks++;
+                pool->num_queued++;
+                group->num_pending++;
+                ThreadPool_BroadcastCondition(&pool->work_cond);
+                ThreadPool_Unlock(pool);
+                return THREADPOOL_APIRESULT_OK;
+            }
+        }
+        ThreadPool_Unlock(pool);
+    }
+#endif
+
+    /* スレッドが無いかキューが満杯のためその場で実行 */
+    function(arg, 0);
+
+    return THREADPOOL_APIRESULT_OK;
+}
+
+/* タスクグループの完了待ち */
+ThreadPoolApiResult ThreadPool_Wait(struct ThreadPool *pool, struct ThreadPoolTaskGroup *group)
+{
+    /* 引数チェック */
+    if ((pool == NULL) || (group == NULL)) {
+        return THREADPOOL_APIRESULT_INVALID_ARGUMENT;
+    }
+
+#if defined(THREADPOOL_USE_THREADS)
+    {
+        struct ThreadPoolTask task;
+
+        ThreadPool_Lock(pool);
+        while (group->num_pending > 0) {
+            /* 待っている間も積まれたタスクを実行する */
+            if (ThreadPool_PopTask(pool, 0, &task) != 0) {
+                ThreadPool_RunTask(pool, 0, &task);
+            } else {
+                ThreadPool_WaitCondition(pool, &pool->done_cond);
+            }
+        }
+        ThreadPool_Unlock(pool);
+    }
+#else
+    /* 投入時に実行済み */
+    assert(group->num_pending == 0);
+#endif
+
+    return THREADPOOL_APIRESULT_OK;
+}
@@ -2,6 +2,7 @@
 #define WAV_INCLUDED
 
 #include <stdint.h>
+#include <stdio.h>
 
 /* PCM型 - ファイルのビット深度如何によらず、メモリ上では全て符号付き32bitで取り扱う */
 typedef int32_t WAVPcmData;
@@ -20,13 +21,16 @@ typedef enum WAVApiResultTag {
     WAV_APIRESULT_INVALID_PARAMETER   /* 引数が不正 */
 } WAVApiResult;
 
+/* サンプル数が不明であることを表す値 */
+#define WAV_NUM_SAMPLES_UNKNOWN UINT64_MAX
+
 /* WAVファイルフォーマット */
 struct WAVFileFormat {
     WAVDataFormat data_format;      /* データフォーマット */
     uint32_t      num_channels;     /* チャンネル数 */
     uint32_t      sampling_rate;    /* サンプリングレート */
     uint32_t      bits_per_sample;  /* 量子化ビット数 */
-    uint32_t      num_samples;      /* サンプル数 */
+    uint64_t      num_samples;      /* サンプル数 */
 };
 
 /* WAVファイルハンドル */
@@ -38,6 +42,9 @@ struct WAVFile {
 /* アクセサ */
 #define WAVFile_PCM(wavfile, samp, ch)  (wavfile->data[(ch)][(samp)])
 
+/* WAVストリームハンドル（ファイル全体をメモリに載せずに逐次読み書きする） */
+struct WAVStream;
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -59,6 +66,39 @@ WAVApiResult WAV_WriteToFile(
 WAVApiResult WAV_GetWAVFormatFromFile(
         const char* filename, struct WAVFileFormat* format);
 
+/* 読み込み用にWAVストリームを開く ファイルのフォーマットをformatに取得 */
+struct WAVStream* WAV_OpenStreamForRead(const char* filename, struct WAVFileFormat* format);
+
+/* 開いているファイル（標準入力など）から読み込み用にWAVストリームを開く */
+/* 補足）fpはクローズ時に閉じない。シークできない入力にも対応し、 */
+/*       ヘッダのサイズより先にファイル末尾に達した場合はそこまでを全サンプルとする */
+/*       シークできない入力でヘッダのサイズが仮の値（0または0xFFFFFFFF）の場合は、 */
+/*       format->num_samplesをWAV_NUM_SAMPLES_UNKNOWNとしてファイル末尾まで読む */
+struct WAVStream* WAV_OpenStreamForReadFromFp(FILE* fp, struct WAVFileFormat* format);
+
+/* 書き出し用にWAVストリームを開く */
+/* 補足）format->num_samplesは仮の値でよい。ヘッダのサイズはクローズ時に書き出したサンプル数で確定する */
+/* 補足）RIFFのサイズ上限（約4GB）を超える場合はRF64形式で書き出す。形式はオープン時のnum_samplesで決まるため、 */
+/*       上限を超える可能性があればnum_samplesに十分大きな値を指定すること */
+struct WAVStream* WAV_OpenStreamForWrite(const char* filename, const struct WAVFileFormat* format);
+
+/* 開いているファイル（標準出力など）へ書き出し用にWAVストリームを開く */
+/* 補足）fpはクローズ時に閉じない。シークできない出力ではヘッダのサイズを書き直せないため、 */
+/*       format->num_samplesの値がそのまま残る */
+struct WAVStream* WAV_OpenStreamForWriteToFp(FILE* fp, const struct WAVFileFormat* format);
+
+/* ストリームからチャンネル毎のバッファへ最大num_samplesサンプル読み込み */
+/* 補足）ファイル末尾ではnum_samplesより少ないサンプル数を読み込む */
+WAVApiResult WAV_ReadStream(
+        struct WAVStream* stream, WAVPcmData* const* data, uint32_t num_samples, uint32_t* num_read_samples);
+
+/* チャンネル毎のバッファからnum_samplesサンプルをストリームへ書き出し */
+WAVApiResult WAV_WriteStream(
+        struct WAVStream* stream, WAVPcmData* const* data, uint32_t num_samples);
+
+/* WAVストリームを閉じる 書き出し時はヘッダのサイズを確定させる */
+WAVApiResult WAV_CloseStream(struct WAVStream* stream);
+
 #ifdef __cplusplus
 }
 #endif
@@ -5,9 +5,28 @@
 #include <string.h>
 #include <assert.h>
 
+/* SSE2の利用可否 WAV_NO_SIMDの定義で無効化 */
+#if !defined(WAV_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2)))
+#define WAV_USE_SSE2 1
+#include <emmintrin.h>
+#endif
+
 /* パーサの読み込みバッファサイズ */
 #define WAVBITBUFFER_BUFFER_SIZE         (10 * 1024)
 
+/* PCMデータを一括で読み込む際のバッファサイズ */
+#define WAVPARSER_PCM_READ_BUFFER_SIZE   (1024 * 1024)
+
+/* PCMデータを一括で書き出す際のバッファサイズ */
+#define WAVWRITER_PCM_WRITE_BUFFER_SIZE  (1024 * 1024)
+
+/* RIFF形式で表現できる最大のPCMデータサイズ（RIFFチャンクサイズが32bitに収まる上限） */
+/* 補足）36は"WAVE"から"data"チャンクのサイズフィールドまでのバイト数 */
+#define WAV_RIFF_MAX_PCM_DATA_SIZE       (0xFFFFFFFFUL - 36)
+
+/* RF64形式で32bitのサイズフィールドに書き込む値（ds64チャンクの値を参照させる） */
+#define WAV_RF64_SIZE_PLACEHOLDER        0xFFFFFFFFUL
+
 /* 下位n_bitsを取得 */
 /* 補足）((1 << n_bits) - 1)は下位の数値だけ取り出すマスクになる */
 #define WAV_GetLowerBits(n_bits, val) ((val) & (uint32_t)((1 << (n_bits)) - 1))
@@ -27,6 +46,7 @@ typedef enum WAVErrorTag {
 /* ビットバッファ */
 struct WAVBitBuffer {
     uint8_t   bytes[WAVBITBUFFER_BUFFER_SIZE];   /* ビットバッファ */
+    uint32_t  num_bytes;                        /* バッファ内の有効なバイト数 */
     uint32_t  bit_count;                        /* ビット入力カウント */
     int32_t   byte_pos;                         /* バイト列読み込み位置 */
 };
@@ -35,6 +55,21 @@ struct WAVBitBuffer {
 struct WAVParser {
     FILE*               fp;       /* 読み込みファイルポインタ */
     struct WAVBitBuffer buffer;   /* ビットバッファ */
+    uint8_t             is_data_size_placeholder; /* dataチャンクのサイズが仮の値（0または0xFFFFFFFF）か */
+};
+
+/* ストリーム */
+struct WAVStream {
+    FILE*                 fp;                       /* ファイルポインタ */
+    struct WAVFileFormat  format;                   /* フォーマット */
+    uint8_t               is_write;                 /* 書き出し用か否か */
+    uint8_t               own_fp;                   /* クローズ時にファイルを閉じるか否か */
+    uint64_t              num_processed_samples;    /* 読み書き済みのサンプル数 */
+    uint8_t               is_rf64;                  /* RF64形式で書き出すか否か */
+    uint32_t              frame_size;               /* 1サンプル（全チャンネル分）のバイト数 */
+    uint8_t*              buffer;                   /* インターリーブ変換用のバッファ */
+    uint32_t              max_num_buffer_samples;   /* バッファに収まるサンプル数 */
+    struct WAVParser      parser;                   /* パーサ（読み込み時） */
 };
 
 /* ライタ */
@@ -53,6 +88,10 @@ static void WAVParser_Finalize(struct WAVParser* parser);
 static WAVError WAVParser_GetBits(struct WAVParser* parser, uint32_t n_bits, uint64_t* bitsbuf);
 /* シーク（fseek準拠） */
 static WAVError WAVParser_Seek(struct WAVParser* parser, int32_t offset, int32_t wherefrom);
+/* バイト列を取得（先読み済みのデータから使う） */
+static WAVError WAVParser_GetBytes(struct WAVParser* parser, uint8_t* data, uint32_t size);
+/* 最大sizeバイトのバイト列を取得 ファイル末尾では読めた分だけ取得する */
+static WAVError WAVParser_GetAvailableBytes(struct WAVParser* parser, uint8_t* data, uint32_t size, uint32_t* num_read_bytes);
 /* ライタの初期化 */
 static void WAVWriter_Initialize(struct WAVWriter* writer, FILE* fp);
 /* ライタの終了 */
@@ -68,9 +107,18 @@ static WAVError WAVWriter_PutLittleEndianBytes(
 /* ライタを使用してファイルフォーマットに従ったヘッダ部を出力 */
 static WAVError WAVWriter_PutWAVHeader(
         struct WAVWriter* writer, const struct WAVFileFormat* format);
+/* ライタを使用してヘッダ部を出力（RF64形式とするか指定） */
+static WAVError WAVWriter_PutWAVHeaderCore(
+        struct WAVWriter* writer, const struct WAVFileFormat* format, uint8_t is_rf64);
+/* RF64形式でなければ表現できないフォーマットか */
+static uint8_t WAV_IsRF64Required(const struct WAVFileFormat* format);
 /* ライタを使用してPCMデータ出力 */
 static WAVError WAVWriter_PutWAVPcmData(
         struct WAVWriter* writer, const struct WAVFile* wavfile);
+/* チャンネル毎の32bit形式のPCMデータをリトルエンディアンのインターリーブ形式に変換 */
+static void WAV_InterleavePCMData(
+        uint8_t* dst, uint32_t bits_per_sample, uint32_t num_channels, uint32_t num_samples,
+        WAVPcmData* const* data, uint64_t offset);
 
 /* リトルエンディアンでビットパターンを取得 */
 static WAVError WAVParser_GetLittleEndianBytes(
@@ -88,24 +136,19 @@ static WAVError WAVParser_GetWAVFormat(
 static WAVError WAVParser_GetWAVPcmData(
         struct WAVParser* parser, struct WAVFile* wavfile);
 
-/* 8bitPCM形式を32bit形式に変換 */
-static int32_t WAV_Convert8bitPCMto32bitPCM(int32_t in_8bitpcm);
-/* 16bitPCM形式を32bit形式に変換 */
-static int32_t WAV_Convert16bitPCMto32bitPCM(int32_t in_16bitpcm);
-/* 24bitPCM形式を32bit形式に変換 */
-static int32_t WAV_Convert24bitPCMto32bitPCM(int32_t in_24bitpcm);
-/* 32bitPCM形式を32bit形式に変換 */
-static int32_t WAV_Convert32bitPCMto32bitPCM(int32_t in_32bitpcm);
-
-/* 32bitPCM形式を32bit形式に変換 */
-static int32_t WAV_Convert32bitPCMto32bitPCM(int32_t in_32bitpcm);
+/* インターリーブされたPCMデータをチャンネル毎の32bit形式に変換 */
+static void WAV_DeinterleavePCMData(
+        const uint8_t* src, uint32_t bits_per_sample, uint32_t num_channels, uint32_t num_samples,
+        WAVPcmData* const* data, uint64_t offset);
 
 /* パーサを使用してファイルフォーマットを読み取り */
 static WAVError WAVParser_GetWAVFormat(
         struct WAVParser* parser, struct WAVFileFormat* format)
 {
-    uint64_t  bitsbuf;
+    uint64_t  bitsbuf, pcm_data_size, rf64_pcm_data_size;
     int32_t   fmt_chunk_size;
+    uint8_t   is_rf64;
+    char      signature[4];
     struct WAVFileFormat tmp_format;
 
     /* 引数チェック */
@@ -113,8 +156,15 @@ static WAVError WAVParser_GetWAVFormat(
         return WAV_ERROR_INVALID_PARAMETER;
     }
 
-    /* ヘッダ 'R', 'I', 'F', 'F' をチェック */
-    if (WAVParser_CheckSignatureString(parser, "RIFF", 4) != WAV_ERROR_OK) {
+    /* ヘッダ 'R', 'I', 'F', 'F' または 'R', 'F', '6', '4' をチェック */
+    if (WAVParser_GetString(parser, signature, 4) != WAV_ERROR_OK) {
+        return WAV_ERROR_IO;
+    }
+    if (strncmp(signature, "RIFF", 4) == 0) {
+        is_rf64 = 0;
+    } else if (strncmp(signature, "RF64", 4) == 0) {
+        is_rf64 = 1;
+    } else {
         return WAV_ERROR_INVALID_FORMAT;
     }
 
@@ -126,6 +176,30 @@ static WAVError WAVParser_GetWAVFormat(
         return WAV_ERROR_INVALID_FORMAT;
     }
 
+    /* RF64ではds64チャンクから64bitのサイズを取得 */
+    rf64_pcm_data_size = 0;
+    if (is_rf64) {
+        uint64_t ds64_chunk_size;
+        if (WAVParser_CheckSignatureString(parser, "ds64", 4) != WAV_ERROR_OK) {
+            return WAV_ERROR_INVALID_FORMAT;
+        }
+        if (WAVParser_GetLittleEndianBytes(parser, 4, &ds64_chunk_size) != WAV_ERROR_OK) { return WAV_ERROR_IO; }
+        /* RIFFサイズ、dataサイズ、サンプル数の3つは必須 */
+        if (ds64_chunk_size < 24) {
+            return WAV_ERROR_INVALID_FORMAT;
+        }
+        /* RIFFサイズは読み飛ばし */
+        if (WAVParser_GetLittleEndianBytes(parser, 8, &bitsbuf) != WAV_ERROR_OK) { return WAV_ERROR_IO; }
+        /* dataチャンクのサイズ */
+        if (WAVParser_GetLittleEndianBytes(parser, 8, &rf64_pcm_data_size) != WAV_ERROR_OK) { return WAV_ERROR_IO; }
+        /* サンプル数はdataサイズから求めるため読み飛ばし */
+        if (WAVParser_GetLittleEndianBytes(parser, 8, &bitsbuf) != WAV_ERROR_OK) { return WAV_ERROR_IO; }
+        /* 残り（チャンクサイズテーブル）は読み飛ばし */
+        if (ds64_chunk_size > 24) {
+            if (WAVParser_Seek(parser, (int32_t)(ds64_chunk_size - 24), SEEK_CUR) != WAV_ERROR_OK) { return WAV_ERROR_IO; }
+        }
+    }
+
     /* fmtチャンクのヘッダ 'f', 'm', 't', ' ' をチェック */
     if (WAVParser_CheckSignatureString(parser, "fmt ", 4) != WAV_ERROR_OK) {
         return WAV_ERROR_INVALID_FORMAT;
@@ -191,9 +265,16 @@ static WAVError WAVParser_GetWAVFormat(
 
     /* サンプル数: 波形データバイト数から算出 */
     if (WAVParser_GetLittleEndianBytes(parser, 4, &bitsbuf) != WAV_ERROR_OK) { return WAV_ERROR_IO; }
-    tmp_format.num_samples = (uint32_t)bitsbuf;
-    assert(tmp_format.num_samples % ((tmp_format.bits_per_sample / 8) * tmp_format.num_channels) == 0);
-    tmp_format.num_samples /= ((tmp_format.bits_per_sample / 8) * tmp_format.num_channels);
+    pcm_data_size = bitsbuf;
+    /* RF64では32bitのサイズフィールドは無効値で、ds64チャンクの値を使う */
+    if (is_rf64 && (bitsbuf == WAV_RF64_SIZE_PLACEHOLDER)) {
+        pcm_data_size = rf64_pcm_data_size;
+    }
+    /* パイプに書き出すプロデューサは後からサイズを書き直せないため、0か0xFFFFFFFFを書いておくことがある */
+    parser->is_data_size_placeholder
+        = ((pcm_data_size == 0) || (pcm_data_size == WAV_RF64_SIZE_PLACEHOLDER)) ? 1 : 0;
+    /* 補足）パイプ出力で仮に書かれたサイズはフレームサイズで割り切れないことがあるため端数は切り捨てる */
+    tmp_format.num_samples = pcm_data_size / ((tmp_format.bits_per_sample / 8) * tmp_format.num_channels);
 
     /* 構造体コピー */
     *format = tmp_format;
@@ -201,51 +282,149 @@ static WAVError WAVParser_GetWAVFormat(
     return WAV_ERROR_OK;
 }
 
+#if defined(WAV_USE_SSE2)
+/* 16bitPCMのチャンネル分離と32bit化（SSE2） 処理したサンプル数を返す */
+static uint32_t WAV_Deinterleave16bitPCMDataSSE2(
+        const uint8_t* src, uint32_t num_channels, uint32_t num_samples,
+        WAVPcmData* const* data, uint64_t offset)
+{
+    uint32_t smpl = 0;
+
+    if (num_channels == 1) {
+        /* 各サンプルを32bitの上位16bitに置く */
+        const __m128i zero = _mm_setzero_si128();
+        WAVPcmData* dst = &data[0][offset];
+        for (smpl = 0; (smpl + 8) <= num_samples; smpl += 8) {
+            const __m128i v = _mm_loadu_si128((const __m128i *)&src[2 * smpl]);
+            _mm_storeu_si128((__m128i *)&dst[smpl + 0], _mm_unpacklo_epi16(zero, v));
+            _mm_storeu_si128((__m128i *)&dst[smpl + 4], _mm_unpackhi_epi16(zero, v));
+        }
+    } else if (num_channels == 2) {
+        /* 32bit単位で見るとLchが下位16bit、Rchが上位16bitに並んでいる */
+        const __m128i rmask = _mm_set1_epi32((int)0xFFFF0000);
+        WAVPcmData* dst0 = &data[0][offset];
+        WAVPcmData* dst1 = &data[1][offset];
+        for (smpl = 0; (smpl + 4) <= num_samples; smpl += 4) {
+            const __m128i v = _mm_loadu_si128((const __m128i *)&src[4 * smpl]);
+            _mm_storeu_si128((__m128i *)&dst0[smpl], _mm_slli_epi32(v, 16));
+            _mm_storeu_si128((__m128i *)&dst1[smpl], _mm_and_si128(v, rmask));
+        }
+    }
+
+    return smpl;
+}
+#endif /* WAV_USE_SSE2 */
+
+/* インターリーブされたPCMデータをチャンネル毎の32bit形式に変換 */
+static void WAV_DeinterleavePCMData(
+        const uint8_t* src, uint32_t bits_per_sample, uint32_t num_channels, uint32_t num_samples,
+        WAVPcmData* const* data, uint64_t offset)
+{
+    uint32_t ch, smpl, head;
+    const uint32_t bytes_per_sample = bits_per_sample / 8;
+    const uint32_t frame_size = bytes_per_sample * num_channels;
+
+    assert(src != NULL);
+    assert(data != NULL);
+
+    head = 0;
+#if defined(WAV_USE_SSE2)
+    if (bits_per_sample == 16) {
+        head = WAV_Deinterleave16bitPCMDataSSE2(src, num_channels, num_samples, data, offset);
+    }
+#endif
+
+    /* 残りはチャンネル毎に走査し、いずれも32bitの上位詰めに揃える */
+    for (ch = 0; ch < num_channels; ch++) {
+        const uint8_t* pos = &src[head * frame_size + ch * bytes_per_sample];
+        WAVPcmData* dst = &data[ch][offset];
+        switch (bits_per_sample) {
+        case 8:
+            /* 無音に相当する128を中心とした符号なし表現: 最上位ビットの反転で符号付きになる */
+            for (smpl = head; smpl < num_samples; smpl++) {
+                dst[smpl] = (int32_t)(((uint32_t)pos[0] ^ 0x80U) << 24);
+                pos += frame_size;
+            }
+            break;
+        case 16:
+            for (smpl = head; smpl < num_samples; smpl++) {
+                dst[smpl] = (int32_t)(((uint32_t)pos[0] << 16) | ((uint32_t)pos[1] << 24));
+                pos += frame_size;
+            }
+            break;
+        case 24:
+            for (smpl = head; smpl < num_samples; smpl++) {
+                dst[smpl] = (int32_t)(((uint32_t)pos[0] << 8) | ((uint32_t)pos[1] << 16) | ((uint32_t)pos[2] << 24));
+                pos += frame_size;
+            }
+            break;
+        case 32:
+            for (smpl = head; smpl < num_samples; smpl++) {
+                dst[smpl] = (int32_t)((uint32_t)pos[0] | ((uint32_t)pos[1] << 8) | ((uint32_t)pos[2] << 16) | ((uint32_t)pos[3] << 24));
+                pos += frame_size;
+            }
+            break;
+        default:
+            assert(0);
+        }
+    }
+}
+
 /* パーサを使用してPCMデータを読み取り */
 static WAVError WAVParser_GetWAVPcmData(
         struct WAVParser* parser, struct WAVFile* wavfile)
 {
-    uint32_t  ch, sample, bytes_per_sample;
-    uint64_t  bitsbuf;
-    int32_t   (*convert_to_sint32_func)(int32_t);
+    uint8_t*  read_buffer;
+    uint32_t  frame_size, num_samples_per_read;
+    uint64_t  progress;
+    WAVError  err;
 
     /* 引数チェック */
     if (parser == NULL || wavfile == NULL) {
         return WAV_ERROR_INVALID_PARAMETER;
     }
 
-    /* ビット深度に合わせてPCMデータの変換関数を決定 */
+    /* 対応しているビット深度か */
     switch (wavfile->format.bits_per_sample) {
-    case 8:
-        convert_to_sint32_func = WAV_Convert8bitPCMto32bitPCM;
-        break;
-    case 16:
-        convert_to_sint32_func = WAV_Convert16bitPCMto32bitPCM;
-        break;
-    case 24:
-        convert_to_sint32_func = WAV_Convert24bitPCMto32bitPCM;
-        break;
-    case 32:
-        convert_to_sint32_func = WAV_Convert32bitPCMto32bitPCM;
+    case 8: case 16: case 24: case 32:
         break;
     default:
         /* fprintf(stderr, "Unsupported bits per sample format(=%d). \n", wavfile->format.bits_per_sample); */
         return WAV_ERROR_INVALID_FORMAT;
     }
 
-    /* データ読み取り */
-    bytes_per_sample = wavfile->format.bits_per_sample / 8;
-    for (sample = 0; sample < wavfile->format.num_samples; sample++) {
-        for (ch = 0; ch < wavfile->format.num_channels; ch++) {
-            if (WAVParser_GetLittleEndianBytes(parser, bytes_per_sample, &bitsbuf) != WAV_ERROR_OK) {
-                return WAV_ERROR_IO;
-            }
-            /* 32bit整数形式に変形してデータにセット */
-            wavfile->data[ch][sample] = convert_to_sint32_func((int32_t)(bitsbuf));
+    /* 1サンプル（全チャンネル分）のバイト数 */
+    frame_size = (wavfile->format.bits_per_sample / 8) * wavfile->format.num_channels;
+    if (frame_size == 0) {
+        return WAV_ERROR_INVALID_FORMAT;
+    }
+
+    /* 一括読み込み用のバッファを確保 */
+    num_samples_per_read = (uint32_t)WAV_Min(wavfile->format.num_samples, WAVPARSER_PCM_READ_BUFFER_SIZE / frame_size);
+    if (num_samples_per_read == 0) {
+        num_samples_per_read = 1;
+    }
+    if ((read_buffer = (uint8_t *)malloc((size_t)num_samples_per_read * frame_size)) == NULL) {
+        return WAV_ERROR_NG;
+    }
+
+    /* まとめて読み込み、チャンネル毎に分離 */
+    err = WAV_ERROR_OK;
+    progress = 0;
+    while (progress < wavfile->format.num_samples) {
+        const uint32_t num_read_samples = (uint32_t)WAV_Min(num_samples_per_read, wavfile->format.num_samples - progress);
+        if ((err = WAVParser_GetBytes(parser, read_buffer, num_read_samples * frame_size)) != WAV_ERROR_OK) {
+            break;
         }
+        WAV_DeinterleavePCMData(read_buffer,
+                wavfile->format.bits_per_sample, wavfile->format.num_channels, num_read_samples,
+                wavfile->data, progress);
+        progress += num_read_samples;
     }
 
-    return WAV_ERROR_OK;
+    free(read_buffer);
+
+    return err;
 }
 
 /* ファイルからWAVファイルフォーマットだけ読み取り */
@@ -372,7 +551,7 @@ struct WAVFile* WAV_Create(const struct WAVFileFormat* format)
         goto EXIT_FAILURE_WITH_DATA_RELEASE;
     }
     for (ch = 0; ch < format->num_channels; ch++) {
-        wavfile->data[ch] = (WAVPcmData *)calloc(format->num_samples, sizeof(WAVPcmData));
+        wavfile->data[ch] = (WAVPcmData *)calloc((size_t)format->num_samples, sizeof(WAVPcmData));
         if (wavfile->data[ch] == NULL) {
             goto EXIT_FAILURE_WITH_DATA_RELEASE;
         }
@@ -385,40 +564,13 @@ EXIT_FAILURE_WITH_DATA_RELEASE:
     return NULL;
 }
 
-/* 8bitPCM形式を32bit形式に変換 */
-static int32_t WAV_Convert8bitPCMto32bitPCM(int32_t in_8bitpcm)
-{
-    /* 無音に相当する128を引いてから32bit整数に切り上げる */
-    return (in_8bitpcm - 128) << 24;
-}
-
-/* 16bitPCM形式を32bit形式に変換 */
-static int32_t WAV_Convert16bitPCMto32bitPCM(int32_t in_16bitpcm)
-{
-    /* そのまま16bit左シフト */
-    return in_16bitpcm << 16;
-}
-
-/* 24bitPCM形式を32bit形式に変換 */
-static int32_t WAV_Convert24bitPCMto32bitPCM(int32_t in_24bitpcm)
-{
-    /* そのまま8bit左シフト */
-    return in_24bitpcm << 8;
-}
-
-/* 32bitPCM形式を32bit形式に変換 */
-static int32_t WAV_Convert32bitPCMto32bitPCM(int32_t in_32bitpcm)
-{
-    /* 何もしない */
-    return in_32bitpcm;
-}
-
 /* パーサの初期化 */
 static void WAVParser_Initialize(struct WAVParser* parser, FILE* fp)
 {
     parser->fp                = fp;
     memset(&parser->buffer, 0, sizeof(struct WAVBitBuffer));
     parser->buffer.byte_pos   = -1;
+    parser->is_data_size_placeholder = 0;
 }
 
 /* パーサの使用終了 */
@@ -442,7 +594,7 @@ static WAVError WAVParser_GetBits(struct WAVParser* parser, uint32_t n_bits, uin
 
     /* 初回読み込み */
     if (buf->byte_pos == -1) {
-        if (fread(buf->bytes, sizeof(uint8_t), WAVBITBUFFER_BUFFER_SIZE, parser->fp) == 0) {
+        if ((buf->num_bytes = (uint32_t)fread(buf->bytes, sizeof(uint8_t), WAVBITBUFFER_BUFFER_SIZE, parser->fp)) == 0) {
             return WAV_ERROR_IO;
         }
         buf->byte_pos   = 0;
@@ -464,7 +616,7 @@ static WAVError WAVParser_GetBits(struct WAVParser* parser, uint32_t n_bits, uin
 
         /* バッファが一杯ならば、再度読み込み */
         if (buf->byte_pos == WAVBITBUFFER_BUFFER_SIZE) {
-            if (fread(buf->bytes, sizeof(uint8_t), WAVBITBUFFER_BUFFER_SIZE, parser->fp) == 0) {
+            if ((buf->num_bytes = (uint32_t)fread(buf->bytes, sizeof(uint8_t), WAVBITBUFFER_BUFFER_SIZE, parser->fp)) == 0) {
                 return WAV_ERROR_IO;
             }
             buf->byte_pos = 0;
@@ -481,16 +633,103 @@ static WAVError WAVParser_GetBits(struct WAVParser* parser, uint32_t n_bits, uin
 }
 
 /* シーク（fseek準拠） */
+/* 補足）現在位置からの前方への移動は、先読みしたバッファ内で済めばファイルに触れない。 */
+/*       またパイプなどシークできない入力では読み捨てて移動する */
 static WAVError WAVParser_Seek(struct WAVParser* parser, int32_t offset, int32_t wherefrom)
 {
-    if (parser->buffer.byte_pos != -1) {
+    struct WAVBitBuffer* buf = &(parser->buffer);
+
+    if ((wherefrom == SEEK_CUR) && (offset >= 0) && (buf->byte_pos != -1)) {
+        /* 補足）バイト単位で読んでいる前提: bit_countが8の時のみ現在位置のバイトが未読 */
+        const uint32_t pos = (uint32_t)buf->byte_pos + ((buf->bit_count == 0) ? 1U : 0U);
+        const uint32_t num_remain = (buf->num_bytes > pos) ? (buf->num_bytes - pos) : 0;
+        /* バッファ内で移動 */
+        if ((uint32_t)offset < num_remain) {
+            buf->byte_pos = (int32_t)(pos + (uint32_t)offset);
+            buf->bit_count = 8;
+            return WAV_ERROR_OK;
+        }
+        /* バッファを使い切り、残りをファイル上で移動 */
+        offset -= (int32_t)num_remain;
+        buf->byte_pos = -1;
+    }
+
+    if (buf->byte_pos != -1) {
         /* バッファに取り込んだ分先読みしているので戻す */
-        offset -= (WAVBITBUFFER_BUFFER_SIZE - (parser->buffer.byte_pos + 1));
+        offset -= ((int32_t)buf->num_bytes - (buf->byte_pos + 1));
     }
-    /* 移動 */
-    fseek(parser->fp, offset, wherefrom);
     /* バッファをクリア */
-    parser->buffer.byte_pos = -1;
+    buf->byte_pos = -1;
+
+    /* 移動 */
+    if (fseek(parser->fp, offset, wherefrom) != 0) {
+        /* シークできない場合、前方への移動に限り読み捨てる */
+        if ((wherefrom != SEEK_CUR) || (offset < 0)) {
+            return WAV_ERROR_IO;
+        }
+        while (offset > 0) {
+            const uint32_t skip_size = WAV_Min((uint32_t)offset, WAVBITBUFFER_BUFFER_SIZE);
+            if (fread(buf->bytes, sizeof(uint8_t), skip_size, parser->fp) < skip_size) {
+                return WAV_ERROR_IO;
+            }
+            offset -= (int32_t)skip_size;
+        }
+    }
+
+    return WAV_ERROR_OK;
+}
+
+/* 最大sizeバイトのバイト列を取得（先読み済みのデータから使う） ファイル末尾では読めた分だけ取得する */
+static WAVError WAVParser_GetAvailableBytes(struct WAVParser* parser, uint8_t* data, uint32_t size, uint32_t* num_read_bytes)
+{
+    struct WAVBitBuffer* buf = &(parser->buffer);
+
+    (*num_read_bytes) = 0;
+
+    /* バッファに先読みしたデータがあればコピー */
+    if (buf->byte_pos != -1) {
+        uint32_t pos, num_remain, copy_size;
+        /* 補足）バイト単位で読んでいる前提: bit_countが8の時のみ現在位置のバイトが未読 */
+        assert((buf->bit_count == 0) || (buf->bit_count == 8));
+        pos = (uint32_t)buf->byte_pos + ((buf->bit_count == 0) ? 1U : 0U);
+        num_remain = (buf->num_bytes > pos) ? (buf->num_bytes - pos) : 0;
+        copy_size = WAV_Min(num_remain, size);
+        memcpy(data, &buf->bytes[pos], copy_size);
+        data += copy_size;
+        size -= copy_size;
+        (*num_read_bytes) += copy_size;
+        if (copy_size == num_remain) {
+            /* 先読み分を使い切った */
+            buf->byte_pos = -1;
+        } else {
+            buf->byte_pos = (int32_t)(pos + copy_size);
+            buf->bit_count = 8;
+        }
+    }
+
+    /* 残りはファイルから直接読み込む */
+    if (size > 0) {
+        (*num_read_bytes) += (uint32_t)fread(data, sizeof(uint8_t), size, parser->fp);
+        if (ferror(parser->fp)) {
+            return WAV_ERROR_IO;
+        }
+    }
+
+    return WAV_ERROR_OK;
+}
+
+/* バイト列を取得 sizeバイト読めなければエラー */
+static WAVError WAVParser_GetBytes(struct WAVParser* parser, uint8_t* data, uint32_t size)
+{
+    uint32_t num_read_bytes;
+    WAVError err;
+
+    if ((err = WAVParser_GetAvailableBytes(parser, data, size, &num_read_bytes)) != WAV_ERROR_OK) {
+        return err;
+    }
+    if (num_read_bytes < size) {
+        return WAV_ERROR_IO;
+    }
 
     return WAV_ERROR_OK;
 }
@@ -519,11 +758,32 @@ void WAV_Destroy(struct WAVFile* wavfile)
 #undef NULLCHECK_AND_FREE
 }
 
+/* RF64形式でなければ表現できないフォーマットか */
+static uint8_t WAV_IsRF64Required(const struct WAVFileFormat* format)
+{
+    const uint64_t pcm_data_size
+        = format->num_samples * (format->bits_per_sample / 8) * format->num_channels;
+    return (pcm_data_size > WAV_RIFF_MAX_PCM_DATA_SIZE) ? 1 : 0;
+}
+
 /* ライタを使用してファイルフォーマットに従ったヘッダ部を出力 */
 static WAVError WAVWriter_PutWAVHeader(
         struct WAVWriter* writer, const struct WAVFileFormat* format)
 {
-    uint32_t filesize, pcm_data_size;
+    /* 引数チェック */
+    if (writer == NULL || format == NULL) {
+        return WAV_ERROR_INVALID_PARAMETER;
+    }
+
+    /* RIFFのサイズに収まらない場合のみRF64形式にする */
+    return WAVWriter_PutWAVHeaderCore(writer, format, WAV_IsRF64Required(format));
+}
+
+/* ライタを使用してヘッダ部を出力（RF64形式とするか指定） */
+static WAVError WAVWriter_PutWAVHeaderCore(
+        struct WAVWriter* writer, const struct WAVFileFormat* format, uint8_t is_rf64)
+{
+    uint64_t filesize, pcm_data_size;
 
     /* 引数チェック */
     if (writer == NULL || format == NULL) {
@@ -536,22 +796,42 @@ static WAVError WAVWriter_PutWAVHeader(
         return WAV_ERROR_INVALID_FORMAT;
     }
 
+    /* RIFF形式では表現できないサイズ */
+    if (!is_rf64 && WAV_IsRF64Required(format)) {
+        return WAV_ERROR_INVALID_FORMAT;
+    }
+
     /* PCM データサイズ */
     pcm_data_size
         = format->num_samples * (format->bits_per_sample / 8) * format->num_channels;
 
     /* ファイルサイズ */
     /* 44は"RIFF" から ("data"のサイズ) までのフィールドのバイト数（拡張部分を一切含まない） */
+    /* RF64の場合はds64チャンク（ヘッダ8byte + 28byte）の分だけ増える */
     filesize = pcm_data_size + 44;
+    if (is_rf64) {
+        filesize += 36;
+    }
 
-    /* ヘッダ 'R', 'I', 'F', 'F' を出力 */
-    if (WAVWriter_PutBits(writer, 'R', 8) != WAV_ERROR_OK) { return WAV_ERROR_IO; };
-    if (WAVWriter_PutBits(writer, 'I', 8) != WAV_ERROR_OK) { return WAV_ERROR_IO; };
-    if (WAVWriter_PutBits(writer, 'F', 8) != WAV_ERROR_OK) { return WAV_ERROR_IO; };
-    if (WAVWriter_PutBits(writer, 'F', 8) != WAV_ERROR_OK) { return WAV_ERROR_IO; };
-
-    /* ファイルサイズ-8（この要素以降のサイズ） */
-    if (WAVWriter_PutLittleEndianBytes(writer, 4, filesize - 8) != WAV_ERROR_OK) { return WAV_ERROR_IO; }
+    if (is_rf64) {
+        /* ヘッダ 'R', 'F', '6', '4' を出力 */
+        if (WAVWriter_PutBits(writer, 'R', 8) != WAV_ERROR_OK) { return WAV_ERROR_IO; };
+        if (WAVWriter_PutBits(writer, 'F', 8) != WAV_ERROR_OK) { return WAV_ERROR_IO; };
+        if (WAVWriter_PutBits(writer, '6', 8) != WAV_ERROR_OK) { return WAV_ERROR_IO; };
+        if (WAVWriter_PutBits(writer, '4', 8) != WAV_ERROR_OK) { return WAV_ERROR_IO; };
+
+        /* ファイルサイズはds64チャンクに書くので無効値 */
+        if (WAVWriter_PutLittleEndianBytes(writer, 4, WAV_RF64_SIZE_PLACEHOLDER) != WAV_ERROR_OK) { return WAV_ERROR_IO; }
+    } else {
+        /* ヘッダ 'R', 'I', 'F', 'F' を出力 */
+        if (WAVWriter_PutBits(writer, 'R', 8) != WAV_ERROR_OK) { return WAV_ERROR_IO; };
+        if (WAVWriter_PutBits(writer, 'I', 8) != WAV_ERROR_OK) { return WAV_ERROR_IO; };
+        if (WAVWriter_PutBits(writer, 'F', 8) != WAV_ERROR_OK) { return WAV_ERROR_IO; };
+        if (WAVWriter_PutBits(writer, 'F', 8) != WAV_ERROR_OK) { return WAV_ERROR_IO; };
+
+        /* ファイルサイズ-8（この要素以降のサイズ） */
+        if (WAVWriter_PutLittleEndianBytes(writer, 4, filesize - 8) != WAV_ERROR_OK) { return WAV_ERROR_IO; }
+    }
 
     /* ヘッダ 'W', 'A', 'V', 'E' を出力 */
     if (WAVWriter_PutBits(writer, 'W', 8) != WAV_ERROR_OK) { return WAV_ERROR_IO; };
@@ -559,6 +839,24 @@ static WAVError WAVWriter_PutWAVHeader(
     if (WAVWriter_PutBits(writer, 'V', 8) != WAV_ERROR_OK) { return WAV_ERROR_IO; };
     if (WAVWriter_PutBits(writer, 'E', 8) != WAV_ERROR_OK) { return WAV_ERROR_IO; };
 
+    if (is_rf64) {
+        /* ds64チャンクのヘッダ 'd', 's', '6', '4' を出力 */
+        if (WAVWriter_PutBits(writer, 'd', 8) != WAV_ERROR_OK) { return WAV_ERROR_IO; };
+        if (WAVWriter_PutBits(writer, 's', 8) != WAV_ERROR_OK) { return WAV_ERROR_IO; };
+        if (WAVWriter_PutBits(writer, '6', 8) != WAV_ERROR_OK) { return WAV_ERROR_IO; };
+        if (WAVWriter_PutBits(writer, '4', 8) != WAV_ERROR_OK) { return WAV_ERROR_IO; };
+        /* ds64チャンクのバイト数 （補足）チャンクサイズテーブルは使わないので28byte決め打ち */
+        if (WAVWriter_PutLittleEndianBytes(writer, 4, 28) != WAV_ERROR_OK) { return WAV_ERROR_IO; };
+        /* RIFFサイズ（ファイルサイズ-8） */
+        if (WAVWriter_PutLittleEndianBytes(writer, 8, filesize - 8) != WAV_ERROR_OK) { return WAV_ERROR_IO; };
+        /* dataチャンクのサイズ */
+        if (WAVWriter_PutLittleEndianBytes(writer, 8, pcm_data_size) != WAV_ERROR_OK) { return WAV_ERROR_IO; };
+        /* サンプル数 */
+        if (WAVWriter_PutLittleEndianBytes(writer, 8, format->num_samples) != WAV_ERROR_OK) { return WAV_ERROR_IO; };
+        /* チャンクサイズテーブルの要素数 */
+        if (WAVWriter_PutLittleEndianBytes(writer, 4, 0) != WAV_ERROR_OK) { return WAV_ERROR_IO; };
+    }
+
     /* fmtチャンクのヘッダ 'f', 'm', 't', ' ' を出力 */
     if (WAVWriter_PutBits(writer, 'f', 8) != WAV_ERROR_OK) { return WAV_ERROR_IO; };
     if (WAVWriter_PutBits(writer, 'm', 8) != WAV_ERROR_OK) { return WAV_ERROR_IO; };
@@ -596,172 +894,166 @@ static WAVError WAVWriter_PutWAVHeader(
     if (WAVWriter_PutBits(writer, 't', 8) != WAV_ERROR_OK) { return WAV_ERROR_IO; };
     if (WAVWriter_PutBits(writer, 'a', 8) != WAV_ERROR_OK) { return WAV_ERROR_IO; };
 
-    /* 波形データバイト数 */
-    if (WAVWriter_PutLittleEndianBytes(writer, 4, pcm_data_size) != WAV_ERROR_OK) { return WAV_ERROR_IO; }
+    /* 波形データバイト数 RF64ではds64チャンクに書いたので無効値 */
+    if (WAVWriter_PutLittleEndianBytes(writer, 4,
+                is_rf64 ? WAV_RF64_SIZE_PLACEHOLDER : pcm_data_size) != WAV_ERROR_OK) { return WAV_ERROR_IO; }
 
     return WAV_ERROR_OK;
 }
 
-/* リトルエンディアンで書き出し
-* 注意）dataはスワップされる可能性がある */
-static size_t WAVWrite_FWriteLittleEndian(
-        void *data, size_t size, size_t ndata, FILE *fp)
+#if defined(WAV_USE_SSE2)
+/* 32bit形式の16bitPCMへの変換とインターリーブ（SSE2） 処理したサンプル数を返す */
+static uint32_t WAV_Interleave16bitPCMDataSSE2(
+        uint8_t* dst, uint32_t num_channels, uint32_t num_samples,
+        WAVPcmData* const* data, uint64_t offset)
 {
-    int x = 1;
-    uint8_t *buffer;
-    uint32_t i;
-
-    /* リトルエンディアン環境ではそのままfwrite */
-    if ((size == 1) || (*((char *)&x) == 1)) {
-        return fwrite(data, size, ndata, fp);
-    }
-
-    /* ビッグエンディアン環境では並び替えてから書き込む */
-    buffer = (uint8_t *)data;
-
-    switch (size) {
-    case 2:
-        for (i = 0; i < ndata; i++) {
-            uint8_t a = buffer[2 * i];
-            buffer[2 * i + 0] = buffer[2 * i + 1];
-            buffer[2 * i + 1] = a;
+    uint32_t smpl = 0;
+
+    if (num_channels == 1) {
+        const WAVPcmData* src = &data[0][offset];
+        for (smpl = 0; (smpl + 8) <= num_samples; smpl += 8) {
+            const __m128i a = _mm_srai_epi32(_mm_loadu_si128((const __m128i *)&src[smpl + 0]), 16);
+            const __m128i b = _mm_srai_epi32(_mm_loadu_si128((const __m128i *)&src[smpl + 4]), 16);
+            /* 16bit右シフト後は16bitに収まるため飽和は起こらない */
+            _mm_storeu_si128((__m128i *)&dst[2 * smpl], _mm_packs_epi32(a, b));
         }
-        break;
-    case 3:
-        for (i = 0; i < ndata; i++) {
-            uint8_t a = buffer[3 * i];
-            buffer[3 * i + 0] = buffer[3 * i + 2];
-            buffer[3 * i + 2] = a;
+    } else if (num_channels == 2) {
+        const WAVPcmData* src0 = &data[0][offset];
+        const WAVPcmData* src1 = &data[1][offset];
+        for (smpl = 0; (smpl + 4) <= num_samples; smpl += 4) {
+            const __m128i l = _mm_srai_epi32(_mm_loadu_si128((const __m128i *)&src0[smpl]), 16);
+            const __m128i r = _mm_srai_epi32(_mm_loadu_si128((const __m128i *)&src1[smpl]), 16);
+            /* L0 R0 L1 R1 | L2 R2 L3 R3 の順に並べてから16bitに詰める */
+            _mm_storeu_si128((__m128i *)&dst[4 * smpl],
+                    _mm_packs_epi32(_mm_unpacklo_epi32(l, r), _mm_unpackhi_epi32(l, r)));
         }
-        break;
-    case 4:
-        for (i = 0; i < ndata; i++) {
-            uint8_t a = buffer[4 * i];
-            uint8_t b = buffer[4 * i + 1];
-            buffer[4 * i + 0] = buffer[4 * i + 3];
-            buffer[4 * i + 1] = buffer[4 * i + 2];
-            buffer[4 * i + 2] = b;
-            buffer[4 * i + 3] = a;
-        }
-        break;
-    default:
-        return 0;
     }
 
-    return fwrite(data, size, ndata, fp);
+    return smpl;
 }
+#endif /* WAV_USE_SSE2 */
 
-/* ライタを使用してPCMデータ出力 */
-static WAVError WAVWriter_PutWAVPcmData(
-        struct WAVWriter* writer, const struct WAVFile* wavfile)
+/* チャンネル毎の32bit形式のPCMデータをリトルエンディアンのインターリーブ形式に変換 */
+static void WAV_InterleavePCMData(
+        uint8_t* dst, uint32_t bits_per_sample, uint32_t num_channels, uint32_t num_samples,
+        WAVPcmData* const* data, uint64_t offset)
 {
-    uint32_t ch, smpl, progress;
+    uint32_t ch, smpl, head;
+    const uint32_t bytes_per_sample = bits_per_sample / 8;
+    const uint32_t frame_size = bytes_per_sample * num_channels;
 
-    /* バッファは空に */
-    WAVWriter_Flush(writer);
+    assert(dst != NULL);
+    assert(data != NULL);
 
-    /* チャンネルインターリーブしながら書き出し */
-    switch (wavfile->format.bits_per_sample) {
-    case 8:
-        {
-            uint8_t *buffer;
-            const uint32_t num_output_smpls_per_buffer = WAVBITBUFFER_BUFFER_SIZE / (sizeof(uint8_t) * wavfile->format.num_channels);
-            progress = 0;
-            while (progress < wavfile->format.num_samples) {
-                const uint32_t num_process_smpls = WAV_Min(num_output_smpls_per_buffer, wavfile->format.num_samples - progress);
-                const uint32_t num_output_smpls = num_process_smpls * wavfile->format.num_channels;
-                buffer = (uint8_t *)writer->buffer.bytes;
-                for (smpl = 0; smpl < num_process_smpls; smpl++) {
-                    for (ch = 0; ch < wavfile->format.num_channels; ch++) {
-                        (*buffer++) = (uint8_t)(((WAVFile_PCM(wavfile, progress + smpl, ch) >> 24) + 128) & 0xFF);
-                    }
-                }
-                if (WAVWrite_FWriteLittleEndian(writer->buffer.bytes,
-                            sizeof(uint8_t), num_output_smpls, writer->fp) < num_output_smpls) {
-                    return WAV_ERROR_IO;
-                }
-                progress += num_process_smpls;
+    head = 0;
+#if defined(WAV_USE_SSE2)
+    if (bits_per_sample == 16) {
+        head = WAV_Interleave16bitPCMDataSSE2(dst, num_channels, num_samples, data, offset);
+    }
+#endif
+
+    /* 残りはチャンネル毎に走査し、上位ビットを取り出して書き込む */
+    for (ch = 0; ch < num_channels; ch++) {
+        uint8_t* pos = &dst[head * frame_size + ch * bytes_per_sample];
+        const WAVPcmData* src = &data[ch][offset];
+        switch (bits_per_sample) {
+        case 8:
+            /* 最上位ビットの反転で128を中心とした符号なし表現になる */
+            for (smpl = head; smpl < num_samples; smpl++) {
+                pos[0] = (uint8_t)((((uint32_t)src[smpl] >> 24) ^ 0x80U) & 0xFF);
+                pos += frame_size;
             }
-        }
-        break;
-    case 16:
-        {
-            int16_t *buffer;
-            const uint32_t num_output_smpls_per_buffer = WAVBITBUFFER_BUFFER_SIZE / (sizeof(int16_t) * wavfile->format.num_channels);
-            progress = 0;
-            while (progress < wavfile->format.num_samples) {
-                const uint32_t num_process_smpls = WAV_Min(num_output_smpls_per_buffer, wavfile->format.num_samples - progress);
-                const uint32_t num_output_smpls = num_process_smpls * wavfile->format.num_channels;
-                buffer = (int16_t *)writer->buffer.bytes;
-                for (smpl = 0; smpl < num_process_smpls; smpl++) {
-                    for (ch = 0; ch < wavfile->format.num_channels; ch++) {
-                        (*buffer++) = (int16_t)((WAVFile_PCM(wavfile, progress + smpl, ch) >> 16) & 0xFFFF);
-                    }
-                }
-                if (WAVWrite_FWriteLittleEndian(writer->buffer.bytes,
-                            sizeof(int16_t), num_output_smpls, writer->fp) < num_output_smpls) {
-                    return WAV_ERROR_IO;
-                }
-                progress += num_process_smpls;
+            break;
+        case 16:
+            for (smpl = head; smpl < num_samples; smpl++) {
+                const uint32_t pcm = (uint32_t)src[smpl];
+                pos[0] = (uint8_t)((pcm >> 16) & 0xFF);
+                pos[1] = (uint8_t)((pcm >> 24) & 0xFF);
+                pos += frame_size;
             }
-        }
-        break;
-    case 24:
-        {
-            uint8_t *buffer;
-            const size_t int24_size = 3 * sizeof(uint8_t);
-            const uint32_t num_output_smpls_per_buffer = WAVBITBUFFER_BUFFER_SIZE / (int24_size * wavfile->format.num_channels);
-            progress = 0;
-            while (progress < wavfile->format.num_samples) {
-                const uint32_t num_process_smpls = WAV_Min(num_output_smpls_per_buffer, wavfile->format.num_samples - progress);
-                const uint32_t num_output_smpls = num_process_smpls * wavfile->format.num_channels;
-                const size_t output_size = num_output_smpls * int24_size;
-                buffer = (uint8_t *)writer->buffer.bytes;
-                for (smpl = 0; smpl < num_process_smpls; smpl++) {
-                    for (ch = 0; ch < wavfile->format.num_channels; ch++) {
-                        int32_t pcm = WAVFile_PCM(wavfile, progress + smpl, ch);
-                        (*buffer++) = (uint8_t)((pcm >>  8) & 0xFF);
-                        (*buffer++) = (uint8_t)((pcm >> 16) & 0xFF);
-                        (*buffer++) = (uint8_t)((pcm >> 24) & 0xFF);
-                    }
-                }
-                if (WAVWrite_FWriteLittleEndian(writer->buffer.bytes,
-                            sizeof(uint8_t), output_size, writer->fp) < output_size) {
-                    return WAV_ERROR_IO;
-                }
-                progress += num_process_smpls;
+            break;
+        case 24:
+            for (smpl = head; smpl < num_samples; smpl++) {
+                const uint32_t pcm = (uint32_t)src[smpl];
+                pos[0] = (uint8_t)((pcm >>  8) & 0xFF);
+                pos[1] = (uint8_t)((pcm >> 16) & 0xFF);
+                pos[2] = (uint8_t)((pcm >> 24) & 0xFF);
+                pos += frame_size;
             }
-        }
-        break;
-    case 32:
-        {
-            int32_t *buffer;
-            const uint32_t num_output_smpls_per_buffer = WAVBITBUFFER_BUFFER_SIZE / (sizeof(int32_t) * wavfile->format.num_channels);
-            progress = 0;
-            while (progress < wavfile->format.num_samples) {
-                const uint32_t num_process_smpls = WAV_Min(num_output_smpls_per_buffer, wavfile->format.num_samples - progress);
-                const uint32_t num_output_smpls = num_process_smpls * wavfile->format.num_channels;
-                buffer = (int32_t *)writer->buffer.bytes;
-                for (smpl = 0; smpl < num_process_smpls; smpl++) {
-                    for (ch = 0; ch < wavfile->format.num_channels; ch++) {
-                        (*buffer++) = WAVFile_PCM(wavfile, progress + smpl, ch);
-                    }
-                }
-                if (WAVWrite_FWriteLittleEndian(writer->buffer.bytes,
-                            sizeof(int32_t), num_output_smpls, writer->fp) < num_output_smpls) {
-                    return WAV_ERROR_IO;
-                }
-                progress += num_process_smpls;
+            break;
+        case 32:
+            for (smpl = head; smpl < num_samples; smpl++) {
+                const uint32_t pcm = (uint32_t)src[smpl];
+                pos[0] = (uint8_t)((pcm >>  0) & 0xFF);
+                pos[1] = (uint8_t)((pcm >>  8) & 0xFF);
+                pos[2] = (uint8_t)((pcm >> 16) & 0xFF);
+                pos[3] = (uint8_t)((pcm >> 24) & 0xFF);
+                pos += frame_size;
             }
+            break;
+        default:
+            assert(0);
         }
+    }
+}
+
+/* ライタを使用してPCMデータ出力 */
+static WAVError WAVWriter_PutWAVPcmData(
+        struct WAVWriter* writer, const struct WAVFile* wavfile)
+{
+    uint8_t*  write_buffer;
+    uint32_t  frame_size, num_samples_per_write;
+    uint64_t  progress;
+    WAVError  err;
+
+    /* 対応しているビット深度か */
+    switch (wavfile->format.bits_per_sample) {
+    case 8: case 16: case 24: case 32:
         break;
     default:
         /* fprintf(stderr, "Unsupported bits per smpl format(=%d). \n", wavfile->format.bits_per_smpl); */
         return WAV_ERROR_INVALID_FORMAT;
     }
 
+    /* 1サンプル（全チャンネル分）のバイト数 */
+    frame_size = (wavfile->format.bits_per_sample / 8) * wavfile->format.num_channels;
+    if (frame_size == 0) {
+        return WAV_ERROR_INVALID_FORMAT;
+    }
 
-    return WAV_ERROR_OK;
+    /* バッファは空に */
+    if (WAVWriter_Flush(writer) != WAV_ERROR_OK) {
+        return WAV_ERROR_IO;
+    }
+
+    /* 一括書き出し用のバッファを確保 */
+    num_samples_per_write = (uint32_t)WAV_Min(wavfile->format.num_samples, WAVWRITER_PCM_WRITE_BUFFER_SIZE / frame_size);
+    if (num_samples_per_write == 0) {
+        num_samples_per_write = 1;
+    }
+    if ((write_buffer = (uint8_t *)malloc((size_t)num_samples_per_write * frame_size)) == NULL) {
+        return WAV_ERROR_NG;
+    }
+
+    /* チャンネルインターリーブしながらまとめて書き出し */
+    err = WAV_ERROR_OK;
+    progress = 0;
+    while (progress < wavfile->format.num_samples) {
+        const uint32_t num_write_samples = (uint32_t)WAV_Min(num_samples_per_write, wavfile->format.num_samples - progress);
+        const uint32_t write_size = num_write_samples * frame_size;
+        WAV_InterleavePCMData(write_buffer,
+                wavfile->format.bits_per_sample, wavfile->format.num_channels, num_write_samples,
+                wavfile->data, progress);
+        if (fwrite(write_buffer, sizeof(uint8_t), write_size, writer->fp) < write_size) {
+            err = WAV_ERROR_IO;
+            break;
+        }
+        progress += num_write_samples;
+    }
+
+    free(write_buffer);
+
+    return err;
 }
 
 /* ファイル書き出し */
@@ -806,6 +1098,341 @@ WAVApiResult WAV_WriteToFile(
     return WAV_APIRESULT_OK;
 }
 
+/* ストリームハンドルの作成 */
+static struct WAVStream* WAVStream_Create(FILE* fp, uint8_t is_write, uint8_t own_fp)
+{
+    struct WAVStream* stream;
+
+    if ((stream = (struct WAVStream *)malloc(sizeof(struct WAVStream))) == NULL) {
+        return NULL;
+    }
+
+    stream->fp = fp;
+    stream->is_write = is_write;
+    stream->own_fp = own_fp;
+    stream->num_processed_samples = 0;
+    stream->is_rf64 = 0;
+    stream->frame_size = 0;
+    stream->buffer = NULL;
+    stream->max_num_buffer_samples = 0;
+    WAVParser_Initialize(&stream->parser, fp);
+
+    return stream;
+}
+
+/* フォーマットに合わせてストリームの変換用バッファを確保 */
+static WAVError WAVStream_AllocateBuffer(struct WAVStream* stream)
+{
+    const struct WAVFileFormat* format = &stream->format;
+
+    /* PCM以外は対応していない */
+    if (format->data_format != WAV_DATA_FORMAT_PCM) {
+        return WAV_ERROR_INVALID_FORMAT;
+    }
+
+    /* 対応しているビット深度か */
+    switch (format->bits_per_sample) {
+    case 8: case 16: case 24: case 32:
+        break;
+    default:
+        return WAV_ERROR_INVALID_FORMAT;
+    }
+
+    /* 1サンプル（全チャンネル分）のバイト数 */
+    stream->frame_size = (format->bits_per_sample / 8) * format->num_channels;
+    if (stream->frame_size == 0) {
+        return WAV_ERROR_INVALID_FORMAT;
+    }
+
+    /* バッファサイズは読み書きで一括処理するサイズに合わせる */
+    stream->max_num_buffer_samples = (stream->is_write ? WAVWRITER_PCM_WRITE_BUFFER_SIZE : WAVPARSER_PCM_READ_BUFFER_SIZE) / stream->frame_size;
+    if (stream->max_num_buffer_samples == 0) {
+        stream->max_num_buffer_samples = 1;
+    }
+    if ((stream->buffer = (uint8_t *)malloc((size_t)stream->max_num_buffer_samples * stream->frame_size)) == NULL) {
+        return WAV_ERROR_NG;
+    }
+
+    return WAV_ERROR_OK;
+}
+
+/* ストリームの現在位置にヘッダを書き出し */
+static WAVError WAVStream_PutHeader(struct WAVStream* stream)
+{
+    struct WAVWriter writer;
+    WAVError err;
+
+    WAVWriter_Initialize(&writer, stream->fp);
+    if ((err = WAVWriter_PutWAVHeaderCore(&writer, &stream->format, stream->is_rf64)) != WAV_ERROR_OK) {
+        return err;
+    }
+    if (WAVWriter_Flush(&writer) != WAV_ERROR_OK) {
+        return WAV_ERROR_IO;
+    }
+    WAVWriter_Finalize(&writer);
+
+    return WAV_ERROR_OK;
+}
+
+/* 開いたファイルからストリームを作成し、ヘッダを読み取る */
+static struct WAVStream* WAVStream_OpenForRead(FILE* fp, uint8_t own_fp, struct WAVFileFormat* format)
+{
+    struct WAVStream* stream;
+
+    /* ハンドル作成 */
+    if ((stream = WAVStream_Create(fp, 0, own_fp)) == NULL) {
+        if (own_fp) {
+            fclose(fp);
+        }
+        return NULL;
+    }
+
+    /* ヘッダ読み取り パーサは先読みしたデータを保持したまま後続のPCM読み込みに使う */
+    if (WAVParser_GetWAVFormat(&stream->parser, &stream->format) != WAV_ERROR_OK) {
+        goto EXIT_FAILURE_WITH_STREAM_CLOSE;
+    }
+
+    /* シークできない入力でサイズが仮の値のときは、サンプル数を不明としてファイル末尾まで読む */
+    /* 補足）仮のサイズから求めたサンプル数で打ち切ると、約4GBを超えるパイプ入力が欠ける */
+    if (stream->parser.is_data_size_placeholder && (ftell(fp) < 0)) {
+        stream->format.num_samples = WAV_NUM_SAMPLES_UNKNOWN;
+    }
+
+    /* 変換用バッファ確保 */
+    if (WAVStream_AllocateBuffer(stream) != WAV_ERROR_OK) {
+        goto EXIT_FAILURE_WITH_STREAM_CLOSE;
+    }
+
+    (*format) = stream->format;
+    return stream;
+
+EXIT_FAILURE_WITH_STREAM_CLOSE:
+    WAV_CloseStream(stream);
+    return NULL;
+}
+
+/* 開いたファイルからストリームを作成し、仮のヘッダを書き出す */
+static struct WAVStream* WAVStream_OpenForWrite(FILE* fp, uint8_t own_fp, const struct WAVFileFormat* format)
+{
+    struct WAVStream* stream;
+
+    /* ハンドル作成 */
+    if ((stream = WAVStream_Create(fp, 1, own_fp)) == NULL) {
+        if (own_fp) {
+            fclose(fp);
+        }
+        return NULL;
+    }
+    stream->format = (*format);
+    stream->is_rf64 = WAV_IsRF64Required(format);
+
+    /* 変換用バッファ確保 */
+    if (WAVStream_AllocateBuffer(stream) != WAV_ERROR_OK) {
+        goto EXIT_FAILURE_WITH_STREAM_CLOSE;
+    }
+
+    /* 仮のヘッダを書き出し */
+    if (WAVStream_PutHeader(stream) != WAV_ERROR_OK) {
+        goto EXIT_FAILURE_WITH_STREAM_CLOSE;
+    }
+
+    return stream;
+
+EXIT_FAILURE_WITH_STREAM_CLOSE:
+    WAV_CloseStream(stream);
+    return NULL;
+}
+
+/* 読み込み用にWAVストリームを開く */
+struct WAVStream* WAV_OpenStreamForRead(const char* filename, struct WAVFileFormat* format)
+{
+    FILE*             fp;
+    struct WAVStream* stream;
+
+    /* 引数チェック */
+    if (filename == NULL || format == NULL) {
+        return NULL;
+    }
+
+    /* wavファイルを開く */
+    if ((fp = fopen(filename, "rb")) == NULL) {
+        return NULL;
+    }
+
+    /* ストリーム作成 失敗時はファイルも閉じられる */
+    if ((stream = WAVStream_OpenForRead(fp, 1, format)) == NULL) {
+        return NULL;
+    }
+
+    return stream;
+}
+
+/* 開いているファイルから読み込み用にWAVストリームを開く */
+struct WAVStream* WAV_OpenStreamForReadFromFp(FILE* fp, struct WAVFileFormat* format)
+{
+    /* 引数チェック */
+    if (fp == NULL || format == NULL) {
+        return NULL;
+    }
+
+    return WAVStream_OpenForRead(fp, 0, format);
+}
+
+/* 書き出し用にWAVストリームを開く */
+struct WAVStream* WAV_OpenStreamForWrite(const char* filename, const struct WAVFileFormat* format)
+{
+    FILE*             fp;
+    struct WAVStream* stream;
+
+    /* 引数チェック */
+    if (filename == NULL || format == NULL) {
+        return NULL;
+    }
+
+    /* wavファイルを開く */
+    if ((fp = fopen(filename, "wb")) == NULL) {
+        return NULL;
+    }
+
+    /* ストリーム作成 失敗時はファイルも閉じられる */
+    if ((stream = WAVStream_OpenForWrite(fp, 1, format)) == NULL) {
+        return NULL;
+    }
+
+    return stream;
+}
+
+/* 開いているファイルへ書き出し用にWAVストリームを開く */
+struct WAVStream* WAV_OpenStreamForWriteToFp(FILE* fp, const struct WAVFileFormat* format)
+{
+    /* 引数チェック */
+    if (fp == NULL || format == NULL) {
+        return NULL;
+    }
+
+    return WAVStream_OpenForWrite(fp, 0, format);
+}
+
+/* ストリームからチャンネル毎のバッファへ最大num_samplesサンプル読み込み */
+WAVApiResult WAV_ReadStream(
+        struct WAVStream* stream, WAVPcmData* const* data, uint32_t num_samples, uint32_t* num_read_samples)
+{
+    uint32_t progress;
+
+    /* 引数チェック */
+    if (stream == NULL || data == NULL || num_read_samples == NULL) {
+        return WAV_APIRESULT_INVALID_PARAMETER;
+    }
+
+    /* 書き出し用のストリームからは読めない */
+    if (stream->is_write) {
+        return WAV_APIRESULT_INVALID_PARAMETER;
+    }
+
+    /* 残りのサンプル数で制限 */
+    num_samples = (uint32_t)WAV_Min((uint64_t)num_samples, stream->format.num_samples - stream->num_processed_samples);
+
+    /* バッファ単位で読み込み、チャンネル毎に分離 */
+    progress = 0;
+    while (progress < num_samples) {
+        uint32_t num_read, num_read_bytes;
+        num_read = WAV_Min(stream->max_num_buffer_samples, num_samples - progress);
+        if (WAVParser_GetAvailableBytes(&stream->parser,
+                    stream->buffer, num_read * stream->frame_size, &num_read_bytes) != WAV_ERROR_OK) {
+            return WAV_APIRESULT_IOERROR;
+        }
+        /* ヘッダのサイズより先にファイル末尾に達した */
+        /* 補足）パイプ入力ではヘッダのサイズが仮の値になっているため、読めた分を全サンプルとする */
+        if (num_read_bytes < (num_read * stream->frame_size)) {
+            num_read = num_read_bytes / stream->frame_size;
+            stream->format.num_samples = stream->num_processed_samples + progress + num_read;
+            num_samples = progress + num_read;
+        }
+        WAV_DeinterleavePCMData(stream->buffer,
+                stream->format.bits_per_sample, stream->format.num_channels, num_read, data, progress);
+        progress += num_read;
+    }
+
+    stream->num_processed_samples += num_samples;
+    (*num_read_samples) = num_samples;
+
+    return WAV_APIRESULT_OK;
+}
+
+/* チャンネル毎のバッファからnum_samplesサンプルをストリームへ書き出し */
+WAVApiResult WAV_WriteStream(
+        struct WAVStream* stream, WAVPcmData* const* data, uint32_t num_samples)
+{
+    uint32_t progress;
+
+    /* 引数チェック */
+    if (stream == NULL || data == NULL) {
+        return WAV_APIRESULT_INVALID_PARAMETER;
+    }
+
+    /* 読み込み用のストリームには書けない */
+    if (!stream->is_write) {
+        return WAV_APIRESULT_INVALID_PARAMETER;
+    }
+
+    /* バッファ単位でインターリーブして書き出し */
+    progress = 0;
+    while (progress < num_samples) {
+        const uint32_t num_write = WAV_Min(stream->max_num_buffer_samples, num_samples - progress);
+        const uint32_t write_size = num_write * stream->frame_size;
+        WAV_InterleavePCMData(stream->buffer,
+                stream->format.bits_per_sample, stream->format.num_channels, num_write, data, progress);
+        if (fwrite(stream->buffer, sizeof(uint8_t), write_size, stream->fp) < write_size) {
+            return WAV_APIRESULT_IOERROR;
+        }
+        progress += num_write;
+    }
+
+    stream->num_processed_samples += num_samples;
+
+    return WAV_APIRESULT_OK;
+}
+
+/* WAVストリームを閉じる */
+WAVApiResult WAV_CloseStream(struct WAVStream* stream)
+{
+    WAVApiResult ret = WAV_APIRESULT_OK;
+
+    /* 引数チェック */
+    if (stream == NULL) {
+        return WAV_APIRESULT_INVALID_PARAMETER;
+    }
+
+    /* 書き出したサンプル数がヘッダと異なる場合は先頭に戻ってヘッダを書き直す */
+    /* 補足）パイプなどシークできない出力では、ヘッダは仮の値のまま残す */
+    if (stream->is_write && (stream->buffer != NULL)
+            && (stream->num_processed_samples != stream->format.num_samples)) {
+        stream->format.num_samples = stream->num_processed_samples;
+        if ((fflush(stream->fp) == 0) && (fseek(stream->fp, 0, SEEK_SET) == 0)) {
+            if (WAVStream_PutHeader(stream) != WAV_ERROR_OK) {
+                ret = WAV_APIRESULT_IOERROR;
+            }
+        }
+    }
+
+    WAVParser_Finalize(&stream->parser);
+    if (stream->own_fp) {
+        if (fclose(stream->fp) != 0) {
+            ret = WAV_APIRESULT_IOERROR;
+        }
+    } else if (stream->is_write) {
+        if (fflush(stream->fp) != 0) {
+            ret = WAV_APIRESULT_IOERROR;
+        }
+    }
+    if (stream->buffer != NULL) {
+        free(stream->buffer);
+    }
+    free(stream);
+
+    return ret;
+}
+
 /* ライタの初期化 */
 static void WAVWriter_Initialize(struct WAVWriter* writer, FILE* fp)
 {
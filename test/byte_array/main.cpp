@@ -350,6 +350,41 @@ TEST(ByteArrayTest, ReadWriteTest)
 #undef TEST_SIZE_UINT16
     }
 
+    /* 8バイトの読み書き（ビッグエンディアン） */
+    {
+#define TEST_SIZE_UINT64 (TEST_SIZE / sizeof(uint64_t))
+        uint8_t   *pos;
+        uint8_t   array[TEST_SIZE];
+        uint64_t  test[TEST_SIZE_UINT64], answer[TEST_SIZE_UINT64];
+        uint32_t  i;
+
+        /* 上位32bitにも値が入るように書き出し */
+        pos = array;
+        for (i = 0; i < TEST_SIZE_UINT64; i++) {
+            answer[i] = ((uint64_t)(i + 1) << 32) | (uint64_t)(0xFFFFFFF0UL - i);
+            ByteArray_PutUint64BE(pos, answer[i]);
+        }
+        EXPECT_EQ(0x00, array[0]);
+        EXPECT_EQ(0x01, array[3]);
+        EXPECT_EQ(0xFF, array[4]);
+        EXPECT_EQ(0xF0, array[7]);
+
+        /* 読み出し */
+        pos = array;
+        for (i = 0; i < TEST_SIZE_UINT64; i++) {
+            ByteArray_GetUint64BE(pos, &test[i]);
+        }
+        EXPECT_EQ(0, memcmp(test, answer, sizeof(uint64_t) * TEST_SIZE_UINT64));
+
+        /* Read/Writeでも同じ結果 */
+        for (i = 0; i < TEST_SIZE_UINT64; i++) {
+            ByteArray_WriteUint64BE(&array[8 * i], answer[i]);
+            EXPECT_EQ(answer[i], ByteArray_ReadUint64BE(&array[8 * i]));
+        }
+
+#undef TEST_SIZE_UINT64
+    }
+
 #undef TEST_SIZE
 }
 
@@ -425,6 +425,27 @@ TEST(CommandLineParserTest, GetOtherStringTest)
         EXPECT_EQ(0, strcmp(specs[0].argument_string, "inputfile"));
     }
 
+    /* 単独の'-'はオプションではなく文字列として取得 */
+    {
+        struct CommandLineParserSpecification specs[] = {
+            { 'i', "input", "input file", COMMAND_LINE_PARSER_TRUE, NULL, COMMAND_LINE_PARSER_FALSE },
+            { 0, NULL, }
+        };
+        const char* test_argv[] = { "progname", "-", "-i", "inputfile", "-" };
+        const char* other_string_array[2];
+
+        EXPECT_EQ(
+                COMMAND_LINE_PARSER_RESULT_OK,
+                CommandLineParser_ParseArguments(
+                    specs,
+                    sizeof(test_argv) / sizeof(test_argv[0]), test_argv,
+                    other_string_array, sizeof(other_string_array) / sizeof(other_string_array[0])));
+
+        EXPECT_EQ(0, strcmp(other_string_array[0], "-"));
+        EXPECT_EQ(0, strcmp(other_string_array[1], "-"));
+        EXPECT_EQ(0, strcmp(specs[0].argument_string, "inputfile"));
+    }
+
     /* 失敗系 */
 
     /* バッファサイズが足らない */
@@ -0,0 +1,29 @@
+#ifndef TEST_ALLOCATOR_H_INCLUDED
+#define TEST_ALLOCATOR_H_INCLUDED
+
+#include <stdint.h>
+#include <stdlib.h>
+
+/* テスト用アロケータ 確保・解放の回数を数える */
+
+/* テスト用アロケータのコンテキスト */
+struct TestAllocatorContext {
+    int32_t num_alloc; /* 確保回数 */
+    int32_t num_free; /* 解放回数 */
+};
+
+/* テスト用の領域確保関数 */
+static void *TestAllocator_Malloc(void *context, size_t size)
+{
+    ((struct TestAllocatorContext *)context)->num_alloc++;
+    return malloc(size);
+}
+
+/* テスト用の領域解放関数 */
+static void TestAllocator_Free(void *context, void *ptr)
+{
+    ((struct TestAllocatorContext *)context)->num_free++;
+    free(ptr);
+}
+
+#endif /* TEST_ALLOCATOR_H_INCLUDED */
@@ -3,6 +3,8 @@
 
 #include <gtest/gtest.h>
 
+#include "../common/test_allocator.h"
+
 /* テスト対象のモジュール */
 extern "C" {
 #include "../../libs/linne_coder/src/linne_coder.c"
@@ -29,7 +31,7 @@ TEST(LINNECoderTest, CreateDestroyHandleTest)
         work_size = LINNECoder_CalculateWorkSize();
         work = malloc(work_size);
 
-        coder = LINNECoder_Create(work, work_size);
+        coder = LINNECoder_Create(NULL, work, work_size);
         ASSERT_TRUE(coder != NULL);
         EXPECT_TRUE(coder->work == work);
         EXPECT_EQ(coder->alloced_by_own, 0);
@@ -42,7 +44,7 @@ TEST(LINNECoderTest, CreateDestroyHandleTest)
     {
         struct LINNECoder *coder;
 
-        coder = LINNECoder_Create(NULL, 0);
+        coder = LINNECoder_Create(NULL, NULL, 0);
         ASSERT_TRUE(coder != NULL);
         EXPECT_TRUE(coder->work != NULL);
         EXPECT_EQ(coder->alloced_by_own, 1);
@@ -60,14 +62,41 @@ TEST(LINNECoderTest, CreateDestroyHandleTest)
         work = malloc(work_size);
 
         /* 引数が不正 */
-        coder = LINNECoder_Create(NULL, work_size);
+        coder = LINNECoder_Create(NULL, NULL, work_size);
         EXPECT_TRUE(coder == NULL);
-        coder = LINNECoder_Create(work, 0);
+        coder = LINNECoder_Create(NULL, work, 0);
         EXPECT_TRUE(coder == NULL);
 
         /* ワークサイズ不足 */
-        coder = LINNECoder_Create(work, work_size - 1);
+        coder = LINNECoder_Create(NULL, work, work_size - 1);
+        EXPECT_TRUE(coder == NULL);
+    }
+
+    /* アロケータ指定による自前確保 */
+    {
+        struct LINNECoder *coder;
+        struct LINNEAllocator allocator;
+        struct TestAllocatorContext context = { 0, 0 };
+
+        allocator.malloc_func = TestAllocator_Malloc;
+        allocator.free_func = TestAllocator_Free;
+        allocator.context = &context;
+
+        coder = LINNECoder_Create(&allocator, NULL, 0);
+        ASSERT_TRUE(coder != NULL);
+        EXPECT_EQ(1, coder->alloced_by_own);
+        EXPECT_EQ(1, context.num_alloc);
+        EXPECT_EQ(0, context.num_free);
+
+        LINNECoder_Destroy(coder);
+        EXPECT_EQ(1, context.num_alloc);
+        EXPECT_EQ(1, context.num_free);
+
+        /* 確保・解放関数の片方だけの指定は不正 */
+        allocator.free_func = NULL;
+        coder = LINNECoder_Create(&allocator, NULL, 0);
         EXPECT_TRUE(coder == NULL);
+        EXPECT_EQ(1, context.num_alloc);
     }
 }
 
@@ -303,6 +332,119 @@ TEST(LINNECoderTest, RecursiveRiceTest)
     }
 }
 
+/* 符号長計算テスト */
+TEST(LINNECoderTest, CalculateCodeLengthTest)
+{
+    uint32_t i, trial;
+    const uint32_t num_samples_list[] = { 1, 3, 256, 1000, 4096 };
+    const int32_t amplitude_list[] = { 1, 16, 1 << 15, 1 << 23 };
+    struct LINNECoder *coder;
+
+    srand(0);
+    coder = LINNECoder_Create(NULL, NULL, 0);
+    ASSERT_TRUE(coder != NULL);
+
+    for (trial = 0; trial < sizeof(num_samples_list) / sizeof(num_samples_list[0]); trial++) {
+        uint32_t a;
+        const uint32_t num_samples = num_samples_list[trial];
+        const uint32_t buffer_size = sizeof(int32_t) * num_samples * 4 + 16;
+        int32_t *data = (int32_t *)malloc(sizeof(int32_t) * num_samples);
+        uint8_t *buffer = (uint8_t *)malloc(buffer_size);
+        uint8_t *porder_buffer = (uint8_t *)malloc(buffer_size);
+
+        for (a = 0; a < sizeof(amplitude_list) / sizeof(amplitude_list[0]); a++) {
+            int32_t num_bytes, porder_num_bytes;
+            uint32_t code_length, partition_order;
+            struct BitStream strm;
+
+            /* 前半は小さく、後半は大きな振幅 */
+            for (i = 0; i < num_samples; i++) {
+                const int32_t amp = (i < num_samples / 2) ? 1 : amplitude_list[a];
+                data[i] = (int32_t)(((uint32_t)rand() * (uint32_t)rand()) % (uint32_t)(2 * amp)) - amp;
+            }
+
+            code_length = LINNECoder_CalculateCodeLength(coder, data, num_samples, &partition_order);
+
+            /* 実際に書き出したビット数と一致するか */
+            BitWriter_Open(&strm, buffer, buffer_size);
+            LINNECoder_Encode(coder, &strm, data, num_samples);
+            BitStream_Tell(&strm, &num_bytes);
+            EXPECT_EQ(8 * (uint32_t)num_bytes + (32 - strm.bit_count), code_length);
+            BitStream_Flush(&strm);
+            BitStream_Tell(&strm, &num_bytes);
+            BitStream_Close(&strm);
+
+            /* 得た分割次数を指定して符号化しても同じ符号になるか */
+            BitWriter_Open(&strm, porder_buffer, buffer_size);
+            LINNECoder_EncodeWithPartitionOrder(coder, &strm, data, num_samples, partition_order);
+            BitStream_Flush(&strm);
+            BitStream_Tell(&strm, &porder_num_bytes);
+            BitStream_Close(&strm);
+            EXPECT_EQ(num_bytes, porder_num_bytes);
+            EXPECT_EQ(0, memcmp(buffer, porder_buffer, (size_t)num_bytes));
+        }
+
+        free(data);
+        free(buffer);
+        free(porder_buffer);
+    }
+
+    LINNECoder_Destroy(coder);
+}
+
+/* 逐次復号テスト */
+TEST(LINNECoderTest, DecodeSamplesTest)
+{
+    uint32_t i, trial;
+    const uint32_t num_samples_list[] = { 1, 3, 256, 1000, 4096 };
+    const uint32_t chunk_size_list[] = { 1, 7, 64, 256, 5000 };
+    struct LINNECoder *coder;
+
+    srand(0);
+    coder = LINNECoder_Create(NULL, NULL, 0);
+    ASSERT_TRUE(coder != NULL);
+
+    for (trial = 0; trial < sizeof(num_samples_list) / sizeof(num_samples_list[0]); trial++) {
+        uint32_t c;
+        const uint32_t num_samples = num_samples_list[trial];
+        int32_t *data = (int32_t *)malloc(sizeof(int32_t) * num_samples);
+        int32_t *decoded = (int32_t *)malloc(sizeof(int32_t) * num_samples);
+        uint8_t *buffer = (uint8_t *)malloc(sizeof(int32_t) * num_samples * 2 + 16);
+        struct BitStream strm;
+
+        for (i = 0; i < num_samples; i++) {
+            /* 分割毎に振幅を変える */
+            data[i] = (rand() % (2 * (i / 64) + 3)) - (int32_t)(i / 64) - 1;
+        }
+
+        BitWriter_Open(&strm, buffer, sizeof(int32_t) * num_samples * 2 + 16);
+        LINNECoder_Encode(coder, &strm, data, num_samples);
+        BitStream_Flush(&strm);
+        BitStream_Close(&strm);
+
+        /* 復号単位を変えても一括復号と一致するか */
+        for (c = 0; c < sizeof(chunk_size_list) / sizeof(chunk_size_list[0]); c++) {
+            uint32_t pos;
+            struct LINNECoderDecodeState state;
+            memset(decoded, 0, sizeof(int32_t) * num_samples);
+            BitReader_Open(&strm, buffer, sizeof(int32_t) * num_samples * 2 + 16);
+            LINNECoder_BeginDecode(&strm, &state, num_samples);
+            for (pos = 0; pos < num_samples; pos += chunk_size_list[c]) {
+                LINNECoder_DecodeSamples(&strm, &state,
+                        &decoded[pos], LINNEUTILITY_MIN(chunk_size_list[c], num_samples - pos));
+            }
+            BitStream_Close(&strm);
+            EXPECT_EQ(0, memcmp(data, decoded, sizeof(int32_t) * num_samples));
+        }
+
+        free(data);
+        free(decoded);
+        free(buffer);
+    }
+
+    LINNECoder_Destroy(coder);
+}
+
 int main(int argc, char **argv)
 {
     ::testing::InitGoogleTest(&argc, argv);
@@ -1,9 +1,11 @@
 #include <stdlib.h>
 #include <string.h>
+#include <math.h>
 
 #include <gtest/gtest.h>
 
 #include "linne_encoder.h"
+#include "../common/test_allocator.h"
 
 /* テスト対象のモジュール */
 extern "C" {
@@ -58,6 +60,8 @@ extern "C" {
         config__p->max_num_samples_per_block    = 8192;\
         config__p->max_num_layers               = 4;\
         config__p->max_num_parameters_per_layer = 128;\
+        config__p->max_num_threads              = 1;\
+        config__p->allocator                    = NULL;\
     } while (0);
 
 /* 有効なデコーダコンフィグをセット */
@@ -67,7 +71,10 @@ extern "C" {
         config__p->max_num_channels             = 8;\
         config__p->max_num_layers               = 4;\
         config__p->max_num_parameters_per_layer = 128;\
+        config__p->max_num_threads              = 1;\
+        config__p->max_num_samples_per_block    = 8192;\
         config__p->check_crc                    = 1;\
+        config__p->allocator                    = NULL;\
     } while (0);
 
 /* ヘッダデコードテスト */
@@ -96,6 +103,19 @@ TEST(LINNEDecoderTest, DecodeHeaderTest)
         EXPECT_EQ(header.ch_process_method, tmp_header.ch_process_method);
     }
 
+    /* 32bitを超えるサンプル数 */
+    {
+        uint8_t data[LINNE_HEADER_SIZE] = { 0, };
+        struct LINNEHeader header, tmp_header;
+
+        LINNE_SetValidHeader(&header);
+        header.num_samples = ((uint64_t)1 << 33) + 5;
+
+        EXPECT_EQ(LINNE_APIRESULT_OK, LINNEEncoder_EncodeHeader(&header, data, sizeof(data)));
+        EXPECT_EQ(LINNE_APIRESULT_OK, LINNEDecoder_DecodeHeader(data, sizeof(data), &tmp_header));
+        EXPECT_EQ(header.num_samples, tmp_header.num_samples);
+    }
+
     /* ヘッダデコード失敗ケース */
     {
         struct LINNEHeader header, getheader;
@@ -150,42 +170,42 @@ TEST(LINNEDecoderTest, DecodeHeaderTest)
         /* 異常なサンプル数 */
         memcpy(data, valid_data, sizeof(valid_data));
         memset(&getheader, 0xCD, sizeof(getheader));
-        ByteArray_WriteUint32BE(&data[14], 0);
+        ByteArray_WriteUint64BE(&data[14], 0);
         EXPECT_EQ(LINNE_APIRESULT_OK, LINNEDecoder_DecodeHeader(data, sizeof(data), &getheader));
         EXPECT_EQ(LINNE_ERROR_INVALID_FORMAT, LINNEDecoder_CheckHeaderFormat(&getheader));
 
         /* 異常なサンプリングレート */
         memcpy(data, valid_data, sizeof(valid_data));
         memset(&getheader, 0xCD, sizeof(getheader));
-        ByteArray_WriteUint32BE(&data[18], 0);
+        ByteArray_WriteUint32BE(&data[22], 0);
         EXPECT_EQ(LINNE_APIRESULT_OK, LINNEDecoder_DecodeHeader(data, sizeof(data), &getheader));
         EXPECT_EQ(LINNE_ERROR_INVALID_FORMAT, LINNEDecoder_CheckHeaderFormat(&getheader));
 
         /* 異常なサンプルあたりビット数 */
         memcpy(data, valid_data, sizeof(valid_data));
         memset(&getheader, 0xCD, sizeof(getheader));
-        ByteArray_WriteUint16BE(&data[22], 0);
+        ByteArray_WriteUint16BE(&data[26], 0);
         EXPECT_EQ(LINNE_APIRESULT_OK, LINNEDecoder_DecodeHeader(data, sizeof(data), &getheader));
         EXPECT_EQ(LINNE_ERROR_INVALID_FORMAT, LINNEDecoder_CheckHeaderFormat(&getheader));
 
         /* 異常なブロックあたりサンプル数 */
         memcpy(data, valid_data, sizeof(valid_data));
         memset(&getheader, 0xCD, sizeof(getheader));
-        ByteArray_WriteUint32BE(&data[24], 0);
+        ByteArray_WriteUint32BE(&data[28], 0);
         EXPECT_EQ(LINNE_APIRESULT_OK, LINNEDecoder_DecodeHeader(data, sizeof(data), &getheader));
         EXPECT_EQ(LINNE_ERROR_INVALID_FORMAT, LINNEDecoder_CheckHeaderFormat(&getheader));
 
         /* 異常なプリセット */
         memcpy(data, valid_data, sizeof(valid_data));
         memset(&getheader, 0xCD, sizeof(getheader));
-        ByteArray_WriteUint8(&data[28], LINNE_NUM_PARAMETER_PRESETS);
+        ByteArray_WriteUint8(&data[32], LINNE_NUM_PARAMETER_PRESETS);
         EXPECT_EQ(LINNE_APIRESULT_OK, LINNEDecoder_DecodeHeader(data, sizeof(data), &getheader));
         EXPECT_EQ(LINNE_ERROR_INVALID_FORMAT, LINNEDecoder_CheckHeaderFormat(&getheader));
 
         /* 異常なチャンネル処理法 */
         memcpy(data, valid_data, sizeof(valid_data));
         memset(&getheader, 0xCD, sizeof(getheader));
-        ByteArray_WriteUint8(&data[29], LINNE_CH_PROCESS_METHOD_INVALID);
+        ByteArray_WriteUint8(&data[33], LINNE_CH_PROCESS_METHOD_INVALID);
         EXPECT_EQ(LINNE_APIRESULT_OK, LINNEDecoder_DecodeHeader(data, sizeof(data), &getheader));
         EXPECT_EQ(LINNE_ERROR_INVALID_FORMAT, LINNEDecoder_CheckHeaderFormat(&getheader));
 
@@ -193,7 +213,7 @@ TEST(LINNEDecoderTest, DecodeHeaderTest)
         memcpy(data, valid_data, sizeof(valid_data));
         memset(&getheader, 0xCD, sizeof(getheader));
         ByteArray_WriteUint16BE(&data[12], 1);
-        ByteArray_WriteUint8(&data[29], LINNE_CH_PROCESS_METHOD_MS);
+        ByteArray_WriteUint8(&data[33], LINNE_CH_PROCESS_METHOD_MS);
         EXPECT_EQ(LINNE_APIRESULT_OK, LINNEDecoder_DecodeHeader(data, sizeof(data), &getheader));
         EXPECT_EQ(LINNE_ERROR_INVALID_FORMAT, LINNEDecoder_CheckHeaderFormat(&getheader));
     }
@@ -252,6 +272,8 @@ TEST(LINNEDecoderTest, CreateDestroyHandleTest)
         EXPECT_TRUE(decoder->num_units[0] != NULL);
         EXPECT_TRUE(decoder->rshifts != NULL);
         EXPECT_TRUE(decoder->rshifts[0] != NULL);
+        EXPECT_TRUE(decoder->pcm_buffer != NULL);
+        EXPECT_TRUE(decoder->pcm_buffer[0] != NULL);
 
         LINNEDecoder_Destroy(decoder);
         free(work);
@@ -280,6 +302,35 @@ TEST(LINNEDecoderTest, CreateDestroyHandleTest)
         LINNEDecoder_Destroy(decoder);
     }
 
+    /* アロケータ指定による自前確保 */
+    {
+        struct LINNEDecoder *decoder;
+        struct LINNEDecoderConfig config;
+        struct LINNEAllocator allocator;
+        struct TestAllocatorContext context = { 0, 0 };
+
+        LINNEDecoder_SetValidConfig(&config);
+        allocator.malloc_func = TestAllocator_Malloc;
+        allocator.free_func = TestAllocator_Free;
+        allocator.context = &context;
+        config.allocator = &allocator;
+
+        decoder = LINNEDecoder_Create(&config, NULL, 0);
+        ASSERT_TRUE(decoder != NULL);
+        EXPECT_EQ(1, context.num_alloc);
+        EXPECT_EQ(0, context.num_free);
+
+        LINNEDecoder_Destroy(decoder);
+        EXPECT_EQ(1, context.num_alloc);
+        EXPECT_EQ(1, context.num_free);
+
+        /* 確保・解放関数の片方だけの指定は不正 */
+        allocator.free_func = NULL;
+        decoder = LINNEDecoder_Create(&config, NULL, 0);
+        EXPECT_TRUE(decoder == NULL);
+        EXPECT_EQ(1, context.num_alloc);
+    }
+
     /* ワーク領域渡しによるハンドル作成（失敗ケース） */
     {
         void *work;
@@ -578,3 +629,222 @@ TEST(LINNEDecoderTest, DecodeBlockTest)
         LINNEEncoder_Destroy(encoder);
     }
 }
+
+/* PCMバッファ出力テスト */
+TEST(LINNEDecoderTest, DecodePCMTest)
+{
+    /* 32bitプレーナ出力と同じ値を各形式で書き出すか */
+    {
+        struct LINNEEncoder *encoder;
+        struct LINNEDecoder *decoder;
+        struct LINNEEncoderConfig encoder_config;
+        struct LINNEDecoderConfig decoder_config;
+        struct LINNEEncodeParameter parameter;
+        struct LINNEDecoderPCMOutput pcm;
+        uint8_t *data;
+        int32_t *input[LINNE_MAX_NUM_CHANNELS];
+        int32_t *output[LINNE_MAX_NUM_CHANNELS];
+        int16_t *int16_output;
+        uint8_t *int24_output;
+        float *float_output;
+        uint32_t ch, smpl, data_size, output_size, decode_size, num_decode_samples;
+        const uint32_t num_channels = 2;
+        const uint32_t num_samples = 2 * 1024 + 100;
+
+        LINNEEncoder_SetValidConfig(&encoder_config);
+        LINNEDecoder_SetValidConfig(&decoder_config);
+        LINNEEncoder_SetValidEncodeParameter(&parameter);
+        parameter.num_channels = (uint16_t)num_channels;
+        parameter.ch_process_method = LINNE_CH_PROCESS_METHOD_MS;
+
+        data_size = LINNE_HEADER_SIZE + 2 * num_channels * num_samples * sizeof(int16_t);
+        data = (uint8_t *)malloc(data_size);
+        for (ch = 0; ch < num_channels; ch++) {
+            input[ch] = (int32_t *)malloc(sizeof(int32_t) * num_samples);
+            output[ch] = (int32_t *)malloc(sizeof(int32_t) * num_samples);
+        }
+        /* 3チャンネル分の間隔で2チャンネル書き出す */
+        int16_output = (int16_t *)malloc(sizeof(int16_t) * 3 * num_samples);
+        int24_output = (uint8_t *)malloc(3 * num_channels * num_samples);
+        float_output = (float *)malloc(sizeof(float) * num_channels * num_samples);
+
+        encoder = LINNEEncoder_Create(&encoder_config, NULL, 0);
+        decoder = LINNEDecoder_Create(&decoder_config, NULL, 0);
+        ASSERT_TRUE(encoder != NULL);
+        ASSERT_TRUE(decoder != NULL);
+
+        /* 正弦波に雑音を乗せた信号をエンコード */
+        srand(0);
+        for (ch = 0; ch < num_channels; ch++) {
+            for (smpl = 0; smpl < num_samples; smpl++) {
+                input[ch][smpl] = (int32_t)(8192.0 * sin(0.02 * (ch + 1) * smpl)) + (rand() % 256) - 128;
+            }
+        }
+        EXPECT_EQ(LINNE_APIRESULT_OK, LINNEEncoder_SetEncodeParameter(encoder, &parameter));
+        EXPECT_EQ(LINNE_APIRESULT_OK, LINNEEncoder_EncodeWhole(encoder, input, num_samples, data, data_size, &output_size));
+        EXPECT_EQ(LINNE_APIRESULT_OK, LINNEDecoder_DecodeWhole(decoder, data, output_size, output, num_channels, num_samples));
+
+        /* 16bitインターリーブ（ストライド付き） */
+        pcm.format = LINNE_PCM_FORMAT_INT16;
+        pcm.stride = 3 * sizeof(int16_t);
+        for (ch = 0; ch < num_channels; ch++) {
+            pcm.channels[ch] = &int16_output[ch];
+        }
+        EXPECT_EQ(LINNE_APIRESULT_OK, LINNEDecoder_DecodeWholePCM(decoder, data, output_size, &pcm, num_samples));
+        for (ch = 0; ch < num_channels; ch++) {
+            for (smpl = 0; smpl < num_samples; smpl++) {
+                EXPECT_EQ(output[ch][smpl], int16_output[3 * smpl + ch]);
+            }
+        }
+
+        /* 24bitインターリーブ: MSB詰めで8bit左シフトされる */
+        pcm.format = LINNE_PCM_FORMAT_INT24;
+        pcm.stride = 3 * num_channels;
+        for (ch = 0; ch < num_channels; ch++) {
+            pcm.channels[ch] = &int24_output[3 * ch];
+        }
+        EXPECT_EQ(LINNE_APIRESULT_OK, LINNEDecoder_DecodeWholePCM(decoder, data, output_size, &pcm, num_samples));
+        for (ch = 0; ch < num_channels; ch++) {
+            for (smpl = 0; smpl < num_samples; smpl++) {
+                const uint8_t *p = &int24_output[3 * (num_channels * smpl + ch)];
+                const uint32_t u = (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16);
+                EXPECT_EQ(((uint32_t)output[ch][smpl] << 8) & 0xFFFFFF, u);
+            }
+        }
+
+        /* 16bit奇数ストライド（アラインメントされていない配置） */
+        pcm.format = LINNE_PCM_FORMAT_INT16;
+        pcm.stride = 5;
+        for (ch = 0; ch < num_channels; ch++) {
+            pcm.channels[ch] = &int24_output[2 * ch + 1];
+        }
+        EXPECT_EQ(LINNE_APIRESULT_OK, LINNEDecoder_DecodeWholePCM(decoder, data, output_size, &pcm, num_samples));
+        for (ch = 0; ch < num_channels; ch++) {
+            for (smpl = 0; smpl < num_samples; smpl++) {
+                int16_t sval;
+                memcpy(&sval, &int24_output[5 * smpl + 2 * ch + 1], sizeof(int16_t));
+                EXPECT_EQ(output[ch][smpl], sval);
+            }
+        }
+
+        /* 浮動小数インターリーブ */
+        pcm.format = LINNE_PCM_FORMAT_FLOAT32;
+        pcm.stride = num_channels * sizeof(float);
+        for (ch = 0; ch < num_channels; ch++) {
+            pcm.channels[ch] = &float_output[ch];
+        }
+        EXPECT_EQ(LINNE_APIRESULT_OK, LINNEDecoder_DecodeWholePCM(decoder, data, output_size, &pcm, num_samples));
+        for (ch = 0; ch < num_channels; ch++) {
+            for (smpl = 0; smpl < num_samples; smpl++) {
+                EXPECT_FLOAT_EQ(output[ch][smpl] / 32768.0f, float_output[num_channels * smpl + ch]);
+            }
+        }
+
+        /* 単一ブロック */
+        pcm.format = LINNE_PCM_FORMAT_INT16;
+        pcm.stride = 3 * sizeof(int16_t);
+        for (ch = 0; ch < num_channels; ch++) {
+            pcm.channels[ch] = &int16_output[ch];
+        }
+        memset(int16_output, 0, sizeof(int16_t) * 3 * num_samples);
+        EXPECT_EQ(LINNE_APIRESULT_OK,
+                LINNEDecoder_DecodeBlockPCM(decoder, data + LINNE_HEADER_SIZE, output_size - LINNE_HEADER_SIZE,
+                    &pcm, num_samples, &decode_size, &num_decode_samples));
+        EXPECT_EQ(parameter.num_samples_per_block, num_decode_samples);
+        for (ch = 0; ch < num_channels; ch++) {
+            for (smpl = 0; smpl < num_decode_samples; smpl++) {
+                EXPECT_EQ(output[ch][smpl], int16_output[3 * smpl + ch]);
+            }
+        }
+
+        LINNEDecoder_Destroy(decoder);
+        LINNEEncoder_Destroy(encoder);
+        free(float_output);
+        free(int24_output);
+        free(int16_output);
+        for (ch = 0; ch < num_channels; ch++) {
+            free(output[ch]);
+            free(input[ch]);
+        }
+        free(data);
+    }
+
+    /* 失敗ケース */
+    {
+        struct LINNEEncoder *encoder;
+        struct LINNEDecoder *decoder;
+        struct LINNEEncoderConfig encoder_config;
+        struct LINNEDecoderConfig decoder_config;
+        struct LINNEEncodeParameter parameter;
+        struct LINNEDecoderPCMOutput pcm;
+        struct LINNEHeader header;
+        int32_t input_buffer[256];
+        const int32_t *input[1];
+        int16_t buffer[256];
+        uint8_t data[1024];
+        uint32_t output_size, decode_size, num_decode_samples;
+
+        memset(input_buffer, 0, sizeof(input_buffer));
+        input[0] = input_buffer;
+        LINNEEncoder_SetValidConfig(&encoder_config);
+        LINNEDecoder_SetValidConfig(&decoder_config);
+        LINNEEncoder_SetValidEncodeParameter(&parameter);
+
+        encoder = LINNEEncoder_Create(&encoder_config, NULL, 0);
+        decoder = LINNEDecoder_Create(&decoder_config, NULL, 0);
+        ASSERT_TRUE(encoder != NULL);
+        ASSERT_TRUE(decoder != NULL);
+        EXPECT_EQ(LINNE_APIRESULT_OK, LINNEEncoder_SetEncodeParameter(encoder, &parameter));
+        EXPECT_EQ(LINNE_APIRESULT_OK, LINNEEncoder_EncodeWhole(encoder, input, 256, data, sizeof(data), &output_size));
+
+        pcm.format = LINNE_PCM_FORMAT_INT16;
+        pcm.stride = sizeof(int16_t);
+        pcm.channels[0] = buffer;
+
+        /* ヘッダ未設定 */
+        EXPECT_EQ(LINNE_APIRESULT_PARAMETER_NOT_SET,
+                LINNEDecoder_DecodeBlockPCM(decoder, data + LINNE_HEADER_SIZE, output_size - LINNE_HEADER_SIZE,
+                    &pcm, 256, &decode_size, &num_decode_samples));
+
+        /* 不正な引数 */
+        EXPECT_EQ(LINNE_APIRESULT_INVALID_ARGUMENT, LINNEDecoder_DecodeWholePCM(NULL, data, output_size, &pcm, 256));
+        EXPECT_EQ(LINNE_APIRESULT_INVALID_ARGUMENT, LINNEDecoder_DecodeWholePCM(decoder, NULL, output_size, &pcm, 256));
+        EXPECT_EQ(LINNE_APIRESULT_INVALID_ARGUMENT, LINNEDecoder_DecodeWholePCM(decoder, data, output_size, NULL, 256));
+
+        /* 不正な形式・ストライド・チャンネル */
+        pcm.format = LINNE_PCM_FORMAT_INVALID;
+        EXPECT_EQ(LINNE_APIRESULT_INVALID_ARGUMENT, LINNEDecoder_DecodeWholePCM(decoder, data, output_size, &pcm, 256));
+        pcm.format = LINNE_PCM_FORMAT_INT16;
+        pcm.stride = 1;
+        EXPECT_EQ(LINNE_APIRESULT_INVALID_ARGUMENT, LINNEDecoder_DecodeWholePCM(decoder, data, output_size, &pcm, 256));
+        pcm.stride = sizeof(int16_t);
+        pcm.channels[0] = NULL;
+        EXPECT_EQ(LINNE_APIRESULT_INVALID_ARGUMENT, LINNEDecoder_DecodeWholePCM(decoder, data, output_size, &pcm, 256));
+        pcm.channels[0] = buffer;
+
+        /* 出力サンプル数不足 */
+        EXPECT_EQ(LINNE_APIRESULT_INSUFFICIENT_BUFFER, LINNEDecoder_DecodeWholePCM(decoder, data, output_size, &pcm, 255));
+
+        /* 正常にデコードできることを確認 */
+        EXPECT_EQ(LINNE_APIRESULT_OK, LINNEDecoder_DecodeWholePCM(decoder, data, output_size, &pcm, 256));
+
+        /* コンテナに収まらないビット深度 */
+        EXPECT_EQ(LINNE_APIRESULT_OK, LINNEDecoder_DecodeHeader(data, output_size, &header));
+        header.bits_per_sample = 24;
+        EXPECT_EQ(LINNE_APIRESULT_OK, LINNEDecoder_SetHeader(decoder, &header));
+        EXPECT_EQ(LINNE_APIRESULT_INVALID_ARGUMENT,
+                LINNEDecoder_DecodeBlockPCM(decoder, data + LINNE_HEADER_SIZE, output_size - LINNE_HEADER_SIZE,
+                    &pcm, 256, &decode_size, &num_decode_samples));
+        LINNEDecoder_Destroy(decoder);
+
+        /* PCM出力用のバッファを持たないデコーダ */
+        decoder_config.max_num_samples_per_block = 0;
+        decoder = LINNEDecoder_Create(&decoder_config, NULL, 0);
+        ASSERT_TRUE(decoder != NULL);
+        EXPECT_TRUE(decoder->pcm_buffer == NULL);
+        EXPECT_EQ(LINNE_APIRESULT_INSUFFICIENT_BUFFER, LINNEDecoder_DecodeWholePCM(decoder, data, output_size, &pcm, 256));
+
+        LINNEDecoder_Destroy(decoder);
+        LINNEEncoder_Destroy(encoder);
+    }
+}
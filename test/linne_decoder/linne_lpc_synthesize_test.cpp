@@ -1,4 +1,182 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include <gtest/gtest.h>
+
 /* テスト対象のモジュール */
 extern "C" {
 #include "../../libs/linne_decoder/src/linne_lpc_synthesize.c"
 }
+
+/* 合成結果がスカラー実装と一致するか確認 */
+static bool LINNELPCSynthesizeTest_CheckSynthesize(uint32_t num_samples, uint32_t coef_order, uint32_t num_units)
+{
+    uint32_t i;
+    const uint32_t rshift = 8;
+    int32_t *data = (int32_t *)malloc(sizeof(int32_t) * num_samples);
+    int32_t *ref = (int32_t *)malloc(sizeof(int32_t) * num_samples);
+    int32_t *coef = (int32_t *)malloc(sizeof(int32_t) * coef_order);
+    /* 発散しないよう係数は小さく取る */
+    const int32_t max_abs_coef = ((coef_order / num_units) <= 32) ? 3 : 1;
+    bool is_ok;
+
+    for (i = 0; i < coef_order; i++) {
+        coef[i] = (rand() % (2 * max_abs_coef + 1)) - max_abs_coef;
+    }
+    for (i = 0; i < num_samples; i++) {
+        data[i] = (rand() % (1 << 16)) - (1 << 15);
+    }
+    memcpy(ref, data, sizeof(int32_t) * num_samples);
+
+    LINNELPC_SynthesizeScalar(ref, num_samples, coef, coef_order, rshift, num_units);
+    LINNELPC_Synthesize(data, num_samples, coef, coef_order, rshift, num_units);
+    is_ok = (memcmp(ref, data, sizeof(int32_t) * num_samples) == 0);
+
+    free(data);
+    free(ref);
+    free(coef);
+
+    return is_ok;
+}
+
+/* 合成結果が実行環境によらず一致するか */
+TEST(LINNELPCSynthesizeTest, SynthesizeTest)
+{
+    uint32_t num_units, nparams_per_unit;
+
+    srand(0);
+
+    /* ユニット数・次数・サンプル数の組み合わせ */
+    for (num_units = 1; num_units <= 128; num_units *= 2) {
+        for (nparams_per_unit = 1; nparams_per_unit <= 32; nparams_per_unit++) {
+            EXPECT_TRUE(LINNELPCSynthesizeTest_CheckSynthesize(
+                        num_units * 200, num_units * nparams_per_unit, num_units));
+            /* ユニット数で割り切れないサンプル数 */
+            EXPECT_TRUE(LINNELPCSynthesizeTest_CheckSynthesize(
+                        num_units * (nparams_per_unit + 1) + 3, num_units * nparams_per_unit, num_units));
+        }
+    }
+    /* 単一ユニットの高次数 */
+    EXPECT_TRUE(LINNELPCSynthesizeTest_CheckSynthesize(1000, 64, 1));
+    EXPECT_TRUE(LINNELPCSynthesizeTest_CheckSynthesize(1000, 128, 1));
+    EXPECT_TRUE(LINNELPCSynthesizeTest_CheckSynthesize(1000, 100, 1));
+
+#if defined(LINNE_USE_X86_SIMD)
+    /* 各命令セットの次数別関数を直接確認 */
+    {
+        uint32_t i, order;
+        const uint32_t num_samples = 16 * 300;
+        const uint32_t features = LINNEUtility_GetCPUFeatures();
+        int32_t *data = (int32_t *)malloc(sizeof(int32_t) * num_samples);
+        int32_t *ref = (int32_t *)malloc(sizeof(int32_t) * num_samples);
+        int32_t coef[16 * 32];
+
+        for (order = 1; order <= 32; order++) {
+            for (i = 0; i < 16 * order; i++) {
+                coef[i] = (rand() % 7) - 3;
+            }
+            for (i = 0; i < num_samples; i++) {
+                data[i] = (rand() % (1 << 16)) - (1 << 15);
+            }
+            if (features & LINNEUTILITY_CPU_FEATURE_SSE41) {
+                memcpy(ref, data, sizeof(int32_t) * num_samples);
+                LINNELPC_SynthesizeScalar(ref, num_samples, coef, 4 * order, 8, 4);
+                st_synthesize_lanes_sse41_functions[LINNELPC_GetFunctionTableIndex(order)](data, num_samples / 4, coef, order, 1 << 7, 8);
+                EXPECT_EQ(0, memcmp(ref, data, sizeof(int32_t) * num_samples));
+                memcpy(ref, data, sizeof(int32_t) * num_samples);
+                LINNELPC_SynthesizeScalar(ref, num_samples, coef, order, 8, 1);
+                st_synthesize_unit_sse41_functions[LINNELPC_GetFunctionTableIndex(order)](data, num_samples, coef, order, 1 << 7, 8);
+                EXPECT_EQ(0, memcmp(ref, data, sizeof(int32_t) * num_samples));
+            }
+            if (features & LINNEUTILITY_CPU_FEATURE_AVX2) {
+                memcpy(ref, data, sizeof(int32_t) * num_samples);
+                LINNELPC_SynthesizeScalar(ref, num_samples / 2, coef, 8 * order, 8, 8);
+                st_synthesize_lanes_avx2_functions[LINNELPC_GetFunctionTableIndex(order)](data, num_samples / 16, coef, order, 1 << 7, 8);
+                EXPECT_EQ(0, memcmp(ref, data, sizeof(int32_t) * num_samples));
+                memcpy(ref, data, sizeof(int32_t) * num_samples);
+                LINNELPC_SynthesizeScalar(ref, num_samples, coef, order, 8, 1);
+                st_synthesize_unit_avx2_functions[LINNELPC_GetFunctionTableIndex(order)](data, num_samples, coef, order, 1 << 7, 8);
+                EXPECT_EQ(0, memcmp(ref, data, sizeof(int32_t) * num_samples));
+            }
+            if (features & LINNEUTILITY_CPU_FEATURE_AVX512F) {
+                memcpy(ref, data, sizeof(int32_t) * num_samples);
+                LINNELPC_SynthesizeScalar(ref, num_samples, coef, 16 * order, 8, 16);
+                st_synthesize_lanes_avx512_functions[LINNELPC_GetFunctionTableIndex(order)](data, num_samples / 16, coef, order, 1 << 7, 8);
+                EXPECT_EQ(0, memcmp(ref, data, sizeof(int32_t) * num_samples));
+            }
+        }
+
+        free(data);
+        free(ref);
+    }
+#endif
+}
+
+/* 多段合成の結果が層毎の合成+デエンファシスと一致するか */
+TEST(LINNELPCSynthesizeTest, SynthesizeCascadeTest)
+{
+    uint32_t i, l, trial;
+    const uint32_t num_layers = 3;
+    const uint32_t coef_orders[3] = { 4, 32, 16 };
+    const uint32_t num_samples_list[] = { 64, 255, 256, 257, 1000, 4096, 4099 };
+    const uint32_t num_units_list[][3] = {
+        { 1, 1, 1 }, { 2, 4, 8 }, { 4, 32, 16 }, { 1, 32, 1 }, { 4, 1, 16 }, { 2, 2, 2 }
+    };
+    int32_t *coefs[3];
+    int32_t *layer_buffers[3];
+    uint32_t coef_rshifts[3] = { 8, 7, 6 };
+
+    srand(0);
+
+    for (l = 0; l < num_layers; l++) {
+        coefs[l] = (int32_t *)malloc(sizeof(int32_t) * coef_orders[l]);
+        layer_buffers[l] = (int32_t *)malloc(sizeof(int32_t) * (coef_orders[l] + LINNELPC_CASCADE_TILE_SIZE));
+    }
+
+    for (trial = 0; trial < sizeof(num_samples_list) / sizeof(num_samples_list[0]); trial++) {
+        uint32_t u;
+        const uint32_t num_samples = num_samples_list[trial];
+        int32_t *data = (int32_t *)malloc(sizeof(int32_t) * num_samples);
+        int32_t *ref = (int32_t *)malloc(sizeof(int32_t) * num_samples);
+
+        for (u = 0; u < sizeof(num_units_list) / sizeof(num_units_list[0]); u++) {
+            struct LINNEPreemphasisFilter deemph[2], ref_deemph[2];
+
+            for (l = 0; l < num_layers; l++) {
+                for (i = 0; i < coef_orders[l]; i++) {
+                    coefs[l][i] = (rand() % 7) - 3;
+                }
+            }
+            for (i = 0; i < num_samples; i++) {
+                data[i] = (rand() % (1 << 16)) - (1 << 15);
+            }
+            memcpy(ref, data, sizeof(int32_t) * num_samples);
+            for (l = 0; l < 2; l++) {
+                deemph[l].coef = rand() % 16;
+                deemph[l].prev = (rand() % (1 << 16)) - (1 << 15);
+                ref_deemph[l] = deemph[l];
+            }
+
+            for (l = num_layers; l > 0; l--) {
+                LINNELPC_SynthesizeScalar(ref, num_samples,
+                        coefs[l - 1], coef_orders[l - 1], coef_rshifts[l - 1], num_units_list[u][l - 1]);
+            }
+            LINNEPreemphasisFilter_MultiStageDeemphasis(ref_deemph, 2, ref, num_samples);
+
+            LINNELPC_SynthesizeCascade(data, num_samples,
+                    coefs, coef_orders, coef_rshifts, num_units_list[u], num_layers, deemph, layer_buffers);
+
+            EXPECT_EQ(0, memcmp(ref, data, sizeof(int32_t) * num_samples));
+            EXPECT_EQ(ref_deemph[0].prev, deemph[0].prev);
+            EXPECT_EQ(ref_deemph[1].prev, deemph[1].prev);
+        }
+
+        free(data);
+        free(ref);
+    }
+
+    for (l = 0; l < num_layers; l++) {
+        free(coefs[l]);
+        free(layer_buffers[l]);
+    }
+}
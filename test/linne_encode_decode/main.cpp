@@ -224,12 +224,13 @@ static int32_t LINNEEncodeDecodeTest_ExecuteTestCase(const struct EncodeDecodeTe
     int32_t **input;
     uint8_t *data;
     int32_t **output;
+    int32_t *pcm_output;
     LINNEApiResult api_ret;
 
     struct LINNEEncoderConfig encoder_config;
     struct LINNEDecoderConfig decoder_config;
     struct LINNEEncoder *encoder;
-    struct LINNEDecoder *decoder;
+    struct LINNEDecoder *decoder, *parallel_decoder;
 
     assert(test_case != NULL);
     assert(test_case->num_samples <= (1UL << 14));  /* 長過ぎる入力はNG */
@@ -245,16 +246,22 @@ static int32_t LINNEEncodeDecodeTest_ExecuteTestCase(const struct EncodeDecodeTe
     encoder_config.max_num_samples_per_block    = test_case->encode_parameter.num_samples_per_block;
     encoder_config.max_num_layers               = 3;
     encoder_config.max_num_parameters_per_layer = 128;
+    encoder_config.max_num_threads              = 1;
+    encoder_config.allocator                    = NULL;
     decoder_config.max_num_channels             = num_channels;
     decoder_config.max_num_layers               = 3;
     decoder_config.max_num_parameters_per_layer = 128;
+    decoder_config.max_num_threads              = 1;
+    decoder_config.max_num_samples_per_block    = test_case->encode_parameter.num_samples_per_block;
     decoder_config.check_crc                    = 1;
+    decoder_config.allocator                    = NULL;
 
     /* 一時領域の割り当て */
     input_double  = (double **)malloc(sizeof(double*) * num_channels);
     input         = (int32_t **)malloc(sizeof(int32_t*) * num_channels);
     output        = (int32_t **)malloc(sizeof(int32_t*) * num_channels);
     data          = (uint8_t *)malloc(data_size);
+    pcm_output    = (int32_t *)malloc(sizeof(int32_t) * num_channels * num_samples);
     for (ch = 0; ch < num_channels; ch++) {
         input_double[ch]  = (double *)malloc(sizeof(double) * num_samples);
         input[ch]         = (int32_t *)malloc(sizeof(int32_t) * num_samples);
@@ -264,7 +271,10 @@ static int32_t LINNEEncodeDecodeTest_ExecuteTestCase(const struct EncodeDecodeTe
     /* エンコード・デコードハンドル作成 */
     encoder = LINNEEncoder_Create(&encoder_config, NULL, 0);
     decoder = LINNEDecoder_Create(&decoder_config, NULL, 0);
-    if ((encoder == NULL) || (decoder == NULL)) {
+    /* チャンネル並列で合成するデコーダ */
+    decoder_config.max_num_threads = num_channels;
+    parallel_decoder = LINNEDecoder_Create(&decoder_config, NULL, 0);
+    if ((encoder == NULL) || (decoder == NULL) || (parallel_decoder == NULL)) {
         ret = 1;
         goto EXIT;
     }
@@ -309,11 +319,65 @@ static int32_t LINNEEncodeDecodeTest_ExecuteTestCase(const struct EncodeDecodeTe
         }
     }
 
+    /* チャンネル並列でデコード */
+    if ((api_ret = LINNEDecoder_DecodeWhole(parallel_decoder, data, output_size, output, num_channels, num_samples)) != LINNE_APIRESULT_OK) {
+        fprintf(stderr, "Parallel decode failed! ret:%d \n", api_ret);
+        ret = 6;
+        goto EXIT;
+    }
+
+    /* 一致確認 */
+    for (ch = 0; ch < num_channels; ch++) {
+        for (smpl = 0; smpl < num_samples; smpl++) {
+            if (input[ch][smpl] != output[ch][smpl]) {
+                printf("%5d %12d vs %12d \n", smpl, input[ch][smpl], output[ch][smpl]);
+                ret = 7;
+                goto EXIT;
+            }
+        }
+    }
+
+    /* インターリーブした32bit PCMに直接デコード */
+    {
+        uint32_t i;
+        struct LINNEDecoderPCMOutput pcm;
+        struct LINNEDecoder *decoders[2];
+        const uint32_t lshift = 32U - test_case->encode_parameter.bits_per_sample;
+
+        decoders[0] = decoder;
+        decoders[1] = parallel_decoder;
+        pcm.format = LINNE_PCM_FORMAT_INT32;
+        pcm.stride = (uint32_t)sizeof(int32_t) * num_channels;
+        for (ch = 0; ch < num_channels; ch++) {
+            pcm.channels[ch] = &pcm_output[ch];
+        }
+
+        for (i = 0; i < 2; i++) {
+            memset(pcm_output, 0, sizeof(int32_t) * num_channels * num_samples);
+            if ((api_ret = LINNEDecoder_DecodeWholePCM(decoders[i], data, output_size, &pcm, num_samples)) != LINNE_APIRESULT_OK) {
+                fprintf(stderr, "PCM decode failed! ret:%d \n", api_ret);
+                ret = 8;
+                goto EXIT;
+            }
+            /* MSB詰めで一致するか */
+            for (ch = 0; ch < num_channels; ch++) {
+                for (smpl = 0; smpl < num_samples; smpl++) {
+                    if ((int32_t)((uint32_t)input[ch][smpl] << lshift) != pcm_output[num_channels * smpl + ch]) {
+                        printf("%5d %12d vs %12d \n", smpl, input[ch][smpl], pcm_output[num_channels * smpl + ch]);
+                        ret = 9;
+                        goto EXIT;
+                    }
+                }
+            }
+        }
+    }
+
     /* ここまで来れば成功 */
     ret = 0;
 
 EXIT:
     /* ハンドル開放 */
+    LINNEDecoder_Destroy(parallel_decoder);
     LINNEDecoder_Destroy(decoder);
     LINNEEncoder_Destroy(encoder);
 
@@ -326,6 +390,7 @@ EXIT:
     free(input_double);
     free(input);
     free(output);
+    free(pcm_output);
     free(data);
 
     return ret;
@@ -3,6 +3,8 @@
 
 #include <gtest/gtest.h>
 
+#include "../common/test_allocator.h"
+
 /* テスト対象のモジュール */
 extern "C" {
 #include "../../libs/linne_encoder/src/linne_encoder.c"
@@ -43,6 +45,8 @@ extern "C" {
         config__p->max_num_samples_per_block    = 8192;\
         config__p->max_num_layers               = 4;\
         config__p->max_num_parameters_per_layer = 128;\
+        config__p->max_num_threads              = 1;\
+        config__p->allocator                    = NULL;\
     } while (0);
 
 /* ヘッダエンコードテスト */
@@ -195,6 +199,66 @@ TEST(LINNEEncoderTest, CreateDestroyHandleTest)
         LINNEEncoder_Destroy(encoder);
     }
 
+    /* アロケータ指定による自前確保 */
+    {
+        struct LINNEEncoder *encoder;
+        struct LINNEEncoderConfig config;
+        struct LINNEAllocator allocator;
+        struct TestAllocatorContext context = { 0, 0 };
+
+        LINNEEncoder_SetValidConfig(&config);
+        allocator.malloc_func = TestAllocator_Malloc;
+        allocator.free_func = TestAllocator_Free;
+        allocator.context = &context;
+        config.allocator = &allocator;
+
+        encoder = LINNEEncoder_Create(&config, NULL, 0);
+        ASSERT_TRUE(encoder != NULL);
+        EXPECT_EQ(1, context.num_alloc);
+        EXPECT_EQ(0, context.num_free);
+
+        LINNEEncoder_Destroy(encoder);
+        EXPECT_EQ(1, context.num_alloc);
+        EXPECT_EQ(1, context.num_free);
+
+        /* バッファはパラメータ設定時に確保し、足りない時のみ確保し直す */
+        {
+            struct LINNEEncodeParameter parameter;
+            LINNEEncoder_SetValidEncodeParameter(&parameter);
+            context.num_alloc = context.num_free = 0;
+            encoder = LINNEEncoder_Create(&config, NULL, 0);
+            ASSERT_TRUE(encoder != NULL);
+            EXPECT_EQ(1, context.num_alloc);
+            EXPECT_EQ(LINNE_APIRESULT_OK, LINNEEncoder_SetEncodeParameter(encoder, &parameter));
+            EXPECT_EQ(2, context.num_alloc);
+            EXPECT_EQ(0, context.num_free);
+            EXPECT_EQ(parameter.num_channels, encoder->buffer_num_channels);
+            EXPECT_EQ(parameter.num_samples_per_block, encoder->buffer_num_samples_per_block);
+            EXPECT_EQ(g_linne_parameter_preset[parameter.preset].num_layers, encoder->buffer_num_layers);
+            /* 小さいパラメータでは確保し直さない */
+            parameter.num_samples_per_block /= 2;
+            EXPECT_EQ(LINNE_APIRESULT_OK, LINNEEncoder_SetEncodeParameter(encoder, &parameter));
+            EXPECT_EQ(2, context.num_alloc);
+            EXPECT_EQ(0, context.num_free);
+            /* 足りなくなったら確保し直す */
+            parameter.num_channels = 2;
+            EXPECT_EQ(LINNE_APIRESULT_OK, LINNEEncoder_SetEncodeParameter(encoder, &parameter));
+            EXPECT_EQ(3, context.num_alloc);
+            EXPECT_EQ(1, context.num_free);
+            EXPECT_EQ(2, encoder->buffer_num_channels);
+            EXPECT_EQ(1024, encoder->buffer_num_samples_per_block);
+            LINNEEncoder_Destroy(encoder);
+            EXPECT_EQ(3, context.num_alloc);
+            EXPECT_EQ(3, context.num_free);
+        }
+
+        /* 確保・解放関数の片方だけの指定は不正 */
+        allocator.free_func = NULL;
+        encoder = LINNEEncoder_Create(&config, NULL, 0);
+        EXPECT_TRUE(encoder == NULL);
+        EXPECT_EQ(3, context.num_alloc);
+    }
+
     /* ワーク領域渡しによるハンドル作成（失敗ケース） */
     {
         void *work;
@@ -456,3 +520,459 @@ TEST(LINNEEncoderTest, EncodeBlockTest)
         LINNEEncoder_Destroy(encoder);
     }
 }
+
+/* 最大出力サイズ計算テスト */
+TEST(LINNEEncoderTest, CalculateMaxSizeTest)
+{
+    /* 簡単な成功例 */
+    {
+        struct LINNEEncodeParameter parameter;
+        uint32_t max_block_size, max_output_size;
+
+        LINNEEncoder_SetValidEncodeParameter(&parameter);
+        parameter.num_channels = 2;
+
+        EXPECT_EQ(LINNE_APIRESULT_OK, LINNEEncoder_CalculateMaxBlockSize(&parameter, &max_block_size));
+        EXPECT_EQ(LINNE_BLOCK_HEADER_SIZE + (2 * 16 * parameter.num_samples_per_block) / 8, max_block_size);
+
+        /* ブロックサイズで割り切れる場合 */
+        EXPECT_EQ(LINNE_APIRESULT_OK,
+                LINNEEncoder_CalculateMaxOutputSize(&parameter, 4 * parameter.num_samples_per_block, &max_output_size));
+        EXPECT_EQ(LINNE_HEADER_SIZE + 4 * max_block_size, max_output_size);
+
+        /* 端数のブロックがある場合 */
+        EXPECT_EQ(LINNE_APIRESULT_OK,
+                LINNEEncoder_CalculateMaxOutputSize(&parameter, 4 * parameter.num_samples_per_block + 3, &max_output_size));
+        EXPECT_EQ(LINNE_HEADER_SIZE + 4 * max_block_size + LINNE_BLOCK_HEADER_SIZE + (2 * 16 * 3) / 8, max_output_size);
+    }
+
+    /* 失敗ケース */
+    {
+        struct LINNEEncodeParameter parameter;
+        uint32_t size;
+
+        LINNEEncoder_SetValidEncodeParameter(&parameter);
+
+        EXPECT_EQ(LINNE_APIRESULT_INVALID_ARGUMENT, LINNEEncoder_CalculateMaxBlockSize(NULL, &size));
+        EXPECT_EQ(LINNE_APIRESULT_INVALID_ARGUMENT, LINNEEncoder_CalculateMaxBlockSize(&parameter, NULL));
+        EXPECT_EQ(LINNE_APIRESULT_INVALID_ARGUMENT, LINNEEncoder_CalculateMaxOutputSize(NULL, 1024, &size));
+        EXPECT_EQ(LINNE_APIRESULT_INVALID_ARGUMENT, LINNEEncoder_CalculateMaxOutputSize(&parameter, 1024, NULL));
+
+        /* 不正なパラメータ */
+        parameter.num_channels = 0;
+        EXPECT_EQ(LINNE_APIRESULT_INVALID_FORMAT, LINNEEncoder_CalculateMaxBlockSize(&parameter, &size));
+        EXPECT_EQ(LINNE_APIRESULT_INVALID_FORMAT, LINNEEncoder_CalculateMaxOutputSize(&parameter, 1024, &size));
+
+        /* 32bitで表せないサイズ */
+        LINNEEncoder_SetValidEncodeParameter(&parameter);
+        parameter.num_channels = 8;
+        parameter.bits_per_sample = 24;
+        EXPECT_EQ(LINNE_APIRESULT_NG, LINNEEncoder_CalculateMaxOutputSize(&parameter, UINT32_MAX, &size));
+    }
+
+    /* 最大サイズのバッファで、圧縮の効かない信号もエンコードできるか */
+    {
+        struct LINNEEncoder *encoder;
+        struct LINNEEncoderConfig config;
+        struct LINNEEncodeParameter parameter;
+        int32_t *input[LINNE_MAX_NUM_CHANNELS];
+        uint8_t *data;
+        uint32_t ch, smpl, trial, max_block_size, max_output_size, output_size;
+        const uint32_t num_samples = 4 * 1024 + 100;
+
+        LINNEEncoder_SetValidEncodeParameter(&parameter);
+        LINNEEncoder_SetValidConfig(&config);
+        parameter.num_channels = 2;
+        parameter.enable_learning = 0;
+        parameter.num_afmethod_iterations = 0;
+
+        encoder = LINNEEncoder_Create(&config, NULL, 0);
+        ASSERT_TRUE(encoder != NULL);
+        EXPECT_EQ(LINNE_APIRESULT_OK, LINNEEncoder_SetEncodeParameter(encoder, &parameter));
+        EXPECT_EQ(LINNE_APIRESULT_OK, LINNEEncoder_CalculateMaxBlockSize(&parameter, &max_block_size));
+        EXPECT_EQ(LINNE_APIRESULT_OK, LINNEEncoder_CalculateMaxOutputSize(&parameter, num_samples, &max_output_size));
+
+        data = (uint8_t *)malloc(max_output_size);
+        for (ch = 0; ch < parameter.num_channels; ch++) {
+            input[ch] = (int32_t *)malloc(sizeof(int32_t) * num_samples);
+        }
+
+        srand(0);
+        for (trial = 0; trial < 3; trial++) {
+            for (ch = 0; ch < parameter.num_channels; ch++) {
+                for (smpl = 0; smpl < num_samples; smpl++) {
+                    switch (trial) {
+                    case 0: /* 正弦波 */
+                        input[ch][smpl] = (int32_t)(16384.0 * sin(0.01 * smpl));
+                        break;
+                    case 1: /* 白色雑音 */
+                        input[ch][smpl] = (rand() % 65536) - 32768;
+                        break;
+                    default: /* 最大振幅の矩形波 */
+                        input[ch][smpl] = (smpl % 2 == 0) ? 32767 : -32768;
+                        break;
+                    }
+                }
+            }
+
+            /* 単一ブロック */
+            EXPECT_EQ(LINNE_APIRESULT_OK,
+                    LINNEEncoder_EncodeBlock(encoder, input, parameter.num_samples_per_block,
+                        data, max_block_size, &output_size));
+            EXPECT_LE(output_size, max_block_size);
+
+            /* ファイル全体 */
+            EXPECT_EQ(LINNE_APIRESULT_OK,
+                    LINNEEncoder_EncodeWhole(encoder, input, num_samples, data, max_output_size, &output_size));
+            EXPECT_LE(output_size, max_output_size);
+        }
+
+        for (ch = 0; ch < parameter.num_channels; ch++) {
+            free(input[ch]);
+        }
+        free(data);
+        LINNEEncoder_Destroy(encoder);
+    }
+}
+
+/* PCMバッファ入力テスト */
+TEST(LINNEEncoderTest, PCMInputTest)
+{
+    /* 形式・配置によらず32bitプレーナ入力と同一の出力になるか */
+    {
+        struct LINNEEncoder *encoder;
+        struct LINNEEncoderConfig config;
+        struct LINNEEncodeParameter parameter;
+        struct LINNEEncoderPCMInput pcm_input;
+        int32_t *input[LINNE_MAX_NUM_CHANNELS];
+        int16_t *int16_buffer;
+        uint8_t *int24_buffer;
+        int32_t *int32_buffer;
+        uint8_t *data, *pcm_data;
+        uint32_t ch, smpl, max_output_size, output_size, pcm_output_size;
+        const uint32_t num_channels = 2;
+        const uint32_t num_samples = 3 * 1024 + 100;
+
+        LINNEEncoder_SetValidEncodeParameter(&parameter);
+        LINNEEncoder_SetValidConfig(&config);
+        parameter.num_channels = (uint16_t)num_channels;
+        parameter.ch_process_method = LINNE_CH_PROCESS_METHOD_MS;
+        parameter.enable_learning = 0;
+        parameter.num_afmethod_iterations = 0;
+
+        encoder = LINNEEncoder_Create(&config, NULL, 0);
+        ASSERT_TRUE(encoder != NULL);
+        EXPECT_EQ(LINNE_APIRESULT_OK, LINNEEncoder_SetEncodeParameter(encoder, &parameter));
+        EXPECT_EQ(LINNE_APIRESULT_OK, LINNEEncoder_CalculateMaxOutputSize(&parameter, num_samples, &max_output_size));
+
+        data = (uint8_t *)malloc(max_output_size);
+        pcm_data = (uint8_t *)malloc(max_output_size);
+        int16_buffer = (int16_t *)malloc(sizeof(int16_t) * 3 * num_samples);
+        int24_buffer = (uint8_t *)malloc(3 * num_channels * num_samples);
+        int32_buffer = (int32_t *)malloc(sizeof(int32_t) * num_channels * num_samples);
+        for (ch = 0; ch < num_channels; ch++) {
+            input[ch] = (int32_t *)malloc(sizeof(int32_t) * num_samples);
+        }
+
+        /* 正弦波に雑音を乗せた入力を各形式で用意 */
+        srand(0);
+        for (smpl = 0; smpl < num_samples; smpl++) {
+            for (ch = 0; ch < num_channels; ch++) {
+                const int32_t val = (int32_t)(8192.0 * sin(0.01 * (ch + 1) * smpl)) + (rand() % 512) - 256;
+                const uint32_t msb24 = (uint32_t)val << 8;
+                input[ch][smpl] = val;
+                /* 3ch分の領域に2chだけ詰めた16bitインターリーブ */
+                int16_buffer[3 * smpl + ch] = (int16_t)val;
+                int24_buffer[3 * (num_channels * smpl + ch) + 0] = (uint8_t)(msb24 >> 0);
+                int24_buffer[3 * (num_channels * smpl + ch) + 1] = (uint8_t)(msb24 >> 8);
+                int24_buffer[3 * (num_channels * smpl + ch) + 2] = (uint8_t)(msb24 >> 16);
+                /* 32bitはプレーナでMSB詰め */
+                int32_buffer[ch * num_samples + smpl] = (int32_t)((uint32_t)val << 16);
+            }
+        }
+
+        /* 基準となる32bitプレーナ入力のエンコード結果 */
+        EXPECT_EQ(LINNE_APIRESULT_OK,
+                LINNEEncoder_EncodeWhole(encoder, input, num_samples, data, max_output_size, &output_size));
+
+        /* 16bitインターリーブ（ストライド付き） */
+        pcm_input.format = LINNE_PCM_FORMAT_INT16;
+        pcm_input.stride = 3 * sizeof(int16_t);
+        for (ch = 0; ch < num_channels; ch++) {
+            pcm_input.channels[ch] = &int16_buffer[ch];
+        }
+        EXPECT_EQ(LINNE_APIRESULT_OK,
+                LINNEEncoder_EncodeWholePCM(encoder, &pcm_input, num_samples, pcm_data, max_output_size, &pcm_output_size));
+        EXPECT_EQ(output_size, pcm_output_size);
+        EXPECT_EQ(0, memcmp(data, pcm_data, output_size));
+
+        /* 24bitインターリーブ */
+        pcm_input.format = LINNE_PCM_FORMAT_INT24;
+        pcm_input.stride = 3 * num_channels;
+        for (ch = 0; ch < num_channels; ch++) {
+            pcm_input.channels[ch] = &int24_buffer[3 * ch];
+        }
+        EXPECT_EQ(LINNE_APIRESULT_OK,
+                LINNEEncoder_EncodeWholePCM(encoder, &pcm_input, num_samples, pcm_data, max_output_size, &pcm_output_size));
+        EXPECT_EQ(output_size, pcm_output_size);
+        EXPECT_EQ(0, memcmp(data, pcm_data, output_size));
+
+        /* 16bit奇数ストライド（アラインメントされていない配置） */
+        for (smpl = 0; smpl < num_samples; smpl++) {
+            for (ch = 0; ch < num_channels; ch++) {
+                const int16_t sval = (int16_t)input[ch][smpl];
+                memcpy(&int24_buffer[5 * smpl + 2 * ch + 1], &sval, sizeof(int16_t));
+            }
+        }
+        pcm_input.format = LINNE_PCM_FORMAT_INT16;
+        pcm_input.stride = 5;
+        for (ch = 0; ch < num_channels; ch++) {
+            pcm_input.channels[ch] = &int24_buffer[2 * ch + 1];
+        }
+        EXPECT_EQ(LINNE_APIRESULT_OK,
+                LINNEEncoder_EncodeWholePCM(encoder, &pcm_input, num_samples, pcm_data, max_output_size, &pcm_output_size));
+        EXPECT_EQ(output_size, pcm_output_size);
+        EXPECT_EQ(0, memcmp(data, pcm_data, output_size));
+
+        /* 32bitプレーナ */
+        pcm_input.format = LINNE_PCM_FORMAT_INT32;
+        pcm_input.stride = sizeof(int32_t);
+        for (ch = 0; ch < num_channels; ch++) {
+            pcm_input.channels[ch] = &int32_buffer[ch * num_samples];
+        }
+        EXPECT_EQ(LINNE_APIRESULT_OK,
+                LINNEEncoder_EncodeWholePCM(encoder, &pcm_input, num_samples, pcm_data, max_output_size, &pcm_output_size));
+        EXPECT_EQ(output_size, pcm_output_size);
+        EXPECT_EQ(0, memcmp(data, pcm_data, output_size));
+
+        /* 単一ブロック */
+        EXPECT_EQ(LINNE_APIRESULT_OK,
+                LINNEEncoder_EncodeBlock(encoder, input, parameter.num_samples_per_block, data, max_output_size, &output_size));
+        EXPECT_EQ(LINNE_APIRESULT_OK,
+                LINNEEncoder_EncodeBlockPCM(encoder, &pcm_input, parameter.num_samples_per_block, pcm_data, max_output_size, &pcm_output_size));
+        EXPECT_EQ(output_size, pcm_output_size);
+        EXPECT_EQ(0, memcmp(data, pcm_data, output_size));
+
+        for (ch = 0; ch < num_channels; ch++) {
+            free(input[ch]);
+        }
+        free(int32_buffer);
+        free(int24_buffer);
+        free(int16_buffer);
+        free(pcm_data);
+        free(data);
+        LINNEEncoder_Destroy(encoder);
+    }
+
+    /* 失敗ケース */
+    {
+        struct LINNEEncoder *encoder;
+        struct LINNEEncoderConfig config;
+        struct LINNEEncodeParameter parameter;
+        struct LINNEEncoderPCMInput pcm_input;
+        int16_t buffer[2 * 256];
+        uint8_t data[4096];
+        uint32_t output_size;
+
+        memset(buffer, 0, sizeof(buffer));
+        LINNEEncoder_SetValidEncodeParameter(&parameter);
+        LINNEEncoder_SetValidConfig(&config);
+        parameter.num_channels = 2;
+
+        encoder = LINNEEncoder_Create(&config, NULL, 0);
+        ASSERT_TRUE(encoder != NULL);
+
+        pcm_input.format = LINNE_PCM_FORMAT_INT16;
+        pcm_input.stride = 2 * sizeof(int16_t);
+        pcm_input.channels[0] = &buffer[0];
+        pcm_input.channels[1] = &buffer[1];
+
+        /* パラメータ未設定 */
+        EXPECT_EQ(LINNE_APIRESULT_PARAMETER_NOT_SET,
+                LINNEEncoder_EncodeBlockPCM(encoder, &pcm_input, 256, data, sizeof(data), &output_size));
+        EXPECT_EQ(LINNE_APIRESULT_PARAMETER_NOT_SET,
+                LINNEEncoder_EncodeWholePCM(encoder, &pcm_input, 256, data, sizeof(data), &output_size));
+
+        EXPECT_EQ(LINNE_APIRESULT_OK, LINNEEncoder_SetEncodeParameter(encoder, &parameter));
+
+        /* 不正な引数 */
+        EXPECT_EQ(LINNE_APIRESULT_INVALID_ARGUMENT,
+                LINNEEncoder_EncodeBlockPCM(NULL, &pcm_input, 256, data, sizeof(data), &output_size));
+        EXPECT_EQ(LINNE_APIRESULT_INVALID_ARGUMENT,
+                LINNEEncoder_EncodeBlockPCM(encoder, NULL, 256, data, sizeof(data), &output_size));
+        EXPECT_EQ(LINNE_APIRESULT_INVALID_ARGUMENT,
+                LINNEEncoder_EncodeWholePCM(encoder, NULL, 256, data, sizeof(data), &output_size));
+
+        /* 不正な形式 */
+        pcm_input.format = LINNE_PCM_FORMAT_INVALID;
+        EXPECT_EQ(LINNE_APIRESULT_INVALID_ARGUMENT,
+                LINNEEncoder_EncodeBlockPCM(encoder, &pcm_input, 256, data, sizeof(data), &output_size));
+        pcm_input.format = LINNE_PCM_FORMAT_FLOAT32;
+        EXPECT_EQ(LINNE_APIRESULT_INVALID_ARGUMENT,
+                LINNEEncoder_EncodeBlockPCM(encoder, &pcm_input, 256, data, sizeof(data), &output_size));
+        pcm_input.format = LINNE_PCM_FORMAT_INT16;
+
+        /* サンプルより小さいストライド */
+        pcm_input.stride = 1;
+        EXPECT_EQ(LINNE_APIRESULT_INVALID_ARGUMENT,
+                LINNEEncoder_EncodeWholePCM(encoder, &pcm_input, 256, data, sizeof(data), &output_size));
+        pcm_input.stride = 2 * sizeof(int16_t);
+
+        /* チャンネルの指定漏れ */
+        pcm_input.channels[1] = NULL;
+        EXPECT_EQ(LINNE_APIRESULT_INVALID_ARGUMENT,
+                LINNEEncoder_EncodeBlockPCM(encoder, &pcm_input, 256, data, sizeof(data), &output_size));
+        pcm_input.channels[1] = &buffer[1];
+
+        /* コンテナに収まらないビット深度 */
+        parameter.bits_per_sample = 24;
+        EXPECT_EQ(LINNE_APIRESULT_OK, LINNEEncoder_SetEncodeParameter(encoder, &parameter));
+        EXPECT_EQ(LINNE_APIRESULT_INVALID_ARGUMENT,
+                LINNEEncoder_EncodeBlockPCM(encoder, &pcm_input, 256, data, sizeof(data), &output_size));
+
+        LINNEEncoder_Destroy(encoder);
+    }
+}
+
+/* チャンネル並列分析テスト */
+TEST(LINNEEncoderTest, ParallelAnalysisTest)
+{
+    /* スレッド数によらず同一の出力になるか */
+    {
+        struct LINNEEncoder *encoder;
+        struct LINNEEncoderConfig config;
+        struct LINNEEncodeParameter parameter;
+        int32_t *input[LINNE_MAX_NUM_CHANNELS];
+        uint8_t *data, *ref_data;
+        uint32_t ch, smpl, sufficient_size, output_size, ref_output_size, num_threads;
+
+        LINNEEncoder_SetValidEncodeParameter(&parameter);
+        LINNEEncoder_SetValidConfig(&config);
+        parameter.num_channels = 8;
+        parameter.preset = 1;
+
+        /* 十分なデータサイズ */
+        sufficient_size = (2 * parameter.num_channels * parameter.num_samples_per_block * parameter.bits_per_sample) / 8;
+
+        /* データ領域確保 */
+        data = (uint8_t *)malloc(sufficient_size);
+        ref_data = (uint8_t *)malloc(sufficient_size);
+        srand(0);
+        for (ch = 0; ch < parameter.num_channels; ch++) {
+            input[ch] = (int32_t *)malloc(sizeof(int32_t) * parameter.num_samples_per_block);
+            /* チャンネル毎に異なる正弦波+雑音 */
+            for (smpl = 0; smpl < parameter.num_samples_per_block; smpl++) {
+                input[ch][smpl] = (int32_t)(8192.0 * sin(0.01 * (ch + 1) * smpl)) + (rand() % 64) - 32;
+            }
+        }
+
+        /* 単一スレッドでの結果を参照とする */
+        config.max_num_threads = 1;
+        encoder = LINNEEncoder_Create(&config, NULL, 0);
+        ASSERT_TRUE(encoder != NULL);
+        EXPECT_EQ(LINNE_APIRESULT_OK, LINNEEncoder_SetEncodeParameter(encoder, &parameter));
+        EXPECT_EQ(LINNE_APIRESULT_OK,
+                LINNEEncoder_EncodeBlock(encoder, input, parameter.num_samples_per_block,
+                    ref_data, sufficient_size, &ref_output_size));
+        LINNEEncoder_Destroy(encoder);
+
+        for (num_threads = 2; num_threads <= 16; num_threads *= 2) {
+            config.max_num_threads = num_threads;
+            encoder = LINNEEncoder_Create(&config, NULL, 0);
+            ASSERT_TRUE(encoder != NULL);
+            EXPECT_EQ(LINNE_APIRESULT_OK, LINNEEncoder_SetEncodeParameter(encoder, &parameter));
+            EXPECT_EQ(LINNE_APIRESULT_OK,
+                    LINNEEncoder_EncodeBlock(encoder, input, parameter.num_samples_per_block,
+                        data, sufficient_size, &output_size));
+            EXPECT_EQ(ref_output_size, output_size);
+            EXPECT_EQ(0, memcmp(ref_data, data, output_size));
+            LINNEEncoder_Destroy(encoder);
+        }
+
+        /* 領域の開放 */
+        for (ch = 0; ch < parameter.num_channels; ch++) {
+            free(input[ch]);
+        }
+        free(data);
+        free(ref_data);
+    }
+}
+
+/* バッファ確保し直しテスト */
+TEST(LINNEEncoderTest, BufferReallocationTest)
+{
+    /* ワーク領域の与え方やバッファの確保し直しによらず同一の出力になるか */
+    {
+        void *work;
+        int32_t work_size;
+        struct LINNEEncoder *encoder, *ref_encoder;
+        struct LINNEEncoderConfig config;
+        struct LINNEEncodeParameter parameter;
+        int32_t *input[LINNE_MAX_NUM_CHANNELS];
+        uint8_t *data, *ref_data;
+        uint32_t ch, smpl, sufficient_size, output_size, ref_output_size;
+        uint8_t preset;
+
+        LINNEEncoder_SetValidEncodeParameter(&parameter);
+        LINNEEncoder_SetValidConfig(&config);
+        parameter.num_channels = 2;
+        parameter.enable_learning = 0;
+        parameter.num_afmethod_iterations = 0;
+
+        /* 十分なデータサイズ */
+        sufficient_size = (2 * parameter.num_channels * parameter.num_samples_per_block * parameter.bits_per_sample) / 8;
+
+        /* データ領域確保 */
+        data = (uint8_t *)malloc(sufficient_size);
+        ref_data = (uint8_t *)malloc(sufficient_size);
+        srand(0);
+        for (ch = 0; ch < parameter.num_channels; ch++) {
+            input[ch] = (int32_t *)malloc(sizeof(int32_t) * parameter.num_samples_per_block);
+            for (smpl = 0; smpl < parameter.num_samples_per_block; smpl++) {
+                input[ch][smpl] = (int32_t)(8192.0 * sin(0.01 * (ch + 1) * smpl)) + (rand() % 64) - 32;
+            }
+        }
+
+        /* 最大構成のバッファを持つエンコーダを参照とする */
+        work_size = LINNEEncoder_CalculateWorkSize(&config);
+        work = malloc(work_size);
+        ref_encoder = LINNEEncoder_Create(&config, work, work_size);
+        ASSERT_TRUE(ref_encoder != NULL);
+        encoder = LINNEEncoder_Create(&config, NULL, 0);
+        ASSERT_TRUE(encoder != NULL);
+
+        /* プリセットを変えてバッファを確保し直しながらエンコード */
+        for (preset = 0; preset < LINNE_NUM_PARAMETER_PRESETS; preset++) {
+            parameter.preset = preset;
+            EXPECT_EQ(LINNE_APIRESULT_OK, LINNEEncoder_SetEncodeParameter(ref_encoder, &parameter));
+            EXPECT_EQ(LINNE_APIRESULT_OK, LINNEEncoder_SetEncodeParameter(encoder, &parameter));
+            EXPECT_EQ(LINNE_APIRESULT_OK,
+                    LINNEEncoder_EncodeBlock(ref_encoder, input, parameter.num_samples_per_block,
+                        ref_data, sufficient_size, &ref_output_size));
+            EXPECT_EQ(LINNE_APIRESULT_OK,
+                    LINNEEncoder_EncodeBlock(encoder, input, parameter.num_samples_per_block,
+                        data, sufficient_size, &output_size));
+            EXPECT_EQ(ref_output_size, output_size);
+            EXPECT_EQ(0, memcmp(ref_data, data, output_size));
+            /* 端数ブロックの0埋めも確認するため半分のサンプル数もエンコード */
+            EXPECT_EQ(LINNE_APIRESULT_OK,
+                    LINNEEncoder_EncodeBlock(ref_encoder, input, parameter.num_samples_per_block / 2,
+                        ref_data, sufficient_size, &ref_output_size));
+            EXPECT_EQ(LINNE_APIRESULT_OK,
+                    LINNEEncoder_EncodeBlock(encoder, input, parameter.num_samples_per_block / 2,
+                        data, sufficient_size, &output_size));
+            EXPECT_EQ(ref_output_size, output_size);
+            EXPECT_EQ(0, memcmp(ref_data, data, output_size));
+        }
+
+        /* 領域の開放 */
+        LINNEEncoder_Destroy(encoder);
+        LINNEEncoder_Destroy(ref_encoder);
+        free(work);
+        for (ch = 0; ch < parameter.num_channels; ch++) {
+            free(input[ch]);
+        }
+        free(data);
+        free(ref_data);
+    }
+}
@@ -1,4 +1,172 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include <gtest/gtest.h>
+
 /* テスト対象のモジュール */
 extern "C" {
 #include "../../libs/linne_encoder/src/linne_lpc_predict.c"
 }
+
+/* 予測関数の結果がスカラー実装と一致するか確認 */
+static bool LINNELPCPredictTest_CheckPredictUnitFunction(
+    const LINNELPCPredictUnitFunction *function_table, int32_t max_abs_data, int32_t max_abs_coef)
+{
+    uint32_t i, order, num_samples;
+    const uint32_t max_num_samples = 1000;
+    int32_t *data = (int32_t *)malloc(sizeof(int32_t) * max_num_samples);
+    int32_t *ref = (int32_t *)malloc(sizeof(int32_t) * max_num_samples);
+    int32_t *out = (int32_t *)malloc(sizeof(int32_t) * max_num_samples);
+    int32_t coef[LINNELPC_INT16_MAX_ORDER];
+    bool is_ok = true;
+
+    srand(0);
+    for (i = 0; i < max_num_samples; i++) {
+        data[i] = (rand() % (2 * max_abs_data + 1)) - max_abs_data;
+    }
+    /* 値域の端を含める */
+    data[0] = -max_abs_data;
+    data[max_num_samples / 2] = max_abs_data;
+
+    for (order = 1; order <= LINNELPC_INT16_MAX_ORDER; order++) {
+        for (i = 0; i < order; i++) {
+            coef[i] = (rand() % (2 * max_abs_coef + 1)) - max_abs_coef;
+        }
+        for (num_samples = order; num_samples <= max_num_samples; num_samples += 37) {
+            const uint32_t rshift = 1 + (uint32_t)(rand() % 15);
+            const int32_t half = 1 << (rshift - 1);
+            const LINNELPCPredictUnitFunction predict_unit = function_table[LINNELPC_GetFunctionTableIndex(order)];
+            memcpy(ref, data, sizeof(int32_t) * num_samples);
+            memcpy(out, data, sizeof(int32_t) * num_samples);
+            LINNELPC_PredictUnitScalar(data, ref, num_samples - order, coef, order, half, rshift);
+            predict_unit(data, out, num_samples - order, coef, order, half, rshift);
+            if (memcmp(ref, out, sizeof(int32_t) * num_samples) != 0) {
+                is_ok = false;
+                goto EXIT;
+            }
+        }
+    }
+
+EXIT:
+    free(data);
+    free(ref);
+    free(out);
+
+    return is_ok;
+}
+
+/* 次数固定版・SIMD実装の予測結果がスカラー実装と一致するか */
+TEST(LINNELPCPredictTest, PredictUnitFunctionTest)
+{
+    EXPECT_TRUE(LINNELPCPredictTest_CheckPredictUnitFunction(st_predict_unit_scalar_functions, (1 << 16), 127));
+
+#if defined(LINNE_USE_X86_SIMD)
+    const uint32_t features = LINNEUtility_GetCPUFeatures();
+
+    if (features & LINNEUTILITY_CPU_FEATURE_SSE2) {
+        EXPECT_TRUE(LINNELPCPredictTest_CheckPredictUnitFunction(st_predict_unit_int16_sse2_functions, INT16_MAX, 127));
+    }
+    if (features & LINNEUTILITY_CPU_FEATURE_SSE41) {
+        EXPECT_TRUE(LINNELPCPredictTest_CheckPredictUnitFunction(st_predict_unit_sse41_functions, (1 << 16), 127));
+    }
+    if (features & LINNEUTILITY_CPU_FEATURE_AVX2) {
+        EXPECT_TRUE(LINNELPCPredictTest_CheckPredictUnitFunction(st_predict_unit_int16_avx2_functions, INT16_MAX, 127));
+        EXPECT_TRUE(LINNELPCPredictTest_CheckPredictUnitFunction(st_predict_unit_avx2_functions, (1 << 16), 127));
+    }
+#endif
+
+    /* 関数テーブルの参照位置 */
+    EXPECT_EQ(0U, LINNELPC_GetFunctionTableIndex(1));
+    EXPECT_EQ(3U, LINNELPC_GetFunctionTableIndex(8));
+    EXPECT_EQ(7U, LINNELPC_GetFunctionTableIndex(128));
+    EXPECT_EQ((uint32_t)LINNELPC_NUM_SPECIALIZED_ORDERS, LINNELPC_GetFunctionTableIndex(0));
+    EXPECT_EQ((uint32_t)LINNELPC_NUM_SPECIALIZED_ORDERS, LINNELPC_GetFunctionTableIndex(3));
+    EXPECT_EQ((uint32_t)LINNELPC_NUM_SPECIALIZED_ORDERS, LINNELPC_GetFunctionTableIndex(256));
+
+    /* 値域判定 */
+    {
+        int32_t data[4] = { 0, INT16_MAX, INT16_MIN, 0 };
+        int32_t coef[2] = { 127, -128 };
+
+        EXPECT_EQ(1, LINNELPC_IsInt16Range(data, 4, coef, 2));
+        data[1] = INT16_MAX + 1;
+        EXPECT_EQ(0, LINNELPC_IsInt16Range(data, 4, coef, 2));
+        data[1] = 0;
+        data[2] = INT16_MIN - 1;
+        EXPECT_EQ(0, LINNELPC_IsInt16Range(data, 4, coef, 2));
+        data[2] = 0;
+        coef[1] = INT16_MIN;
+        EXPECT_EQ(0, LINNELPC_IsInt16Range(data, 4, coef, 2));
+    }
+}
+
+/* 多段予測の結果が層毎の予測と一致するか */
+TEST(LINNELPCPredictTest, PredictCascadeTest)
+{
+    uint32_t i, l, trial;
+    const uint32_t num_layers = 3;
+    const uint32_t coef_orders[3] = { 4, 128, 16 };
+    const uint32_t num_samples_list[] = { 1, 100, 255, 256, 257, 1000, 4096, 4099 };
+    const uint32_t num_units_list[][3] = {
+        { 1, 1, 1 }, { 2, 4, 8 }, { 4, 32, 16 }, { 1, 128, 1 }, { 4, 1, 16 }, { 2, 2, 2 }
+    };
+    int32_t *coefs[3];
+    int32_t *layer_buffers[3];
+    const uint32_t coef_rshifts[3] = { 8, 7, 6 };
+
+    srand(0);
+
+    for (l = 0; l < num_layers; l++) {
+        coefs[l] = (int32_t *)malloc(sizeof(int32_t) * coef_orders[l]);
+        /* 履歴領域は全層の最大次数分 */
+        layer_buffers[l] = (int32_t *)malloc(sizeof(int32_t) * (coef_orders[1] + LINNELPC_CASCADE_TILE_SIZE));
+    }
+
+    for (trial = 0; trial < sizeof(num_samples_list) / sizeof(num_samples_list[0]); trial++) {
+        uint32_t u;
+        const uint32_t num_samples = num_samples_list[trial];
+        int32_t *data = (int32_t *)malloc(sizeof(int32_t) * num_samples);
+        int32_t *ref = (int32_t *)malloc(sizeof(int32_t) * num_samples);
+        int32_t *tmp = (int32_t *)malloc(sizeof(int32_t) * num_samples);
+        int32_t *residual = (int32_t *)malloc(sizeof(int32_t) * num_samples);
+
+        for (u = 0; u < sizeof(num_units_list) / sizeof(num_units_list[0]); u++) {
+            for (l = 0; l < num_layers; l++) {
+                for (i = 0; i < coef_orders[l]; i++) {
+                    coefs[l][i] = (rand() % 7) - 3;
+                }
+            }
+            /* 途中の層で16bitの範囲を超えるよう振幅を取る */
+            for (i = 0; i < num_samples; i++) {
+                data[i] = (rand() % (1 << 15)) - (1 << 14);
+            }
+
+            /* 層毎に予測した結果を参照値とする */
+            memcpy(tmp, data, sizeof(int32_t) * num_samples);
+            for (l = 0; l < num_layers; l++) {
+                /* ユニットあたりのサンプル数が次数に満たない場合は予測しない */
+                if ((num_samples / num_units_list[u][l]) >= (coef_orders[l] / num_units_list[u][l])) {
+                    LINNELPC_Predict(tmp, num_samples, coefs[l], coef_orders[l], ref, coef_rshifts[l], num_units_list[u][l]);
+                } else {
+                    memcpy(ref, tmp, sizeof(int32_t) * num_samples);
+                }
+                memcpy(tmp, ref, sizeof(int32_t) * num_samples);
+            }
+
+            LINNELPC_PredictCascade(data, num_samples,
+                    coefs, coef_orders, coef_rshifts, num_units_list[u], num_layers, residual, layer_buffers);
+
+            EXPECT_EQ(0, memcmp(ref, residual, sizeof(int32_t) * num_samples));
+        }
+
+        free(data);
+        free(ref);
+        free(tmp);
+        free(residual);
+    }
+
+    for (l = 0; l < num_layers; l++) {
+        free(coefs[l]);
+        free(layer_buffers[l]);
+    }
+}
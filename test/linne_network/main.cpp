@@ -1,5 +1,6 @@
 #include <stdlib.h>
 #include <string.h>
+#include <math.h>
 
 #include <gtest/gtest.h>
 
@@ -40,6 +41,8 @@ TEST(LINNENetworkTest, CreateDestroyHandleTest)
         EXPECT_TRUE(net->layers_work != NULL);
         EXPECT_TRUE(net->lpcc != NULL);
         EXPECT_TRUE(net->data_buffer != NULL);
+        EXPECT_TRUE(net->backward_buffer != NULL);
+        EXPECT_TRUE(net->din_buffers != NULL);
         EXPECT_EQ(net->max_num_samples, 1024);
         EXPECT_EQ(net->max_num_layers, 10);
         EXPECT_EQ(net->max_num_params, 128);
@@ -78,6 +81,129 @@ TEST(LINNENetworkTest, CreateDestroyHandleTest)
 
 }
 
+/* 1層分の予測を素朴に計算（参照用） */
+static void LINNENetworkTest_ReferenceForward(
+        const double *params, uint32_t num_params, double *data, uint32_t num_samples)
+{
+    uint32_t i, j;
+    double *input = (double *)malloc(sizeof(double) * num_samples);
+
+    memcpy(input, data, sizeof(double) * num_samples);
+    for (i = 1; i < num_samples; i++) {
+        double predict = 0.0;
+        for (j = 0; j < num_params; j++) {
+            /* 範囲外の入力は0とみなす */
+            if (i + j >= num_params) {
+                predict += params[j] * input[i + j - num_params];
+            }
+        }
+        data[i] += predict;
+    }
+
+    free(input);
+}
+
+/* 順行伝播・学習テスト */
+TEST(LINNENetworkTest, ForwardBackwardTest)
+{
+    /* ロス計算結果が素朴な計算と一致するか */
+    {
+        void *work;
+        int32_t work_size;
+        struct LINNENetwork *net;
+        uint32_t l, i, smpl;
+        double loss, ref_loss;
+        double *data, *ref_data;
+        const uint32_t num_samples = 256;
+        const uint32_t num_params_list[] = { 8, 4, 2 };
+        const uint32_t num_layers = sizeof(num_params_list) / sizeof(num_params_list[0]);
+
+        work_size = LINNENetwork_CalculateWorkSize(num_samples, num_layers, 8);
+        work = malloc(work_size);
+        net = LINNENetwork_Create(num_samples, num_layers, 8, work, work_size);
+        ASSERT_TRUE(net != NULL);
+        LINNENetwork_SetLayerStructure(net, num_samples, num_layers, num_params_list);
+
+        /* パラメータ設定 */
+        for (l = 0; l < num_layers; l++) {
+            for (i = 0; i < num_params_list[l]; i++) {
+                net->layers[l]->params[i] = 0.1 * sin(0.5 * (l + 1) * (i + 1));
+            }
+        }
+
+        data = (double *)malloc(sizeof(double) * num_samples);
+        ref_data = (double *)malloc(sizeof(double) * num_samples);
+        for (smpl = 0; smpl < num_samples; smpl++) {
+            data[smpl] = ref_data[smpl] = sin(0.05 * smpl) + 0.01 * ((smpl * 7) % 5);
+        }
+
+        loss = LINNENetwork_CalculateLoss(net, data, num_samples);
+        for (l = 0; l < num_layers; l++) {
+            /* 各層の入力が保持されているか */
+            for (smpl = 0; smpl < num_samples; smpl++) {
+                EXPECT_DOUBLE_EQ(ref_data[smpl], net->layers[l]->din[smpl]);
+            }
+            LINNENetworkTest_ReferenceForward(net->layers[l]->params, num_params_list[l], ref_data, num_samples);
+        }
+        ref_loss = 0.0;
+        for (smpl = 0; smpl < num_samples; smpl++) {
+            EXPECT_DOUBLE_EQ(ref_data[smpl], data[smpl]);
+            ref_loss += fabs(ref_data[smpl]);
+        }
+        EXPECT_DOUBLE_EQ(ref_loss / num_samples, loss);
+
+        free(data);
+        free(ref_data);
+        LINNENetwork_Destroy(net);
+        free(work);
+    }
+
+    /* 学習によりロスが減少するか */
+    {
+        void *work, *trainer_work;
+        int32_t work_size, trainer_work_size;
+        struct LINNENetwork *net;
+        struct LINNENetworkTrainer *trainer;
+        uint32_t smpl;
+        double before_loss, after_loss;
+        double *input, *data;
+        const uint32_t num_samples = 256;
+        const uint32_t num_params_list[] = { 8, 4, 2 };
+        const uint32_t num_layers = sizeof(num_params_list) / sizeof(num_params_list[0]);
+
+        work_size = LINNENetwork_CalculateWorkSize(num_samples, num_layers, 8);
+        work = malloc(work_size);
+        net = LINNENetwork_Create(num_samples, num_layers, 8, work, work_size);
+        ASSERT_TRUE(net != NULL);
+        trainer_work_size = LINNENetworkTrainer_CalculateWorkSize(num_layers, 8);
+        trainer_work = malloc(trainer_work_size);
+        trainer = LINNENetworkTrainer_Create(num_layers, 8, trainer_work, trainer_work_size);
+        ASSERT_TRUE(trainer != NULL);
+        LINNENetwork_SetLayerStructure(net, num_samples, num_layers, num_params_list);
+        LINNENetwork_ResetParameters(net);
+
+        input = (double *)malloc(sizeof(double) * num_samples);
+        data = (double *)malloc(sizeof(double) * num_samples);
+        for (smpl = 0; smpl < num_samples; smpl++) {
+            input[smpl] = sin(0.05 * smpl);
+        }
+
+        memcpy(data, input, sizeof(double) * num_samples);
+        before_loss = LINNENetwork_CalculateLoss(net, data, num_samples);
+        LINNENetworkTrainer_Train(trainer, net, input, num_samples, 100, 0.1, 0.0);
+        memcpy(data, input, sizeof(double) * num_samples);
+        after_loss = LINNENetwork_CalculateLoss(net, data, num_samples);
+        EXPECT_LT(after_loss, before_loss);
+
+        free(input);
+        free(data);
+        LINNENetworkTrainer_Destroy(trainer);
+        LINNENetwork_Destroy(net);
+        free(trainer_work);
+        free(work);
+    }
+}
+
 /* トレーナーハンドル作成破棄テスト */
 TEST(LINNENetworkTrainer, CreateDestroyHandleTest)
 {
@@ -3,6 +3,8 @@
 
 #include <gtest/gtest.h>
 
+#include "../common/test_allocator.h"
+
 /* テスト対象のモジュール */
 extern "C" {
 #include "../../libs/lpc/src/lpc.c"
@@ -19,6 +21,7 @@ TEST(LPCCalculatorTest, CreateDestroyHandleTest)
         /* 最低限構造体本体よりは大きいはず */
         config.max_order = 1;
         config.max_num_samples = 1;
+        config.allocator = NULL;
         work_size = LPCCalculator_CalculateWorkSize(&config);
         ASSERT_TRUE(work_size > sizeof(struct LPCCalculator));
 
@@ -35,6 +38,7 @@ TEST(LPCCalculatorTest, CreateDestroyHandleTest)
 
         config.max_order = 1;
         config.max_num_samples = 1;
+        config.allocator = NULL;
         work_size = LPCCalculator_CalculateWorkSize(&config);
         work = malloc(work_size);
 
@@ -54,6 +58,7 @@ TEST(LPCCalculatorTest, CreateDestroyHandleTest)
 
         config.max_order = 1;
         config.max_num_samples = 1;
+        config.allocator = NULL;
         lpcc = LPCCalculator_Create(&config, NULL, 0);
         ASSERT_TRUE(lpcc != NULL);
         EXPECT_TRUE(lpcc->work != NULL);
@@ -71,6 +76,7 @@ TEST(LPCCalculatorTest, CreateDestroyHandleTest)
 
         config.max_order = 1;
         config.max_num_samples = 1;
+        config.allocator = NULL;
         work_size = LPCCalculator_CalculateWorkSize(&config);
         work = malloc(work_size);
 
@@ -83,7 +89,7 @@ TEST(LPCCalculatorTest, CreateDestroyHandleTest)
         EXPECT_TRUE(lpcc == NULL);
 
         /* コンフィグパラメータが不正 */
-        config.max_order = 0; config.max_num_samples = 1;
+        config.max_order = 0; config.max_num_samples = 1; config.allocator = NULL;
         lpcc = LPCCalculator_Create(&config, work, work_size);
         EXPECT_TRUE(lpcc == NULL);
         config.max_order = 1; config.max_num_samples = 0;
@@ -99,13 +105,51 @@ TEST(LPCCalculatorTest, CreateDestroyHandleTest)
         struct LPCCalculatorConfig config;
 
         /* コンフィグパラメータが不正 */
-        config.max_order = 0; config.max_num_samples = 1;
+        config.max_order = 0; config.max_num_samples = 1; config.allocator = NULL;
         lpcc = LPCCalculator_Create(&config, NULL, 0);
         EXPECT_TRUE(lpcc == NULL);
         config.max_order = 1; config.max_num_samples = 0;
         lpcc = LPCCalculator_Create(&config, NULL, 0);
         EXPECT_TRUE(lpcc == NULL);
     }
+
+    /* アロケータ指定による自前確保 */
+    {
+        struct LPCCalculator *lpcc;
+        struct LPCCalculatorConfig config;
+        struct LPCAllocator allocator;
+        struct TestAllocatorContext context = { 0, 0 };
+
+        allocator.malloc_func = TestAllocator_Malloc;
+        allocator.free_func = TestAllocator_Free;
+        allocator.context = &context;
+        config.max_order = 1;
+        config.max_num_samples = 1;
+        config.allocator = &allocator;
+
+        lpcc = LPCCalculator_Create(&config, NULL, 0);
+        ASSERT_TRUE(lpcc != NULL);
+        EXPECT_EQ(1, lpcc->alloced_by_own);
+        EXPECT_EQ(1, context.num_alloc);
+        EXPECT_EQ(0, context.num_free);
+
+        LPCCalculator_Destroy(lpcc);
+        EXPECT_EQ(1, context.num_alloc);
+        EXPECT_EQ(1, context.num_free);
+
+        /* 確保・解放関数の片方だけの指定は不正 */
+        allocator.malloc_func = NULL;
+        lpcc = LPCCalculator_Create(&config, NULL, 0);
+        EXPECT_TRUE(lpcc == NULL);
+        EXPECT_EQ(1, context.num_alloc);
+
+        /* 確保後にコンフィグ不正で失敗した場合は領域を返す */
+        allocator.malloc_func = TestAllocator_Malloc;
+        config.max_order = 0;
+        lpcc = LPCCalculator_Create(&config, NULL, 0);
+        EXPECT_TRUE(lpcc == NULL);
+        EXPECT_EQ(context.num_alloc, context.num_free);
+    }
 }
 
 /* （テスト用）PARCOR係数をLPC係数に変換 */
@@ -158,7 +202,7 @@ TEST(LPCCalculatorTest, LPC_ConvertLPCandPARCORTest)
             data[i] = sin(0.1 * i);
         }
 
-        config.max_num_samples = NUM_SAMPLES; config.max_order = COEF_ORDER;
+        config.max_num_samples = NUM_SAMPLES; config.max_order = COEF_ORDER; config.allocator = NULL;
         lpcc = LPCCalculator_Create(&config, NULL, 0);
         ASSERT_TRUE(lpcc != NULL);
 
@@ -197,7 +241,7 @@ TEST(LPCCalculatorTest, LPC_ConvertLPCandPARCORTest)
             data[i] = sin(0.1 * i);
         }
 
-        config.max_num_samples = NUM_SAMPLES; config.max_order = COEF_ORDER;
+        config.max_num_samples = NUM_SAMPLES; config.max_order = COEF_ORDER; config.allocator = NULL;
         lpcc = LPCCalculator_Create(&config, NULL, 0);
         ASSERT_TRUE(lpcc != NULL);
 
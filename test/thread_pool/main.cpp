@@ -0,0 +1,315 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include <gtest/gtest.h>
+
+#include "../common/test_allocator.h"
+
+/* テスト対象のモジュール */
+extern "C" {
+#include "../../libs/thread_pool/src/thread_pool.c"
+}
+
+/* テスト用のタスク */
+struct ThreadPoolTestTask {
+    uint32_t index; /* 投入順のインデックス */
+    uint32_t num_threads; /* プールのスレッド数 */
+    uint64_t result; /* 計算結果 */
+    uint32_t thread_index; /* 実行したスレッド番号 */
+    uint32_t *thread_counts; /* スレッド毎の実行中タスク数 */
+    uint8_t is_ok; /* スレッド番号の重複がなかったか */
+};
+
+/* テスト用のタスク関数 インデックスから決まる値を計算する */
+static void ThreadPoolTest_TaskFunction(void *arg, uint32_t thread_index)
+{
+    uint32_t i;
+    uint64_t val;
+    struct ThreadPoolTestTask *task = (struct ThreadPoolTestTask *)arg;
+
+    task->thread_index = thread_index;
+    task->is_ok = 1;
+
+    /* 同じスレッド番号で同時に実行されていないか確認 */
+    if (task->thread_counts != NULL) {
+        if (task->thread_counts[thread_index]++ != 0) {
+            task->is_ok = 0;
+        }
+    }
+
+    /* 負荷を偏らせるため、インデックスに応じて計算量を変える */
+    val = task->index;
+    for (i = 0; i < 1000 * (task->index % 7 + 1); i++) {
+        val = val * 6364136223846793005ULL + 1442695040888963407ULL;
+    }
+    task->result = val;
+
+    if (task->thread_counts != NULL) {
+        task->thread_counts[thread_index]--;
+    }
+}
+
+/* ハンドル作成破棄テスト */
+TEST(ThreadPoolTest, CreateDestroyHandleTest)
+{
+    /* ワークサイズ計算テスト */
+    {
+        int32_t work_size;
+        struct ThreadPoolConfig config;
+
+        /* 最低限構造体本体よりは大きいはず */
+        config.max_num_threads = 1;
+        config.max_num_tasks = 1;
+        config.allocator = NULL;
+        work_size = ThreadPool_CalculateWorkSize(&config);
+        ASSERT_TRUE(work_size > sizeof(struct ThreadPool));
+
+        /* 不正なコンフィグ */
+        EXPECT_TRUE(ThreadPool_CalculateWorkSize(NULL) < 0);
+        config.max_num_tasks = 0;
+        EXPECT_TRUE(ThreadPool_CalculateWorkSize(&config) < 0);
+    }
+
+    /* ワーク領域渡しによるハンドル作成（成功例） */
+    {
+        void *work;
+        int32_t work_size;
+        struct ThreadPoolConfig config;
+        struct ThreadPool *pool;
+
+        config.max_num_threads = 4;
+        config.max_num_tasks = 8;
+        config.allocator = NULL;
+        work_size = ThreadPool_CalculateWorkSize(&config);
+        work = malloc(work_size);
+
+        pool = ThreadPool_Create(&config, work, work_size);
+        ASSERT_TRUE(pool != NULL);
+        EXPECT_TRUE(pool->work == work);
+        EXPECT_EQ(0, pool->alloced_by_own);
+        EXPECT_TRUE(ThreadPool_GetNumThreads(pool) >= 1);
+        EXPECT_TRUE(ThreadPool_GetNumThreads(pool) <= 4);
+
+        ThreadPool_Destroy(pool);
+        free(work);
+    }
+
+    /* 自前確保によるハンドル作成（成功例） */
+    {
+        struct ThreadPool *pool;
+        struct ThreadPoolConfig config;
+
+        config.max_num_threads = 0;
+        config.max_num_tasks = 1;
+        config.allocator = NULL;
+        pool = ThreadPool_Create(&config, NULL, 0);
+        ASSERT_TRUE(pool != NULL);
+        EXPECT_TRUE(pool->work != NULL);
+        EXPECT_EQ(1, pool->alloced_by_own);
+        EXPECT_EQ(1, ThreadPool_GetNumThreads(pool));
+
+        ThreadPool_Destroy(pool);
+    }
+
+    /* ワーク領域渡しによるハンドル作成（失敗ケース） */
+    {
+        void *work;
+        int32_t work_size;
+        struct ThreadPoolConfig config;
+        struct ThreadPool *pool;
+
+        config.max_num_threads = 2;
+        config.max_num_tasks = 2;
+        config.allocator = NULL;
+        work_size = ThreadPool_CalculateWorkSize(&config);
+        work = malloc(work_size);
+
+        /* 引数が不正 */
+        pool = ThreadPool_Create(NULL, work, work_size);
+        EXPECT_TRUE(pool == NULL);
+        pool = ThreadPool_Create(&config, NULL, work_size);
+        EXPECT_TRUE(pool == NULL);
+        pool = ThreadPool_Create(&config, work, 0);
+        EXPECT_TRUE(pool == NULL);
+
+        /* ワークサイズ不足 */
+        pool = ThreadPool_Create(&config, work, work_size - 1);
+        EXPECT_TRUE(pool == NULL);
+
+        /* コンフィグが不正 */
+        config.max_num_tasks = 0;
+        pool = ThreadPool_Create(&config, work, work_size);
+        EXPECT_TRUE(pool == NULL);
+
+        free(work);
+    }
+
+    /* アロケータ指定による自前確保 */
+    {
+        struct ThreadPool *pool;
+        struct ThreadPoolConfig config;
+        struct ThreadPoolAllocator allocator;
+        struct TestAllocatorContext context = { 0, 0 };
+
+        allocator.malloc_func = TestAllocator_Malloc;
+        allocator.free_func = TestAllocator_Free;
+        allocator.context = &context;
+        config.max_num_threads = 2;
+        config.max_num_tasks = 1;
+        config.allocator = &allocator;
+
+        pool = ThreadPool_Create(&config, NULL, 0);
+        ASSERT_TRUE(pool != NULL);
+        EXPECT_EQ(1, pool->alloced_by_own);
+        EXPECT_EQ(1, context.num_alloc);
+        EXPECT_EQ(0, context.num_free);
+
+        ThreadPool_Destroy(pool);
+        EXPECT_EQ(1, context.num_alloc);
+        EXPECT_EQ(1, context.num_free);
+
+        /* 確保・解放関数の片方だけの指定は不正 */
+        allocator.free_func = NULL;
+        pool = ThreadPool_Create(&config, NULL, 0);
+        EXPECT_TRUE(pool == NULL);
+        EXPECT_EQ(1, context.num_alloc);
+    }
+}
+
+/* タスク実行テスト */
+TEST(ThreadPoolTest, SubmitWaitTest)
+{
+    /* 引数が不正 */
+    {
+        struct ThreadPool *pool;
+        struct ThreadPoolConfig config;
+        struct ThreadPoolTaskGroup group;
+        struct ThreadPoolTestTask task;
+
+        config.max_num_threads = 2;
+        config.max_num_tasks = 1;
+        config.allocator = NULL;
+        pool = ThreadPool_Create(&config, NULL, 0);
+        ASSERT_TRUE(pool != NULL);
+        ThreadPool_InitializeTaskGroup(&group);
+
+        EXPECT_EQ(THREADPOOL_APIRESULT_INVALID_ARGUMENT, ThreadPool_Submit(NULL, &group, ThreadPoolTest_TaskFunction, &task));
+        EXPECT_EQ(THREADPOOL_APIRESULT_INVALID_ARGUMENT, ThreadPool_Submit(pool, NULL, ThreadPoolTest_TaskFunction, &task));
+        EXPECT_EQ(THREADPOOL_APIRESULT_INVALID_ARGUMENT, ThreadPool_Submit(pool, &group, NULL, &task));
+        EXPECT_EQ(THREADPOOL_APIRESULT_INVALID_ARGUMENT, ThreadPool_Wait(NULL, &group));
+        EXPECT_EQ(THREADPOOL_APIRESULT_INVALID_ARGUMENT, ThreadPool_Wait(pool, NULL));
+
+        /* タスクの無いグループの待ちはすぐに戻る */
+        EXPECT_EQ(THREADPOOL_APIRESULT_OK, ThreadPool_Wait(pool, &group));
+
+        ThreadPool_Destroy(pool);
+    }
+
+    /* スレッド数・キュー長によらず結果が一致するか */
+    {
+#define NUM_TASKS 200
+        uint32_t i, t, q, r;
+        const uint32_t num_threads_list[] = { 0, 1, 2, 3, 4, 8, 16 };
+        const uint32_t max_num_tasks_list[] = { 1, 4, NUM_TASKS };
+        static struct ThreadPoolTestTask ref_tasks[NUM_TASKS];
+        static struct ThreadPoolTestTask tasks[NUM_TASKS];
+
+        /* 参照値はスレッド無しで直接計算 */
+        for (i = 0; i < NUM_TASKS; i++) {
+            ref_tasks[i].index = i;
+            ref_tasks[i].thread_counts = NULL;
+            ThreadPoolTest_TaskFunction(&ref_tasks[i], 0);
+        }
+
+        for (t = 0; t < sizeof(num_threads_list) / sizeof(num_threads_list[0]); t++) {
+            for (q = 0; q < sizeof(max_num_tasks_list) / sizeof(max_num_tasks_list[0]); q++) {
+                struct ThreadPool *pool;
+                struct ThreadPoolConfig config;
+                uint32_t thread_counts[16];
+                uint32_t num_threads;
+
+                config.max_num_threads = num_threads_list[t];
+                config.max_num_tasks = max_num_tasks_list[q];
+                config.allocator = NULL;
+                pool = ThreadPool_Create(&config, NULL, 0);
+                ASSERT_TRUE(pool != NULL);
+                num_threads = ThreadPool_GetNumThreads(pool);
+                memset(thread_counts, 0, sizeof(thread_counts));
+
+                /* 同じプールで繰り返し使えるか */
+                for (r = 0; r < 3; r++) {
+                    struct ThreadPoolTaskGroup group;
+                    ThreadPool_InitializeTaskGroup(&group);
+                    for (i = 0; i < NUM_TASKS; i++) {
+                        tasks[i].index = i;
+                        tasks[i].num_threads = num_threads;
+                        tasks[i].result = 0;
+                        tasks[i].thread_index = num_threads;
+                        tasks[i].thread_counts = thread_counts;
+                        ASSERT_EQ(THREADPOOL_APIRESULT_OK,
+                                ThreadPool_Submit(pool, &group, ThreadPoolTest_TaskFunction, &tasks[i]));
+                    }
+                    ASSERT_EQ(THREADPOOL_APIRESULT_OK, ThreadPool_Wait(pool, &group));
+                    EXPECT_EQ(0, group.num_pending);
+
+                    for (i = 0; i < NUM_TASKS; i++) {
+                        EXPECT_EQ(ref_tasks[i].result, tasks[i].result);
+                        EXPECT_TRUE(tasks[i].thread_index < num_threads);
+                        EXPECT_EQ(1, tasks[i].is_ok);
+                    }
+                }
+
+                ThreadPool_Destroy(pool);
+            }
+        }
+#undef NUM_TASKS
+    }
+
+    /* 複数のタスクグループを独立に待てるか */
+    {
+#define NUM_TASKS 32
+        uint32_t i;
+        struct ThreadPool *pool;
+        struct ThreadPoolConfig config;
+        struct ThreadPoolTaskGroup groups[2];
+        static struct ThreadPoolTestTask tasks[2][NUM_TASKS];
+        uint64_t ref_results[NUM_TASKS];
+
+        for (i = 0; i < NUM_TASKS; i++) {
+            struct ThreadPoolTestTask ref;
+            ref.index = i;
+            ref.thread_counts = NULL;
+            ThreadPoolTest_TaskFunction(&ref, 0);
+            ref_results[i] = ref.result;
+        }
+
+        config.max_num_threads = 4;
+        config.max_num_tasks = NUM_TASKS;
+        config.allocator = NULL;
+        pool = ThreadPool_Create(&config, NULL, 0);
+        ASSERT_TRUE(pool != NULL);
+
+        ThreadPool_InitializeTaskGroup(&groups[0]);
+        ThreadPool_InitializeTaskGroup(&groups[1]);
+        for (i = 0; i < NUM_TASKS; i++) {
+            tasks[0][i].index = tasks[1][i].index = i;
+            tasks[0][i].thread_counts = tasks[1][i].thread_counts = NULL;
+            ThreadPool_Submit(pool, &groups[0], ThreadPoolTest_TaskFunction, &tasks[0][i]);
+            ThreadPool_Submit(pool, &groups[1], ThreadPoolTest_TaskFunction, &tasks[1][i]);
+        }
+
+        ThreadPool_Wait(pool, &groups[1]);
+        EXPECT_EQ(0, groups[1].num_pending);
+        for (i = 0; i < NUM_TASKS; i++) {
+            EXPECT_EQ(ref_results[i], tasks[1][i].result);
+        }
+        ThreadPool_Wait(pool, &groups[0]);
+        EXPECT_EQ(0, groups[0].num_pending);
+        for (i = 0; i < NUM_TASKS; i++) {
+            EXPECT_EQ(ref_results[i], tasks[0][i].result);
+        }
+
+        ThreadPool_Destroy(pool);
+#undef NUM_TASKS
+    }
+}
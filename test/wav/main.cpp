@@ -3,6 +3,10 @@
 
 #include <gtest/gtest.h>
 
+#if defined(__unix__) || defined(__APPLE__)
+#include <unistd.h>
+#endif
+
 /* テスト対象のモジュール */
 extern "C" {
 #include "../../libs/wav/src/wav.c"
@@ -183,6 +187,73 @@ TEST(WAVTest, WriteTest)
         fclose(fp);
     }
 
+    /* 書き出したバイト列の並びを確認 */
+    {
+        const char            test_filename[] = "test.wav";
+        static const uint32_t bits_list[] = { 8, 16, 24, 32 };
+        static const uint32_t num_channels_list[] = { 1, 2, 3 };
+        struct WAVWriter      writer;
+        struct WAVFileFormat  format;
+        FILE                  *fp;
+        struct WAVFile*       wavfile;
+        uint8_t               bytes[9 * 3 * 4];
+        uint32_t              i_bits, i_ch, ch, sample, i_byte, is_ok;
+
+        for (i_bits = 0; i_bits < sizeof(bits_list) / sizeof(bits_list[0]); i_bits++) {
+            for (i_ch = 0; i_ch < sizeof(num_channels_list) / sizeof(num_channels_list[0]); i_ch++) {
+                const uint32_t bytes_per_sample = bits_list[i_bits] / 8;
+                size_t data_size;
+
+                format.data_format     = WAV_DATA_FORMAT_PCM;
+                format.num_samples     = 9;
+                format.num_channels    = num_channels_list[i_ch];
+                format.sampling_rate   = 48000;
+                format.bits_per_sample = bits_list[i_bits];
+                data_size = format.num_samples * format.num_channels * bytes_per_sample;
+
+                wavfile = WAV_Create(&format);
+                ASSERT_TRUE(wavfile != NULL);
+                for (ch = 0; ch < format.num_channels; ch++) {
+                    for (sample = 0; sample < format.num_samples; sample++) {
+                        WAVFile_PCM(wavfile, sample, ch)
+                            = (int32_t)(0x80000000U + 0x01020304U * (sample * format.num_channels + ch));
+                    }
+                }
+
+                /* PCMデータのみ書き出し */
+                fp = fopen(test_filename, "wb");
+                WAVWriter_Initialize(&writer, fp);
+                EXPECT_EQ(WAV_ERROR_OK, WAVWriter_PutWAVPcmData(&writer, wavfile));
+                WAVWriter_Finalize(&writer);
+                fclose(fp);
+
+                /* インターリーブされたリトルエンディアンの上位バイトが並んでいるか */
+                fp = fopen(test_filename, "rb");
+                ASSERT_EQ(data_size, fread(bytes, sizeof(uint8_t), sizeof(bytes), fp));
+                fclose(fp);
+                is_ok = 1;
+                for (sample = 0; sample < format.num_samples; sample++) {
+                    for (ch = 0; ch < format.num_channels; ch++) {
+                        const uint32_t pcm = (uint32_t)WAVFile_PCM(wavfile, sample, ch);
+                        const uint8_t *pos = &bytes[(sample * format.num_channels + ch) * bytes_per_sample];
+                        for (i_byte = 0; i_byte < bytes_per_sample; i_byte++) {
+                            uint8_t expect = (uint8_t)((pcm >> (8 * (4 - bytes_per_sample + i_byte))) & 0xFF);
+                            if (format.bits_per_sample == 8) {
+                                expect ^= 0x80;
+                            }
+                            if (pos[i_byte] != expect) {
+                                is_ok = 0;
+                            }
+                        }
+                    }
+                }
+                EXPECT_EQ(1, is_ok);
+
+                WAV_Destroy(wavfile);
+            }
+        }
+    }
+
     /* 実ファイルを読み出してそのまま書き出してみる */
     {
         uint32_t ch, is_ok, i_test;
@@ -239,6 +310,508 @@ TEST(WAVTest, WriteTest)
 
 }
 
+/* PCMデータ読み込みテスト */
+TEST(WAVTest, ReadPCMTest)
+{
+    /* 1サンプルずつ読み出した結果と一致するか */
+    {
+        static const char* test_sourcefile_list[] = {
+            "a.wav",
+            "8bit.wav", "16bit.wav", "24bit.wav", "32bit.wav",
+            "8bit_2ch.wav", "16bit_2ch.wav", "24bit_2ch.wav", "32bit_2ch.wav",
+        };
+        uint32_t i_test, ch, smpl, is_ok;
+
+        for (i_test = 0;
+                i_test < sizeof(test_sourcefile_list) / sizeof(test_sourcefile_list[0]);
+                i_test++) {
+            FILE *fp;
+            struct WAVParser parser;
+            struct WAVFileFormat format;
+            struct WAVFile *wavfile;
+            uint64_t bitsbuf;
+            int32_t ref;
+
+            wavfile = WAV_CreateFromFile(test_sourcefile_list[i_test]);
+            ASSERT_TRUE(wavfile != NULL);
+
+            /* ヘッダを読んだ後、1サンプルずつ取得して比較 */
+            fp = fopen(test_sourcefile_list[i_test], "rb");
+            ASSERT_TRUE(fp != NULL);
+            WAVParser_Initialize(&parser, fp);
+            ASSERT_EQ(WAV_ERROR_OK, WAVParser_GetWAVFormat(&parser, &format));
+            is_ok = 1;
+            for (smpl = 0; smpl < format.num_samples; smpl++) {
+                for (ch = 0; ch < format.num_channels; ch++) {
+                    ASSERT_EQ(WAV_ERROR_OK,
+                            WAVParser_GetLittleEndianBytes(&parser, format.bits_per_sample / 8, &bitsbuf));
+                    switch (format.bits_per_sample) {
+                    case 8:  ref = ((int32_t)bitsbuf - 128) << 24; break;
+                    case 16: ref = (int32_t)(bitsbuf << 16); break;
+                    case 24: ref = (int32_t)(bitsbuf << 8); break;
+                    default: ref = (int32_t)bitsbuf; break;
+                    }
+                    if (wavfile->data[ch][smpl] != ref) {
+                        is_ok = 0;
+                    }
+                }
+            }
+            EXPECT_EQ(1, is_ok);
+            WAVParser_Finalize(&parser);
+            fclose(fp);
+
+            WAV_Destroy(wavfile);
+        }
+    }
+
+    /* 半端なサンプル数・チャンネル数のデータを書き出して読み戻す */
+    {
+        static const uint32_t bits_list[] = { 8, 16, 24, 32 };
+        static const uint32_t num_channels_list[] = { 1, 2, 3 };
+        static const uint32_t num_samples_list[] = { 1, 7, 13, 1023 };
+        const char test_filename[] = "tmp.wav";
+        uint32_t i_bits, i_ch, i_smpl, ch, smpl, is_ok;
+
+        for (i_bits = 0; i_bits < sizeof(bits_list) / sizeof(bits_list[0]); i_bits++) {
+            for (i_ch = 0; i_ch < sizeof(num_channels_list) / sizeof(num_channels_list[0]); i_ch++) {
+                for (i_smpl = 0; i_smpl < sizeof(num_samples_list) / sizeof(num_samples_list[0]); i_smpl++) {
+                    struct WAVFileFormat format;
+                    struct WAVFile *src_wavfile, *test_wavfile;
+
+                    format.data_format = WAV_DATA_FORMAT_PCM;
+                    format.bits_per_sample = bits_list[i_bits];
+                    format.num_channels = num_channels_list[i_ch];
+                    format.sampling_rate = 44100;
+                    format.num_samples = num_samples_list[i_smpl];
+                    src_wavfile = WAV_Create(&format);
+                    ASSERT_TRUE(src_wavfile != NULL);
+
+                    /* 正負の値が混ざるように埋める（下位の未使用ビットは0） */
+                    for (ch = 0; ch < format.num_channels; ch++) {
+                        for (smpl = 0; smpl < format.num_samples; smpl++) {
+                            const uint32_t val = (smpl * 0x9E3779B1U) ^ (ch * 0x7F4A7C15U);
+                            src_wavfile->data[ch][smpl]
+                                = (int32_t)(val & ~((1U << (32 - format.bits_per_sample)) - 1U));
+                        }
+                    }
+
+                    ASSERT_EQ(WAV_APIRESULT_OK, WAV_WriteToFile(test_filename, src_wavfile));
+                    test_wavfile = WAV_CreateFromFile(test_filename);
+                    ASSERT_TRUE(test_wavfile != NULL);
+
+                    is_ok = 1;
+                    for (ch = 0; ch < format.num_channels; ch++) {
+                        if (memcmp(src_wavfile->data[ch], test_wavfile->data[ch],
+                                    sizeof(WAVPcmData) * format.num_samples) != 0) {
+                            is_ok = 0;
+                            break;
+                        }
+                    }
+                    EXPECT_EQ(1, is_ok);
+
+                    WAV_Destroy(src_wavfile);
+                    WAV_Destroy(test_wavfile);
+                }
+            }
+        }
+    }
+}
+
+/* ストリーム読み書きテスト */
+TEST(WAVTest, StreamTest)
+{
+    /* 失敗テスト */
+    {
+        struct WAVFileFormat format;
+        struct WAVStream *stream;
+        WAVPcmData *data[1];
+        WAVPcmData buffer[16];
+        uint32_t num_read_samples;
+
+        EXPECT_TRUE(WAV_OpenStreamForRead(NULL, &format) == NULL);
+        EXPECT_TRUE(WAV_OpenStreamForRead("a.wav", NULL) == NULL);
+        EXPECT_TRUE(WAV_OpenStreamForRead("dummy.a.wav.wav", &format) == NULL);
+        EXPECT_TRUE(WAV_OpenStreamForWrite(NULL, &format) == NULL);
+        EXPECT_TRUE(WAV_OpenStreamForWrite("tmp.wav", NULL) == NULL);
+        format.data_format     = WAV_DATA_FORMAT_PCM;
+        format.num_channels    = 1;
+        format.sampling_rate   = 48000;
+        format.bits_per_sample = 3; /* 不正なビット深度 */
+        format.num_samples     = 0;
+        EXPECT_TRUE(WAV_OpenStreamForWrite("tmp.wav", &format) == NULL);
+        EXPECT_EQ(WAV_APIRESULT_INVALID_PARAMETER, WAV_CloseStream(NULL));
+
+        /* 読み書きの向きが違う */
+        data[0] = buffer;
+        format.bits_per_sample = 16;
+        stream = WAV_OpenStreamForWrite("tmp.wav", &format);
+        ASSERT_TRUE(stream != NULL);
+        EXPECT_EQ(WAV_APIRESULT_INVALID_PARAMETER, WAV_ReadStream(stream, data, 16, &num_read_samples));
+        EXPECT_EQ(WAV_APIRESULT_INVALID_PARAMETER, WAV_WriteStream(NULL, data, 16));
+        EXPECT_EQ(WAV_APIRESULT_INVALID_PARAMETER, WAV_WriteStream(stream, NULL, 16));
+        EXPECT_EQ(WAV_APIRESULT_OK, WAV_CloseStream(stream));
+        stream = WAV_OpenStreamForRead("a.wav", &format);
+        ASSERT_TRUE(stream != NULL);
+        EXPECT_EQ(WAV_APIRESULT_INVALID_PARAMETER, WAV_WriteStream(stream, data, 16));
+        EXPECT_EQ(WAV_APIRESULT_INVALID_PARAMETER, WAV_ReadStream(NULL, data, 16, &num_read_samples));
+        EXPECT_EQ(WAV_APIRESULT_INVALID_PARAMETER, WAV_ReadStream(stream, data, 16, NULL));
+        EXPECT_EQ(WAV_APIRESULT_OK, WAV_CloseStream(stream));
+    }
+
+    /* 一括読み込みの結果と一致するか / 逐次書き出したファイルが一致するか */
+    {
+        static const char* test_sourcefile_list[] = {
+            "a.wav",
+            "8bit.wav", "16bit.wav", "24bit.wav", "32bit.wav",
+            "8bit_2ch.wav", "16bit_2ch.wav", "24bit_2ch.wav", "32bit_2ch.wav",
+        };
+        const char test_filename[] = "tmp.wav";
+        const uint32_t num_samples_per_call = 1001;
+        uint32_t i_test, ch, is_ok;
+
+        for (i_test = 0;
+                i_test < sizeof(test_sourcefile_list) / sizeof(test_sourcefile_list[0]);
+                i_test++) {
+            struct WAVFile *src_wavfile, *test_wavfile;
+            struct WAVStream *in_stream, *out_stream;
+            struct WAVFileFormat format, out_format;
+            WAVPcmData *data[8];
+            uint32_t progress, num_read_samples;
+
+            src_wavfile = WAV_CreateFromFile(test_sourcefile_list[i_test]);
+            ASSERT_TRUE(src_wavfile != NULL);
+
+            in_stream = WAV_OpenStreamForRead(test_sourcefile_list[i_test], &format);
+            ASSERT_TRUE(in_stream != NULL);
+            EXPECT_EQ(0, memcmp(&src_wavfile->format, &format, sizeof(struct WAVFileFormat)));
+
+            /* サンプル数は不明として書き出し開始 */
+            out_format = format;
+            out_format.num_samples = 0;
+            out_stream = WAV_OpenStreamForWrite(test_filename, &out_format);
+            ASSERT_TRUE(out_stream != NULL);
+
+            /* 半端なサンプル数ずつ読み込んで比較しつつ書き出し */
+            for (ch = 0; ch < format.num_channels; ch++) {
+                data[ch] = (WAVPcmData *)malloc(sizeof(WAVPcmData) * num_samples_per_call);
+            }
+            is_ok = 1;
+            progress = 0;
+            while (progress < format.num_samples) {
+                ASSERT_EQ(WAV_APIRESULT_OK, WAV_ReadStream(in_stream, data, num_samples_per_call, &num_read_samples));
+                ASSERT_TRUE(num_read_samples > 0);
+                for (ch = 0; ch < format.num_channels; ch++) {
+                    if (memcmp(&src_wavfile->data[ch][progress], data[ch], sizeof(WAVPcmData) * num_read_samples) != 0) {
+                        is_ok = 0;
+                    }
+                }
+                ASSERT_EQ(WAV_APIRESULT_OK, WAV_WriteStream(out_stream, data, num_read_samples));
+                progress += num_read_samples;
+            }
+            EXPECT_EQ(1, is_ok);
+            EXPECT_EQ(format.num_samples, progress);
+
+            /* 末尾では0サンプルが返る */
+            EXPECT_EQ(WAV_APIRESULT_OK, WAV_ReadStream(in_stream, data, num_samples_per_call, &num_read_samples));
+            EXPECT_EQ(0U, num_read_samples);
+
+            EXPECT_EQ(WAV_APIRESULT_OK, WAV_CloseStream(in_stream));
+            EXPECT_EQ(WAV_APIRESULT_OK, WAV_CloseStream(out_stream));
+            for (ch = 0; ch < format.num_channels; ch++) {
+                free(data[ch]);
+            }
+
+            /* 書き出したファイルはヘッダのサイズが確定していて元と一致する */
+            test_wavfile = WAV_CreateFromFile(test_filename);
+            ASSERT_TRUE(test_wavfile != NULL);
+            EXPECT_EQ(0, memcmp(&src_wavfile->format, &test_wavfile->format, sizeof(struct WAVFileFormat)));
+            is_ok = 1;
+            for (ch = 0; ch < format.num_channels; ch++) {
+                if (memcmp(src_wavfile->data[ch], test_wavfile->data[ch],
+                            sizeof(WAVPcmData) * format.num_samples) != 0) {
+                    is_ok = 0;
+                }
+            }
+            EXPECT_EQ(1, is_ok);
+
+            WAV_Destroy(src_wavfile);
+            WAV_Destroy(test_wavfile);
+        }
+    }
+}
+
+/* 開いているファイルに対するストリームのテスト */
+TEST(WAVTest, StreamFpTest)
+{
+    /* 失敗テスト */
+    {
+        struct WAVFileFormat format;
+
+        EXPECT_TRUE(WAV_OpenStreamForReadFromFp(NULL, &format) == NULL);
+        EXPECT_TRUE(WAV_OpenStreamForReadFromFp(stdin, NULL) == NULL);
+        EXPECT_TRUE(WAV_OpenStreamForWriteToFp(NULL, &format) == NULL);
+        EXPECT_TRUE(WAV_OpenStreamForWriteToFp(stdout, NULL) == NULL);
+    }
+
+    /* 書き出し後もファイルは開いたまま / 途中のチャンクを読み飛ばせる / ヘッダより短いファイルは末尾までを読む */
+    {
+        const char test_filename[] = "tmp_fp.wav";
+        struct WAVFile *src_wavfile;
+        struct WAVStream *stream;
+        struct WAVFileFormat format;
+        WAVPcmData *data[2];
+        uint32_t ch, num_read_samples, is_ok;
+        uint8_t *bytes;
+        long file_size;
+        FILE *fp;
+
+        src_wavfile = WAV_CreateFromFile("16bit_2ch.wav");
+        ASSERT_TRUE(src_wavfile != NULL);
+
+        /* サンプル数を実際の2倍としてヘッダを書き、シーク可能なのでクローズ時に書き直される */
+        format = src_wavfile->format;
+        format.num_samples *= 2;
+        fp = fopen(test_filename, "wb");
+        ASSERT_TRUE(fp != NULL);
+        stream = WAV_OpenStreamForWriteToFp(fp, &format);
+        ASSERT_TRUE(stream != NULL);
+        EXPECT_EQ(WAV_APIRESULT_OK, WAV_WriteStream(stream, src_wavfile->data, (uint32_t)src_wavfile->format.num_samples));
+        EXPECT_EQ(WAV_APIRESULT_OK, WAV_CloseStream(stream));
+        /* ファイルは閉じられていない */
+        EXPECT_EQ(0, fseek(fp, 0, SEEK_END));
+        file_size = ftell(fp);
+        EXPECT_EQ(44 + src_wavfile->format.num_samples * 4, (uint64_t)file_size);
+        fclose(fp);
+
+        /* fmtチャンクの後に未知のチャンクを挟み、dataチャンクのサイズを実際の2倍に書き換える */
+        bytes = (uint8_t *)malloc((size_t)file_size + 12);
+        fp = fopen(test_filename, "rb");
+        ASSERT_EQ((size_t)file_size, fread(bytes, sizeof(uint8_t), (size_t)file_size, fp));
+        fclose(fp);
+        memmove(&bytes[36 + 12], &bytes[36], (size_t)file_size - 36);
+        memcpy(&bytes[36], "JUNK\x04\x00\x00\x00\x01\x02\x03\x04", 12);
+        {
+            const uint32_t data_size = (uint32_t)(src_wavfile->format.num_samples * 4 * 2);
+            bytes[48 + 4] = (uint8_t)((data_size >>  0) & 0xFF);
+            bytes[48 + 5] = (uint8_t)((data_size >>  8) & 0xFF);
+            bytes[48 + 6] = (uint8_t)((data_size >> 16) & 0xFF);
+            bytes[48 + 7] = (uint8_t)((data_size >> 24) & 0xFF);
+        }
+        fp = fopen(test_filename, "wb");
+        fwrite(bytes, sizeof(uint8_t), (size_t)file_size + 12, fp);
+        fclose(fp);
+        free(bytes);
+
+        /* 開いたファイルから読み込み */
+        fp = fopen(test_filename, "rb");
+        ASSERT_TRUE(fp != NULL);
+        stream = WAV_OpenStreamForReadFromFp(fp, &format);
+        ASSERT_TRUE(stream != NULL);
+        EXPECT_EQ(src_wavfile->format.num_samples * 2, format.num_samples);
+        for (ch = 0; ch < 2; ch++) {
+            data[ch] = (WAVPcmData *)malloc(sizeof(WAVPcmData) * format.num_samples);
+        }
+        /* 実際のサンプル数だけ読める */
+        EXPECT_EQ(WAV_APIRESULT_OK, WAV_ReadStream(stream, data, (uint32_t)format.num_samples, &num_read_samples));
+        EXPECT_EQ(src_wavfile->format.num_samples, num_read_samples);
+        is_ok = 1;
+        for (ch = 0; ch < 2; ch++) {
+            if (memcmp(src_wavfile->data[ch], data[ch], sizeof(WAVPcmData) * num_read_samples) != 0) {
+                is_ok = 0;
+            }
+        }
+        EXPECT_EQ(1, is_ok);
+        /* 以降は0サンプル */
+        EXPECT_EQ(WAV_APIRESULT_OK, WAV_ReadStream(stream, data, 16, &num_read_samples));
+        EXPECT_EQ(0U, num_read_samples);
+        EXPECT_EQ(WAV_APIRESULT_OK, WAV_CloseStream(stream));
+        fclose(fp);
+
+        for (ch = 0; ch < 2; ch++) {
+            free(data[ch]);
+        }
+        WAV_Destroy(src_wavfile);
+    }
+
+#if defined(__unix__) || defined(__APPLE__)
+    /* シークできない入力でサイズが仮の値なら、仮のサイズを超えてファイル末尾まで読む */
+    {
+#define NUM_TEST_SAMPLES 1000
+        static const uint32_t placeholder_list[] = { 0, 0xFFFFFFFFUL };
+        uint32_t i, smpl, ch, num_read_samples, is_ok;
+        uint8_t bytes[44 + NUM_TEST_SAMPLES * 4];
+        struct WAVStream *stream;
+        struct WAVFileFormat format;
+        WAVPcmData *data[2];
+        int fds[2];
+        FILE *fp;
+
+        for (ch = 0; ch < 2; ch++) {
+            data[ch] = (WAVPcmData *)malloc(sizeof(WAVPcmData) * NUM_TEST_SAMPLES * 2);
+        }
+
+        for (i = 0; i < sizeof(placeholder_list) / sizeof(placeholder_list[0]); i++) {
+            const uint32_t data_size = placeholder_list[i];
+
+            /* 16bit 2chのヘッダとPCMデータを作る（読み込み後は上位16bitに入る） */
+            memcpy(bytes, "RIFF\xFF\xFF\xFF\xFFWAVEfmt \x10\x00\x00\x00\x01\x00\x02\x00"
+                    "\x44\xAC\x00\x00\x10\xB1\x02\x00\x04\x00\x10\x00" "data", 40);
+            bytes[40] = (uint8_t)((data_size >>  0) & 0xFF);
+            bytes[41] = (uint8_t)((data_size >>  8) & 0xFF);
+            bytes[42] = (uint8_t)((data_size >> 16) & 0xFF);
+            bytes[43] = (uint8_t)((data_size >> 24) & 0xFF);
+            for (smpl = 0; smpl < NUM_TEST_SAMPLES * 2; smpl++) {
+                bytes[44 + 2 * smpl + 0] = (uint8_t)(smpl & 0xFF);
+                bytes[44 + 2 * smpl + 1] = (uint8_t)((smpl >> 8) & 0xFF);
+            }
+
+            /* パイプに全て書き込んでから読み込み側を開く */
+            ASSERT_EQ(0, pipe(fds));
+            ASSERT_EQ((ssize_t)sizeof(bytes), write(fds[1], bytes, sizeof(bytes)));
+            close(fds[1]);
+            fp = fdopen(fds[0], "rb");
+            ASSERT_TRUE(fp != NULL);
+
+            stream = WAV_OpenStreamForReadFromFp(fp, &format);
+            ASSERT_TRUE(stream != NULL);
+            EXPECT_EQ(WAV_NUM_SAMPLES_UNKNOWN, format.num_samples);
+
+            /* 仮のサイズから求まるサンプル数を読み終えたことにしても、続きが読める */
+            stream->num_processed_samples = 0xFFFFFFFFUL / 4;
+            EXPECT_EQ(WAV_APIRESULT_OK, WAV_ReadStream(stream, data, NUM_TEST_SAMPLES * 2, &num_read_samples));
+            EXPECT_EQ((uint32_t)NUM_TEST_SAMPLES, num_read_samples);
+            is_ok = 1;
+            for (smpl = 0; smpl < NUM_TEST_SAMPLES; smpl++) {
+                for (ch = 0; ch < 2; ch++) {
+                    if (data[ch][smpl] != (WAVPcmData)((2 * smpl + ch) << 16)) {
+                        is_ok = 0;
+                    }
+                }
+            }
+            EXPECT_EQ(1, is_ok);
+            /* 以降は0サンプル */
+            EXPECT_EQ(WAV_APIRESULT_OK, WAV_ReadStream(stream, data, 16, &num_read_samples));
+            EXPECT_EQ(0U, num_read_samples);
+
+            EXPECT_EQ(WAV_APIRESULT_OK, WAV_CloseStream(stream));
+            fclose(fp);
+        }
+
+        for (ch = 0; ch < 2; ch++) {
+            free(data[ch]);
+        }
+#undef NUM_TEST_SAMPLES
+    }
+#endif
+}
+
+/* RF64形式の読み書きテスト */
+TEST(WAVTest, RF64Test)
+{
+    /* RF64形式が必要なサイズの判定 */
+    {
+        struct WAVFileFormat format;
+
+        format.data_format     = WAV_DATA_FORMAT_PCM;
+        format.num_channels    = 1;
+        format.sampling_rate   = 48000;
+        format.bits_per_sample = 8;
+        format.num_samples     = 48000;
+        EXPECT_EQ(0, WAV_IsRF64Required(&format));
+        format.num_samples     = WAV_RIFF_MAX_PCM_DATA_SIZE;
+        EXPECT_EQ(0, WAV_IsRF64Required(&format));
+        format.num_samples     = WAV_RIFF_MAX_PCM_DATA_SIZE + 1;
+        EXPECT_EQ(1, WAV_IsRF64Required(&format));
+        format.num_channels    = 2;
+        format.bits_per_sample = 16;
+        format.num_samples     = (uint64_t)1 << 32;
+        EXPECT_EQ(1, WAV_IsRF64Required(&format));
+    }
+
+    /* RIFF形式を指定して表現できないサイズを書き出そうとした */
+    {
+        const char            test_filename[] = "test.wav";
+        struct WAVWriter      writer;
+        struct WAVFileFormat  format;
+        FILE                  *fp;
+
+        format.data_format     = WAV_DATA_FORMAT_PCM;
+        format.num_channels    = 2;
+        format.sampling_rate   = 48000;
+        format.bits_per_sample = 16;
+        format.num_samples     = (uint64_t)1 << 32;
+
+        fp = fopen(test_filename, "wb");
+        WAVWriter_Initialize(&writer, fp);
+        EXPECT_EQ(WAV_ERROR_INVALID_FORMAT, WAVWriter_PutWAVHeaderCore(&writer, &format, 0));
+        EXPECT_EQ(WAV_ERROR_OK, WAVWriter_PutWAVHeaderCore(&writer, &format, 1));
+        WAVWriter_Finalize(&writer);
+        fclose(fp);
+    }
+
+    /* RF64形式で書き出したファイルを読み戻す */
+    {
+        static const char* test_sourcefile_list[] = {
+            "8bit.wav", "16bit_2ch.wav", "24bit.wav", "32bit_2ch.wav",
+        };
+        const char test_filename[] = "tmp_rf64.wav";
+        uint32_t i_test, ch, is_ok;
+
+        for (i_test = 0;
+                i_test < sizeof(test_sourcefile_list) / sizeof(test_sourcefile_list[0]);
+                i_test++) {
+            struct WAVWriter writer;
+            struct WAVFile *src_wavfile, *test_wavfile;
+            struct WAVStream *stream;
+            struct WAVFileFormat format;
+            uint8_t head[16];
+            FILE *fp;
+
+            src_wavfile = WAV_CreateFromFile(test_sourcefile_list[i_test]);
+            ASSERT_TRUE(src_wavfile != NULL);
+
+            /* 小さいサイズでもRF64形式で書き出す */
+            fp = fopen(test_filename, "wb");
+            WAVWriter_Initialize(&writer, fp);
+            ASSERT_EQ(WAV_ERROR_OK, WAVWriter_PutWAVHeaderCore(&writer, &src_wavfile->format, 1));
+            ASSERT_EQ(WAV_ERROR_OK, WAVWriter_PutWAVPcmData(&writer, src_wavfile));
+            WAVWriter_Finalize(&writer);
+            fclose(fp);
+
+            /* 先頭はRF64とds64チャンク */
+            fp = fopen(test_filename, "rb");
+            ASSERT_EQ(sizeof(head), fread(head, sizeof(uint8_t), sizeof(head), fp));
+            fclose(fp);
+            EXPECT_EQ(0, memcmp(&head[0], "RF64", 4));
+            EXPECT_EQ(0, memcmp(&head[4], "\xFF\xFF\xFF\xFF", 4));
+            EXPECT_EQ(0, memcmp(&head[8], "WAVE", 4));
+            EXPECT_EQ(0, memcmp(&head[12], "ds64", 4));
+
+            /* フォーマットとPCMの一致確認 */
+            test_wavfile = WAV_CreateFromFile(test_filename);
+            ASSERT_TRUE(test_wavfile != NULL);
+            EXPECT_EQ(0, memcmp(&src_wavfile->format, &test_wavfile->format, sizeof(struct WAVFileFormat)));
+            is_ok = 1;
+            for (ch = 0; ch < src_wavfile->format.num_channels; ch++) {
+                if (memcmp(src_wavfile->data[ch], test_wavfile->data[ch],
+                            sizeof(WAVPcmData) * src_wavfile->format.num_samples) != 0) {
+                    is_ok = 0;
+                }
+            }
+            EXPECT_EQ(1, is_ok);
+
+            /* ストリームでも同じフォーマットが得られる */
+            stream = WAV_OpenStreamForRead(test_filename, &format);
+            ASSERT_TRUE(stream != NULL);
+            EXPECT_EQ(0, memcmp(&src_wavfile->format, &format, sizeof(struct WAVFileFormat)));
+            EXPECT_EQ(WAV_APIRESULT_OK, WAV_CloseStream(stream));
+
+            WAV_Destroy(src_wavfile);
+            WAV_Destroy(test_wavfile);
+        }
+    }
+}
+
 int main(int argc, char **argv)
 {
     ::testing::InitGoogleTest(&argc, argv);
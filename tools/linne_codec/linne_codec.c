@@ -2,14 +2,90 @@
 #include <linne_decoder.h>
 #include "wav.h"
 #include "command_line_parser.h"
+#include "thread_pool.h"
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <ctype.h>
 #include <sys/stat.h>
+#if defined(_WIN32)
+#include <windows.h>
+#include <io.h>
+#include <fcntl.h>
+#elif defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/time.h>
+#include <sys/mman.h>
+#include <pthread.h>
+#else
+#include <time.h>
+#endif
+
+/* 入力ファイルのメモリマップの利用可否 LINNECODEC_NO_MMAPの定義で無効化 */
+#if !defined(LINNECODEC_NO_MMAP) && (defined(_WIN32) || defined(__unix__) || defined(__APPLE__))
+#define LINNECODEC_USE_MMAP 1
+#endif
+
+/* バッチ処理のジョブ取り出しの排他の利用可否 */
+#if defined(_WIN32) || defined(__unix__) || defined(__APPLE__)
+#define LINNECODEC_USE_LOCK 1
+#endif
+
+/* ディレクトリ判定マクロが無い環境向け */
+#if !defined(S_ISDIR)
+#define S_ISDIR(mode) (((mode) & S_IFMT) == S_IFDIR)
+#endif
 
 /* a, bのうち小さい方を選択 */
 #define LINNECODEC_MIN(a, b) (((a) < (b)) ? (a) : (b))
+/* a, bのうち大きい方を選択 */
+#define LINNECODEC_MAX(a, b) (((a) > (b)) ? (a) : (b))
+
+/* エンコード結果をまとめて書き出す単位 */
+#define LINNECODEC_OUTPUT_BUFFER_SIZE (1024 * 1024)
+/* ブロック先頭の同期コードとブロックサイズのバイト数 */
+#define LINNECODEC_BLOCK_HEADER_SIZE 6
+/* ブロック先頭からブロックチャンネルあたりサンプル数までのバイト数 */
+#define LINNECODEC_BLOCK_NUM_SAMPLES_OFFSET 9
+/* パイプラインで同時に処理するスレッドあたりのブロック数 */
+#define LINNECODEC_NUM_BLOCKS_PER_THREAD 4
+/* コア数が取得できない時のスレッド数 呼び出し元スレッドが読み込む間にもう1スレッドで変換と書き出しを進める */
+#define LINNECODEC_DEFAULT_NUM_THREADS 2
+/* 指定できる最大スレッド数 */
+#define LINNECODEC_MAX_NUM_THREADS 256
+/* スレッド数の自動選択を表す値 */
+#define LINNECODEC_NUM_THREADS_AUTO 0
+/* 標準入出力を表すファイル名 */
+#define LINNECODEC_STDIO_FILENAME "-"
+/* 標準入出力を指定したか */
+#define LINNECODEC_IS_STDIO(filename) (strcmp((filename), LINNECODEC_STDIO_FILENAME) == 0)
+/* バッチ処理で扱うブロックあたりサンプル数の上限 */
+#define LINNECODEC_BATCH_MAX_NUM_SAMPLES_PER_BLOCK (16 * 1024)
+/* リストファイルの1行の最大長 */
+#define LINNECODEC_BATCH_MAX_PATH_LENGTH 4096
+
+/* 入力ファイル */
+/* マップできた時はマップ領域を直接参照し、できなかった時はバッファに読み込む */
+struct LINNECodecInputFile {
+    FILE *fp; /* 逐次読み込み用のファイル */
+    uint8_t own_fp; /* クローズ時にファイルを閉じるか */
+    uint8_t *buffer; /* 逐次読み込み用のバッファ */
+    uint32_t buffer_size; /* 逐次読み込み用のバッファサイズ */
+    const uint8_t *data; /* マップした領域の先頭 マップしていなければNULL */
+    uint64_t data_size; /* マップした領域のサイズ */
+    uint64_t read_pos; /* マップした領域の読み込み位置 */
+#if defined(LINNECODEC_USE_MMAP)
+#if defined(_WIN32)
+    HANDLE file; /* ファイルハンドル */
+    HANDLE mapping; /* マッピングハンドル */
+#else
+    int fd; /* ファイルディスクリプタ */
+#endif
+#endif
+};
 
 /* コマンドライン仕様 */
 static struct CommandLineParserSpecification command_line_spec[] = {
@@ -25,6 +101,10 @@ static struct CommandLineParserSpecification command_line_spec[] = {
         COMMAND_LINE_PARSER_TRUE, "0", COMMAND_LINE_PARSER_FALSE },
     { 'c', "no-crc-check", "Whether to NOT check CRC16 at decoding (default:no)",
         COMMAND_LINE_PARSER_FALSE, NULL, COMMAND_LINE_PARSER_FALSE },
+    { 'j', "threads", "Specify number of threads, or auto to decide from processors and blocks (default:auto)",
+        COMMAND_LINE_PARSER_TRUE, "auto", COMMAND_LINE_PARSER_FALSE },
+    { 'b', "batch", "Batch mode: process all files in INPUT (a directory or a list file) into OUTPUT directory",
+        COMMAND_LINE_PARSER_FALSE, NULL, COMMAND_LINE_PARSER_FALSE },
     { 'h', "help", "Show command help message",
         COMMAND_LINE_PARSER_FALSE, NULL, COMMAND_LINE_PARSER_FALSE },
     { 'v', "version", "Show version information",
@@ -32,246 +112,1734 @@ static struct CommandLineParserSpecification command_line_spec[] = {
     { 0, NULL,  }
 };
 
-/* エンコード 成功時は0、失敗時は0以外を返す */
-static int do_encode(
-    const char* in_filename, const char* out_filename,
-    uint32_t encode_preset_no, uint8_t enable_learning, uint8_t num_afmethod_iterations)
+/* 利用可能なプロセッサ数を取得 取得できない時は0を返す */
+static uint32_t LINNECodec_GetNumProcessors(void)
+{
+#if defined(_WIN32)
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return (uint32_t)info.dwNumberOfProcessors;
+#elif defined(_SC_NPROCESSORS_ONLN)
+    const long num_processors = sysconf(_SC_NPROCESSORS_ONLN);
+    return (num_processors > 0) ? (uint32_t)num_processors : 0;
+#else
+    return 0;
+#endif
+}
+
+/* 使用するスレッド数を決める num_tasksは並列に処理できる単位（ブロックやファイル）の数 */
+/* 自動選択ではプロセッサ数を上限に、処理単位の数より多くは使わない */
+static uint32_t LINNECodec_DecideNumThreads(uint32_t num_threads, uint64_t num_tasks)
+{
+    if (num_threads == LINNECODEC_NUM_THREADS_AUTO) {
+        if ((num_threads = LINNECodec_GetNumProcessors()) == 0) {
+            num_threads = LINNECODEC_DEFAULT_NUM_THREADS;
+        }
+        num_threads = (uint32_t)LINNECODEC_MIN(num_threads, num_tasks);
+    }
+
+    return LINNECODEC_MAX(1, LINNECODEC_MIN(num_threads, LINNECODEC_MAX_NUM_THREADS));
+}
+
+#if defined(LINNECODEC_USE_MMAP)
+/* 入力ファイルを読み込み専用でマップ 成功時は0、失敗時は0以外を返す */
+static int LINNECodecInputFile_Map(struct LINNECodecInputFile *input, const char *filename)
+{
+#if defined(_WIN32)
+    LARGE_INTEGER size;
+    void *view;
+
+    if ((input->file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, NULL,
+                    OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL)) == INVALID_HANDLE_VALUE) {
+        return 1;
+    }
+    if (!GetFileSizeEx(input->file, &size) || (size.QuadPart <= 0)) {
+        CloseHandle(input->file);
+        return 1;
+    }
+    if ((input->mapping = CreateFileMappingA(input->file, NULL, PAGE_READONLY, 0, 0, NULL)) == NULL) {
+        CloseHandle(input->file);
+        return 1;
+    }
+    if ((view = MapViewOfFile(input->mapping, FILE_MAP_READ, 0, 0, 0)) == NULL) {
+        CloseHandle(input->mapping);
+        CloseHandle(input->file);
+        return 1;
+    }
+    input->data = (const uint8_t *)view;
+    input->data_size = (uint64_t)size.QuadPart;
+#else
+    struct stat fstat_buf;
+    void *addr;
+
+    if ((input->fd = open(filename, O_RDONLY)) < 0) {
+        return 1;
+    }
+    /* 空のファイルはマップできない */
+    if ((fstat(input->fd, &fstat_buf) != 0) || (fstat_buf.st_size <= 0)
+            || ((uint64_t)fstat_buf.st_size > (uint64_t)((size_t)-1))) {
+        close(input->fd);
+        return 1;
+    }
+    if ((addr = mmap(NULL, (size_t)fstat_buf.st_size, PROT_READ, MAP_PRIVATE, input->fd, 0)) == MAP_FAILED) {
+        close(input->fd);
+        return 1;
+    }
+    input->data = (const uint8_t *)addr;
+    input->data_size = (uint64_t)fstat_buf.st_size;
+#endif
+
+    return 0;
+}
+
+/* 入力ファイルのマップを解除 */
+static void LINNECodecInputFile_Unmap(struct LINNECodecInputFile *input)
+{
+#if defined(_WIN32)
+    UnmapViewOfFile(input->data);
+    CloseHandle(input->mapping);
+    CloseHandle(input->file);
+#else
+    munmap((void *)input->data, (size_t)input->data_size);
+    close(input->fd);
+#endif
+}
+#endif /* LINNECODEC_USE_MMAP */
+
+/* 入力ファイルを開く マップできなければ逐次読み込みにする 成功時は0、失敗時は0以外を返す */
+static int LINNECodecInputFile_Open(struct LINNECodecInputFile *input, const char *filename)
+{
+    input->fp = NULL;
+    input->own_fp = 0;
+    input->buffer = NULL;
+    input->buffer_size = 0;
+    input->data = NULL;
+    input->data_size = 0;
+    input->read_pos = 0;
+
+    /* 標準入力は逐次読み込み */
+    if (LINNECODEC_IS_STDIO(filename)) {
+        input->fp = stdin;
+        return 0;
+    }
+
+#if defined(LINNECODEC_USE_MMAP)
+    if (LINNECodecInputFile_Map(input, filename) == 0) {
+        return 0;
+    }
+#endif
+
+    if ((input->fp = fopen(filename, "rb")) == NULL) {
+        return 1;
+    }
+    input->own_fp = 1;
+
+    return 0;
+}
+
+/* 入力ファイルを閉じる */
+static void LINNECodecInputFile_Close(struct LINNECodecInputFile *input)
+{
+#if defined(LINNECODEC_USE_MMAP)
+    if (input->data != NULL) {
+        LINNECodecInputFile_Unmap(input);
+    }
+#endif
+    if ((input->fp != NULL) && input->own_fp) {
+        fclose(input->fp);
+    }
+    if (input->buffer != NULL) {
+        free(input->buffer);
+    }
+}
+
+/* 逐次読み込み用のバッファを確保し、offsetバイト目以降にsizeバイト読み込む 成功時は0、失敗時は0以外を返す */
+static int LINNECodecInputFile_FillBuffer(struct LINNECodecInputFile *input, uint32_t offset, uint32_t size)
+{
+    if (size > (UINT32_MAX - offset)) {
+        return 1;
+    }
+
+    if ((offset + size) > input->buffer_size) {
+        uint8_t *tmp;
+        if ((tmp = (uint8_t *)realloc(input->buffer, offset + size)) == NULL) {
+            return 1;
+        }
+        input->buffer = tmp;
+        input->buffer_size = offset + size;
+    }
+
+    if (fread(&input->buffer[offset], sizeof(uint8_t), size, input->fp) < size) {
+        return 1;
+    }
+
+    return 0;
+}
+
+/* 先頭からsizeバイトを読み込み、その先頭を返す 読めなかった時はNULLを返す */
+static const uint8_t *LINNECodecInputFile_Read(struct LINNECodecInputFile *input, uint32_t size)
+{
+    const uint8_t *ptr;
+
+    /* マップ済みならマップ領域を直接返す */
+    if (input->data != NULL) {
+        if (size > (input->data_size - input->read_pos)) {
+            return NULL;
+        }
+        ptr = &input->data[input->read_pos];
+        input->read_pos += size;
+        return ptr;
+    }
+
+    if (LINNECodecInputFile_FillBuffer(input, 0, size) != 0) {
+        return NULL;
+    }
+
+    return input->buffer;
+}
+
+/* 全て読み終えたか */
+static uint8_t LINNECodecInputFile_IsEnd(struct LINNECodecInputFile *input)
+{
+    int c;
+
+    if (input->data != NULL) {
+        return (input->read_pos >= input->data_size) ? 1 : 0;
+    }
+
+    /* 1文字先読みして確かめる */
+    if ((c = getc(input->fp)) == EOF) {
+        return 1;
+    }
+    ungetc(c, input->fp);
+
+    return 0;
+}
+
+/* 1ブロックを読み込み、その先頭とサイズを返す 読めなかった時はNULLを返す */
+static const uint8_t *LINNECodecInputFile_ReadBlock(struct LINNECodecInputFile *input, uint32_t *block_size)
+{
+    const uint8_t *head;
+    uint32_t size;
+
+    /* 同期コードとブロックサイズからブロック全体のサイズを得る */
+    if ((head = LINNECodecInputFile_Read(input, LINNECODEC_BLOCK_HEADER_SIZE)) == NULL) {
+        return NULL;
+    }
+    size = ((uint32_t)head[2] << 24) | ((uint32_t)head[3] << 16) | ((uint32_t)head[4] << 8) | (uint32_t)head[5];
+
+    /* マップ済みならブロック全体がマップ領域に並んでいる */
+    if (input->data != NULL) {
+        if (size > (input->data_size - input->read_pos)) {
+            return NULL;
+        }
+        input->read_pos += size;
+        (*block_size) = size + LINNECODEC_BLOCK_HEADER_SIZE;
+        return head;
+    }
+
+    /* 読み込み済みの先頭に続けて残りを読み込む */
+    if (LINNECodecInputFile_FillBuffer(input, LINNECODEC_BLOCK_HEADER_SIZE, size) != 0) {
+        return NULL;
+    }
+    (*block_size) = size + LINNECODEC_BLOCK_HEADER_SIZE;
+    return input->buffer;
+}
+
+/* パイプラインのブロック */
+/* 補足）読み込み関数は入力側のメンバ、書き出し関数は出力側のメンバのみに触れる */
+struct LINNECodecBlock {
+    int32_t *pcm[LINNE_MAX_NUM_CHANNELS]; /* チャンネル毎のPCM */
+    uint32_t num_samples; /* PCMのサンプル数 */
+    const uint8_t *data; /* 符号化データの先頭 */
+    uint32_t data_size; /* 符号化データのサイズ */
+    uint8_t *buffer; /* 符号化データ領域 */
+    uint32_t buffer_size; /* 符号化データ領域のサイズ */
+    LINNEApiResult result; /* 変換結果 */
+    struct LINNECodecPipeline *pipeline; /* 所属するパイプライン */
+};
+
+/* 読み込み・変換・書き出しのパイプライン */
+/* ブロックの組を2つ交互に使い、呼び出し元スレッドが次の組を読み込む間に */
+/* ワーカスレッドで現在の組を変換し、前の組を書き出す */
+struct LINNECodecPipeline {
+    struct ThreadPool *pool; /* スレッドプール */
+    void *context; /* 各関数に渡すコンテキスト */
+    /* 次の組のブロックを読み込む 成功時は0、失敗時は0以外を返す */
+    int (*read_function)(void *context, struct LINNECodecBlock *blocks, uint32_t max_num_blocks, uint32_t *num_blocks);
+    /* 1ブロックの変換 thread_indexは実行スレッドの番号 */
+    LINNEApiResult (*process_function)(void *context, struct LINNECodecBlock *block, uint32_t thread_index);
+    /* 変換済みの組を書き出す 成功時は0、失敗時は0以外を返す */
+    int (*write_function)(void *context, const struct LINNECodecBlock *blocks, uint32_t num_blocks);
+    struct LINNECodecBlock *blocks[2]; /* 交互に使うブロックの組 */
+    uint32_t max_num_blocks; /* 1組あたりのブロック数 */
+    const struct LINNECodecBlock *write_blocks; /* 書き出す組 */
+    uint32_t num_write_blocks; /* 書き出すブロック数 */
+    int write_result; /* 書き出し結果 */
+};
+
+/* パイプラインの破棄 */
+static void LINNECodecPipeline_Destroy(struct LINNECodecPipeline *pipeline)
+{
+    uint32_t set, i, ch;
+
+    if (pipeline == NULL) {
+        return;
+    }
+
+    for (set = 0; set < 2; set++) {
+        if (pipeline->blocks[set] == NULL) {
+            continue;
+        }
+        for (i = 0; i < pipeline->max_num_blocks; i++) {
+            struct LINNECodecBlock *block = &pipeline->blocks[set][i];
+            for (ch = 0; ch < LINNE_MAX_NUM_CHANNELS; ch++) {
+                if (block->pcm[ch] != NULL) {
+                    free(block->pcm[ch]);
+                }
+            }
+            if (block->buffer != NULL) {
+                free(block->buffer);
+            }
+        }
+        free(pipeline->blocks[set]);
+    }
+    if (pipeline->pool != NULL) {
+        ThreadPool_Destroy(pipeline->pool);
+    }
+    free(pipeline);
+}
+
+/* パイプラインの作成 */
+/* 各ブロックにはnum_channels x num_samples_per_blockのPCM領域と、buffer_sizeの符号化データ領域を確保する */
+static struct LINNECodecPipeline *LINNECodecPipeline_Create(
+        uint32_t num_threads, uint32_t num_channels, uint32_t num_samples_per_block, uint32_t buffer_size)
+{
+    uint32_t set, i, ch;
+    struct LINNECodecPipeline *pipeline;
+    struct ThreadPoolConfig pool_config;
+
+    if ((pipeline = (struct LINNECodecPipeline *)malloc(sizeof(struct LINNECodecPipeline))) == NULL) {
+        return NULL;
+    }
+    memset(pipeline, 0, sizeof(struct LINNECodecPipeline));
+
+    /* 1組のブロック数はスレッド数に比例させ、キューの深さ（メモリ使用量）を抑える */
+    pipeline->max_num_blocks = LINNECODEC_NUM_BLOCKS_PER_THREAD * LINNECODEC_MAX(1, num_threads);
+
+    /* スレッドプール作成 */
+    pool_config.max_num_threads = num_threads;
+    pool_config.max_num_tasks = pipeline->max_num_blocks + 1;
+    pool_config.allocator = NULL;
+    if ((pipeline->pool = ThreadPool_Create(&pool_config, NULL, 0)) == NULL) {
+        goto EXIT_FAILURE_WITH_PIPELINE_DESTROY;
+    }
+
+    /* ブロック領域確保 */
+    for (set = 0; set < 2; set++) {
+        if ((pipeline->blocks[set] = (struct LINNECodecBlock *)malloc(
+                        sizeof(struct LINNECodecBlock) * pipeline->max_num_blocks)) == NULL) {
+            goto EXIT_FAILURE_WITH_PIPELINE_DESTROY;
+        }
+        memset(pipeline->blocks[set], 0, sizeof(struct LINNECodecBlock) * pipeline->max_num_blocks);
+        for (i = 0; i < pipeline->max_num_blocks; i++) {
+            struct LINNECodecBlock *block = &pipeline->blocks[set][i];
+            block->pipeline = pipeline;
+            for (ch = 0; ch < num_channels; ch++) {
+                if ((block->pcm[ch] = (int32_t *)malloc(sizeof(int32_t) * num_samples_per_block)) == NULL) {
+                    goto EXIT_FAILURE_WITH_PIPELINE_DESTROY;
+                }
+            }
+            if (buffer_size > 0) {
+                if ((block->buffer = (uint8_t *)malloc(buffer_size)) == NULL) {
+                    goto EXIT_FAILURE_WITH_PIPELINE_DESTROY;
+                }
+                block->buffer_size = buffer_size;
+            }
+        }
+    }
+
+    return pipeline;
+
+EXIT_FAILURE_WITH_PIPELINE_DESTROY:
+    LINNECodecPipeline_Destroy(pipeline);
+    return NULL;
+}
+
+/* スレッドプールで実行する変換タスク */
+static void LINNECodecPipeline_ProcessTask(void *arg, uint32_t thread_index)
+{
+    struct LINNECodecBlock *block = (struct LINNECodecBlock *)arg;
+    struct LINNECodecPipeline *pipeline = block->pipeline;
+
+    block->result = pipeline->process_function(pipeline->context, block, thread_index);
+}
+
+/* スレッドプールで実行する書き出しタスク */
+static void LINNECodecPipeline_WriteTask(void *arg, uint32_t thread_index)
+{
+    struct LINNECodecPipeline *pipeline = (struct LINNECodecPipeline *)arg;
+
+    (void)thread_index;
+
+    pipeline->write_result = pipeline->write_function(pipeline->context, pipeline->write_blocks, pipeline->num_write_blocks);
+}
+
+/* パイプラインの実行 全ブロックを読み込み・変換・書き出すまで戻らない 成功時は0、失敗時は0以外を返す */
+static int LINNECodecPipeline_Run(struct LINNECodecPipeline *pipeline)
+{
+    uint32_t i, set, num_blocks;
+
+    /* 最初の組を読み込み */
+    set = 0;
+    if (pipeline->read_function(pipeline->context, pipeline->blocks[set], pipeline->max_num_blocks, &num_blocks) != 0) {
+        return 1;
+    }
+    pipeline->write_blocks = NULL;
+    pipeline->num_write_blocks = 0;
+    pipeline->write_result = 0;
+
+    while ((num_blocks > 0) || (pipeline->num_write_blocks > 0)) {
+        struct ThreadPoolTaskGroup group;
+        uint32_t num_next_blocks = 0;
+        int read_result = 0;
+
+        ThreadPool_InitializeTaskGroup(&group);
+
+        /* 前の組の書き出し 書き出し順を保つため1タスクでまとめて行う */
+        if (pipeline->num_write_blocks > 0) {
+            ThreadPool_Submit(pipeline->pool, &group, LINNECodecPipeline_WriteTask, pipeline);
+        }
+
+        /* 現在の組の変換 */
+        for (i = 0; i < num_blocks; i++) {
+            ThreadPool_Submit(pipeline->pool, &group, LINNECodecPipeline_ProcessTask, &pipeline->blocks[set][i]);
+        }
+
+        /* 変換と書き出しを待つ間に次の組を読み込む */
+        if (num_blocks > 0) {
+            read_result = pipeline->read_function(pipeline->context,
+                    pipeline->blocks[set ^ 1], pipeline->max_num_blocks, &num_next_blocks);
+        }
+
+        ThreadPool_Wait(pipeline->pool, &group);
+
+        /* 失敗していたら打ち切り */
+        if ((read_result != 0) || (pipeline->write_result != 0)) {
+            return 1;
+        }
+        for (i = 0; i < num_blocks; i++) {
+            if (pipeline->blocks[set][i].result != LINNE_APIRESULT_OK) {
+                return 1;
+            }
+        }
+
+        /* 変換した組は次に書き出す */
+        pipeline->write_blocks = pipeline->blocks[set];
+        pipeline->num_write_blocks = num_blocks;
+        num_blocks = num_next_blocks;
+        set ^= 1;
+    }
+
+    return 0;
+}
+
+/* エンコード処理のコンテキスト */
+struct LINNECodecEncodeContext {
+    struct WAVStream *in_stream; /* 入力WAVストリーム */
+    FILE *out_fp; /* 出力ファイル */
+    FILE *log_fp; /* 進捗の表示先 */
+    uint8_t is_num_samples_known; /* 全サンプル数が事前に分かっているか */
+    struct LINNEEncoder **encoders; /* スレッド毎のエンコーダ */
+    uint32_t num_channels; /* チャンネル数 */
+    uint32_t num_samples_per_block; /* ブロックあたりサンプル数 */
+    uint64_t num_samples; /* 全サンプル数 */
+    uint64_t num_read_samples; /* 読み込んだサンプル数 */
+    uint64_t encoded_data_size; /* 書き出したデータサイズ */
+};
+
+/* エンコード: WAVからブロック単位でPCMを読み込む */
+static int LINNECodecEncode_Read(void *context, struct LINNECodecBlock *blocks, uint32_t max_num_blocks, uint32_t *num_blocks)
+{
+    uint32_t i;
+    struct LINNECodecEncodeContext *encode = (struct LINNECodecEncodeContext *)context;
+
+    for (i = 0; (i < max_num_blocks) && (encode->num_read_samples < encode->num_samples); i++) {
+        const uint32_t num_read = (uint32_t)LINNECODEC_MIN(encode->num_samples_per_block,
+                encode->num_samples - encode->num_read_samples);
+        if (WAV_ReadStream(encode->in_stream, blocks[i].pcm, num_read, &blocks[i].num_samples) != WAV_APIRESULT_OK) {
+            fprintf(stderr, "Failed to read wav file. \n");
+            return 1;
+        }
+        /* ファイル末尾に達した（パイプ入力ではヘッダのサイズが仮の値のことがある） */
+        if (blocks[i].num_samples == 0) {
+            encode->num_samples = encode->num_read_samples;
+            break;
+        }
+        encode->num_read_samples += blocks[i].num_samples;
+    }
+    (*num_blocks) = i;
+
+    /* 進捗表示 */
+    if (encode->is_num_samples_known) {
+        fprintf(encode->log_fp, "progress... %5.2f%% \r",
+                ((double)encode->num_read_samples * 100.0) / (double)encode->num_samples);
+    } else {
+        fprintf(encode->log_fp, "progress... %.0f samples \r", (double)encode->num_read_samples);
+    }
+    fflush(encode->log_fp);
+
+    return 0;
+}
+
+/* エンコード: 1ブロックのエンコード */
+static LINNEApiResult LINNECodecEncode_Process(void *context, struct LINNECodecBlock *block, uint32_t thread_index)
+{
+    uint32_t ch;
+    LINNEApiResult ret;
+    struct LINNEEncoderPCMInput input;
+    struct LINNECodecEncodeContext *encode = (struct LINNECodecEncodeContext *)context;
+
+    /* WAVのPCMは32bit MSB詰めなのでそのまま入力する（右シフトはエンコーダ内で行う） */
+    input.format = LINNE_PCM_FORMAT_INT32;
+    input.stride = sizeof(int32_t);
+    for (ch = 0; ch < encode->num_channels; ch++) {
+        input.channels[ch] = block->pcm[ch];
+    }
+
+    /* 実行スレッドのエンコーダを使う */
+    if ((ret = LINNEEncoder_EncodeBlockPCM(encode->encoders[thread_index],
+                    &input, block->num_samples, block->buffer, block->buffer_size, &block->data_size))
+            != LINNE_APIRESULT_OK) {
+        fprintf(stderr, "Failed to encode! ret:%d \n", ret);
+        return ret;
+    }
+    block->data = block->buffer;
+
+    return LINNE_APIRESULT_OK;
+}
+
+/* エンコード: ブロックを順に書き出す */
+static int LINNECodecEncode_Write(void *context, const struct LINNECodecBlock *blocks, uint32_t num_blocks)
+{
+    uint32_t i;
+    struct LINNECodecEncodeContext *encode = (struct LINNECodecEncodeContext *)context;
+
+    for (i = 0; i < num_blocks; i++) {
+        if (fwrite(blocks[i].data, sizeof(uint8_t), blocks[i].data_size, encode->out_fp) < blocks[i].data_size) {
+            fprintf(stderr, "File output error! \n");
+            return 1;
+        }
+        encode->encoded_data_size += blocks[i].data_size;
+    }
+
+    return 0;
+}
+
+/* WAVのフォーマットとオプションからエンコードパラメータを設定 */
+static void LINNECodec_SetEncodeParameter(const struct WAVFileFormat *wav_format,
+    uint32_t encode_preset_no, uint8_t enable_learning, uint8_t num_afmethod_iterations,
+    struct LINNEEncodeParameter *parameter)
+{
+    parameter->num_channels = (uint16_t)wav_format->num_channels;
+    parameter->bits_per_sample = (uint16_t)wav_format->bits_per_sample;
+    parameter->sampling_rate = wav_format->sampling_rate;
+    /* プリセットの反映 */
+    parameter->num_samples_per_block = 5 * 2048;
+    parameter->ch_process_method = LINNE_CH_PROCESS_METHOD_MS;
+    parameter->preset = (uint8_t)encode_preset_no;
+    parameter->enable_learning = enable_learning;
+    parameter->num_afmethod_iterations = num_afmethod_iterations;
+    /* 2ch未満の信号にはMS処理できないので無効に */
+    if (wav_format->num_channels < 2) {
+        parameter->ch_process_method = LINNE_CH_PROCESS_METHOD_NONE;
+    }
+}
+
+/* エンコードパラメータと全サンプル数からヘッダを設定 */
+static void LINNECodec_SetHeader(const struct LINNEEncodeParameter *parameter,
+    uint64_t num_samples, struct LINNEHeader *header)
+{
+    header->num_channels = parameter->num_channels;
+    header->num_samples = num_samples;
+    header->sampling_rate = parameter->sampling_rate;
+    header->bits_per_sample = parameter->bits_per_sample;
+    header->num_samples_per_block = parameter->num_samples_per_block;
+    header->preset = parameter->preset;
+    header->ch_process_method = parameter->ch_process_method;
+}
+
+/* エンコード 成功時は0、失敗時は0以外を返す */
+static int do_encode(
+    const char* in_filename, const char* out_filename,
+    uint32_t encode_preset_no, uint8_t enable_learning, uint8_t num_afmethod_iterations, uint32_t num_threads)
+{
+    struct LINNECodecEncodeContext encode;
+    struct LINNECodecPipeline *pipeline;
+    struct WAVFileFormat wav_format;
+    struct LINNEEncoderConfig config;
+    struct LINNEEncodeParameter parameter;
+    struct LINNEHeader header;
+    struct stat fstat;
+    uint8_t header_data[LINNE_HEADER_SIZE];
+    uint32_t max_block_size, i;
+    double input_size;
+    LINNEApiResult ret;
+
+    /* 標準出力に書き出す場合は進捗を標準エラー出力に表示 */
+    encode.log_fp = LINNECODEC_IS_STDIO(out_filename) ? stderr : stdout;
+
+    /* WAVファイルオープン（PCMはブロック毎に逐次読み込む） */
+    /* 標準入力ではヘッダのサイズが仮の値のことがあるため、全サンプル数は読み終えるまで確定しない */
+    if (LINNECODEC_IS_STDIO(in_filename)) {
+        encode.in_stream = WAV_OpenStreamForReadFromFp(stdin, &wav_format);
+        encode.is_num_samples_known = 0;
+    } else {
+        encode.in_stream = WAV_OpenStreamForRead(in_filename, &wav_format);
+        encode.is_num_samples_known = 1;
+    }
+    if (encode.in_stream == NULL) {
+        fprintf(stderr, "Failed to open %s. \n", in_filename);
+        return 1;
+    }
+    encode.num_channels = wav_format.num_channels;
+    encode.num_samples = wav_format.num_samples;
+    encode.num_read_samples = 0;
+    if (encode.num_channels > LINNE_MAX_NUM_CHANNELS) {
+        fprintf(stderr, "Unsupported number of channels: %d \n", encode.num_channels);
+        return 1;
+    }
+    if (encode.is_num_samples_known && (encode.num_samples == 0)) {
+        fprintf(stderr, "No samples to encode: %s \n", in_filename);
+        return 1;
+    }
+
+    /* エンコードパラメータセット */
+    LINNECodec_SetEncodeParameter(&wav_format,
+            encode_preset_no, enable_learning, num_afmethod_iterations, &parameter);
+    encode.num_samples_per_block = parameter.num_samples_per_block;
+
+    /* スレッド数の決定 全サンプル数が分からなければブロック数で制限しない */
+    num_threads = LINNECodec_DecideNumThreads(num_threads, encode.is_num_samples_known
+            ? ((encode.num_samples + encode.num_samples_per_block - 1) / encode.num_samples_per_block) : UINT64_MAX);
+
+    /* スレッド毎にエンコーダを作成 ブロックは互いに独立なので、どのエンコーダで処理しても結果は同じ */
+    /* 補足）ブロック単位で並列化するため、エンコーダ内のチャンネル並列は使わない */
+    config.max_num_channels = LINNE_MAX_NUM_CHANNELS;
+    config.max_num_samples_per_block = 16 * 1024;
+    config.max_num_layers = 5;
+    config.max_num_parameters_per_layer = 128;
+    config.max_num_threads = 1;
+    config.allocator = NULL;
+    if ((encode.encoders = (struct LINNEEncoder **)calloc(num_threads, sizeof(struct LINNEEncoder *))) == NULL) {
+        fprintf(stderr, "Failed to allocate encoder handles. \n");
+        return 1;
+    }
+    for (i = 0; i < num_threads; i++) {
+        if ((encode.encoders[i] = LINNEEncoder_Create(&config, NULL, 0)) == NULL) {
+            fprintf(stderr, "Failed to create encoder handle. \n");
+            return 1;
+        }
+        if ((ret = LINNEEncoder_SetEncodeParameter(encode.encoders[i], &parameter)) != LINNE_APIRESULT_OK) {
+            fprintf(stderr, "Failed to set encode parameter: %d \n", ret);
+            return 1;
+        }
+    }
+
+    /* 入力ファイルのサイズを拾っておく */
+    input_size = 0.0;
+    if (encode.is_num_samples_known) {
+        stat(in_filename, &fstat);
+        input_size = (double)fstat.st_size;
+    }
+
+    /* 1ブロックの出力サイズの上限でブロック毎の出力領域を確保 */
+    if ((ret = LINNEEncoder_CalculateMaxBlockSize(&parameter, &max_block_size)) != LINNE_APIRESULT_OK) {
+        fprintf(stderr, "Failed to calculate max block size: %d \n", ret);
+        return 1;
+    }
+    if ((pipeline = LINNECodecPipeline_Create(num_threads,
+                    encode.num_channels, parameter.num_samples_per_block, max_block_size)) == NULL) {
+        fprintf(stderr, "Failed to create pipeline. \n");
+        return 1;
+    }
+    pipeline->context = &encode;
+    pipeline->read_function = LINNECodecEncode_Read;
+    pipeline->process_function = LINNECodecEncode_Process;
+    pipeline->write_function = LINNECodecEncode_Write;
+
+    /* 出力ファイルオープン ブロック毎の書き出しはまとめてから行う */
+    if ((encode.out_fp = LINNECODEC_IS_STDIO(out_filename) ? stdout : fopen(out_filename, "wb")) == NULL) {
+        fprintf(stderr, "Failed to open %s. \n", out_filename);
+        return 1;
+    }
+    setvbuf(encode.out_fp, NULL, _IOFBF, LINNECODEC_OUTPUT_BUFFER_SIZE);
+
+    /* ヘッダエンコード */
+    LINNECodec_SetHeader(&parameter,
+            encode.is_num_samples_known ? encode.num_samples : LINNE_NUM_SAMPLES_UNKNOWN, &header);
+    if ((ret = LINNEEncoder_EncodeHeader(&header, header_data, sizeof(header_data)))
+            != LINNE_APIRESULT_OK) {
+        fprintf(stderr, "Failed to encode header! ret:%d \n", ret);
+        return 1;
+    }
+    if (fwrite(header_data, sizeof(uint8_t), LINNE_HEADER_SIZE, encode.out_fp) < LINNE_HEADER_SIZE) {
+        fprintf(stderr, "File output error! \n");
+        return 1;
+    }
+    encode.encoded_data_size = LINNE_HEADER_SIZE;
+
+    /* 読み込み・エンコード・書き出しを重ねて実行 */
+    if (LINNECodecPipeline_Run(pipeline) != 0) {
+        return 1;
+    }
+
+    /* サンプルを1つも読めなかった（標準入力では読み終えるまで分からない） */
+    if (encode.num_read_samples == 0) {
+        fprintf(stderr, "No samples to encode: %s \n", in_filename);
+        return 1;
+    }
+
+    /* 実際のサンプル数がヘッダと異なれば、先頭に戻ってヘッダを書き直す */
+    /* 補足）パイプなどシークできない出力ではヘッダはそのまま残す */
+    if (encode.num_read_samples != header.num_samples) {
+        header.num_samples = encode.num_read_samples;
+        if ((fflush(encode.out_fp) == 0) && (fseek(encode.out_fp, 0, SEEK_SET) == 0)) {
+            if (((ret = LINNEEncoder_EncodeHeader(&header, header_data, sizeof(header_data))) != LINNE_APIRESULT_OK)
+                    || (fwrite(header_data, sizeof(uint8_t), LINNE_HEADER_SIZE, encode.out_fp) < LINNE_HEADER_SIZE)) {
+                fprintf(stderr, "Failed to rewrite header. \n");
+                return 1;
+            }
+        }
+    }
+
+    /* 圧縮結果サマリの表示 標準入力の場合はPCMデータのサイズと比べる */
+    if (!encode.is_num_samples_known) {
+        input_size = (double)encode.num_read_samples * (wav_format.bits_per_sample / 8) * encode.num_channels;
+    }
+    fprintf(encode.log_fp, "finished: %.0f -> %.0f (%6.2f %%) \n",
+            input_size, (double)encode.encoded_data_size,
+            100.0 * (double)encode.encoded_data_size / input_size);
+
+    /* リソース破棄 */
+    if (((encode.out_fp == stdout) ? fflush(encode.out_fp) : fclose(encode.out_fp)) != 0) {
+        fprintf(stderr, "File output error! \n");
+        return 1;
+    }
+    LINNECodecPipeline_Destroy(pipeline);
+    WAV_CloseStream(encode.in_stream);
+    for (i = 0; i < num_threads; i++) {
+        LINNEEncoder_Destroy(encode.encoders[i]);
+    }
+    free(encode.encoders);
+
+    return 0;
+}
+
+/* デコード処理のコンテキスト */
+struct LINNECodecDecodeContext {
+    struct LINNECodecInputFile input; /* 入力ファイル */
+    struct WAVStream *out_stream; /* 出力WAVストリーム */
+    struct LINNEDecoder **decoders; /* スレッド毎のデコーダ */
+    uint32_t num_channels; /* チャンネル数 */
+    uint32_t num_samples_per_block; /* ブロックあたりサンプル数 */
+    uint64_t num_samples; /* 全サンプル数 */
+    uint64_t num_read_samples; /* 読み込んだブロックのサンプル数 */
+};
+
+/* デコード: ブロック単位で符号化データを読み込む */
+static int LINNECodecDecode_Read(void *context, struct LINNECodecBlock *blocks, uint32_t max_num_blocks, uint32_t *num_blocks)
+{
+    uint32_t i;
+    struct LINNECodecDecodeContext *decode = (struct LINNECodecDecodeContext *)context;
+
+    for (i = 0; (i < max_num_blocks) && (decode->num_read_samples < decode->num_samples); i++) {
+        const uint8_t *block;
+        uint32_t block_size;
+
+        /* サンプル数が不明な場合は入力の末尾まで読む */
+        if ((decode->num_samples == LINNE_NUM_SAMPLES_UNKNOWN) && LINNECodecInputFile_IsEnd(&decode->input)) {
+            decode->num_samples = decode->num_read_samples;
+            break;
+        }
+
+        if (((block = LINNECodecInputFile_ReadBlock(&decode->input, &block_size)) == NULL)
+                || (block_size < (LINNECODEC_BLOCK_NUM_SAMPLES_OFFSET + 2))) {
+            fprintf(stderr, "Failed to read input file. \n");
+            return 1;
+        }
+
+        /* マップ領域はそのまま参照し、逐次読み込みの場合はブロックの領域に移す */
+        if (decode->input.data != NULL) {
+            blocks[i].data = block;
+        } else {
+            if (block_size > blocks[i].buffer_size) {
+                uint8_t *tmp;
+                if ((tmp = (uint8_t *)realloc(blocks[i].buffer, block_size)) == NULL) {
+                    fprintf(stderr, "Failed to allocate block buffer. \n");
+                    return 1;
+                }
+                blocks[i].buffer = tmp;
+                blocks[i].buffer_size = block_size;
+            }
+            memcpy(blocks[i].buffer, block, block_size);
+            blocks[i].data = blocks[i].buffer;
+        }
+        blocks[i].data_size = block_size;
+
+        /* ブロックヘッダに記録されたサンプル数で読み込み終わりを判定 */
+        decode->num_read_samples += ((uint32_t)block[LINNECODEC_BLOCK_NUM_SAMPLES_OFFSET] << 8)
+            | (uint32_t)block[LINNECODEC_BLOCK_NUM_SAMPLES_OFFSET + 1];
+    }
+    (*num_blocks) = i;
+
+    return 0;
+}
+
+/* デコード: 1ブロックのデコード */
+static LINNEApiResult LINNECodecDecode_Process(void *context, struct LINNECodecBlock *block, uint32_t thread_index)
+{
+    uint32_t ch, decode_size;
+    LINNEApiResult ret;
+    struct LINNEDecoderPCMOutput output;
+    struct LINNECodecDecodeContext *decode = (struct LINNECodecDecodeContext *)context;
+
+    /* WAVのPCMは32bit MSB詰めなので、左シフトはデコーダ内で行う */
+    output.format = LINNE_PCM_FORMAT_INT32;
+    output.stride = sizeof(int32_t);
+    for (ch = 0; ch < decode->num_channels; ch++) {
+        output.channels[ch] = block->pcm[ch];
+    }
+
+    /* 実行スレッドのデコーダを使う */
+    if ((ret = LINNEDecoder_DecodeBlockPCM(decode->decoders[thread_index],
+                    block->data, block->data_size, &output, decode->num_samples_per_block,
+                    &decode_size, &block->num_samples)) != LINNE_APIRESULT_OK) {
+        fprintf(stderr, "Decoding error! %d \n", ret);
+        return ret;
+    }
+
+    return LINNE_APIRESULT_OK;
+}
+
+/* デコード: PCMを順に書き出す */
+static int LINNECodecDecode_Write(void *context, const struct LINNECodecBlock *blocks, uint32_t num_blocks)
+{
+    uint32_t i;
+    struct LINNECodecDecodeContext *decode = (struct LINNECodecDecodeContext *)context;
+
+    for (i = 0; i < num_blocks; i++) {
+        if (WAV_WriteStream(decode->out_stream, blocks[i].pcm, blocks[i].num_samples) != WAV_APIRESULT_OK) {
+            fprintf(stderr, "Failed to write wav file. \n");
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+/* デコード 成功時は0、失敗時は0以外を返す */
+static int do_decode(const char* in_filename, const char* out_filename, uint8_t check_crc, uint32_t num_threads)
+{
+    struct LINNECodecDecodeContext decode;
+    struct LINNECodecPipeline *pipeline;
+    struct WAVFileFormat wav_format;
+    struct LINNEDecoderConfig config;
+    struct LINNEHeader header;
+    const uint8_t* header_data;
+    uint32_t i;
+    LINNEApiResult ret;
+
+    /* 入力ファイルオープン（可能ならメモリマップして直接デコーダに渡す） */
+    if (LINNECodecInputFile_Open(&decode.input, in_filename) != 0) {
+        fprintf(stderr, "Failed to open %s. \n", in_filename);
+        return 1;
+    }
+
+    /* ヘッダデコード */
+    if (((header_data = LINNECodecInputFile_Read(&decode.input, LINNE_HEADER_SIZE)) == NULL)
+            || ((ret = LINNEDecoder_DecodeHeader(header_data, LINNE_HEADER_SIZE, &header))
+                != LINNE_APIRESULT_OK)) {
+        fprintf(stderr, "Failed to get header information. \n");
+        return 1;
+    }
+    decode.num_channels = header.num_channels;
+    decode.num_samples_per_block = header.num_samples_per_block;
+    decode.num_samples = header.num_samples;
+    decode.num_read_samples = 0;
+
+    /* スレッド数の決定 全サンプル数が分からなければブロック数で制限しない */
+    num_threads = LINNECodec_DecideNumThreads(num_threads, (decode.num_samples != LINNE_NUM_SAMPLES_UNKNOWN)
+            ? ((decode.num_samples + decode.num_samples_per_block - 1) / decode.num_samples_per_block) : UINT64_MAX);
+
+    /* スレッド毎にデコーダハンドルを作成 */
+    config.max_num_channels = LINNE_MAX_NUM_CHANNELS;
+    config.max_num_layers = 5;
+    config.max_num_parameters_per_layer = 128;
+    config.max_num_threads = 1;
+    config.max_num_samples_per_block = header.num_samples_per_block;
+    config.check_crc = check_crc;
+    config.allocator = NULL;
+    if ((decode.decoders = (struct LINNEDecoder **)calloc(num_threads, sizeof(struct LINNEDecoder *))) == NULL) {
+        fprintf(stderr, "Failed to allocate decoder handles. \n");
+        return 1;
+    }
+    for (i = 0; i < num_threads; i++) {
+        if ((decode.decoders[i] = LINNEDecoder_Create(&config, NULL, 0)) == NULL) {
+            fprintf(stderr, "Failed to create decoder handle. \n");
+            return 1;
+        }
+        if ((ret = LINNEDecoder_SetHeader(decode.decoders[i], &header)) != LINNE_APIRESULT_OK) {
+            fprintf(stderr, "Failed to set header: %d \n", ret);
+            return 1;
+        }
+    }
+
+    /* 符号化データはマップ領域を直接参照するか、読み込み時に確保する */
+    if ((pipeline = LINNECodecPipeline_Create(num_threads,
+                    decode.num_channels, header.num_samples_per_block, 0)) == NULL) {
+        fprintf(stderr, "Failed to create pipeline. \n");
+        return 1;
+    }
+    pipeline->context = &decode;
+    pipeline->read_function = LINNECodecDecode_Read;
+    pipeline->process_function = LINNECodecDecode_Process;
+    pipeline->write_function = LINNECodecDecode_Write;
+
+    /* 出力wavストリームのオープン */
+    /* サンプル数が不明な場合は十分大きな値を仮に書いておき、シークできればクローズ時に書き直す */
+    wav_format.data_format     = WAV_DATA_FORMAT_PCM;
+    wav_format.num_channels    = header.num_channels;
+    wav_format.sampling_rate   = header.sampling_rate;
+    wav_format.bits_per_sample = header.bits_per_sample;
+    wav_format.num_samples     = (header.num_samples == LINNE_NUM_SAMPLES_UNKNOWN) ? UINT32_MAX : header.num_samples;
+    if (LINNECODEC_IS_STDIO(out_filename)) {
+        decode.out_stream = WAV_OpenStreamForWriteToFp(stdout, &wav_format);
+    } else {
+        decode.out_stream = WAV_OpenStreamForWrite(out_filename, &wav_format);
+    }
+    if (decode.out_stream == NULL) {
+        fprintf(stderr, "Failed to open %s. \n", out_filename);
+        return 1;
+    }
+
+    /* 読み込み・デコード・書き出しを重ねて実行 */
+    if (LINNECodecPipeline_Run(pipeline) != 0) {
+        return 1;
+    }
+
+    /* WAVファイルを閉じる（ヘッダのサイズが確定する） */
+    if (WAV_CloseStream(decode.out_stream) != WAV_APIRESULT_OK) {
+        fprintf(stderr, "Failed to write wav file. \n");
+        return 1;
+    }
+
+    LINNECodecPipeline_Destroy(pipeline);
+    LINNECodecInputFile_Close(&decode.input);
+    for (i = 0; i < num_threads; i++) {
+        LINNEDecoder_Destroy(decode.decoders[i]);
+    }
+    free(decode.decoders);
+
+    return 0;
+}
+
+/* バッチ処理のジョブ（1ファイル分） */
+struct LINNECodecBatchJob {
+    char *in_filename; /* 入力ファイル名 */
+    char *out_filename; /* 出力ファイル名 */
+    uint64_t input_size; /* 入力ファイルサイズ */
+    uint64_t output_size; /* 出力ファイルサイズ */
+    uint64_t num_samples; /* 1チャンネルあたりサンプル数 */
+    uint32_t sampling_rate; /* サンプリングレート */
+    int result; /* 処理結果 成功時は0 */
+};
+
+/* バッチ処理のワーカ（スレッド毎に1つ） */
+/* 補足）ハンドルと作業領域はファイル間で使い回し、ファイル毎の確保と初期化を省く */
+struct LINNECodecBatchWorker {
+    struct LINNEEncoder *encoder; /* エンコーダ */
+    struct LINNEDecoder *decoder; /* デコーダ */
+    int32_t *pcm[LINNE_MAX_NUM_CHANNELS]; /* チャンネル毎のPCM */
+    uint8_t *buffer; /* 符号化データ領域 */
+    uint32_t buffer_size; /* 符号化データ領域のサイズ */
+};
+
+/* バッチ処理 */
+struct LINNECodecBatch {
+    uint8_t is_encode; /* エンコードするか */
+    uint32_t encode_preset_no; /* エンコードプリセット番号 */
+    uint8_t enable_learning; /* エンコード時に学習するか */
+    uint8_t num_afmethod_iterations; /* 補助関数法の繰り返し回数 */
+    uint8_t check_crc; /* デコード時にCRCを確認するか */
+    struct LINNECodecBatchWorker *workers; /* スレッド毎のワーカ */
+    uint32_t num_workers; /* ワーカ数 */
+    struct LINNECodecBatchJob *jobs; /* ジョブ配列 */
+    uint32_t num_jobs; /* ジョブ数 */
+    uint32_t max_num_jobs; /* ジョブ配列の確保数 */
+    uint32_t next_job; /* 次に取り出すジョブ */
+#if defined(LINNECODEC_USE_LOCK)
+#if defined(_WIN32)
+    CRITICAL_SECTION lock; /* ジョブ取り出しのロック */
+#else
+    pthread_mutex_t lock; /* ジョブ取り出しのロック */
+#endif
+#endif
+};
+
+/* 経過時間計測用の時刻[sec]を取得 */
+static double LINNECodec_GetTime(void)
 {
-    FILE *out_fp;
-    struct WAVFile *in_wav;
-    struct LINNEEncoder *encoder;
-    struct LINNEEncoderConfig config;
-    struct LINNEEncodeParameter parameter;
+#if defined(_WIN32)
+    LARGE_INTEGER count, frequency;
+    QueryPerformanceCounter(&count);
+    QueryPerformanceFrequency(&frequency);
+    return (double)count.QuadPart / (double)frequency.QuadPart;
+#elif defined(__unix__) || defined(__APPLE__)
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return (double)tv.tv_sec + (double)tv.tv_usec * 1.0e-6;
+#else
+    return (double)clock() / CLOCKS_PER_SEC;
+#endif
+}
+
+/* 文字列の複製 */
+static char *LINNECodec_DuplicateString(const char *str)
+{
+    char *dup;
+    const size_t length = strlen(str);
+
+    if ((dup = (char *)malloc(length + 1)) == NULL) {
+        return NULL;
+    }
+    memcpy(dup, str, length + 1);
+
+    return dup;
+}
+
+/* ファイル名が拡張子extで終わるか（大文字小文字は区別しない） */
+static uint8_t LINNECodec_HasExtension(const char *filename, const char *ext)
+{
+    size_t i;
+    const size_t length = strlen(filename), ext_length = strlen(ext);
+
+    if (length <= ext_length) {
+        return 0;
+    }
+    for (i = 0; i < ext_length; i++) {
+        if (tolower((unsigned char)filename[length - ext_length + i]) != tolower((unsigned char)ext[i])) {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+/* ジョブの追加 出力ファイル名は出力ディレクトリに入力ファイル名の拡張子を置き換えて作る */
+static int LINNECodecBatch_AddJob(struct LINNECodecBatch *batch, const char *in_filename, const char *out_directory)
+{
+    struct LINNECodecBatchJob *job;
     struct stat fstat;
-    int32_t *input[LINNE_MAX_NUM_CHANNELS];
-    uint8_t *buffer;
-    uint32_t buffer_size, encoded_data_size;
-    LINNEApiResult ret;
-    uint32_t ch, smpl, num_channels, num_samples;
+    const char *basename, *pos, *out_ext;
+    size_t basename_length, out_directory_length;
 
-    /* エンコーダ作成 */
-    config.max_num_channels = LINNE_MAX_NUM_CHANNELS;
-    config.max_num_samples_per_block = 16 * 1024;
-    config.max_num_layers = 5;
-    config.max_num_parameters_per_layer = 128;
-    if ((encoder = LINNEEncoder_Create(&config, NULL, 0)) == NULL) {
-        fprintf(stderr, "Failed to create encoder handle. \n");
-        return 1;
+    /* 配列の拡張 */
+    if (batch->num_jobs >= batch->max_num_jobs) {
+        struct LINNECodecBatchJob *tmp;
+        const uint32_t max_num_jobs = LINNECODEC_MAX(16, 2 * batch->max_num_jobs);
+        if ((tmp = (struct LINNECodecBatchJob *)realloc(batch->jobs, max_num_jobs * sizeof(struct LINNECodecBatchJob))) == NULL) {
+            return 1;
+        }
+        batch->jobs = tmp;
+        batch->max_num_jobs = max_num_jobs;
     }
 
-    /* WAVファイルオープン */
-    if ((in_wav = WAV_CreateFromFile(in_filename)) == NULL) {
-        fprintf(stderr, "Failed to open %s. \n", in_filename);
+    /* ディレクトリ部分と拡張子を除いたファイル名 */
+    basename = in_filename;
+    for (pos = in_filename; *pos != '\0'; pos++) {
+        if ((*pos == '/') || (*pos == '\\')) {
+            basename = pos + 1;
+        }
+    }
+    basename_length = strlen(basename);
+    if ((pos = strrchr(basename, '.')) != NULL) {
+        basename_length = (size_t)(pos - basename);
+    }
+    out_ext = batch->is_encode ? ".lnn" : ".wav";
+    out_directory_length = strlen(out_directory);
+
+    job = &batch->jobs[batch->num_jobs];
+    if ((job->in_filename = LINNECodec_DuplicateString(in_filename)) == NULL) {
+        return 1;
+    }
+    if ((job->out_filename = (char *)malloc(out_directory_length + basename_length + strlen(out_ext) + 2)) == NULL) {
+        free(job->in_filename);
         return 1;
     }
-    num_channels = in_wav->format.num_channels;
-    num_samples = in_wav->format.num_samples;
+    memcpy(job->out_filename, out_directory, out_directory_length);
+    job->out_filename[out_directory_length] = '/';
+    memcpy(&job->out_filename[out_directory_length + 1], basename, basename_length);
+    strcpy(&job->out_filename[out_directory_length + 1 + basename_length], out_ext);
 
-    /* エンコードパラメータセット */
-    parameter.num_channels = (uint16_t)num_channels;
-    parameter.bits_per_sample = (uint16_t)in_wav->format.bits_per_sample;
-    parameter.sampling_rate = in_wav->format.sampling_rate;
-    /* プリセットの反映 */
-    parameter.num_samples_per_block = 5 * 2048;
-    parameter.ch_process_method = LINNE_CH_PROCESS_METHOD_MS;
-    parameter.preset = (uint8_t)encode_preset_no;
-    parameter.enable_learning = enable_learning;
-    parameter.num_afmethod_iterations = num_afmethod_iterations;
-    /* 2ch未満の信号にはMS処理できないので無効に */
-    if (num_channels < 2) {
-        parameter.ch_process_method = LINNE_CH_PROCESS_METHOD_NONE;
+    /* スケジューリングのため入力サイズを拾っておく（取れなければ処理時に失敗する） */
+    job->input_size = 0;
+    if (stat(in_filename, &fstat) == 0) {
+        job->input_size = (uint64_t)fstat.st_size;
     }
-    if ((ret = LINNEEncoder_SetEncodeParameter(encoder, &parameter)) != LINNE_APIRESULT_OK) {
-        fprintf(stderr, "Failed to set encode parameter: %d \n", ret);
+    job->output_size = 0;
+    job->num_samples = 0;
+    job->sampling_rate = 0;
+    job->result = 1;
+    batch->num_jobs++;
+
+    return 0;
+}
+
+/* ディレクトリ名とファイル名を連結してpathに書き込む 収まらない時は0以外を返す */
+static int LINNECodec_JoinPath(char *path, size_t path_size, const char *directory, const char *name, char separator)
+{
+    const size_t directory_length = strlen(directory), name_length = strlen(name);
+
+    if ((directory_length + name_length + 2) > path_size) {
         return 1;
     }
+    memcpy(path, directory, directory_length);
+    path[directory_length] = separator;
+    memcpy(&path[directory_length + 1], name, name_length + 1);
 
-    /* 入力ファイルのサイズを拾っておく */
-    stat(in_filename, &fstat);
-    /* 入力wavの2倍よりは大きくならないだろうという想定 */
-    buffer_size = (uint32_t)(2 * fstat.st_size);
+    return 0;
+}
+
+/* ディレクトリ内の処理対象ファイルをジョブに追加 成功時は0、失敗時は0以外を返す */
+static int LINNECodecBatch_AddDirectory(struct LINNECodecBatch *batch, const char *in_directory, const char *out_directory)
+{
+    const char *ext = batch->is_encode ? ".wav" : ".lnn";
+    char path[LINNECODEC_BATCH_MAX_PATH_LENGTH];
+#if defined(_WIN32)
+    HANDLE find;
+    WIN32_FIND_DATAA data;
 
-    /* エンコードデータ/入力データ領域を作成 */
-    buffer = (uint8_t *)malloc(buffer_size);
-    for (ch = 0; ch < num_channels; ch++) {
-        input[ch] = (int32_t *)malloc(sizeof(int32_t) * num_samples);
+    if (LINNECodec_JoinPath(path, sizeof(path), in_directory, "*", '\\') != 0) {
+        return 1;
+    }
+    if ((find = FindFirstFileA(path, &data)) == INVALID_HANDLE_VALUE) {
+        return 1;
     }
+    do {
+        if ((data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) || !LINNECodec_HasExtension(data.cFileName, ext)) {
+            continue;
+        }
+        if (LINNECodec_JoinPath(path, sizeof(path), in_directory, data.cFileName, '\\') != 0) {
+            continue;
+        }
+        if (LINNECodecBatch_AddJob(batch, path, out_directory) != 0) {
+            FindClose(find);
+            return 1;
+        }
+    } while (FindNextFileA(find, &data));
+    FindClose(find);
+#elif defined(__unix__) || defined(__APPLE__)
+    DIR *dir;
+    struct dirent *entry;
+    struct stat fstat;
 
-    /* 情報が失われない程度に右シフト */
-    for (ch = 0; ch < num_channels; ch++) {
-        for (smpl = 0; smpl < num_samples; smpl++) {
-            input[ch][smpl] = (int32_t)(WAVFile_PCM(in_wav, smpl, ch) >> (32 - in_wav->format.bits_per_sample));
+    if ((dir = opendir(in_directory)) == NULL) {
+        return 1;
+    }
+    while ((entry = readdir(dir)) != NULL) {
+        if (!LINNECodec_HasExtension(entry->d_name, ext)) {
+            continue;
+        }
+        if (LINNECodec_JoinPath(path, sizeof(path), in_directory, entry->d_name, '/') != 0) {
+            continue;
+        }
+        if ((stat(path, &fstat) != 0) || S_ISDIR(fstat.st_mode)) {
+            continue;
+        }
+        if (LINNECodecBatch_AddJob(batch, path, out_directory) != 0) {
+            closedir(dir);
+            return 1;
         }
     }
+    closedir(dir);
+#else
+    /* ディレクトリを走査する手段がない */
+    (void)ext;
+    (void)path;
+    (void)out_directory;
+    fprintf(stderr, "Directory input is not supported on this platform: %s \n", in_directory);
+    return 1;
+#endif
 
-    /* エンコード実行 */
-    {
-        uint8_t *data_pos = buffer;
-        uint32_t write_offset, progress;
-        struct LINNEHeader header;
+    return 0;
+}
 
-        write_offset = 0;
+/* リストファイルに1行1つずつ書かれたファイルをジョブに追加 成功時は0、失敗時は0以外を返す */
+static int LINNECodecBatch_AddList(struct LINNECodecBatch *batch, const char *list_filename, const char *out_directory)
+{
+    FILE *fp;
+    char line[LINNECODEC_BATCH_MAX_PATH_LENGTH];
+    int ret = 0;
 
-        /* ヘッダエンコード */
-        header.num_channels = (uint16_t)num_channels;
-        header.num_samples = num_samples;
-        header.sampling_rate = parameter.sampling_rate;
-        header.bits_per_sample = parameter.bits_per_sample;
-        header.num_samples_per_block = parameter.num_samples_per_block;
-        header.preset = parameter.preset;
-        header.ch_process_method = parameter.ch_process_method;
-        if ((ret = LINNEEncoder_EncodeHeader(&header, data_pos, buffer_size))
-                != LINNE_APIRESULT_OK) {
-            fprintf(stderr, "Failed to encode header! ret:%d \n", ret);
-            return 1;
+    if ((fp = LINNECODEC_IS_STDIO(list_filename) ? stdin : fopen(list_filename, "r")) == NULL) {
+        return 1;
+    }
+
+    while (fgets(line, sizeof(line), fp) != NULL) {
+        /* 末尾の改行を除き、空行は読み飛ばす */
+        size_t length = strlen(line);
+        while ((length > 0) && ((line[length - 1] == '\n') || (line[length - 1] == '\r'))) {
+            line[--length] = '\0';
         }
-        data_pos += LINNE_HEADER_SIZE;
-        write_offset += LINNE_HEADER_SIZE;
-
-        /* ブロックを時系列順にエンコード */
-        progress = 0;
-        while (progress < num_samples) {
-            uint32_t ch, write_size;
-            const int32_t *input_ptr[LINNE_MAX_NUM_CHANNELS];
-            /* エンコードサンプル数の確定 */
-            const uint32_t num_encode_samples
-                = LINNECODEC_MIN(parameter.num_samples_per_block, num_samples - progress);
-
-            /* サンプル参照位置のセット */
-            for (ch = 0; ch < (uint32_t)num_channels; ch++) {
-                input_ptr[ch] = &input[ch][progress];
-            }
+        if (length == 0) {
+            continue;
+        }
+        if (LINNECodecBatch_AddJob(batch, line, out_directory) != 0) {
+            ret = 1;
+            break;
+        }
+    }
 
-            /* ブロックエンコード */
-            if ((ret = LINNEEncoder_EncodeBlock(encoder,
-                            input_ptr, num_encode_samples,
-                            data_pos, buffer_size - write_offset, &write_size)) != LINNE_APIRESULT_OK) {
-                fprintf(stderr, "Failed to encode! ret:%d \n", ret);
-                return 1;
-            }
+    if (fp != stdin) {
+        fclose(fp);
+    }
 
-            /* 進捗更新 */
-            data_pos += write_size;
-            write_offset += write_size;
-            progress += num_encode_samples;
+    return ret;
+}
 
-            /* 進捗表示 */
-            printf("progress... %5.2f%% \r", (progress * 100.0f) / num_samples);
-            fflush(stdout);
-        }
+/* 入力サイズの降順に並べるための比較関数 */
+static int LINNECodecBatch_CompareJob(const void *a, const void *b)
+{
+    const struct LINNECodecBatchJob *ja = (const struct LINNECodecBatchJob *)a;
+    const struct LINNECodecBatchJob *jb = (const struct LINNECodecBatchJob *)b;
 
-        /* 書き出しサイズ取得 */
-        encoded_data_size = write_offset;
+    if (ja->input_size != jb->input_size) {
+        return (ja->input_size > jb->input_size) ? -1 : 1;
     }
 
-    /* ファイル書き出し */
-    out_fp = fopen(out_filename, "wb");
-    if (fwrite(buffer, sizeof(uint8_t), encoded_data_size, out_fp) < encoded_data_size) {
-        fprintf(stderr, "File output error! %d \n", ret);
-        return 1;
+    return strcmp(ja->in_filename, jb->in_filename);
+}
+
+/* 大文字小文字を区別せずに文字列を比較 */
+static int LINNECodec_CompareStringIgnoreCase(const char *a, const char *b)
+{
+    while ((*a != '\0') && (tolower((unsigned char)*a) == tolower((unsigned char)*b))) {
+        a++;
+        b++;
     }
 
-    /* 圧縮結果サマリの表示 */
-    printf("finished: %d -> %d (%6.2f %%) \n",
-            (uint32_t)fstat.st_size, encoded_data_size, 100.f * (double)encoded_data_size / fstat.st_size);
+    return tolower((unsigned char)*a) - tolower((unsigned char)*b);
+}
 
-    /* リソース破棄 */
-    fclose(out_fp);
-    free(buffer);
-    for (ch = 0; ch < num_channels; ch++) {
-        free(input[ch]);
+/* 出力ファイル名の順に並べるための比較関数 */
+static int LINNECodecBatch_CompareOutputName(const void *a, const void *b)
+{
+    const struct LINNECodecBatchJob *ja = (const struct LINNECodecBatchJob *)a;
+    const struct LINNECodecBatchJob *jb = (const struct LINNECodecBatchJob *)b;
+
+    return LINNECodec_CompareStringIgnoreCase(ja->out_filename, jb->out_filename);
+}
+
+/* 出力ファイル名の重複確認 重複がなければ0、あれば0以外を返す */
+/* 補足）大文字小文字を区別しないファイルシステムでも上書きしないよう、大文字小文字は区別せずに比べる */
+static int LINNECodecBatch_CheckOutputNames(struct LINNECodecBatch *batch)
+{
+    uint32_t i;
+    int ret = 0;
+
+    qsort(batch->jobs, batch->num_jobs, sizeof(struct LINNECodecBatchJob), LINNECodecBatch_CompareOutputName);
+
+    for (i = 1; i < batch->num_jobs; i++) {
+        const struct LINNECodecBatchJob *prev = &batch->jobs[i - 1], *job = &batch->jobs[i];
+        if (LINNECodec_CompareStringIgnoreCase(prev->out_filename, job->out_filename) == 0) {
+            fprintf(stderr, "Output file name conflicts: %s and %s are both written to %s. \n",
+                    prev->in_filename, job->in_filename, job->out_filename);
+            ret = 1;
+        }
     }
-    WAV_Destroy(in_wav);
-    LINNEEncoder_Destroy(encoder);
 
-    return 0;
+    return ret;
 }
 
-/* デコード 成功時は0、失敗時は0以外を返す */
-static int do_decode(const char* in_filename, const char* out_filename, uint8_t check_crc)
+/* バッチ: 1ファイルのエンコード 成功時は0、失敗時は0以外を返す */
+static int LINNECodecBatch_EncodeFile(const struct LINNECodecBatch *batch,
+    struct LINNECodecBatchWorker *worker, struct LINNECodecBatchJob *job)
 {
-    FILE* in_fp;
-    struct WAVFile* out_wav;
+    struct WAVStream *in_stream;
     struct WAVFileFormat wav_format;
-    struct stat fstat;
-    struct LINNEDecoder* decoder;
-    struct LINNEDecoderConfig config;
+    struct LINNEEncodeParameter parameter;
+    struct LINNEEncoderPCMInput input;
     struct LINNEHeader header;
-    uint8_t* buffer;
-    uint32_t ch, smpl, buffer_size;
+    uint8_t header_data[LINNE_HEADER_SIZE];
+    uint32_t max_block_size, ch;
+    FILE *out_fp;
     LINNEApiResult ret;
+    int result = 1;
 
-    /* デコーダハンドルの作成 */
-    config.max_num_channels = LINNE_MAX_NUM_CHANNELS;
-    config.max_num_layers = 5;
-    config.max_num_parameters_per_layer = 128;
-    config.check_crc = check_crc;
-    if ((decoder = LINNEDecoder_Create(&config, NULL, 0)) == NULL) {
-        fprintf(stderr, "Failed to create decoder handle. \n");
+    if ((in_stream = WAV_OpenStreamForRead(job->in_filename, &wav_format)) == NULL) {
+        fprintf(stderr, "Failed to open %s. \n", job->in_filename);
         return 1;
     }
+    if (wav_format.num_channels > LINNE_MAX_NUM_CHANNELS) {
+        fprintf(stderr, "Unsupported number of channels: %d (%s) \n", wav_format.num_channels, job->in_filename);
+        goto EXIT;
+    }
 
-    /* 入力ファイルオープン */
-    in_fp = fopen(in_filename, "rb");
-    /* 入力ファイルのサイズ取得 / バッファ領域割り当て */
-    stat(in_filename, &fstat);
-    buffer_size = (uint32_t)fstat.st_size;
-    buffer = (uint8_t *)malloc(buffer_size);
-    /* バッファ領域にデータをロード */
-    fread(buffer, sizeof(uint8_t), buffer_size, in_fp);
-    fclose(in_fp);
+    /* エンコーダはファイル毎にパラメータを設定し直して使い回す */
+    LINNECodec_SetEncodeParameter(&wav_format,
+            batch->encode_preset_no, batch->enable_learning, batch->num_afmethod_iterations, &parameter);
+    if ((ret = LINNEEncoder_SetEncodeParameter(worker->encoder, &parameter)) != LINNE_APIRESULT_OK) {
+        fprintf(stderr, "Failed to set encode parameter: %d (%s) \n", ret, job->in_filename);
+        goto EXIT;
+    }
 
-    /* ヘッダデコード */
-    if ((ret = LINNEDecoder_DecodeHeader(buffer, buffer_size, &header))
-            != LINNE_APIRESULT_OK) {
-        fprintf(stderr, "Failed to get header information: %d \n", ret);
+    /* 出力領域は足りない時だけ拡張 */
+    if ((ret = LINNEEncoder_CalculateMaxBlockSize(&parameter, &max_block_size)) != LINNE_APIRESULT_OK) {
+        fprintf(stderr, "Failed to calculate max block size: %d (%s) \n", ret, job->in_filename);
+        goto EXIT;
+    }
+    if (max_block_size > worker->buffer_size) {
+        uint8_t *tmp;
+        if ((tmp = (uint8_t *)realloc(worker->buffer, max_block_size)) == NULL) {
+            fprintf(stderr, "Failed to allocate encode buffer. \n");
+            goto EXIT;
+        }
+        worker->buffer = tmp;
+        worker->buffer_size = max_block_size;
+    }
+
+    if ((out_fp = fopen(job->out_filename, "wb")) == NULL) {
+        fprintf(stderr, "Failed to open %s. \n", job->out_filename);
+        goto EXIT;
+    }
+
+    /* ヘッダエンコード */
+    LINNECodec_SetHeader(&parameter, wav_format.num_samples, &header);
+    if (((ret = LINNEEncoder_EncodeHeader(&header, header_data, sizeof(header_data))) != LINNE_APIRESULT_OK)
+            || (fwrite(header_data, sizeof(uint8_t), LINNE_HEADER_SIZE, out_fp) < LINNE_HEADER_SIZE)) {
+        fprintf(stderr, "Failed to write header: %s \n", job->out_filename);
+        goto EXIT_WITH_CLOSE;
+    }
+    job->output_size = LINNE_HEADER_SIZE;
+
+    /* ブロック単位で読み込み・エンコード・書き出し */
+    input.format = LINNE_PCM_FORMAT_INT32;
+    input.stride = sizeof(int32_t);
+    for (ch = 0; ch < wav_format.num_channels; ch++) {
+        input.channels[ch] = worker->pcm[ch];
+    }
+    job->num_samples = 0;
+    while (job->num_samples < wav_format.num_samples) {
+        uint32_t num_read_samples, encoded_size;
+        const uint32_t num_samples = (uint32_t)LINNECODEC_MIN(parameter.num_samples_per_block,
+                wav_format.num_samples - job->num_samples);
+        if (WAV_ReadStream(in_stream, worker->pcm, num_samples, &num_read_samples) != WAV_APIRESULT_OK) {
+            fprintf(stderr, "Failed to read wav file: %s \n", job->in_filename);
+            goto EXIT_WITH_CLOSE;
+        }
+        if (num_read_samples == 0) {
+            break;
+        }
+        if ((ret = LINNEEncoder_EncodeBlockPCM(worker->encoder,
+                        &input, num_read_samples, worker->buffer, worker->buffer_size, &encoded_size))
+                != LINNE_APIRESULT_OK) {
+            fprintf(stderr, "Failed to encode! ret:%d (%s) \n", ret, job->in_filename);
+            goto EXIT_WITH_CLOSE;
+        }
+        if (fwrite(worker->buffer, sizeof(uint8_t), encoded_size, out_fp) < encoded_size) {
+            fprintf(stderr, "File output error: %s \n", job->out_filename);
+            goto EXIT_WITH_CLOSE;
+        }
+        job->num_samples += num_read_samples;
+        job->output_size += encoded_size;
+    }
+
+    /* ファイルが途中で終わっていたらヘッダを書き直す */
+    if (job->num_samples != header.num_samples) {
+        header.num_samples = job->num_samples;
+        if ((fseek(out_fp, 0, SEEK_SET) != 0)
+                || (LINNEEncoder_EncodeHeader(&header, header_data, sizeof(header_data)) != LINNE_APIRESULT_OK)
+                || (fwrite(header_data, sizeof(uint8_t), LINNE_HEADER_SIZE, out_fp) < LINNE_HEADER_SIZE)) {
+            fprintf(stderr, "Failed to rewrite header: %s \n", job->out_filename);
+            goto EXIT_WITH_CLOSE;
+        }
+    }
+    job->sampling_rate = wav_format.sampling_rate;
+    result = 0;
+
+EXIT_WITH_CLOSE:
+    if (fclose(out_fp) != 0) {
+        fprintf(stderr, "File output error: %s \n", job->out_filename);
+        result = 1;
+    }
+EXIT:
+    WAV_CloseStream(in_stream);
+    return result;
+}
+
+/* バッチ: 1ファイルのデコード 成功時は0、失敗時は0以外を返す */
+static int LINNECodecBatch_DecodeFile(struct LINNECodecBatchWorker *worker, struct LINNECodecBatchJob *job)
+{
+    struct LINNECodecInputFile input;
+    struct WAVStream *out_stream;
+    struct WAVFileFormat wav_format;
+    struct LINNEDecoderPCMOutput output;
+    struct LINNEHeader header;
+    const uint8_t *header_data;
+    uint32_t ch;
+    LINNEApiResult ret;
+    int result = 1;
+
+    if (LINNECodecInputFile_Open(&input, job->in_filename) != 0) {
+        fprintf(stderr, "Failed to open %s. \n", job->in_filename);
         return 1;
     }
 
-    /* 出力wavハンドルの生成 */
+    /* デコーダはファイル毎にヘッダを設定し直して使い回す */
+    if (((header_data = LINNECodecInputFile_Read(&input, LINNE_HEADER_SIZE)) == NULL)
+            || (LINNEDecoder_DecodeHeader(header_data, LINNE_HEADER_SIZE, &header) != LINNE_APIRESULT_OK)) {
+        fprintf(stderr, "Failed to get header information: %s \n", job->in_filename);
+        goto EXIT;
+    }
+    if (header.num_samples_per_block > LINNECODEC_BATCH_MAX_NUM_SAMPLES_PER_BLOCK) {
+        fprintf(stderr, "Unsupported number of samples per block: %d (%s) \n", header.num_samples_per_block, job->in_filename);
+        goto EXIT;
+    }
+    if ((ret = LINNEDecoder_SetHeader(worker->decoder, &header)) != LINNE_APIRESULT_OK) {
+        fprintf(stderr, "Failed to set header: %d (%s) \n", ret, job->in_filename);
+        goto EXIT;
+    }
+
+    /* 出力wavストリームのオープン */
     wav_format.data_format     = WAV_DATA_FORMAT_PCM;
     wav_format.num_channels    = header.num_channels;
     wav_format.sampling_rate   = header.sampling_rate;
     wav_format.bits_per_sample = header.bits_per_sample;
-    wav_format.num_samples     = header.num_samples;
-    if ((out_wav = WAV_Create(&wav_format)) == NULL) {
-        fprintf(stderr, "Failed to create wav handle. \n");
-        return 1;
+    wav_format.num_samples     = (header.num_samples == LINNE_NUM_SAMPLES_UNKNOWN) ? UINT32_MAX : header.num_samples;
+    if ((out_stream = WAV_OpenStreamForWrite(job->out_filename, &wav_format)) == NULL) {
+        fprintf(stderr, "Failed to open %s. \n", job->out_filename);
+        goto EXIT;
     }
 
-    /* 一括デコード */
-    if ((ret = LINNEDecoder_DecodeWhole(decoder,
-                    buffer, buffer_size,
-                    (int32_t **)out_wav->data, out_wav->format.num_channels, out_wav->format.num_samples))
-                != LINNE_APIRESULT_OK) {
-        fprintf(stderr, "Decoding error! %d \n", ret);
-        return 1;
+    /* ブロック単位で読み込み・デコード・書き出し */
+    output.format = LINNE_PCM_FORMAT_INT32;
+    output.stride = sizeof(int32_t);
+    for (ch = 0; ch < header.num_channels; ch++) {
+        output.channels[ch] = worker->pcm[ch];
+    }
+    job->num_samples = 0;
+    while (job->num_samples < header.num_samples) {
+        const uint8_t *block;
+        uint32_t block_size, decode_size, num_decode_samples;
+        /* サンプル数が不明な場合は入力の末尾まで読む */
+        if ((header.num_samples == LINNE_NUM_SAMPLES_UNKNOWN) && LINNECodecInputFile_IsEnd(&input)) {
+            break;
+        }
+        if ((block = LINNECodecInputFile_ReadBlock(&input, &block_size)) == NULL) {
+            fprintf(stderr, "Failed to read input file: %s \n", job->in_filename);
+            goto EXIT_WITH_CLOSE;
+        }
+        if ((ret = LINNEDecoder_DecodeBlockPCM(worker->decoder,
+                        block, block_size, &output, LINNECODEC_BATCH_MAX_NUM_SAMPLES_PER_BLOCK,
+                        &decode_size, &num_decode_samples)) != LINNE_APIRESULT_OK) {
+            fprintf(stderr, "Decoding error! %d (%s) \n", ret, job->in_filename);
+            goto EXIT_WITH_CLOSE;
+        }
+        if (WAV_WriteStream(out_stream, worker->pcm, num_decode_samples) != WAV_APIRESULT_OK) {
+            fprintf(stderr, "Failed to write wav file: %s \n", job->out_filename);
+            goto EXIT_WITH_CLOSE;
+        }
+        job->num_samples += num_decode_samples;
+    }
+    job->sampling_rate = header.sampling_rate;
+    result = 0;
+
+EXIT_WITH_CLOSE:
+    /* 閉じるとヘッダのサイズが確定する */
+    if (WAV_CloseStream(out_stream) != WAV_APIRESULT_OK) {
+        fprintf(stderr, "Failed to write wav file: %s \n", job->out_filename);
+        result = 1;
+    }
+EXIT:
+    LINNECodecInputFile_Close(&input);
+    return result;
+}
+
+/* 次に処理するジョブを取り出す 残っていなければNULLを返す */
+static struct LINNECodecBatchJob *LINNECodecBatch_PopJob(struct LINNECodecBatch *batch)
+{
+    struct LINNECodecBatchJob *job = NULL;
+
+#if defined(LINNECODEC_USE_LOCK)
+#if defined(_WIN32)
+    EnterCriticalSection(&batch->lock);
+#else
+    pthread_mutex_lock(&batch->lock);
+#endif
+#endif
+
+    if (batch->next_job < batch->num_jobs) {
+        job = &batch->jobs[batch->next_job];
+        batch->next_job++;
+    }
+
+#if defined(LINNECODEC_USE_LOCK)
+#if defined(_WIN32)
+    LeaveCriticalSection(&batch->lock);
+#else
+    pthread_mutex_unlock(&batch->lock);
+#endif
+#endif
+
+    return job;
+}
+
+/* スレッドプールで実行するバッチのタスク 残ったジョブを1つずつ取り出し、実行スレッドのワーカで処理する */
+static void LINNECodecBatch_Task(void *arg, uint32_t thread_index)
+{
+    struct LINNECodecBatch *batch = (struct LINNECodecBatch *)arg;
+    struct LINNECodecBatchWorker *worker = &batch->workers[thread_index];
+    struct LINNECodecBatchJob *job;
+    struct stat fstat;
+
+    while ((job = LINNECodecBatch_PopJob(batch)) != NULL) {
+        if (batch->is_encode) {
+            job->result = LINNECodecBatch_EncodeFile(batch, worker, job);
+        } else {
+            job->result = LINNECodecBatch_DecodeFile(worker, job);
+        }
+
+        if (job->result == 0) {
+            if (stat(job->out_filename, &fstat) == 0) {
+                job->output_size = (uint64_t)fstat.st_size;
+            }
+        } else {
+            fprintf(stderr, "Failed to process %s. \n", job->in_filename);
+        }
+    }
+}
+
+/* バッチ処理の破棄 */
+static void LINNECodecBatch_Destroy(struct LINNECodecBatch *batch)
+{
+    uint32_t i, ch;
+
+    if (batch->workers != NULL) {
+        for (i = 0; i < batch->num_workers; i++) {
+            struct LINNECodecBatchWorker *worker = &batch->workers[i];
+            LINNEEncoder_Destroy(worker->encoder);
+            LINNEDecoder_Destroy(worker->decoder);
+            for (ch = 0; ch < LINNE_MAX_NUM_CHANNELS; ch++) {
+                if (worker->pcm[ch] != NULL) {
+                    free(worker->pcm[ch]);
+                }
+            }
+            if (worker->buffer != NULL) {
+                free(worker->buffer);
+            }
+        }
+        free(batch->workers);
     }
 
-    /* エンコード時に右シフトした分を戻し、32bit化 */
-    for (ch = 0; ch < out_wav->format.num_channels; ch++) {
-        for (smpl = 0; smpl < out_wav->format.num_samples; smpl++) {
-            WAVFile_PCM(out_wav, smpl, ch) <<= (32 - out_wav->format.bits_per_sample);
+    if (batch->jobs != NULL) {
+        for (i = 0; i < batch->num_jobs; i++) {
+            free(batch->jobs[i].in_filename);
+            free(batch->jobs[i].out_filename);
         }
+        free(batch->jobs);
     }
+}
 
-    /* WAVファイル書き出し */
-    if (WAV_WriteToFile(out_filename, out_wav) != WAV_APIRESULT_OK) {
-        fprintf(stderr, "Failed to write wav file. \n");
+/* スレッド毎のワーカの作成 成功時は0、失敗時は0以外を返す */
+static int LINNECodecBatch_CreateWorkers(struct LINNECodecBatch *batch, uint32_t num_workers)
+{
+    uint32_t i, ch;
+
+    if ((batch->workers = (struct LINNECodecBatchWorker *)calloc(num_workers, sizeof(struct LINNECodecBatchWorker))) == NULL) {
         return 1;
     }
+    batch->num_workers = num_workers;
 
-    free(buffer);
-    WAV_Destroy(out_wav);
-    LINNEDecoder_Destroy(decoder);
+    for (i = 0; i < num_workers; i++) {
+        struct LINNECodecBatchWorker *worker = &batch->workers[i];
+        /* 補足）ファイル単位で並列化するため、ハンドル内のチャンネル並列は使わない */
+        if (batch->is_encode) {
+            struct LINNEEncoderConfig config;
+            config.max_num_channels = LINNE_MAX_NUM_CHANNELS;
+            config.max_num_samples_per_block = LINNECODEC_BATCH_MAX_NUM_SAMPLES_PER_BLOCK;
+            config.max_num_layers = 5;
+            config.max_num_parameters_per_layer = 128;
+            config.max_num_threads = 1;
+            config.allocator = NULL;
+            if ((worker->encoder = LINNEEncoder_Create(&config, NULL, 0)) == NULL) {
+                return 1;
+            }
+        } else {
+            struct LINNEDecoderConfig config;
+            config.max_num_channels = LINNE_MAX_NUM_CHANNELS;
+            config.max_num_layers = 5;
+            config.max_num_parameters_per_layer = 128;
+            config.max_num_threads = 1;
+            config.max_num_samples_per_block = LINNECODEC_BATCH_MAX_NUM_SAMPLES_PER_BLOCK;
+            config.check_crc = batch->check_crc;
+            config.allocator = NULL;
+            if ((worker->decoder = LINNEDecoder_Create(&config, NULL, 0)) == NULL) {
+                return 1;
+            }
+        }
+        for (ch = 0; ch < LINNE_MAX_NUM_CHANNELS; ch++) {
+            if ((worker->pcm[ch] = (int32_t *)malloc(sizeof(int32_t) * LINNECODEC_BATCH_MAX_NUM_SAMPLES_PER_BLOCK)) == NULL) {
+                return 1;
+            }
+        }
+    }
 
     return 0;
 }
 
+/* バッチ処理 ディレクトリかリストファイルで指定した全ファイルを出力ディレクトリへ変換する */
+/* 成功時は0、失敗時は0以外を返す */
+static int do_batch(const char *in_name, const char *out_directory, uint8_t is_encode,
+    uint32_t encode_preset_no, uint8_t enable_learning, uint8_t num_afmethod_iterations,
+    uint8_t check_crc, uint32_t num_threads)
+{
+    struct LINNECodecBatch batch;
+    struct ThreadPoolConfig pool_config;
+    struct ThreadPool *pool;
+    struct ThreadPoolTaskGroup group;
+    struct stat fstat;
+    uint32_t i, num_failed;
+    double start_time, elapsed_time, input_size, output_size, duration, num_samples;
+    int ret;
+
+    batch.is_encode = is_encode;
+    batch.encode_preset_no = encode_preset_no;
+    batch.enable_learning = enable_learning;
+    batch.num_afmethod_iterations = num_afmethod_iterations;
+    batch.check_crc = check_crc;
+    batch.workers = NULL;
+    batch.num_workers = 0;
+    batch.jobs = NULL;
+    batch.num_jobs = 0;
+    batch.max_num_jobs = 0;
+    batch.next_job = 0;
+
+    /* 出力先はディレクトリ */
+    if (LINNECODEC_IS_STDIO(out_directory)
+            || (stat(out_directory, &fstat) != 0) || !S_ISDIR(fstat.st_mode)) {
+        fprintf(stderr, "Output directory %s does not exist. \n", out_directory);
+        return 1;
+    }
+
+    /* ジョブ列挙 ディレクトリでなければリストファイルとみなす */
+    if (!LINNECODEC_IS_STDIO(in_name) && (stat(in_name, &fstat) == 0) && S_ISDIR(fstat.st_mode)) {
+        ret = LINNECodecBatch_AddDirectory(&batch, in_name, out_directory);
+    } else {
+        ret = LINNECodecBatch_AddList(&batch, in_name, out_directory);
+    }
+    if (ret != 0) {
+        fprintf(stderr, "Failed to enumerate files in %s. \n", in_name);
+        LINNECodecBatch_Destroy(&batch);
+        return 1;
+    }
+    if (batch.num_jobs == 0) {
+        fprintf(stderr, "No files to process in %s. \n", in_name);
+        LINNECodecBatch_Destroy(&batch);
+        return 1;
+    }
+    if (LINNECodecBatch_CheckOutputNames(&batch) != 0) {
+        LINNECodecBatch_Destroy(&batch);
+        return 1;
+    }
+
+    /* スレッド毎のワーカ作成 ファイル数より多くのスレッドは使わない */
+    num_threads = (uint32_t)LINNECODEC_MIN(LINNECodec_DecideNumThreads(num_threads, batch.num_jobs), batch.num_jobs);
+    if (LINNECodecBatch_CreateWorkers(&batch, num_threads) != 0) {
+        fprintf(stderr, "Failed to create workers. \n");
+        LINNECodecBatch_Destroy(&batch);
+        return 1;
+    }
+
+    /* スレッド毎に1つずつタスクを積むプールを作成 */
+    pool_config.max_num_threads = num_threads;
+    pool_config.max_num_tasks = 1;
+    pool_config.allocator = NULL;
+    if ((pool = ThreadPool_Create(&pool_config, NULL, 0)) == NULL) {
+        fprintf(stderr, "Failed to create thread pool. \n");
+        LINNECodecBatch_Destroy(&batch);
+        return 1;
+    }
+#if defined(LINNECODEC_USE_LOCK)
+#if defined(_WIN32)
+    InitializeCriticalSection(&batch.lock);
+#else
+    if (pthread_mutex_init(&batch.lock, NULL) != 0) {
+        fprintf(stderr, "Failed to create lock. \n");
+        ThreadPool_Destroy(pool);
+        LINNECodecBatch_Destroy(&batch);
+        return 1;
+    }
+#endif
+#endif
+
+    /* 大きいジョブから処理されるように、サイズの降順に並べる */
+    /* 補足）各タスクは手が空くたびに残りのうち最も大きいジョブを取り出すため、 */
+    /* プールのキューの取り出し順に依らず大きいものから始まり、終盤は小さなジョブで負荷が均される */
+    qsort(batch.jobs, batch.num_jobs, sizeof(struct LINNECodecBatchJob), LINNECodecBatch_CompareJob);
+
+    start_time = LINNECodec_GetTime();
+    ThreadPool_InitializeTaskGroup(&group);
+    for (i = 0; i < num_threads; i++) {
+        ThreadPool_Submit(pool, &group, LINNECodecBatch_Task, &batch);
+    }
+    ThreadPool_Wait(pool, &group);
+    elapsed_time = LINNECodec_GetTime() - start_time;
+
+#if defined(LINNECODEC_USE_LOCK)
+#if defined(_WIN32)
+    DeleteCriticalSection(&batch.lock);
+#else
+    pthread_mutex_destroy(&batch.lock);
+#endif
+#endif
+
+    /* 集計結果の表示 */
+    num_failed = 0;
+    input_size = output_size = duration = num_samples = 0.0;
+    for (i = 0; i < batch.num_jobs; i++) {
+        const struct LINNECodecBatchJob *job = &batch.jobs[i];
+        if (job->result != 0) {
+            num_failed++;
+            continue;
+        }
+        input_size += (double)job->input_size;
+        output_size += (double)job->output_size;
+        num_samples += (double)job->num_samples;
+        if (job->sampling_rate > 0) {
+            duration += (double)job->num_samples / job->sampling_rate;
+        }
+    }
+    elapsed_time = LINNECODEC_MAX(elapsed_time, 1.0e-6);
+    printf("finished: %u files (%u failed) in %.2f sec with %u threads \n",
+            batch.num_jobs, num_failed, elapsed_time, num_threads);
+    printf("total: %.0f -> %.0f (%6.2f %%) \n",
+            input_size, output_size, (input_size > 0.0) ? (100.0 * output_size / input_size) : 0.0);
+    printf("throughput: %.2f MB/s, %.0f samples/s, %.2f x realtime \n",
+            input_size / (elapsed_time * 1024.0 * 1024.0), num_samples / elapsed_time, duration / elapsed_time);
+
+    ThreadPool_Destroy(pool);
+    LINNECodecBatch_Destroy(&batch);
+
+    return (num_failed > 0) ? 1 : 0;
+}
+
 /* 使用法の表示 */
 static void print_usage(char** argv)
 {
     printf("Usage: %s [options] INPUT_FILE_NAME OUTPUT_FILE_NAME \n", argv[0]);
+    printf("Specify \"%s\" as a file name to use standard input/output. \n", LINNECODEC_STDIO_FILENAME);
+    printf("In batch mode(-b), INPUT is a directory or a list file and OUTPUT is a directory. \n");
 }
 
 /* バージョン情報の表示 */
@@ -286,6 +1854,8 @@ int main(int argc, char** argv)
     const char* filename_ptr[2] = { NULL, NULL };
     const char* input_file;
     const char* output_file;
+    uint8_t is_batch;
+    uint32_t num_threads;
 
     /* 引数が足らない */
     if (argc == 1) {
@@ -325,6 +1895,38 @@ int main(int argc, char** argv)
         return 1;
     }
 
+#if defined(_WIN32)
+    /* 標準入出力をバイナリモードにする */
+    if (LINNECODEC_IS_STDIO(input_file)) {
+        _setmode(_fileno(stdin), _O_BINARY);
+    }
+    if (LINNECODEC_IS_STDIO(output_file)) {
+        _setmode(_fileno(stdout), _O_BINARY);
+    }
+#endif
+
+    /* バッチモードの指定 */
+    is_batch = (CommandLineParser_GetOptionAcquired(command_line_spec, "batch") == COMMAND_LINE_PARSER_TRUE) ? 1 : 0;
+
+    /* スレッド数の取得 */
+    num_threads = LINNECODEC_NUM_THREADS_AUTO;
+    if (CommandLineParser_GetOptionAcquired(command_line_spec, "threads") == COMMAND_LINE_PARSER_TRUE) {
+        const char *lstr = CommandLineParser_GetArgumentString(command_line_spec, "threads");
+        if (strcmp(lstr, "auto") != 0) {
+            char *e;
+            const long num = strtol(lstr, &e, 10);
+            if (*e != '\0') {
+                fprintf(stderr, "%s: invalid number of threads. (irregular character found in %s at %s)\n", argv[0], lstr, e);
+                return 1;
+            }
+            if ((num < 1) || (num > LINNECODEC_MAX_NUM_THREADS)) {
+                fprintf(stderr, "%s: number of threads is out of range. \n", argv[0]);
+                return 1;
+            }
+            num_threads = (uint32_t)num;
+        }
+    }
+
     /* エンコードとデコードは同時に指定できない */
     if ((CommandLineParser_GetOptionAcquired(command_line_spec, "decode") == COMMAND_LINE_PARSER_TRUE)
             && (CommandLineParser_GetOptionAcquired(command_line_spec, "encode") == COMMAND_LINE_PARSER_TRUE)) {
@@ -339,8 +1941,16 @@ int main(int argc, char** argv)
         if (CommandLineParser_GetOptionAcquired(command_line_spec, "no-crc-check") == COMMAND_LINE_PARSER_TRUE) {
             crc_check = 0;
         }
+        /* バッチモードではディレクトリかリストファイル内の全ファイルをデコード */
+        if (is_batch) {
+            if (do_batch(input_file, output_file, 0, 0, 0, 0, crc_check, num_threads) != 0) {
+                fprintf(stderr, "%s: failed to decode files in %s. \n", argv[0], input_file);
+                return 1;
+            }
+            return 0;
+        }
         /* 一括デコード実行 */
-        if (do_decode(input_file, output_file, crc_check) != 0) {
+        if (do_decode(input_file, output_file, crc_check, num_threads) != 0) {
             fprintf(stderr, "%s: failed to decode %s. \n", argv[0], input_file);
             return 1;
         }
@@ -381,8 +1991,17 @@ int main(int argc, char** argv)
                 return 1;
             }
         }
+        /* バッチモードではディレクトリかリストファイル内の全ファイルをエンコード */
+        if (is_batch) {
+            if (do_batch(input_file, output_file, 1,
+                        encode_preset_no, enable_learning, num_afmethod_iterations, 0, num_threads) != 0) {
+                fprintf(stderr, "%s: failed to encode files in %s. \n", argv[0], input_file);
+                return 1;
+            }
+            return 0;
+        }
         /* 一括エンコード実行 */
-        if (do_encode(input_file, output_file, encode_preset_no, enable_learning, num_afmethod_iterations) != 0) {
+        if (do_encode(input_file, output_file, encode_preset_no, enable_learning, num_afmethod_iterations, num_threads) != 0) {
             fprintf(stderr, "%s: failed to encode %s. \n", argv[0], input_file);
             return 1;
         }
@@ -13,7 +13,7 @@ static void exit_linne_player(void);
 
 /* 再生制御のためのグローバル変数 */
 static struct LINNEHeader header = { 0, };
-static uint32_t output_samples = 0;
+static uint64_t output_samples = 0;
 static int32_t *decode_buffer[LINNE_MAX_NUM_CHANNELS] = { NULL, };
 static uint32_t num_buffered_samples = 0;
 static uint32_t buffer_pos = 0;
@@ -72,7 +72,10 @@ int main(int argc, char **argv)
     decoder_config.max_num_channels = header.num_channels;
     decoder_config.max_num_layers   = 10;
     decoder_config.max_num_parameters_per_layer = 128;
+    decoder_config.max_num_threads  = header.num_channels;
+    decoder_config.max_num_samples_per_block = 0;
     decoder_config.check_crc        = 1;
+    decoder_config.allocator        = NULL;
     if ((decoder = LINNEDecoder_Create(&decoder_config, NULL, 0)) == NULL) {
         fprintf(stderr, "Failed to create decoder handle. \n");
         return 1;